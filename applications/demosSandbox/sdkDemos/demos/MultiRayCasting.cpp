@@ -36,26 +36,8 @@ class dRayCastRecord: public dCustomControllerBase
 	{
 	}
 
-	static dFloat RayCast (const NewtonBody* const body, const NewtonCollision* const collisionHit, const dFloat* const contact, const dFloat* const normal, dLong collisionID, void* const userData, dFloat intersetParam)
-	{
-		dFloat* const paramPtr = (dFloat*)userData;
-		if (intersetParam < paramPtr[0]) {
-			paramPtr[0] = intersetParam;
-		}
-		return paramPtr[0];
-	}
-
 	void PostUpdate(dFloat timestep, int threadIndex)
 	{
-		DemoEntity* const targetEnt = (DemoEntity*) NewtonBodyGetUserData (m_target);
-		const dMatrix& matrix = targetEnt->GetRenderMatrix(); 
-
-		dFloat parameter = 1.1f;
-		NewtonWorld* const world = NewtonBodyGetWorld (m_target);
-		NewtonWorldRayCast(world, &m_p0[0], &matrix.m_posit[0], RayCast, &parameter, NULL, threadIndex);
-
-		dAssert (parameter <= 1.0f);
-		m_p1 = m_p0 + (matrix.m_posit - m_p0).Scale (parameter);
 	}
 
 	void Debug(dCustomJoint::dDebugDisplay* const debugContext) const
@@ -160,6 +142,32 @@ class dRayCasterManager: public dCustomControllerManager<dRayCastRecord>
 	{
 	}
 
+	// cast all the rays in one batch instead of one controller at the time
+	virtual void PostUpdate(dFloat timestep)
+	{
+		int count = 0;
+		for (dListNode* node = GetFirst(); node; node = node->GetNext()) {
+			dRayCastRecord* const caster = &node->GetInfo();
+			DemoEntity* const targetEnt = (DemoEntity*) NewtonBodyGetUserData (caster->m_target);
+			const dMatrix& matrix = targetEnt->GetRenderMatrix(); 
+			for (int i = 0; i < 4; i ++) {
+				m_queries[count].m_p0[i] = caster->m_p0[i];
+				m_queries[count].m_p1[i] = matrix.m_posit[i];
+			}
+			count ++;
+		}
+
+		NewtonWorldRayCastBatch(GetWorld(), m_queries, m_hits, count, NULL, NULL);
+
+		count = 0;
+		for (dListNode* node = GetFirst(); node; node = node->GetNext()) {
+			dRayCastRecord* const caster = &node->GetInfo();
+			dVector p1 (m_queries[count].m_p1[0], m_queries[count].m_p1[1], m_queries[count].m_p1[2], 0.0f);
+			caster->m_p1 = caster->m_p0 + (p1 - caster->m_p0).Scale (m_hits[count].m_param);
+			count ++;
+		}
+	}
+
 	dRayCastRecord* CreateCaster (const dVector& origin, NewtonBody* const targetBody)
 	{
 		dRayCastRecord* const caster = (dRayCastRecord*) CreateController();
@@ -171,6 +179,8 @@ class dRayCasterManager: public dCustomControllerManager<dRayCastRecord>
 
 	virtual void Debug () const {};
 
+	NewtonWorldRayCastQuery m_queries[PARALLET_RAYS_COUNT];
+	NewtonWorldRayCastHitInfo m_hits[PARALLET_RAYS_COUNT];
 };
 
 
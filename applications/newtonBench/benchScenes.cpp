@@ -0,0 +1,621 @@
+/* Copyright (c) <2003-2016> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#include <math.h>
+#include "benchScenes.h"
+
+#define BENCH_GRAVITY			dFloat (-10.0f)
+#define BENCH_PI				dFloat (3.14159265f)
+
+
+// all scenes are seeded, so that every thread count steps the exact same initial configuration
+class BenchRandom
+{
+	public:
+	BenchRandom (unsigned seed)
+		:m_seed (seed)
+	{
+	}
+
+	dFloat Uniform (dFloat low, dFloat high)
+	{
+		m_seed = m_seed * 1664525u + 1013904223u;
+		dFloat r = dFloat ((m_seed >> 8) & 0xffffff) / dFloat (0xffffff);
+		return low + (high - low) * r;
+	}
+
+	int Index (int count)
+	{
+		m_seed = m_seed * 1664525u + 1013904223u;
+		return int ((m_seed >> 8) % unsigned (count));
+	}
+
+	unsigned m_seed;
+};
+
+
+static void ApplyGravity (const NewtonBody* const body, dFloat timestep, int threadIndex)
+{
+	dFloat mass;
+	dFloat Ixx;
+	dFloat Iyy;
+	dFloat Izz;
+
+	NewtonBodyGetMass (body, &mass, &Ixx, &Iyy, &Izz);
+	dFloat force[4] = {dFloat (0.0f), mass * BENCH_GRAVITY, dFloat (0.0f), dFloat (0.0f)};
+	NewtonBodySetForce (body, force);
+}
+
+static void MakeMatrix (dFloat* const matrix, dFloat pitch, dFloat yaw, dFloat roll, dFloat x, dFloat y, dFloat z)
+{
+	const dFloat cx = dFloat (cos (pitch));
+	const dFloat sx = dFloat (sin (pitch));
+	const dFloat cy = dFloat (cos (yaw));
+	const dFloat sy = dFloat (sin (yaw));
+	const dFloat cz = dFloat (cos (roll));
+	const dFloat sz = dFloat (sin (roll));
+
+	const dFloat rx[3][3] = {{1.0f, 0.0f, 0.0f}, {0.0f, cx, sx}, {0.0f, -sx, cx}};
+	const dFloat ry[3][3] = {{cy, 0.0f, -sy}, {0.0f, 1.0f, 0.0f}, {sy, 0.0f, cy}};
+	const dFloat rz[3][3] = {{cz, sz, 0.0f}, {-sz, cz, 0.0f}, {0.0f, 0.0f, 1.0f}};
+
+	dFloat rxy[3][3];
+	for (int i = 0; i < 3; i ++) {
+		for (int j = 0; j < 3; j ++) {
+			rxy[i][j] = rx[i][0] * ry[0][j] + rx[i][1] * ry[1][j] + rx[i][2] * ry[2][j];
+		}
+	}
+	for (int i = 0; i < 3; i ++) {
+		for (int j = 0; j < 3; j ++) {
+			matrix[i * 4 + j] = rxy[i][0] * rz[0][j] + rxy[i][1] * rz[1][j] + rxy[i][2] * rz[2][j];
+		}
+		matrix[i * 4 + 3] = dFloat (0.0f);
+	}
+	matrix[12] = x;
+	matrix[13] = y;
+	matrix[14] = z;
+	matrix[15] = dFloat (1.0f);
+}
+
+static void MakeTranslation (dFloat* const matrix, dFloat x, dFloat y, dFloat z)
+{
+	MakeMatrix (matrix, dFloat (0.0f), dFloat (0.0f), dFloat (0.0f), x, y, z);
+}
+
+static NewtonBody* CreateRigidBody (NewtonWorld* const world, const NewtonCollision* const collision, const dFloat* const matrix, dFloat mass)
+{
+	NewtonBody* const body = NewtonCreateDynamicBody (world, collision, matrix);
+	if (mass > dFloat (0.0f)) {
+		NewtonBodySetMassProperties (body, mass, collision);
+		NewtonBodySetForceAndTorqueCallback (body, ApplyGravity);
+	}
+	return body;
+}
+
+static void CreateFloor (NewtonWorld* const world, dFloat size)
+{
+	dFloat matrix[16];
+	MakeTranslation (matrix, dFloat (0.0f), dFloat (-0.5f), dFloat (0.0f));
+	NewtonCollision* const box = NewtonCreateBox (world, size, dFloat (1.0f), size, 0, NULL);
+	CreateRigidBody (world, box, matrix, dFloat (0.0f));
+	NewtonDestroyCollision (box);
+}
+
+// capsules and cylinders are aligned to the x axis, this offset stands them along the y axis
+static NewtonCollision* CreateVerticalCapsule (NewtonWorld* const world, dFloat radius, dFloat height)
+{
+	dFloat offset[16];
+	MakeMatrix (offset, dFloat (0.0f), dFloat (0.0f), BENCH_PI * dFloat (0.5f), dFloat (0.0f), dFloat (0.0f), dFloat (0.0f));
+	return NewtonCreateCapsule (world, radius, radius, height, 0, offset);
+}
+
+static NewtonCollision* CreateRandomHull (NewtonWorld* const world, BenchRandom& random, dFloat size)
+{
+	dFloat points[24][3];
+	for (int i = 0; i < 24; i ++) {
+		const dFloat y = random.Uniform (dFloat (-1.0f), dFloat (1.0f));
+		const dFloat angle = random.Uniform (dFloat (0.0f), BENCH_PI * dFloat (2.0f));
+		const dFloat r = dFloat (sqrt (dFloat (1.0f) - y * y));
+		points[i][0] = size * r * dFloat (cos (angle));
+		points[i][1] = size * y * dFloat (0.7f);
+		points[i][2] = size * r * dFloat (sin (angle)) * dFloat (0.8f);
+	}
+	return NewtonCreateConvexHull (world, 24, &points[0][0], 3 * sizeof (dFloat), dFloat (0.01f), 0, NULL);
+}
+
+// a palette of convex shapes of comparable size, shared by all bodies in the scene
+static int CreateConvexPalette (NewtonWorld* const world, BenchRandom& random, dFloat size, NewtonCollision** const palette)
+{
+	int count = 0;
+	palette[count ++] = NewtonCreateBox (world, size, size, size, 0, NULL);
+	palette[count ++] = NewtonCreateBox (world, size * dFloat (1.5f), size * dFloat (0.5f), size * dFloat (0.75f), 0, NULL);
+	palette[count ++] = NewtonCreateSphere (world, size * dFloat (0.5f), 0, NULL);
+	palette[count ++] = CreateVerticalCapsule (world, size * dFloat (0.3f), size * dFloat (0.6f));
+	palette[count ++] = NewtonCreateCylinder (world, size * dFloat (0.4f), size * dFloat (0.4f), size, 0, NULL);
+	palette[count ++] = NewtonCreateChamferCylinder (world, size * dFloat (0.5f), size * dFloat (0.4f), 0, NULL);
+	palette[count ++] = CreateRandomHull (world, random, size * dFloat (0.6f));
+	palette[count ++] = CreateRandomHull (world, random, size * dFloat (0.6f));
+	return count;
+}
+
+static void DestroyPalette (NewtonCollision** const palette, int count)
+{
+	for (int i = 0; i < count; i ++) {
+		NewtonDestroyCollision (palette[i]);
+	}
+}
+
+
+// box stacks: many tall independent islands
+static void BuildBoxStacks (NewtonWorld* const world)
+{
+	const int stacksPerSide = 8;
+	const int stackHigh = 12;
+	const dFloat spacing = dFloat (4.0f);
+
+	CreateFloor (world, dFloat (200.0f));
+	NewtonCollision* const box = NewtonCreateBox (world, dFloat (1.0f), dFloat (1.0f), dFloat (1.0f), 0, NULL);
+
+	dFloat matrix[16];
+	const dFloat origin = -dFloat (stacksPerSide - 1) * spacing * dFloat (0.5f);
+	for (int i = 0; i < stacksPerSide; i ++) {
+		for (int j = 0; j < stacksPerSide; j ++) {
+			for (int k = 0; k < stackHigh; k ++) {
+				MakeTranslation (matrix, origin + i * spacing, dFloat (0.5f) + k, origin + j * spacing);
+				CreateRigidBody (world, box, matrix, dFloat (1.0f));
+			}
+		}
+	}
+	NewtonDestroyCollision (box);
+}
+
+// pyramid: a single large island of resting contacts
+static void BuildPyramid (NewtonWorld* const world)
+{
+	const int base = 16;
+	const dFloat spacing = dFloat (1.02f);
+
+	CreateFloor (world, dFloat (200.0f));
+	NewtonCollision* const box = NewtonCreateBox (world, dFloat (1.0f), dFloat (1.0f), dFloat (1.0f), 0, NULL);
+
+	dFloat matrix[16];
+	for (int layer = 0; layer < base; layer ++) {
+		const int side = base - layer;
+		const dFloat origin = -dFloat (side - 1) * spacing * dFloat (0.5f);
+		for (int i = 0; i < side; i ++) {
+			for (int j = 0; j < side; j ++) {
+				MakeTranslation (matrix, origin + i * spacing, dFloat (0.5f) + layer, origin + j * spacing);
+				CreateRigidBody (world, box, matrix, dFloat (1.0f));
+			}
+		}
+	}
+	NewtonDestroyCollision (box);
+}
+
+
+// ragdolls: articulated bodies with joint limits piling on top of each other
+static void ConnectBall (NewtonWorld* const world, NewtonBody* const child, NewtonBody* const parent, dFloat x, dFloat y, dFloat z, dFloat pinY, dFloat cone, dFloat twist)
+{
+	const dFloat pivot[3] = {x, y, z};
+	const dFloat pin[3] = {dFloat (0.0f), pinY, dFloat (0.0f)};
+	NewtonJoint* const joint = NewtonConstraintCreateBall (world, pivot, child, parent);
+	NewtonBallSetConeLimits (joint, pin, cone, twist);
+	NewtonJointSetCollisionState (joint, 0);
+}
+
+static void CreateRagdoll (NewtonWorld* const world, NewtonCollision** const shapes, dFloat x, dFloat y, dFloat z)
+{
+	enum {m_pelvis, m_torso, m_head, m_upperArm, m_lowerArm, m_upperLeg, m_lowerLeg};
+
+	dFloat matrix[16];
+	MakeTranslation (matrix, x, y + dFloat (1.05f), z);
+	NewtonBody* const pelvis = CreateRigidBody (world, shapes[m_pelvis], matrix, dFloat (8.0f));
+
+	MakeTranslation (matrix, x, y + dFloat (1.43f), z);
+	NewtonBody* const torso = CreateRigidBody (world, shapes[m_torso], matrix, dFloat (12.0f));
+	ConnectBall (world, torso, pelvis, x, y + dFloat (1.16f), z, dFloat (1.0f), dFloat (0.5f), dFloat (0.4f));
+
+	MakeTranslation (matrix, x, y + dFloat (1.84f), z);
+	NewtonBody* const head = CreateRigidBody (world, shapes[m_head], matrix, dFloat (4.0f));
+	ConnectBall (world, head, torso, x, y + dFloat (1.70f), z, dFloat (1.0f), dFloat (0.7f), dFloat (0.8f));
+
+	for (int side = -1; side <= 1; side += 2) {
+		const dFloat armX = x + side * dFloat (0.28f);
+		MakeTranslation (matrix, armX, y + dFloat (1.48f), z);
+		NewtonBody* const upperArm = CreateRigidBody (world, shapes[m_upperArm], matrix, dFloat (2.0f));
+		ConnectBall (world, upperArm, torso, armX, y + dFloat (1.64f), z, dFloat (-1.0f), dFloat (1.4f), dFloat (0.6f));
+
+		MakeTranslation (matrix, armX, y + dFloat (1.12f), z);
+		NewtonBody* const lowerArm = CreateRigidBody (world, shapes[m_lowerArm], matrix, dFloat (1.5f));
+		ConnectBall (world, lowerArm, upperArm, armX, y + dFloat (1.30f), z, dFloat (-1.0f), dFloat (1.1f), dFloat (0.1f));
+
+		const dFloat legX = x + side * dFloat (0.12f);
+		MakeTranslation (matrix, legX, y + dFloat (0.72f), z);
+		NewtonBody* const upperLeg = CreateRigidBody (world, shapes[m_upperLeg], matrix, dFloat (6.0f));
+		ConnectBall (world, upperLeg, pelvis, legX, y + dFloat (0.96f), z, dFloat (-1.0f), dFloat (1.0f), dFloat (0.3f));
+
+		MakeTranslation (matrix, legX, y + dFloat (0.25f), z);
+		NewtonBody* const lowerLeg = CreateRigidBody (world, shapes[m_lowerLeg], matrix, dFloat (4.0f));
+		ConnectBall (world, lowerLeg, upperLeg, legX, y + dFloat (0.49f), z, dFloat (-1.0f), dFloat (1.1f), dFloat (0.1f));
+	}
+}
+
+static void BuildRagdollPile (NewtonWorld* const world)
+{
+	const int ragdollsPerSide = 5;
+	const int layers = 4;
+	const dFloat spacing = dFloat (1.2f);
+
+	CreateFloor (world, dFloat (200.0f));
+
+	NewtonCollision* shapes[7];
+	shapes[0] = NewtonCreateBox (world, dFloat (0.35f), dFloat (0.2f), dFloat (0.2f), 0, NULL);
+	shapes[1] = NewtonCreateBox (world, dFloat (0.4f), dFloat (0.5f), dFloat (0.22f), 0, NULL);
+	shapes[2] = NewtonCreateSphere (world, dFloat (0.12f), 0, NULL);
+	shapes[3] = CreateVerticalCapsule (world, dFloat (0.05f), dFloat (0.22f));
+	shapes[4] = CreateVerticalCapsule (world, dFloat (0.05f), dFloat (0.22f));
+	shapes[5] = CreateVerticalCapsule (world, dFloat (0.07f), dFloat (0.3f));
+	shapes[6] = CreateVerticalCapsule (world, dFloat (0.07f), dFloat (0.3f));
+
+	// stagger the layers so that the ragdolls land on each other and tangle up
+	const dFloat origin = -dFloat (ragdollsPerSide - 1) * spacing * dFloat (0.5f);
+	for (int layer = 0; layer < layers; layer ++) {
+		const dFloat shift = (layer & 1) ? spacing * dFloat (0.5f) : dFloat (0.0f);
+		for (int i = 0; i < ragdollsPerSide; i ++) {
+			for (int j = 0; j < ragdollsPerSide; j ++) {
+				CreateRagdoll (world, shapes, origin + i * spacing + shift, dFloat (0.05f) + layer * dFloat (2.2f), origin + j * spacing + shift);
+			}
+		}
+	}
+	DestroyPalette (shapes, 7);
+}
+
+
+// rubble: ten thousand mixed convex bodies collapsing into a single pile
+static void BuildRubble (NewtonWorld* const world)
+{
+	const int countX = 20;
+	const int countY = 25;
+	const int countZ = 20;
+	const dFloat spacing = dFloat (1.25f);
+
+	BenchRandom random (0x1234);
+	CreateFloor (world, dFloat (400.0f));
+
+	NewtonCollision* palette[16];
+	const int paletteCount = CreateConvexPalette (world, random, dFloat (0.8f), palette);
+
+	dFloat matrix[16];
+	const dFloat origin = -dFloat (countX - 1) * spacing * dFloat (0.5f);
+	for (int y = 0; y < countY; y ++) {
+		for (int x = 0; x < countX; x ++) {
+			for (int z = 0; z < countZ; z ++) {
+				const dFloat pitch = random.Uniform (-BENCH_PI, BENCH_PI);
+				const dFloat yaw = random.Uniform (-BENCH_PI, BENCH_PI);
+				const dFloat roll = random.Uniform (-BENCH_PI, BENCH_PI);
+				MakeMatrix (matrix, pitch, yaw, roll, origin + x * spacing, dFloat (1.0f) + y * spacing, origin + z * spacing);
+				CreateRigidBody (world, palette[random.Index (paletteCount)], matrix, dFloat (1.0f));
+			}
+		}
+	}
+	DestroyPalette (palette, paletteCount);
+}
+
+
+// heightfield with vehicles: four wheeled chassis driving over rolling terrain through loose rocks
+#define BENCH_TERRAIN_SIZE			256
+#define BENCH_TERRAIN_VERTICAL_SCALE	dFloat (1.0f / 2048.0f)
+
+static dFloat TerrainHeight (dFloat x, dFloat z)
+{
+	return dFloat (4.0f) + dFloat (2.5f) * dFloat (sin (x * dFloat (0.06f)) * cos (z * dFloat (0.045f))) + dFloat (0.5f) * dFloat (sin (x * dFloat (0.31f) + z * dFloat (0.23f)));
+}
+
+// the public hinge of this core has no implementation, so the wheel axles are user joints.
+// the pin is the local x axis of both the wheel and the chassis.
+class VehicleAxle
+{
+	public:
+	dFloat m_pivot0[3];
+	dFloat m_pivot1[3];
+};
+
+static void LocalToGlobal (const dFloat* const matrix, const dFloat* const local, dFloat* const global)
+{
+	for (int i = 0; i < 3; i ++) {
+		global[i] = local[0] * matrix[i] + local[1] * matrix[4 + i] + local[2] * matrix[8 + i] + matrix[12 + i];
+	}
+}
+
+static void GlobalToLocal (const dFloat* const matrix, const dFloat* const global, dFloat* const local)
+{
+	const dFloat dist[3] = {global[0] - matrix[12], global[1] - matrix[13], global[2] - matrix[14]};
+	for (int i = 0; i < 3; i ++) {
+		local[i] = dist[0] * matrix[i * 4] + dist[1] * matrix[i * 4 + 1] + dist[2] * matrix[i * 4 + 2];
+	}
+}
+
+static void VehicleAxleSubmitConstraints (const NewtonJoint* const joint, dFloat timestep, int threadIndex)
+{
+	const dFloat targetOmega = dFloat (-12.0f);
+	const dFloat maxTorque = dFloat (800.0f);
+
+	const VehicleAxle* const axle = (VehicleAxle*) NewtonJointGetUserData (joint);
+	const NewtonBody* const wheel = NewtonJointGetBody0 (joint);
+	const NewtonBody* const chassis = NewtonJointGetBody1 (joint);
+
+	dFloat matrix0[16];
+	dFloat matrix1[16];
+	NewtonBodyGetMatrix (wheel, matrix0);
+	NewtonBodyGetMatrix (chassis, matrix1);
+
+	dFloat p0[3];
+	dFloat p1[3];
+	LocalToGlobal (matrix0, axle->m_pivot0, p0);
+	LocalToGlobal (matrix1, axle->m_pivot1, p1);
+	for (int i = 0; i < 3; i ++) {
+		NewtonUserJointAddLinearRow (joint, p0, p1, &matrix1[i * 4]);
+	}
+
+	// a second point along the pin keeps the two axis aligned
+	const dFloat q0[3] = {p0[0] + matrix0[0], p0[1] + matrix0[1], p0[2] + matrix0[2]};
+	const dFloat q1[3] = {p1[0] + matrix1[0], p1[1] + matrix1[1], p1[2] + matrix1[2]};
+	NewtonUserJointAddLinearRow (joint, q0, q1, &matrix1[4]);
+	NewtonUserJointAddLinearRow (joint, q0, q1, &matrix1[8]);
+
+	dFloat omega0[3];
+	dFloat omega1[3];
+	NewtonBodyGetOmega (wheel, omega0);
+	NewtonBodyGetOmega (chassis, omega1);
+	const dFloat omega = (omega0[0] - omega1[0]) * matrix1[0] + (omega0[1] - omega1[1]) * matrix1[1] + (omega0[2] - omega1[2]) * matrix1[2];
+	NewtonUserJointAddAngularRow (joint, dFloat (0.0f), &matrix1[0]);
+	NewtonUserJointSetRowAcceleration (joint, (targetOmega - omega) / timestep);
+	NewtonUserJointSetRowMinimumFriction (joint, -maxTorque);
+	NewtonUserJointSetRowMaximumFriction (joint, maxTorque);
+}
+
+static void VehicleAxleDestructor (const NewtonJoint* const joint)
+{
+	delete (VehicleAxle*) NewtonJointGetUserData (joint);
+}
+
+static void CreateVehicle (NewtonWorld* const world, NewtonCollision* const chassisShape, NewtonCollision* const wheelShape, dFloat x, dFloat y, dFloat z)
+{
+	dFloat matrix[16];
+	dFloat chassisMatrix[16];
+	MakeTranslation (chassisMatrix, x, y, z);
+	NewtonBody* const chassis = CreateRigidBody (world, chassisShape, chassisMatrix, dFloat (900.0f));
+
+	for (int i = 0; i < 4; i ++) {
+		const dFloat pivot[3] = {x + ((i & 1) ? dFloat (1.15f) : dFloat (-1.15f)), y - dFloat (0.35f), z + ((i & 2) ? dFloat (1.4f) : dFloat (-1.4f))};
+		MakeTranslation (matrix, pivot[0], pivot[1], pivot[2]);
+		NewtonBody* const wheel = CreateRigidBody (world, wheelShape, matrix, dFloat (30.0f));
+
+		VehicleAxle* const axle = new VehicleAxle;
+		GlobalToLocal (matrix, pivot, axle->m_pivot0);
+		GlobalToLocal (chassisMatrix, pivot, axle->m_pivot1);
+		NewtonJoint* const joint = NewtonConstraintCreateUserJoint (world, 6, VehicleAxleSubmitConstraints, wheel, chassis);
+		NewtonJointSetUserData (joint, axle);
+		NewtonJointSetDestructor (joint, VehicleAxleDestructor);
+		NewtonJointSetCollisionState (joint, 0);
+	}
+}
+
+static void BuildHeightfieldVehicles (NewtonWorld* const world)
+{
+	const int vehiclesPerSide = 8;
+	const dFloat vehicleSpacing = dFloat (12.0f);
+	const int rockCount = 512;
+	const dFloat half = dFloat (BENCH_TERRAIN_SIZE) * dFloat (0.5f);
+
+	BenchRandom random (0x4321);
+
+	unsigned short* const elevation = new unsigned short[BENCH_TERRAIN_SIZE * BENCH_TERRAIN_SIZE];
+	char* const attributes = new char[BENCH_TERRAIN_SIZE * BENCH_TERRAIN_SIZE];
+	for (int z = 0; z < BENCH_TERRAIN_SIZE; z ++) {
+		for (int x = 0; x < BENCH_TERRAIN_SIZE; x ++) {
+			elevation[z * BENCH_TERRAIN_SIZE + x] = (unsigned short) (TerrainHeight (dFloat (x), dFloat (z)) / BENCH_TERRAIN_VERTICAL_SCALE);
+			attributes[z * BENCH_TERRAIN_SIZE + x] = 0;
+		}
+	}
+
+	// elevation type 1 is unsigned short, so the data is the same in single and double precision builds
+	dFloat matrix[16];
+	NewtonCollision* const terrain = NewtonCreateHeightFieldCollision (world, BENCH_TERRAIN_SIZE, BENCH_TERRAIN_SIZE, 0, 1, elevation, attributes, BENCH_TERRAIN_VERTICAL_SCALE, dFloat (1.0f), dFloat (1.0f), 0);
+	MakeTranslation (matrix, -half, dFloat (0.0f), -half);
+	CreateRigidBody (world, terrain, matrix, dFloat (0.0f));
+	NewtonDestroyCollision (terrain);
+	delete[] attributes;
+	delete[] elevation;
+
+	NewtonCollision* const chassisShape = NewtonCreateBox (world, dFloat (2.0f), dFloat (0.6f), dFloat (4.0f), 0, NULL);
+	NewtonCollision* const wheelShape = NewtonCreateChamferCylinder (world, dFloat (0.4f), dFloat (0.3f), 0, NULL);
+	const dFloat origin = -dFloat (vehiclesPerSide - 1) * vehicleSpacing * dFloat (0.5f);
+	for (int i = 0; i < vehiclesPerSide; i ++) {
+		for (int j = 0; j < vehiclesPerSide; j ++) {
+			const dFloat x = origin + i * vehicleSpacing;
+			const dFloat z = origin + j * vehicleSpacing;
+			CreateVehicle (world, chassisShape, wheelShape, x, TerrainHeight (x + half, z + half) + dFloat (1.5f), z);
+		}
+	}
+	NewtonDestroyCollision (wheelShape);
+	NewtonDestroyCollision (chassisShape);
+
+	NewtonCollision* palette[16];
+	const int paletteCount = CreateConvexPalette (world, random, dFloat (0.7f), palette);
+	const dFloat range = -origin + vehicleSpacing;
+	for (int i = 0; i < rockCount; i ++) {
+		const dFloat x = random.Uniform (-range, range);
+		const dFloat z = random.Uniform (-range, range);
+		const dFloat yaw = random.Uniform (-BENCH_PI, BENCH_PI);
+		MakeMatrix (matrix, dFloat (0.0f), yaw, dFloat (0.0f), x, TerrainHeight (x + half, z + half) + dFloat (1.0f), z);
+		CreateRigidBody (world, palette[random.Index (paletteCount)], matrix, dFloat (20.0f));
+	}
+	DestroyPalette (palette, paletteCount);
+}
+
+
+// compound heavy: every body is a compound of several convex pieces
+static NewtonCollision* CreateChairCompound (NewtonWorld* const world)
+{
+	dFloat offset[16];
+	NewtonCollision* const compound = NewtonCreateCompoundCollision (world, 0);
+	NewtonCompoundCollisionBeginAddRemove (compound);
+
+	MakeTranslation (offset, dFloat (0.0f), dFloat (0.0f), dFloat (0.0f));
+	NewtonCollision* const seat = NewtonCreateBox (world, dFloat (1.0f), dFloat (0.1f), dFloat (1.0f), 0, offset);
+	NewtonCompoundCollisionAddSubCollision (compound, seat);
+	NewtonDestroyCollision (seat);
+
+	MakeTranslation (offset, dFloat (0.0f), dFloat (0.45f), dFloat (-0.45f));
+	NewtonCollision* const back = NewtonCreateBox (world, dFloat (1.0f), dFloat (0.8f), dFloat (0.1f), 0, offset);
+	NewtonCompoundCollisionAddSubCollision (compound, back);
+	NewtonDestroyCollision (back);
+
+	for (int i = 0; i < 4; i ++) {
+		MakeTranslation (offset, (i & 1) ? dFloat (0.45f) : dFloat (-0.45f), dFloat (-0.3f), (i & 2) ? dFloat (0.45f) : dFloat (-0.45f));
+		NewtonCollision* const leg = NewtonCreateBox (world, dFloat (0.1f), dFloat (0.5f), dFloat (0.1f), 0, offset);
+		NewtonCompoundCollisionAddSubCollision (compound, leg);
+		NewtonDestroyCollision (leg);
+	}
+
+	NewtonCompoundCollisionEndAddRemove (compound);
+	return compound;
+}
+
+static NewtonCollision* CreateDumbbellCompound (NewtonWorld* const world)
+{
+	dFloat offset[16];
+	NewtonCollision* const compound = NewtonCreateCompoundCollision (world, 0);
+	NewtonCompoundCollisionBeginAddRemove (compound);
+
+	NewtonCollision* const bar = NewtonCreateCapsule (world, dFloat (0.1f), dFloat (0.1f), dFloat (1.2f), 0, NULL);
+	NewtonCompoundCollisionAddSubCollision (compound, bar);
+	NewtonDestroyCollision (bar);
+
+	for (int i = -1; i <= 1; i += 2) {
+		MakeTranslation (offset, i * dFloat (0.7f), dFloat (0.0f), dFloat (0.0f));
+		NewtonCollision* const weight = NewtonCreateSphere (world, dFloat (0.3f), 0, offset);
+		NewtonCompoundCollisionAddSubCollision (compound, weight);
+		NewtonDestroyCollision (weight);
+
+		MakeTranslation (offset, i * dFloat (0.45f), dFloat (0.0f), dFloat (0.0f));
+		NewtonCollision* const plate = NewtonCreateCylinder (world, dFloat (0.35f), dFloat (0.35f), dFloat (0.08f), 0, offset);
+		NewtonCompoundCollisionAddSubCollision (compound, plate);
+		NewtonDestroyCollision (plate);
+	}
+
+	NewtonCompoundCollisionEndAddRemove (compound);
+	return compound;
+}
+
+static void BuildCompoundHeavy (NewtonWorld* const world)
+{
+	const int countPerSide = 8;
+	const int layers = 8;
+	const dFloat spacing = dFloat (2.0f);
+
+	BenchRandom random (0x2468);
+	CreateFloor (world, dFloat (200.0f));
+
+	NewtonCollision* const shapes[2] = {CreateChairCompound (world), CreateDumbbellCompound (world)};
+
+	dFloat matrix[16];
+	const dFloat origin = -dFloat (countPerSide - 1) * spacing * dFloat (0.5f);
+	for (int y = 0; y < layers; y ++) {
+		for (int x = 0; x < countPerSide; x ++) {
+			for (int z = 0; z < countPerSide; z ++) {
+				const dFloat yaw = random.Uniform (-BENCH_PI, BENCH_PI);
+				const dFloat roll = random.Uniform (dFloat (-0.3f), dFloat (0.3f));
+				MakeMatrix (matrix, dFloat (0.0f), yaw, roll, origin + x * spacing, dFloat (1.0f) + y * dFloat (1.8f), origin + z * spacing);
+				CreateRigidBody (world, shapes[(x + y + z) & 1], matrix, dFloat (5.0f));
+			}
+		}
+	}
+	NewtonDestroyCollision (shapes[0]);
+	NewtonDestroyCollision (shapes[1]);
+}
+
+
+// static BVH mesh: thousands of convex bodies landing on a large triangle soup
+static dFloat MeshHeight (dFloat x, dFloat z)
+{
+	return dFloat (1.5f) * dFloat (sin (x * dFloat (0.2f)) * sin (z * dFloat (0.2f))) + dFloat (0.3f) * dFloat (cos (x * dFloat (0.7f) - z * dFloat (0.5f)));
+}
+
+static void BuildConvexOnMesh (NewtonWorld* const world)
+{
+	const int meshCells = 128;
+	const int countPerSide = 16;
+	const int layers = 8;
+	const dFloat spacing = dFloat (2.5f);
+
+	BenchRandom random (0x8642);
+
+	NewtonCollision* const mesh = NewtonCreateTreeCollision (world, 0);
+	NewtonTreeCollisionBeginBuild (mesh);
+	const dFloat half = dFloat (meshCells) * dFloat (0.5f);
+	for (int i = 0; i < meshCells; i ++) {
+		for (int j = 0; j < meshCells; j ++) {
+			const dFloat x0 = dFloat (i) - half;
+			const dFloat x1 = x0 + dFloat (1.0f);
+			const dFloat z0 = dFloat (j) - half;
+			const dFloat z1 = z0 + dFloat (1.0f);
+			const dFloat face0[3][3] = {{x0, MeshHeight (x0, z0), z0}, {x0, MeshHeight (x0, z1), z1}, {x1, MeshHeight (x1, z1), z1}};
+			const dFloat face1[3][3] = {{x0, MeshHeight (x0, z0), z0}, {x1, MeshHeight (x1, z1), z1}, {x1, MeshHeight (x1, z0), z0}};
+			NewtonTreeCollisionAddFace (mesh, 3, &face0[0][0], 3 * sizeof (dFloat), 0);
+			NewtonTreeCollisionAddFace (mesh, 3, &face1[0][0], 3 * sizeof (dFloat), 0);
+		}
+	}
+	NewtonTreeCollisionEndBuild (mesh, 0);
+
+	dFloat matrix[16];
+	MakeTranslation (matrix, dFloat (0.0f), dFloat (0.0f), dFloat (0.0f));
+	CreateRigidBody (world, mesh, matrix, dFloat (0.0f));
+	NewtonDestroyCollision (mesh);
+
+	NewtonCollision* palette[16];
+	const int paletteCount = CreateConvexPalette (world, random, dFloat (1.0f), palette);
+	const dFloat origin = -dFloat (countPerSide - 1) * spacing * dFloat (0.5f);
+	for (int y = 0; y < layers; y ++) {
+		for (int x = 0; x < countPerSide; x ++) {
+			for (int z = 0; z < countPerSide; z ++) {
+				const dFloat pitch = random.Uniform (-BENCH_PI, BENCH_PI);
+				const dFloat yaw = random.Uniform (-BENCH_PI, BENCH_PI);
+				MakeMatrix (matrix, pitch, yaw, dFloat (0.0f), origin + x * spacing, dFloat (3.0f) + y * spacing, origin + z * spacing);
+				CreateRigidBody (world, palette[random.Index (paletteCount)], matrix, dFloat (1.0f));
+			}
+		}
+	}
+	DestroyPalette (palette, paletteCount);
+}
+
+
+static const BenchScene g_benchScenes[] =
+{
+	{"box_stacks", "64 stacks of 12 boxes", BuildBoxStacks},
+	{"pyramid", "16 layer box pyramid", BuildPyramid},
+	{"ragdoll_pile", "100 ragdolls of 11 bodies and 10 ball joints", BuildRagdollPile},
+	{"rubble_10k", "10000 mixed convex bodies", BuildRubble},
+	{"heightfield_vehicles", "64 four wheeled vehicles and 512 rocks on a 256 x 256 heightfield", BuildHeightfieldVehicles},
+	{"compound_heavy", "512 compound bodies of 5 to 6 pieces", BuildCompoundHeavy},
+	{"bvh_mesh_convex", "2048 convex bodies on a 32768 triangle BVH mesh", BuildConvexOnMesh},
+};
+
+int GetBenchSceneCount ()
+{
+	return int (sizeof (g_benchScenes) / sizeof (g_benchScenes[0]));
+}
+
+const BenchScene& GetBenchScene (int index)
+{
+	return g_benchScenes[index];
+}
@@ -0,0 +1,30 @@
+/* Copyright (c) <2003-2016> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#ifndef __BENCH_SCENES_H__
+#define __BENCH_SCENES_H__
+
+#include <Newton.h>
+
+// a scene builder populates an empty world, the world owns everything the builder creates
+typedef void (*BenchSceneBuilder) (NewtonWorld* const world);
+
+struct BenchScene
+{
+	const char* m_name;
+	const char* m_description;
+	BenchSceneBuilder m_builder;
+};
+
+int GetBenchSceneCount ();
+const BenchScene& GetBenchScene (int index);
+
+#endif
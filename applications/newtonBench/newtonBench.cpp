@@ -0,0 +1,390 @@
+/* Copyright (c) <2003-2016> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+// headless benchmark of the core engine.
+// every scene is built in a fresh world for each thread count, warmed up, and then stepped
+// for a fixed number of frames while timing each NewtonUpdate call.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "benchScenes.h"
+
+struct BenchOptions
+{
+	BenchOptions ()
+		:m_frames (300)
+		,m_warmup (30)
+		,m_timestep (dFloat (1.0f / 60.0f))
+		,m_islandParallel (false)
+		,m_soaJoints (false)
+		,m_broadphase (NEWTON_BROADPHASE_DEFAULT)
+		,m_jsonFile (NULL)
+		,m_csvFile (NULL)
+	{
+	}
+
+	int m_frames;
+	int m_warmup;
+	dFloat m_timestep;
+	bool m_islandParallel;
+	bool m_soaJoints;
+	int m_broadphase;
+	const char* m_jsonFile;
+	const char* m_csvFile;
+	std::vector<int> m_threads;
+	std::vector<int> m_scenes;
+};
+
+struct BenchResult
+{
+	const BenchScene* m_scene;
+	int m_threads;
+	int m_bodies;
+	int m_joints;
+	int m_frameMemory;
+	double m_buildMs;
+	double m_meanMs;
+	double m_minMs;
+	double m_p50Ms;
+	double m_p90Ms;
+	double m_p99Ms;
+	double m_maxMs;
+	double m_speedup;
+	double m_efficiency;
+};
+
+
+static void PrintUsage ()
+{
+	printf ("usage: newton_bench [options]\n");
+	printf ("  --frames N         timed frames per run (default 300)\n");
+	printf ("  --warmup N         untimed frames before timing (default 30)\n");
+	printf ("  --timestep T       fixed step in seconds (default 1/60)\n");
+	printf ("  --threads a,b,...  thread counts to run (default 1, 2, 4 ... up to the hardware count)\n");
+	printf ("  --scenes a,b,...   scenes to run by name (default all)\n");
+	printf ("  --island-parallel  let the solver spread a single island across threads\n");
+	printf ("  --soa-joints       solve the joints of each island in simd lanes\n");
+	printf ("  --broadphase NAME  default, persistent or sap (default default)\n");
+	printf ("  --json FILE        write the results as json\n");
+	printf ("  --csv FILE         write the results as csv\n");
+	printf ("  --list             list the scenes and exit\n");
+}
+
+static void ListScenes ()
+{
+	for (int i = 0; i < GetBenchSceneCount (); i ++) {
+		const BenchScene& scene = GetBenchScene (i);
+		printf ("  %-22s %s\n", scene.m_name, scene.m_description);
+	}
+}
+
+static int FindScene (const std::string& name)
+{
+	for (int i = 0; i < GetBenchSceneCount (); i ++) {
+		if (name == GetBenchScene (i).m_name) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static std::vector<std::string> SplitList (const char* const list)
+{
+	std::vector<std::string> items;
+	std::string item;
+	for (const char* ptr = list; ; ptr ++) {
+		if ((*ptr == ',') || (*ptr == 0)) {
+			if (item.size()) {
+				items.push_back (item);
+			}
+			item.clear();
+			if (*ptr == 0) {
+				break;
+			}
+		} else {
+			item += *ptr;
+		}
+	}
+	return items;
+}
+
+static bool ParseOptions (int argc, char** argv, BenchOptions& options)
+{
+	for (int i = 1; i < argc; i ++) {
+		const char* const arg = argv[i];
+		const char* const value = (i + 1 < argc) ? argv[i + 1] : NULL;
+		if (!strcmp (arg, "--list")) {
+			ListScenes ();
+			exit (0);
+		} else if (!strcmp (arg, "--help") || !strcmp (arg, "-h")) {
+			PrintUsage ();
+			exit (0);
+		} else if (!strcmp (arg, "--island-parallel")) {
+			options.m_islandParallel = true;
+		} else if (!strcmp (arg, "--soa-joints")) {
+			options.m_soaJoints = true;
+		} else if (!value) {
+			fprintf (stderr, "missing value for %s\n", arg);
+			return false;
+		} else if (!strcmp (arg, "--frames")) {
+			options.m_frames = std::max (1, atoi (value));
+			i ++;
+		} else if (!strcmp (arg, "--warmup")) {
+			options.m_warmup = std::max (0, atoi (value));
+			i ++;
+		} else if (!strcmp (arg, "--timestep")) {
+			options.m_timestep = dFloat (atof (value));
+			i ++;
+		} else if (!strcmp (arg, "--broadphase")) {
+			if (!strcmp (value, "default")) {
+				options.m_broadphase = NEWTON_BROADPHASE_DEFAULT;
+			} else if (!strcmp (value, "persistent")) {
+				options.m_broadphase = NEWTON_BROADPHASE_PERSINTENT;
+			} else if (!strcmp (value, "sap")) {
+				options.m_broadphase = NEWTON_BROADPHASE_SAP;
+			} else {
+				fprintf (stderr, "unknown broadphase %s\n", value);
+				return false;
+			}
+			i ++;
+		} else if (!strcmp (arg, "--json")) {
+			options.m_jsonFile = value;
+			i ++;
+		} else if (!strcmp (arg, "--csv")) {
+			options.m_csvFile = value;
+			i ++;
+		} else if (!strcmp (arg, "--threads")) {
+			std::vector<std::string> items (SplitList (value));
+			for (size_t j = 0; j < items.size(); j ++) {
+				const int threads = atoi (items[j].c_str());
+				if (threads <= 0) {
+					fprintf (stderr, "invalid thread count %s\n", items[j].c_str());
+					return false;
+				}
+				options.m_threads.push_back (threads);
+			}
+			i ++;
+		} else if (!strcmp (arg, "--scenes")) {
+			std::vector<std::string> items (SplitList (value));
+			for (size_t j = 0; j < items.size(); j ++) {
+				const int index = FindScene (items[j]);
+				if (index < 0) {
+					fprintf (stderr, "unknown scene %s, available scenes are:\n", items[j].c_str());
+					ListScenes ();
+					return false;
+				}
+				options.m_scenes.push_back (index);
+			}
+			i ++;
+		} else {
+			fprintf (stderr, "unknown option %s\n", arg);
+			PrintUsage ();
+			return false;
+		}
+	}
+
+	if (!options.m_threads.size()) {
+		const int hardwareThreads = std::max (1, int (std::thread::hardware_concurrency()));
+		for (int threads = 1; threads < hardwareThreads; threads *= 2) {
+			options.m_threads.push_back (threads);
+		}
+		options.m_threads.push_back (hardwareThreads);
+	}
+	std::sort (options.m_threads.begin(), options.m_threads.end());
+	options.m_threads.erase (std::unique (options.m_threads.begin(), options.m_threads.end()), options.m_threads.end());
+
+	if (!options.m_scenes.size()) {
+		for (int i = 0; i < GetBenchSceneCount (); i ++) {
+			options.m_scenes.push_back (i);
+		}
+	}
+	return true;
+}
+
+// nearest rank percentile of a sorted sample
+static double Percentile (const std::vector<double>& sorted, double percent)
+{
+	const int count = int (sorted.size());
+	int rank = int (percent * count / 100.0 + 0.999999) - 1;
+	rank = std::max (0, std::min (count - 1, rank));
+	return sorted[rank];
+}
+
+static double ElapsedMs (const std::chrono::high_resolution_clock::time_point& start)
+{
+	return std::chrono::duration<double, std::milli> (std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static void RunScene (const BenchScene& scene, int threads, const BenchOptions& options, BenchResult& result)
+{
+	std::chrono::high_resolution_clock::time_point start (std::chrono::high_resolution_clock::now());
+
+	NewtonWorld* const world = NewtonCreate ();
+	NewtonSetThreadsCount (world, threads);
+	NewtonSetMultiThreadSolverOnSingleIsland (world, options.m_islandParallel ? 1 : 0);
+	NewtonSelectBroadphaseAlgorithm (world, options.m_broadphase);
+	if (options.m_soaJoints) {
+		NewtonSetSolverModel (world, NewtonGetSolverModel (world) | NEWTON_SOLVER_MODE_SOA_JOINTS);
+	}
+	scene.m_builder (world);
+
+	result.m_scene = &scene;
+	result.m_threads = NewtonGetThreadsCount (world);
+	result.m_bodies = NewtonWorldGetBodyCount (world);
+	result.m_joints = NewtonWorldGetConstraintCount (world);
+	result.m_buildMs = ElapsedMs (start);
+
+	for (int i = 0; i < options.m_warmup; i ++) {
+		NewtonUpdate (world, options.m_timestep);
+	}
+
+	std::vector<double> samples;
+	samples.reserve (options.m_frames);
+	for (int i = 0; i < options.m_frames; i ++) {
+		start = std::chrono::high_resolution_clock::now();
+		NewtonUpdate (world, options.m_timestep);
+		samples.push_back (ElapsedMs (start));
+	}
+	result.m_frameMemory = NewtonGetFrameMemoryHighWaterMark (world);
+	NewtonDestroy (world);
+
+	double acc = 0.0;
+	for (size_t i = 0; i < samples.size(); i ++) {
+		acc += samples[i];
+	}
+	std::sort (samples.begin(), samples.end());
+	result.m_meanMs = acc / samples.size();
+	result.m_minMs = samples.front();
+	result.m_p50Ms = Percentile (samples, 50.0);
+	result.m_p90Ms = Percentile (samples, 90.0);
+	result.m_p99Ms = Percentile (samples, 99.0);
+	result.m_maxMs = samples.back();
+	result.m_speedup = 1.0;
+	result.m_efficiency = 1.0;
+}
+
+// scaling is measured against the smallest thread count of the same scene
+static void CalculateScaling (std::vector<BenchResult>& results)
+{
+	for (size_t i = 0; i < results.size(); i ++) {
+		const BenchResult* base = NULL;
+		for (size_t j = 0; j < results.size(); j ++) {
+			if ((results[j].m_scene == results[i].m_scene) && (!base || (results[j].m_threads < base->m_threads))) {
+				base = &results[j];
+			}
+		}
+		results[i].m_speedup = base->m_meanMs / results[i].m_meanMs;
+		results[i].m_efficiency = results[i].m_speedup * base->m_threads / results[i].m_threads;
+	}
+}
+
+static void PrintResult (const BenchResult& result)
+{
+	printf ("%-22s %3d %6d %5d %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f %7.2f %6.1f%%\n",
+			result.m_scene->m_name, result.m_threads, result.m_bodies, result.m_joints,
+			result.m_meanMs, result.m_minMs, result.m_p50Ms, result.m_p90Ms, result.m_p99Ms, result.m_maxMs,
+			result.m_speedup, result.m_efficiency * 100.0);
+}
+
+static bool WriteJson (const char* const fileName, const BenchOptions& options, const std::vector<BenchResult>& results)
+{
+	FILE* const file = fopen (fileName, "wb");
+	if (!file) {
+		fprintf (stderr, "can't open %s\n", fileName);
+		return false;
+	}
+
+	fprintf (file, "{\n");
+	fprintf (file, "\t\"float_size\": %d,\n", int (sizeof (dFloat)));
+	fprintf (file, "\t\"frames\": %d,\n", options.m_frames);
+	fprintf (file, "\t\"warmup\": %d,\n", options.m_warmup);
+	fprintf (file, "\t\"timestep\": %g,\n", double (options.m_timestep));
+	fprintf (file, "\t\"island_parallel\": %s,\n", options.m_islandParallel ? "true" : "false");
+	fprintf (file, "\t\"results\": [\n");
+	for (size_t i = 0; i < results.size(); i ++) {
+		const BenchResult& result = results[i];
+		fprintf (file, "\t\t{\"scene\": \"%s\", \"threads\": %d, \"bodies\": %d, \"joints\": %d, \"frame_memory\": %d, \"build_ms\": %.3f, "
+					   "\"mean_ms\": %.4f, \"min_ms\": %.4f, \"p50_ms\": %.4f, \"p90_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f, "
+					   "\"speedup\": %.4f, \"efficiency\": %.4f}%s\n",
+				 result.m_scene->m_name, result.m_threads, result.m_bodies, result.m_joints, result.m_frameMemory, result.m_buildMs,
+				 result.m_meanMs, result.m_minMs, result.m_p50Ms, result.m_p90Ms, result.m_p99Ms, result.m_maxMs,
+				 result.m_speedup, result.m_efficiency, (i + 1 < results.size()) ? "," : "");
+	}
+	fprintf (file, "\t]\n");
+	fprintf (file, "}\n");
+	fclose (file);
+	return true;
+}
+
+static bool WriteCsv (const char* const fileName, const std::vector<BenchResult>& results)
+{
+	FILE* const file = fopen (fileName, "wb");
+	if (!file) {
+		fprintf (stderr, "can't open %s\n", fileName);
+		return false;
+	}
+
+	fprintf (file, "scene,threads,bodies,joints,frame_memory,build_ms,mean_ms,min_ms,p50_ms,p90_ms,p99_ms,max_ms,speedup,efficiency\n");
+	for (size_t i = 0; i < results.size(); i ++) {
+		const BenchResult& result = results[i];
+		fprintf (file, "%s,%d,%d,%d,%d,%.3f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n",
+				 result.m_scene->m_name, result.m_threads, result.m_bodies, result.m_joints, result.m_frameMemory, result.m_buildMs,
+				 result.m_meanMs, result.m_minMs, result.m_p50Ms, result.m_p90Ms, result.m_p99Ms, result.m_maxMs,
+				 result.m_speedup, result.m_efficiency);
+	}
+	fclose (file);
+	return true;
+}
+
+int main (int argc, char** argv)
+{
+	BenchOptions options;
+	if (!ParseOptions (argc, argv, options)) {
+		return 1;
+	}
+
+	printf ("newton_bench: %d frames, %d warmup, timestep %g\n", options.m_frames, options.m_warmup, double (options.m_timestep));
+	printf ("%-22s %3s %6s %5s %9s %9s %9s %9s %9s %9s %7s %7s\n", "scene", "thr", "bodies", "joint", "mean ms", "min ms", "p50 ms", "p90 ms", "p99 ms", "max ms", "speedup", "effic");
+
+	std::vector<BenchResult> results;
+	for (size_t i = 0; i < options.m_scenes.size(); i ++) {
+		const BenchScene& scene = GetBenchScene (options.m_scenes[i]);
+		const size_t first = results.size();
+		for (size_t j = 0; j < options.m_threads.size(); j ++) {
+			BenchResult result;
+			RunScene (scene, options.m_threads[j], options, result);
+			results.push_back (result);
+		}
+
+		std::vector<BenchResult> sceneResults (results.begin() + first, results.end());
+		CalculateScaling (sceneResults);
+		for (size_t j = 0; j < sceneResults.size(); j ++) {
+			results[first + j] = sceneResults[j];
+			PrintResult (sceneResults[j]);
+		}
+		fflush (stdout);
+	}
+
+	bool succeeded = true;
+	if (options.m_jsonFile) {
+		succeeded &= WriteJson (options.m_jsonFile, options, results);
+	}
+	if (options.m_csvFile) {
+		succeeded &= WriteCsv (options.m_csvFile, results);
+	}
+	return succeeded ? 0 : 1;
+}
@@ -13,14 +13,31 @@
 #include "dMaterialPairManager.h"
 
 
-dMaterialPairManager::dMaterialPairManager ()
+dMaterialPairManager::dMaterialPairManager (const NewtonWorld* const world)
 	:dNewtonAlloc()
 	,m_default()
 	,m_maxCount(8)
 	,m_entryCount(0)
 {
-	memset (m_cachedKeys, -1, sizeof(m_cachedKeys));
-	memset (m_cachedMaterial, 0, sizeof(m_cachedMaterial));
+	Init (NewtonGetMaxThreadsCount(world));
+}
+
+dMaterialPairManager::dMaterialPairManager (int maxThreadsCount)
+	:dNewtonAlloc()
+	,m_default()
+	,m_maxCount(8)
+	,m_entryCount(0)
+{
+	Init (maxThreadsCount);
+}
+
+void dMaterialPairManager::Init (int maxThreadsCount)
+{
+	m_maxThreadsCount = maxThreadsCount;
+	m_cachedKeys = new unsigned[m_maxThreadsCount];
+	m_cachedMaterial = new dMaterialPair*[m_maxThreadsCount];
+	memset (m_cachedKeys, -1, m_maxThreadsCount * sizeof(unsigned));
+	memset (m_cachedMaterial, 0, m_maxThreadsCount * sizeof(dMaterialPair*));
 	m_keys = new unsigned[m_maxCount];
 	m_pool = new dMaterialPair[m_maxCount];
 }
@@ -29,6 +46,8 @@ dMaterialPairManager::~dMaterialPairManager ()
 {
 	delete[] m_keys;
 	delete[] m_pool;
+	delete[] m_cachedKeys;
+	delete[] m_cachedMaterial;
 }
 
 
@@ -66,35 +85,42 @@ const dMaterialPairManager::dMaterialPair* dMaterialPairManager::GetPair (int ma
 {
 	unsigned key = MakeKey (materialId_0, materialId_1);
 
+	if (threadIndex >= m_maxThreadsCount) {
+		return FindPair (key);
+	}
+
 	if (m_cachedKeys[threadIndex] != key) {
 		m_cachedKeys[threadIndex] = key;
+		m_cachedMaterial[threadIndex] = FindPair (key);
+	}
+	return m_cachedMaterial[threadIndex];
+}
 
-		int index0 = 0;
-		int index2 = m_entryCount - 1;
-		unsigned key0 = m_keys[index0];
-		unsigned key2 = m_keys[index2];
-		while ((index2 - index0) > 4) {
-			int index1 = (index0 + index2) >> 1;
-			unsigned key1 = m_keys[index1];
-
-			if (key < key1) {
-				index2 = index1;
-				key2 = key1;
-			} else {
-				index0 = index1;
-				key0 = key1;
-			}
+dMaterialPairManager::dMaterialPair* dMaterialPairManager::FindPair (unsigned key) const
+{
+	int index0 = 0;
+	int index2 = m_entryCount - 1;
+	unsigned key0 = m_keys[index0];
+	unsigned key2 = m_keys[index2];
+	while ((index2 - index0) > 4) {
+		int index1 = (index0 + index2) >> 1;
+		unsigned key1 = m_keys[index1];
+
+		if (key < key1) {
+			index2 = index1;
+			key2 = key1;
+		} else {
+			index0 = index1;
+			key0 = key1;
 		}
+	}
 
-		index2 = dMin (m_entryCount, index2 + 4);
-		for (int i = index0; (i <= index2) && (m_keys[i] <= key); i ++) {
-			if (m_keys[i] == key) {
-				m_cachedMaterial[threadIndex] = &m_pool[i];
-				return m_cachedMaterial[threadIndex];
-			}
+	index2 = dMin (m_entryCount, index2 + 4);
+	for (int i = index0; (i <= index2) && (m_keys[i] <= key); i ++) {
+		if (m_keys[i] == key) {
+			return &m_pool[i];
 		}
-		m_cachedMaterial[threadIndex] = &m_default;
 	}
-	return m_cachedMaterial[threadIndex];
+	return &m_default;
 }
 
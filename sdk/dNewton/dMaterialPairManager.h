@@ -44,7 +44,10 @@ class dMaterialPairManager: public dNewtonAlloc
 		friend class dMaterialPairManager;
 	};
 
-	CNEWTON_API dMaterialPairManager ();
+	// the last pair found by each thread is cached, the cache is sized by the world's maximum thread count
+	// or by maxThreadsCount, a thread index past the end of the cache looks up the pair without caching it
+	CNEWTON_API dMaterialPairManager (const NewtonWorld* const world);
+	CNEWTON_API dMaterialPairManager (int maxThreadsCount = 16);
 	CNEWTON_API ~dMaterialPairManager ();
 	
 	dMaterialPair* GetDefaultPair ()
@@ -56,6 +59,9 @@ class dMaterialPairManager: public dNewtonAlloc
 	CNEWTON_API const dMaterialPair* GetPair (int materialId_0, int materialId_1, int threadIndex = 0) const;
 
 	private:
+	void Init (int maxThreadsCount);
+	dMaterialPair* FindPair (unsigned key) const;
+
 	unsigned MakeKey (int id0, int id1) const
 	{
 		id0 &= 0xff;
@@ -65,8 +71,9 @@ class dMaterialPairManager: public dNewtonAlloc
 	
 
 	mutable dMaterialPair m_default;
-	mutable unsigned m_cachedKeys[16];
-	mutable dMaterialPair* m_cachedMaterial[16];
+	mutable unsigned* m_cachedKeys;
+	mutable dMaterialPair** m_cachedMaterial;
+	int m_maxThreadsCount;
 	int m_maxCount;
 	int m_entryCount;
 	unsigned* m_keys;
@@ -44,6 +44,8 @@
 #include "dgRandom.h"
 #include "dgThread.h"
 #include "dgFastQueue.h"
+#include "dgFrameArena.h"
+#include "dgWorkStealingQueue.h"
 #include "dgPolyhedra.h"
 #include "dgThreadHive.h"
 #include "dgPathFinder.h"
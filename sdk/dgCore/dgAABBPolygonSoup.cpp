@@ -26,9 +26,14 @@
 #include "dgMatrix.h"
 #include "dgAABBPolygonSoup.h"
 #include "dgPolygonSoupBuilder.h"
+#include "dgThreadHive.h"
 
 
 #define DG_STACK_DEPTH 512
+#define DG_BUILDER_SAH_BINS 16
+#define DG_BUILDER_PARALLEL_MIN_BOXES		(1024 * 4)
+#define DG_BUILDER_TASKS_PER_THREAD			8
+#define DG_ADJACENCY_FACES_PER_BATCH		64
 
 
 DG_MSC_VECTOR_ALIGMENT
@@ -106,16 +111,6 @@ class dgAABBPolygonSoup::dgNodeBuilder: public dgAABBPolygonSoup::dgNode
 		m_area = m_size.DotProduct4(m_size.ShiftTripleRight()).m_x;
 	}
 
-	static dgFloat32 CalculateSurfaceArea (dgNodeBuilder* const node0, dgNodeBuilder* const node1, dgVector& minBox, dgVector& maxBox)
-	{
-		minBox = node0->m_p0.GetMin(node1->m_p0);
-		maxBox = node0->m_p1.GetMax(node1->m_p1);
-
-		dgVector side0 ((maxBox - minBox).Scale4 (dgFloat32 (0.5f)));
-		dgVector side1 (side0.m_y, side0.m_z, side0.m_x, dgFloat32 (0.0f));
-		return side0.DotProduct4(side1).m_x;
-	}
-
 
 	dgVector m_p0;
 	dgVector m_p1;
@@ -139,92 +134,112 @@ class dgAABBPolygonSoup::dgNodeBuilder: public dgAABBPolygonSoup::dgNode
 class dgAABBPolygonSoup::dgSpliteInfo
 {
 	public:
+	// binned surface area heuristic split of the box centers, m_axis is the size of the left side
 	dgSpliteInfo (dgNodeBuilder* const boxArray, dgInt32 boxCount)
 	{
 		dgVector minP ( dgFloat32 (1.0e15f)); 
 		dgVector maxP (-dgFloat32 (1.0e15f)); 
+		dgVector minCenter ( dgFloat32 (1.0e15f)); 
+		dgVector maxCenter (-dgFloat32 (1.0e15f)); 
+		for (dgInt32 i = 0; i < boxCount; i ++) {
+			const dgNodeBuilder& box = boxArray[i];
+			minP = minP.GetMin (box.m_p0); 
+			maxP = maxP.GetMax (box.m_p1); 
+			minCenter = minCenter.GetMin (box.m_origin); 
+			maxCenter = maxCenter.GetMax (box.m_origin); 
+		}
 
-		if (boxCount == 2) {
-			m_axis = 1;
-			for (dgInt32 i = 0; i < boxCount; i ++) {
-				const dgNodeBuilder& box = boxArray[i];
-				const dgVector& p0 = box.m_p0;
-				const dgVector& p1 = box.m_p1;
-				minP = minP.GetMin (p0); 
-				maxP = maxP.GetMax (p1); 
-			}
-
-		} else {
-			dgVector median (dgFloat32 (0.0f));
-			dgVector varian (dgFloat32 (0.0f));
-			for (dgInt32 i = 0; i < boxCount; i ++) {
-				const dgNodeBuilder& box = boxArray[i];
-
-				const dgVector& p0 = box.m_p0;
-				const dgVector& p1 = box.m_p1;
-
-				minP = minP.GetMin (p0); 
-				maxP = maxP.GetMax (p1); 
-				dgVector p (dgVector::m_half * (p0 + p1));
-
-				median += p;
-				varian += p * p;
-			}
-
-			varian = varian.Scale4 (dgFloat32 (boxCount)) - median * median;
+		dgAssert (maxP.m_x - minP.m_x >= dgFloat32 (0.0f));
+		dgAssert (maxP.m_y - minP.m_y >= dgFloat32 (0.0f));
+		dgAssert (maxP.m_z - minP.m_z >= dgFloat32 (0.0f));
+		m_p0 = minP;
+		m_p1 = maxP;
+		m_axis = boxCount / 2;
+
+		if (boxCount > 2) {
+			dgInt32 bestAxis = -1;
+			dgInt32 bestBin = 0;
+			dgFloat32 bestCost = dgFloat32 (1.0e30f);
+			for (dgInt32 axis = 0; axis < 3; axis ++) {
+				const dgFloat32 extent = maxCenter[axis] - minCenter[axis];
+				if (extent > dgFloat32 (1.0e-6f)) {
+					dgInt32 binCount[DG_BUILDER_SAH_BINS];
+					dgVector binP0[DG_BUILDER_SAH_BINS];
+					dgVector binP1[DG_BUILDER_SAH_BINS];
+					for (dgInt32 i = 0; i < DG_BUILDER_SAH_BINS; i ++) {
+						binCount[i] = 0;
+						binP0[i] = dgVector ( dgFloat32 (1.0e15f));
+						binP1[i] = dgVector (-dgFloat32 (1.0e15f));
+					}
 
-			dgInt32 index = 0;
-			dgFloat32 maxVarian = dgFloat32 (-1.0e10f);
-			for (dgInt32 i = 0; i < 3; i ++) {
-				if (varian[i] > maxVarian) {
-					index = i;
-					maxVarian = varian[i];
-				}
-			}
+					const dgFloat32 scale = dgFloat32 (DG_BUILDER_SAH_BINS) / extent;
+					for (dgInt32 i = 0; i < boxCount; i ++) {
+						const dgNodeBuilder& box = boxArray[i];
+						const dgInt32 bin = GetBin (box, axis, minCenter[axis], scale);
+						binCount[bin] ++;
+						binP0[bin] = binP0[bin].GetMin (box.m_p0);
+						binP1[bin] = binP1[bin].GetMax (box.m_p1);
+					}
 
-			dgVector center = median.Scale4 (dgFloat32 (1.0f) / dgFloat32 (boxCount));
-			dgFloat32 test = center[index];
-			dgInt32 i0 = 0;
-			dgInt32 i1 = boxCount - 1;
-			do {    
-				for (; i0 <= i1; i0 ++) {
-					const dgNodeBuilder& box = boxArray[i0];
-					dgFloat32 val = (box.m_p0[index] + box.m_p1[index]) * dgFloat32 (0.5f);
-					if (val > test) {
-						break;
+					dgInt32 rightCount[DG_BUILDER_SAH_BINS];
+					dgFloat32 rightArea[DG_BUILDER_SAH_BINS];
+					dgInt32 count = 0;
+					dgVector p0 ( dgFloat32 (1.0e15f));
+					dgVector p1 (-dgFloat32 (1.0e15f));
+					for (dgInt32 i = DG_BUILDER_SAH_BINS - 1; i > 0; i --) {
+						count += binCount[i];
+						p0 = p0.GetMin (binP0[i]);
+						p1 = p1.GetMax (binP1[i]);
+						rightCount[i] = count;
+						rightArea[i] = CalculateArea (p0, p1);
 					}
-				}
 
-				for (; i1 >= i0; i1 --) {
-					const dgNodeBuilder& box = boxArray[i1];
-					dgFloat32 val = (box.m_p0[index] + box.m_p1[index]) * dgFloat32 (0.5f);
-					if (val < test) {
-						break;
+					count = 0;
+					p0 = dgVector ( dgFloat32 (1.0e15f));
+					p1 = dgVector (-dgFloat32 (1.0e15f));
+					for (dgInt32 i = 1; i < DG_BUILDER_SAH_BINS; i ++) {
+						count += binCount[i - 1];
+						p0 = p0.GetMin (binP0[i - 1]);
+						p1 = p1.GetMax (binP1[i - 1]);
+						if (count && rightCount[i]) {
+							const dgFloat32 cost = CalculateArea (p0, p1) * dgFloat32 (count) + rightArea[i] * dgFloat32 (rightCount[i]);
+							if (cost < bestCost) {
+								bestCost = cost;
+								bestAxis = axis;
+								bestBin = i;
+							}
+						}
 					}
 				}
+			}
 
-				if (i0 < i1)	{
-					dgSwap(boxArray[i0], boxArray[i1]);
-					i0++; 
-					i1--;
+			if (bestAxis >= 0) {
+				const dgFloat32 scale = dgFloat32 (DG_BUILDER_SAH_BINS) / (maxCenter[bestAxis] - minCenter[bestAxis]);
+				dgInt32 i0 = 0;
+				dgInt32 i1 = boxCount - 1;
+				while (i0 <= i1) {
+					if (GetBin (boxArray[i0], bestAxis, minCenter[bestAxis], scale) < bestBin) {
+						i0 ++;
+					} else {
+						dgSwap (boxArray[i0], boxArray[i1]);
+						i1 --;
+					}
 				}
-			} while (i0 <= i1);
-
-			if (i0 > 0){
-				i0 --;
+				dgAssert ((i0 > 0) && (i0 < boxCount));
+				m_axis = i0;
 			}
-			if ((i0 + 1) >= boxCount) {
-				i0 = boxCount - 2;
-			}
-
-			m_axis = i0 + 1;
 		}
+	}
 
-		dgAssert (maxP.m_x - minP.m_x >= dgFloat32 (0.0f));
-		dgAssert (maxP.m_y - minP.m_y >= dgFloat32 (0.0f));
-		dgAssert (maxP.m_z - minP.m_z >= dgFloat32 (0.0f));
-		m_p0 = minP;
-		m_p1 = maxP;
+	static DG_INLINE dgInt32 GetBin (const dgNodeBuilder& box, dgInt32 axis, dgFloat32 origin, dgFloat32 scale)
+	{
+		return dgClamp (dgInt32 ((box.m_origin[axis] - origin) * scale), 0, DG_BUILDER_SAH_BINS - 1);
+	}
+
+	static DG_INLINE dgFloat32 CalculateArea (const dgVector& p0, const dgVector& p1)
+	{
+		const dgVector size ((p1 - p0) & dgVector::m_triplexMask);
+		return size.DotProduct4(size.ShiftTripleRight()).GetScalar();
 	}
 
 	dgInt32 m_axis;
@@ -240,160 +255,29 @@ dgAABBPolygonSoup::dgAABBPolygonSoup ()
 	,m_indexCount(0)
 	,m_aabb(NULL)
 	,m_indices(NULL)
+	,m_compressedAabb(NULL)
+	,m_compressedGroupCount(0)
+	,m_compressedBox0(dgFloat32 (0.0f))
+	,m_compressedBox1(dgFloat32 (0.0f))
+	,m_inPlace(false)
 {
 }
 
 dgAABBPolygonSoup::~dgAABBPolygonSoup ()
 {
+	if (m_inPlace) {
+		// the arrays belong to the image this tree was loaded from
+		m_localVertex = NULL;
+		return;
+	}
 	if (m_aabb) {
 		dgFreeStack (m_aabb);
-		dgFreeStack (m_indices);
 	}
-}
-
-
-void dgAABBPolygonSoup::ImproveNodeFitness (dgNodeBuilder* const node) const
-{
-	dgAssert (node->m_left);
-	dgAssert (node->m_right);
-
-	if (node->m_parent)	{
-		if (node->m_parent->m_left == node) {
-			dgFloat32 cost0 = node->m_area;
-
-			dgVector cost1P0;
-			dgVector cost1P1;		
-			dgFloat32 cost1 = dgNodeBuilder::CalculateSurfaceArea (node->m_right, node->m_parent->m_right, cost1P0, cost1P1);
-
-			dgVector cost2P0;
-			dgVector cost2P1;		
-			dgFloat32 cost2 = dgNodeBuilder::CalculateSurfaceArea (node->m_left, node->m_parent->m_right, cost2P0, cost2P1);
-
-			if ((cost1 <= cost0) && (cost1 <= cost2)) {
-				dgNodeBuilder* const parent = node->m_parent;
-				node->m_p0 = parent->m_p0;
-				node->m_p1 = parent->m_p1;
-				node->m_area = parent->m_area; 
-				node->m_size = parent->m_size;
-				node->m_origin = parent->m_origin;
-
-				if (parent->m_parent) {
-					if (parent->m_parent->m_left == parent) {
-						parent->m_parent->m_left = node;
-					} else {
-						dgAssert (parent->m_parent->m_right == parent);
-						parent->m_parent->m_right = node;
-					}
-				}
-				node->m_parent = parent->m_parent;
-				parent->m_parent = node;
-				node->m_right->m_parent = parent;
-				parent->m_left = node->m_right;
-				node->m_right = parent;
-				parent->m_p0 = cost1P0;
-				parent->m_p1 = cost1P1;		
-				parent->m_area = cost1;
-				parent->m_size = (parent->m_p1 - parent->m_p0).Scale3(dgFloat32 (0.5f));
-				parent->m_origin = (parent->m_p1 + parent->m_p0).Scale3(dgFloat32 (0.5f));
-
-			} else if ((cost2 <= cost0) && (cost2 <= cost1)) {
-				dgNodeBuilder* const parent = node->m_parent;
-				node->m_p0 = parent->m_p0;
-				node->m_p1 = parent->m_p1;
-				node->m_area = parent->m_area; 
-				node->m_size = parent->m_size;
-				node->m_origin = parent->m_origin;
-
-				if (parent->m_parent) {
-					if (parent->m_parent->m_left == parent) {
-						parent->m_parent->m_left = node;
-					} else {
-						dgAssert (parent->m_parent->m_right == parent);
-						parent->m_parent->m_right = node;
-					}
-				}
-				node->m_parent = parent->m_parent;
-				parent->m_parent = node;
-				node->m_left->m_parent = parent;
-				parent->m_left = node->m_left;
-				node->m_left = parent;
-
-				parent->m_p0 = cost2P0;
-				parent->m_p1 = cost2P1;		
-				parent->m_area = cost2;
-				parent->m_size = (parent->m_p1 - parent->m_p0).Scale3(dgFloat32 (0.5f));
-				parent->m_origin = (parent->m_p1 + parent->m_p0).Scale3(dgFloat32 (0.5f));
-			}
-		} else {
-			dgFloat32 cost0 = node->m_area;
-
-			dgVector cost1P0;
-			dgVector cost1P1;		
-			dgFloat32 cost1 = dgNodeBuilder::CalculateSurfaceArea (node->m_left, node->m_parent->m_left, cost1P0, cost1P1);
-
-			dgVector cost2P0;
-			dgVector cost2P1;		
-			dgFloat32 cost2 = dgNodeBuilder::CalculateSurfaceArea (node->m_right, node->m_parent->m_left, cost2P0, cost2P1);
-
-			if ((cost1 <= cost0) && (cost1 <= cost2)) {
-				dgNodeBuilder* const parent = node->m_parent;
-				node->m_p0 = parent->m_p0;
-				node->m_p1 = parent->m_p1;
-				node->m_area = parent->m_area; 
-				node->m_size = parent->m_size;
-				node->m_origin = parent->m_origin;
-
-				if (parent->m_parent) {
-					if (parent->m_parent->m_left == parent) {
-						parent->m_parent->m_left = node;
-					} else {
-						dgAssert (parent->m_parent->m_right == parent);
-						parent->m_parent->m_right = node;
-					}
-				}
-				node->m_parent = parent->m_parent;
-				parent->m_parent = node;
-				node->m_left->m_parent = parent;
-				parent->m_right = node->m_left;
-				node->m_left = parent;
-
-				parent->m_p0 = cost1P0;
-				parent->m_p1 = cost1P1;		
-				parent->m_area = cost1;
-				parent->m_size = (parent->m_p1 - parent->m_p0).Scale3(dgFloat32 (0.5f));
-				parent->m_origin = (parent->m_p1 + parent->m_p0).Scale3(dgFloat32 (0.5f));
-
-			} else if ((cost2 <= cost0) && (cost2 <= cost1)) {
-				dgNodeBuilder* const parent = node->m_parent;
-				node->m_p0 = parent->m_p0;
-				node->m_p1 = parent->m_p1;
-				node->m_area = parent->m_area; 
-				node->m_size = parent->m_size;
-				node->m_origin = parent->m_origin;
-
-				if (parent->m_parent) {
-					if (parent->m_parent->m_left == parent) {
-						parent->m_parent->m_left = node;
-					} else {
-						dgAssert (parent->m_parent->m_right == parent);
-						parent->m_parent->m_right = node;
-					}
-				}
-				node->m_parent = parent->m_parent;
-				parent->m_parent = node;
-				node->m_right->m_parent = parent;
-				parent->m_right = node->m_right;
-				node->m_right = parent;
-
-				parent->m_p0 = cost2P0;
-				parent->m_p1 = cost2P1;		
-				parent->m_area = cost2;
-				parent->m_size = (parent->m_p1 - parent->m_p0).Scale3(dgFloat32 (0.5f));
-				parent->m_origin = (parent->m_p1 + parent->m_p0).Scale3(dgFloat32 (0.5f));
-			}
-		}
-	} else {
-		// in the future I can handle this but it is too much work for little payoff
+	if (m_compressedAabb) {
+		dgFreeStack (m_compressedAabb);
+	}
+	if (m_indices) {
+		dgFreeStack (m_indices);
 	}
 }
 
@@ -433,8 +317,8 @@ dgFloat32 dgAABBPolygonSoup::CalculateFaceMaxSize (const dgVector* const vertex,
 
 void dgAABBPolygonSoup::GetAABB (dgVector& p0, dgVector& p1) const
 {
-	if (m_aabb) { 
-		GetNodeAABB (m_aabb, p0, p1);
+	if (m_aabb || m_compressedAabb) { 
+		GetNodeAABB (GetRootNode(), m_compressedBox0, m_compressedBox1, p0, p1);
 	} else {
 		p0 = dgVector (dgFloat32 (0.0f));
 		p1 = dgVector (dgFloat32 (0.0f));
@@ -443,13 +327,84 @@ void dgAABBPolygonSoup::GetAABB (dgVector& p0, dgVector& p1) const
 
 
 
-void dgAABBPolygonSoup::CalculateAdjacendy ()
+class dgAABBPolygonSoup::dgBuildTask
 {
-	dgVector p0;
-	dgVector p1;
-	GetAABB (p0, p1);
-	dgFastAABBInfo box (p0, p1);
-	ForAllSectors (box, dgVector (dgFloat32 (0.0f)), dgFloat32 (1.0f), CalculateAllFaceEdgeNormals, this);
+	public:
+	dgInt32 m_firstBox;
+	dgInt32 m_lastBox;
+	dgNodeBuilder* m_parent;
+	dgNodeBuilder** m_link;
+};
+
+class dgAABBPolygonSoup::dgBuildContext
+{
+	public:
+	const dgAABBPolygonSoup* m_me;
+	dgNodeBuilder* m_leafArray;
+	dgNodeBuilder* m_nodeArray;
+	dgBuildTask* m_tasks;
+	dgInt32 m_taskCount;
+	dgInt32 m_taskIndex;
+	dgInt32 m_minTaskSize;
+};
+
+class dgAABBPolygonSoup::dgAdjacencyContext
+{
+	public:
+	dgAABBPolygonSoup* m_me;
+	const dgNode::dgLeafNodePtr* m_faces;
+	dgInt32 m_faceCount;
+	dgInt32 m_faceIndex;
+};
+
+void dgAABBPolygonSoup::CalculateAdjacendyKernel (void* const context, void* const worker, dgInt32 threadID)
+{
+	dgAdjacencyContext* const data = (dgAdjacencyContext*) context;
+	dgAABBPolygonSoup* const me = data->m_me;
+	const dgFloat32* const vertexArray = me->GetLocalVertexPool();
+	for (dgInt32 i = dgAtomicExchangeAndAdd (&data->m_faceIndex, DG_ADJACENCY_FACES_PER_BATCH); i < data->m_faceCount; i = dgAtomicExchangeAndAdd (&data->m_faceIndex, DG_ADJACENCY_FACES_PER_BATCH)) {
+		const dgInt32 count = dgMin (data->m_faceCount - i, DG_ADJACENCY_FACES_PER_BATCH);
+		for (dgInt32 j = 0; j < count; j ++) {
+			const dgNode::dgLeafNodePtr face = data->m_faces[i + j];
+			CalculateAllFaceEdgeNormals (me, vertexArray, sizeof (dgTriplex), &me->m_indices[face.GetIndex()], dgInt32 (face.GetCount()), dgFloat32 (0.0f));
+		}
+	}
+}
+
+void dgAABBPolygonSoup::CalculateAdjacendy (dgThreadHive* const threadPool)
+{
+	dgAssert (!m_compressedAabb);
+
+	// a face only writes its own edge normals and only reads its neighbors' vertices, 
+	// so all faces can be processed concurrently
+	dgStack<dgNode::dgLeafNodePtr> faces (m_nodesCount * 2);
+	dgInt32 faceCount = 0;
+	for (dgInt32 i = 0; i < m_nodesCount; i ++) {
+		const dgNode* const node = &m_aabb[i];
+		if (node->m_left.IsLeaf() && node->m_left.GetCount()) {
+			faces[faceCount] = node->m_left;
+			faceCount ++;
+		}
+		if (node->m_right.IsLeaf() && node->m_right.GetCount()) {
+			faces[faceCount] = node->m_right;
+			faceCount ++;
+		}
+	}
+
+	dgAdjacencyContext context;
+	context.m_me = this;
+	context.m_faces = &faces[0];
+	context.m_faceCount = faceCount;
+	context.m_faceIndex = 0;
+	if (threadPool && (threadPool->GetThreadCount() > 1) && (faceCount >= DG_BUILDER_PARALLEL_MIN_BOXES)) {
+		const dgInt32 threadCount = threadPool->GetThreadCount();
+		for (dgInt32 i = 0; i < threadCount; i ++) {
+			threadPool->QueueJob (CalculateAdjacendyKernel, &context, NULL);
+		}
+		threadPool->SynchronizationBarrier();
+	} else {
+		CalculateAdjacendyKernel (&context, NULL, 0);
+	}
 
 	dgStack<dgTriplex> pool ((m_indexCount / 2) - 1);
 	const dgTriplex* const vertexArray = (dgTriplex*)GetLocalVertexPool();
@@ -704,7 +659,7 @@ dgIntersectStatus dgAABBPolygonSoup::CalculateDisjointedFaceEdgeNormals (void* c
 
 
 
-dgAABBPolygonSoup::dgNodeBuilder* dgAABBPolygonSoup::BuildTopDown (dgNodeBuilder* const leafArray, dgInt32 firstBox, dgInt32 lastBox, dgNodeBuilder** const allocator) const
+dgAABBPolygonSoup::dgNodeBuilder* dgAABBPolygonSoup::BuildTopDown (dgNodeBuilder* const leafArray, dgInt32 firstBox, dgInt32 lastBox, dgNodeBuilder* const nodeArray) const
 {
 	dgAssert (firstBox >= 0);
 	dgAssert (lastBox >= 0);
@@ -714,14 +669,14 @@ dgAABBPolygonSoup::dgNodeBuilder* dgAABBPolygonSoup::BuildTopDown (dgNodeBuilder
 	} else {
 		dgSpliteInfo info (&leafArray[firstBox], lastBox - firstBox + 1);
 
-		dgNodeBuilder* const parent = new (*allocator) dgNodeBuilder (info.m_p0, info.m_p1);
-		*allocator = *allocator + 1;
+		// each parent takes the slot of the gap between its two children, so subtrees can be built in any order
+		dgNodeBuilder* const parent = new (&nodeArray[firstBox + info.m_axis - 1]) dgNodeBuilder (info.m_p0, info.m_p1);
 
 		dgAssert (parent);
-		parent->m_right = BuildTopDown (leafArray, firstBox + info.m_axis, lastBox, allocator);
+		parent->m_right = BuildTopDown (leafArray, firstBox + info.m_axis, lastBox, nodeArray);
 		parent->m_right->m_parent = parent;
 
-		parent->m_left = BuildTopDown (leafArray, firstBox, firstBox + info.m_axis - 1, allocator);
+		parent->m_left = BuildTopDown (leafArray, firstBox, firstBox + info.m_axis - 1, nodeArray);
 		parent->m_left->m_parent = parent;
 		return parent;
 	}
@@ -731,7 +686,64 @@ dgAABBPolygonSoup::dgNodeBuilder* dgAABBPolygonSoup::BuildTopDown (dgNodeBuilder
 
 
 
-void dgAABBPolygonSoup::Create (const dgPolygonSoupDatabaseBuilder& builder, bool optimizedBuild)
+dgAABBPolygonSoup::dgNodeBuilder* dgAABBPolygonSoup::BuildTopDownTasks (dgBuildContext& context, dgInt32 firstBox, dgInt32 lastBox, dgNodeBuilder* const parent, dgNodeBuilder** const link) const
+{
+	if ((lastBox - firstBox + 1) <= context.m_minTaskSize) {
+		dgBuildTask& task = context.m_tasks[context.m_taskCount];
+		task.m_firstBox = firstBox;
+		task.m_lastBox = lastBox;
+		task.m_parent = parent;
+		task.m_link = link;
+		context.m_taskCount ++;
+		return NULL;
+	}
+
+	dgSpliteInfo info (&context.m_leafArray[firstBox], lastBox - firstBox + 1);
+	dgNodeBuilder* const node = new (&context.m_nodeArray[firstBox + info.m_axis - 1]) dgNodeBuilder (info.m_p0, info.m_p1);
+	node->m_parent = parent;
+	node->m_right = BuildTopDownTasks (context, firstBox + info.m_axis, lastBox, node, &node->m_right);
+	node->m_left = BuildTopDownTasks (context, firstBox, firstBox + info.m_axis - 1, node, &node->m_left);
+	return node;
+}
+
+void dgAABBPolygonSoup::BuildTopDownKernel (void* const context, void* const worker, dgInt32 threadID)
+{
+	dgBuildContext* const data = (dgBuildContext*) context;
+	for (dgInt32 i = dgAtomicExchangeAndAdd (&data->m_taskIndex, 1); i < data->m_taskCount; i = dgAtomicExchangeAndAdd (&data->m_taskIndex, 1)) {
+		const dgBuildTask& task = data->m_tasks[i];
+		dgNodeBuilder* const node = data->m_me->BuildTopDown (data->m_leafArray, task.m_firstBox, task.m_lastBox, data->m_nodeArray);
+		node->m_parent = task.m_parent;
+		*task.m_link = node;
+	}
+}
+
+dgAABBPolygonSoup::dgNodeBuilder* dgAABBPolygonSoup::BuildTopDownParallel (dgNodeBuilder* const leafArray, dgInt32 boxCount, dgNodeBuilder* const nodeArray, dgThreadHive* const threadPool) const
+{
+	// split the top of the tree serially, then build the remaining subtrees on the worker threads.
+	// since every node slot is a function of its box range only, the result does not depend on the thread count
+	const dgInt32 threadCount = threadPool->GetThreadCount();
+	dgStack<dgBuildTask> tasks (boxCount);
+
+	dgBuildContext context;
+	context.m_me = this;
+	context.m_leafArray = leafArray;
+	context.m_nodeArray = nodeArray;
+	context.m_tasks = &tasks[0];
+	context.m_taskCount = 0;
+	context.m_taskIndex = 0;
+	context.m_minTaskSize = dgMax (boxCount / (threadCount * DG_BUILDER_TASKS_PER_THREAD), 2);
+
+	dgNodeBuilder* const root = BuildTopDownTasks (context, 0, boxCount - 1, NULL, NULL);
+	dgAssert (root);
+
+	for (dgInt32 i = 0; i < threadCount; i ++) {
+		threadPool->QueueJob (BuildTopDownKernel, &context, NULL);
+	}
+	threadPool->SynchronizationBarrier();
+	return root;
+}
+
+void dgAABBPolygonSoup::Create (const dgPolygonSoupDatabaseBuilder& builder, bool optimizedBuild, dgThreadHive* const threadPool)
 {
 	if (builder.m_faceCount == 0) {
 		return;
@@ -773,50 +785,14 @@ void dgAABBPolygonSoup::Create (const dgPolygonSoupDatabaseBuilder& builder, boo
 		polygonIndex += (indexCount + 1);
 	}
 
-	dgNodeBuilder* contructorAllocator = &constructor[allocatorIndex];
-	dgNodeBuilder* root = BuildTopDown (&constructor[0], 0, allocatorIndex - 1, &contructorAllocator);
+	dgNodeBuilder* root = NULL;
+	if (threadPool && (threadPool->GetThreadCount() > 1) && (allocatorIndex >= DG_BUILDER_PARALLEL_MIN_BOXES)) {
+		root = BuildTopDownParallel (&constructor[0], allocatorIndex, &constructor[allocatorIndex], threadPool);
+	} else {
+		root = BuildTopDown (&constructor[0], 0, allocatorIndex - 1, &constructor[allocatorIndex]);
+	}
 
 	dgAssert (root);
-	if (root->m_left) {
-
-		dgAssert (root->m_right);
-		dgList<dgNodeBuilder*> list (builder.m_allocator);
-		dgList<dgNodeBuilder*> stack (builder.m_allocator);
-		stack.Append(root);
-		while (stack.GetCount()) {
-			dgList<dgNodeBuilder*>::dgListNode* const stackNode = stack.GetLast();
-			dgNodeBuilder* const node = stackNode->GetInfo();
-			stack.Remove(stackNode);
-
-			if (node->m_left) {
-				dgAssert (node->m_right);
-				list.Append(node);
-				stack.Append(node->m_right);
-				stack.Append(node->m_left);
-			} 
-		}
-
-		dgFloat64 newCost = dgFloat32 (1.0e20f);
-		dgFloat64 prevCost = newCost;
-		do {
-			prevCost = newCost;
-			for (dgList<dgNodeBuilder*>::dgListNode* listNode = list.GetFirst(); listNode; listNode = listNode->GetNext()) {
-				dgNodeBuilder* const node = listNode->GetInfo();
-				ImproveNodeFitness (node);
-			}
-
-			newCost = dgFloat32 (0.0f);
-			for (dgList<dgNodeBuilder*>::dgListNode* listNode = list.GetFirst(); listNode; listNode = listNode->GetNext()) {
-				dgNodeBuilder* const node = listNode->GetInfo();
-				newCost += node->m_area;
-			}
-		} while (newCost < (prevCost * dgFloat32 (0.9999f)));
-
-		root = list.GetLast()->GetInfo();
-		while (root->m_parent) {
-			root = root->m_parent;
-		}
-	}
 
 	dgList<dgNodeBuilder*> list (builder.m_allocator);
 
@@ -940,35 +916,225 @@ void dgAABBPolygonSoup::Create (const dgPolygonSoupDatabaseBuilder& builder, boo
 //	CalculateAdjacendy();
 }
 
+void dgAABBPolygonSoup::Compress ()
+{
+	if (!m_aabb) {
+		return;
+	}
+
+	// the root box is quantized relative to the float box of the tree
+	GetNodeBox (m_aabb, m_compressedBox0, m_compressedBox1);
+	m_compressedBox0 = m_compressedBox0 & dgVector::m_triplexMask;
+	m_compressedBox1 = m_compressedBox1 & dgVector::m_triplexMask;
+
+	// groups are filled breadth first from the subtree of their first node so that most children share the cache line of 
+	// their parent, free slots take the next subtree in the queue
+	dgStack<dgInt32> nodeMap (m_nodesCount);
+	dgStack<dgInt32> queue (m_nodesCount);
+	dgInt32 groupCount = 0;
+	dgInt32 nodeCount = 0;
+	dgInt32 queueHead = 0;
+	dgInt32 queueTail = 1;
+	queue[0] = 0;
+	while (queueHead < queueTail) {
+		dgInt32 localQueue[8];
+		dgInt32 localHead = 0;
+		dgInt32 localTail = 0;
+		for (dgInt32 slot = 0; (slot < 3) && ((localHead < localTail) || (queueHead < queueTail)); slot ++) {
+			dgInt32 index;
+			if (localHead < localTail) {
+				index = localQueue[localHead];
+				localHead ++;
+			} else {
+				index = queue[queueHead];
+				queueHead ++;
+			}
+			nodeMap[index] = (groupCount << 2) + slot;
+			nodeCount ++;
+
+			const dgNode& node = m_aabb[index];
+			if (!node.m_left.IsLeaf()) {
+				localQueue[localTail] = node.m_left.m_node;
+				localTail ++;
+			}
+			if (!node.m_right.IsLeaf()) {
+				localQueue[localTail] = node.m_right.m_node;
+				localTail ++;
+			}
+		}
+		for (; localHead < localTail; localHead ++) {
+			queue[queueTail] = localQueue[localHead];
+			queueTail ++;
+		}
+		groupCount ++;
+	}
+	dgAssert (nodeCount == m_nodesCount);
+
+	m_compressedGroupCount = groupCount;
+	m_compressedAabb = (dgCompressedNodeGroup*) dgMallocStack (sizeof (dgCompressedNodeGroup) * groupCount);
+	for (dgInt32 i = 0; i < groupCount; i ++) {
+		new (&m_compressedAabb[i]) dgCompressedNodeGroup;
+	}
+
+	dgInt32 boxBase = m_vertexCount;
+	dgInt32 boxEnd = 0;
+	for (dgInt32 i = 0; i < m_nodesCount; i ++) {
+		const dgNode& node = m_aabb[i];
+		dgCompressedNode& compressedNode = m_compressedAabb[nodeMap[i] >> 2].m_nodes[nodeMap[i] & 3];
+		compressedNode.m_left = node.m_left.IsLeaf() ? node.m_left : dgNode::dgLeafNodePtr (dgUnsigned32 (nodeMap[node.m_left.m_node]));
+		compressedNode.m_right = node.m_right.IsLeaf() ? node.m_right : dgNode::dgLeafNodePtr (dgUnsigned32 (nodeMap[node.m_right.m_node]));
+
+		boxBase = dgMin (boxBase, dgMin (node.m_indexBox0, node.m_indexBox1));
+		boxEnd = dgMax (boxEnd, dgMax (node.m_indexBox0, node.m_indexBox1) + 1);
+	}
+
+	// the boxes are quantized top down, so each child is quantized against the decoded box of its parent
+	dgInt32 stack = 1;
+	dgInt32 stackPool[DG_STACK_DEPTH];
+	dgVector parentBox[DG_STACK_DEPTH][2];
+	stackPool[0] = 0;
+	parentBox[0][0] = m_compressedBox0;
+	parentBox[0][1] = m_compressedBox1;
+	while (stack) {
+		stack --;
+		const dgInt32 index = stackPool[stack];
+		const dgNode& node = m_aabb[index];
+		dgCompressedNode& compressedNode = m_compressedAabb[nodeMap[index] >> 2].m_nodes[nodeMap[index] & 3];
+
+		dgVector p0;
+		dgVector p1;
+		GetNodeBox (&node, p0, p1);
+		EncodeNodeBox (compressedNode, parentBox[stack][0], parentBox[stack][1], p0, p1);
+		DecodeNodeBox (&compressedNode, parentBox[stack][0], parentBox[stack][1], p0, p1);
+
+		const dgNode::dgLeafNodePtr children[] = {node.m_left, node.m_right};
+		for (dgInt32 j = 0; j < 2; j ++) {
+			if (!children[j].IsLeaf()) {
+				dgAssert (stack < DG_STACK_DEPTH);
+				stackPool[stack] = children[j].m_node;
+				parentBox[stack][0] = p0;
+				parentBox[stack][1] = p1;
+				stack ++;
+			}
+		}
+	}
+
+	// remove the box corners from the vertex pool, they sit between the face normals and the edge normals
+	const dgInt32 boxCount = boxEnd - boxBase;
+	if (boxCount > 0) {
+		for (dgInt32 i = 0; i < m_nodesCount; i ++) {
+			const dgNode& node = m_aabb[i];
+			const dgNode::dgLeafNodePtr children[] = {node.m_left, node.m_right};
+			for (dgInt32 j = 0; j < 2; j ++) {
+				if (children[j].IsLeaf()) {
+					const dgInt32 vCount = dgInt32 (children[j].GetCount());
+					dgInt32* const face = &m_indices[children[j].GetIndex()];
+					for (dgInt32 k = 0; k < vCount * 2 + 2; k ++) {
+						// skip the face attribute
+						dgAssert ((k == vCount) || (face[k] < boxBase) || (face[k] >= boxEnd));
+						if ((k != vCount) && (face[k] >= boxEnd)) {
+							face[k] -= boxCount;
+						}
+					}
+				}
+			}
+		}
+
+		const dgTriplex* const vertexArray = (dgTriplex*)m_localVertex;
+		dgTriplex* const compactVertex = (dgTriplex*) dgMallocStack (sizeof (dgTriplex) * (m_vertexCount - boxCount));
+		memcpy (compactVertex, vertexArray, sizeof (dgTriplex) * boxBase);
+		memcpy (&compactVertex[boxBase], &vertexArray[boxEnd], sizeof (dgTriplex) * (m_vertexCount - boxEnd));
+		dgFreeStack (m_localVertex);
+		m_localVertex = &compactVertex[0].m_x;
+		m_vertexCount -= boxCount;
+	}
+
+	dgFreeStack (m_aabb);
+	m_aabb = NULL;
+}
+
+void dgAABBPolygonSoup::EncodeNodeBox (dgCompressedNode& node, const dgVector& parentP0, const dgVector& parentP1, const dgVector& p0, const dgVector& p1) const
+{
+	const dgVector scale ((parentP1 - parentP0) * dgVector (dgFloat32 (1.0f / 65000.0f)));
+	for (dgInt32 i = 0; i < 3; i ++) {
+		dgAssert ((p0[i] >= parentP0[i]) && (p1[i] <= parentP1[i]));
+		dgInt32 q0 = 0;
+		dgInt32 q1 = 0;
+		if (scale[i] > dgFloat32 (0.0f)) {
+			q0 = dgInt32 (dgFloor ((p0[i] - parentP0[i]) / scale[i])) - 1;
+			q1 = dgInt32 (dgCeil ((p1[i] - parentP0[i]) / scale[i])) + 1;
+		}
+		node.m_box[i] = dgUnsigned16 (dgClamp (q0, 0, 0xffff));
+		node.m_box[i + 3] = dgUnsigned16 (dgClamp (q1, 0, 0xffff));
+	}
+
+	// the decoding rounds too, step the bounds out until the decoded box contains the node box
+	for (dgInt32 i = 0; i < 3; i ++) {
+		dgVector q0;
+		dgVector q1;
+		DecodeNodeBox (&node, parentP0, parentP1, q0, q1);
+		while ((q0[i] > p0[i]) && node.m_box[i]) {
+			node.m_box[i] --;
+			DecodeNodeBox (&node, parentP0, parentP1, q0, q1);
+		}
+		while ((q1[i] < p1[i]) && (node.m_box[i + 3] < 0xffff)) {
+			node.m_box[i + 3] ++;
+			DecodeNodeBox (&node, parentP0, parentP1, q0, q1);
+		}
+		dgAssert ((q0[i] <= p0[i]) && (q1[i] >= p1[i]));
+	}
+}
+
 void dgAABBPolygonSoup::Serialize (dgSerialize callback, void* const userData) const
 {
+	// the second node count is negative for the compressed node format
+	dgInt32 nodeFormat = m_compressedAabb ? -m_compressedGroupCount : m_nodesCount;
 	callback (userData, &m_vertexCount, sizeof (dgInt32));
 	callback (userData, &m_indexCount, sizeof (dgInt32));
 	callback (userData, &m_nodesCount, sizeof (dgInt32));
-	callback (userData, &m_nodesCount, sizeof (dgInt32));
-	if (m_aabb) {
-		callback (userData,  m_localVertex, sizeof (dgTriplex) * m_vertexCount);
-		callback (userData,  m_indices, sizeof (dgInt32) * m_indexCount);
-		callback (userData, m_aabb, sizeof (dgNode) * m_nodesCount);
+	callback (userData, &nodeFormat, sizeof (dgInt32));
+	if (m_compressedAabb) {
+		dgTriplex quantization[2];
+		quantization[0].m_x = m_compressedBox0.m_x;
+		quantization[0].m_y = m_compressedBox0.m_y;
+		quantization[0].m_z = m_compressedBox0.m_z;
+		quantization[1].m_x = m_compressedBox1.m_x;
+		quantization[1].m_y = m_compressedBox1.m_y;
+		quantization[1].m_z = m_compressedBox1.m_z;
+		dgSerializeArray (callback, userData, m_localVertex, sizeof (dgTriplex) * m_vertexCount);
+		dgSerializeArray (callback, userData, m_indices, sizeof (dgInt32) * m_indexCount);
+		callback (userData, quantization, sizeof (quantization));
+		dgSerializeArray (callback, userData, m_compressedAabb, sizeof (dgCompressedNodeGroup) * m_compressedGroupCount);
+	} else if (m_aabb) {
+		dgSerializeArray (callback, userData, m_localVertex, sizeof (dgTriplex) * m_vertexCount);
+		dgSerializeArray (callback, userData, m_indices, sizeof (dgInt32) * m_indexCount);
+		dgSerializeArray (callback, userData, m_aabb, sizeof (dgNode) * m_nodesCount);
 	}
 }
 
 void dgAABBPolygonSoup::Deserialize (dgDeserialize callback, void* const userData, dgInt32 revisionNumber)
 {
+	dgInt32 nodeFormat;
 	m_strideInBytes = sizeof (dgTriplex);
 	callback (userData, &m_vertexCount, sizeof (dgInt32));
 	callback (userData, &m_indexCount, sizeof (dgInt32));
 	callback (userData, &m_nodesCount, sizeof (dgInt32));
-	callback (userData, &m_nodesCount, sizeof (dgInt32));
-
-	if (m_vertexCount) {
-		m_localVertex = (dgFloat32*) dgMallocStack (sizeof (dgTriplex) * m_vertexCount);
-		m_indices = (dgInt32*) dgMallocStack (sizeof (dgInt32) * m_indexCount);
-		m_aabb = (dgNode*) dgMallocStack (sizeof (dgNode) * m_nodesCount);
-
-		callback (userData, m_localVertex, sizeof (dgTriplex) * m_vertexCount);
-		callback (userData, m_indices, sizeof (dgInt32) * m_indexCount);
-		callback (userData, m_aabb, sizeof (dgNode) * m_nodesCount);
+	callback (userData, &nodeFormat, sizeof (dgInt32));
+
+	if (m_vertexCount && (nodeFormat < 0)) {
+		dgTriplex quantization[2];
+		m_compressedGroupCount = -nodeFormat;
+		m_localVertex = (dgFloat32*) dgDeserializeArray (callback, userData, sizeof (dgTriplex) * m_vertexCount, m_inPlace);
+		m_indices = (dgInt32*) dgDeserializeArray (callback, userData, sizeof (dgInt32) * m_indexCount, m_inPlace);
+		callback (userData, quantization, sizeof (quantization));
+		m_compressedAabb = (dgCompressedNodeGroup*) dgDeserializeArray (callback, userData, sizeof (dgCompressedNodeGroup) * m_compressedGroupCount, m_inPlace);
+		m_compressedBox0 = dgVector (quantization[0].m_x, quantization[0].m_y, quantization[0].m_z, dgFloat32 (0.0f));
+		m_compressedBox1 = dgVector (quantization[1].m_x, quantization[1].m_y, quantization[1].m_z, dgFloat32 (0.0f));
+		m_aabb = NULL;
+	} else if (m_vertexCount) {
+		m_localVertex = (dgFloat32*) dgDeserializeArray (callback, userData, sizeof (dgTriplex) * m_vertexCount, m_inPlace);
+		m_indices = (dgInt32*) dgDeserializeArray (callback, userData, sizeof (dgInt32) * m_indexCount, m_inPlace);
+		m_aabb = (dgNode*) dgDeserializeArray (callback, userData, sizeof (dgNode) * m_nodesCount, m_inPlace);
 	} else {
 		m_localVertex = NULL;
 		m_indices = NULL;
@@ -979,124 +1145,121 @@ void dgAABBPolygonSoup::Deserialize (dgDeserialize callback, void* const userDat
 
 dgVector dgAABBPolygonSoup::ForAllSectorsSupportVectex (const dgVector& dir) const
 {
-	dgVector supportVertex (dgFloat32 (0.0f));
-	if (m_aabb) {
-		dgFloat32 aabbProjection[DG_STACK_DEPTH];
-		const dgNode *stackPool[DG_STACK_DEPTH];
+	if (m_compressedAabb) {
+		return ForAllSectorsSupportVectexLow (GetCompressedRoot(), dir);
+	} else if (m_aabb) {
+		return ForAllSectorsSupportVectexLow<const dgNode*> (m_aabb, dir);
+	}
+	return dgVector (dgFloat32 (0.0f));
+}
 
-		dgInt32 stack = 1;
-		stackPool[0] = m_aabb;
-		aabbProjection[0] = dgFloat32 (1.0e10f);
-		const dgTriplex* const boxArray = (dgTriplex*)m_localVertex;
-		
+template<class dgNodeRef>
+dgVector dgAABBPolygonSoup::ForAllSectorsSupportVectexLow (const dgNodeRef& root, const dgVector& dir) const
+{
+	dgVector supportVertex (dgFloat32 (0.0f));
+	dgFloat32 aabbProjection[DG_STACK_DEPTH];
+	dgNodeRef stackPool[DG_STACK_DEPTH];
 
-		dgFloat32 maxProj = dgFloat32 (-1.0e20f); 
-		dgInt32 ix = (dir[0] > dgFloat32 (0.0f)) ? 1 : 0;
-		dgInt32 iy = (dir[1] > dgFloat32 (0.0f)) ? 1 : 0;
-		dgInt32 iz = (dir[2] > dgFloat32 (0.0f)) ? 1 : 0;
+	dgInt32 stack = 1;
+	stackPool[0] = root;
+	aabbProjection[0] = dgFloat32 (1.0e10f);
+	const dgTriplex* const boxArray = (dgTriplex*)m_localVertex;
+	
 
-		while (stack) {
-			dgFloat32 boxSupportValue;
-
-			stack--;
-			boxSupportValue = aabbProjection[stack];
-			if (boxSupportValue > maxProj) {
-				dgFloat32 backSupportDist = dgFloat32 (0.0f);
-				dgFloat32 frontSupportDist = dgFloat32 (0.0f);
-				const dgNode* const me = stackPool[stack];
-				if (me->m_left.IsLeaf()) {
-					backSupportDist = dgFloat32 (-1.0e20f);
-					dgInt32 index = dgInt32 (me->m_left.GetIndex());
-					dgInt32 vCount = me->m_left.GetCount();
-					dgVector vertex (dgFloat32 (0.0f));
-					for (dgInt32 j = 0; j < vCount; j ++) {
-						dgInt32 i0 = m_indices[index + j] * dgInt32 (sizeof (dgTriplex) / sizeof (dgFloat32));
-						dgVector p (&boxArray[i0].m_x);
-						dgFloat32 dist = p.DotProduct3 (dir);
-						if (dist > backSupportDist) {
-							backSupportDist = dist;
-							vertex = p;
-						}
-					}
+	dgFloat32 maxProj = dgFloat32 (-1.0e20f); 
+	dgInt32 ix = (dir[0] > dgFloat32 (0.0f)) ? 1 : 0;
+	dgInt32 iy = (dir[1] > dgFloat32 (0.0f)) ? 1 : 0;
+	dgInt32 iz = (dir[2] > dgFloat32 (0.0f)) ? 1 : 0;
 
-					if (backSupportDist > maxProj) {
-						maxProj = backSupportDist;
-						supportVertex = vertex; 
+	while (stack) {
+		dgFloat32 boxSupportValue;
+
+		stack--;
+		boxSupportValue = aabbProjection[stack];
+		if (boxSupportValue > maxProj) {
+			dgFloat32 backSupportDist = dgFloat32 (0.0f);
+			dgFloat32 frontSupportDist = dgFloat32 (0.0f);
+			const dgNodeRef me (stackPool[stack]);
+			if (me->m_left.IsLeaf()) {
+				backSupportDist = dgFloat32 (-1.0e20f);
+				dgInt32 index = dgInt32 (me->m_left.GetIndex());
+				dgInt32 vCount = me->m_left.GetCount();
+				dgVector vertex (dgFloat32 (0.0f));
+				for (dgInt32 j = 0; j < vCount; j ++) {
+					dgInt32 i0 = m_indices[index + j] * dgInt32 (sizeof (dgTriplex) / sizeof (dgFloat32));
+					dgVector p (&boxArray[i0].m_x);
+					dgFloat32 dist = p.DotProduct3 (dir);
+					if (dist > backSupportDist) {
+						backSupportDist = dist;
+						vertex = p;
 					}
+				}
 
-				} else {
-					dgVector box[2];
-					const dgNode* const node = me->m_left.GetNode(m_aabb);
-					box[0].m_x = boxArray[node->m_indexBox0].m_x;
-					box[0].m_y = boxArray[node->m_indexBox0].m_y;
-					box[0].m_z = boxArray[node->m_indexBox0].m_z;
-					box[1].m_x = boxArray[node->m_indexBox1].m_x;
-					box[1].m_y = boxArray[node->m_indexBox1].m_y;
-					box[1].m_z = boxArray[node->m_indexBox1].m_z;
-
-					dgVector supportPoint (box[ix].m_x, box[iy].m_y, box[iz].m_z, dgFloat32 (0.0));
-					backSupportDist = supportPoint.DotProduct3 (dir);
+				if (backSupportDist > maxProj) {
+					maxProj = backSupportDist;
+					supportVertex = vertex; 
 				}
 
-				if (me->m_right.IsLeaf()) {
-					frontSupportDist = dgFloat32 (-1.0e20f);
-					dgInt32 index = dgInt32 (me->m_right.GetIndex());
-					dgInt32 vCount = me->m_right.GetCount();
-					dgVector vertex (dgFloat32 (0.0f));
-					for (dgInt32 j = 0; j < vCount; j ++) {
-						dgInt32 i0 = m_indices[index + j] * dgInt32 (sizeof (dgTriplex) / sizeof (dgFloat32));
-						dgVector p (&boxArray[i0].m_x);
-						dgFloat32 dist = p.DotProduct3 (dir);
-						if (dist > frontSupportDist) {
-							frontSupportDist = dist;
-							vertex = p;
-						}
-					}
-					if (frontSupportDist > maxProj) {
-						maxProj = frontSupportDist;
-						supportVertex = vertex; 
-					}
+			} else {
+				dgVector box[2];
+				GetNodeBox (GetChildNode (me, me->m_left), box[0], box[1]);
 
-				} else {
-					dgVector box[2];
-					const dgNode* const node = me->m_right.GetNode(m_aabb);
-					box[0].m_x = boxArray[node->m_indexBox0].m_x;
-					box[0].m_y = boxArray[node->m_indexBox0].m_y;
-					box[0].m_z = boxArray[node->m_indexBox0].m_z;
-					box[1].m_x = boxArray[node->m_indexBox1].m_x;
-					box[1].m_y = boxArray[node->m_indexBox1].m_y;
-					box[1].m_z = boxArray[node->m_indexBox1].m_z;
-
-					dgVector supportPoint (box[ix].m_x, box[iy].m_y, box[iz].m_z, dgFloat32 (0.0f));
-					frontSupportDist = supportPoint.DotProduct3 (dir);
-				}
+				dgVector supportPoint (box[ix].m_x, box[iy].m_y, box[iz].m_z, dgFloat32 (0.0));
+				backSupportDist = supportPoint.DotProduct3 (dir);
+			}
 
-				if (frontSupportDist >= backSupportDist) {
-					if (!me->m_left.IsLeaf()) {
-						aabbProjection[stack] = backSupportDist;
-						stackPool[stack] = me->m_left.GetNode(m_aabb);
-						stack++;
+			if (me->m_right.IsLeaf()) {
+				frontSupportDist = dgFloat32 (-1.0e20f);
+				dgInt32 index = dgInt32 (me->m_right.GetIndex());
+				dgInt32 vCount = me->m_right.GetCount();
+				dgVector vertex (dgFloat32 (0.0f));
+				for (dgInt32 j = 0; j < vCount; j ++) {
+					dgInt32 i0 = m_indices[index + j] * dgInt32 (sizeof (dgTriplex) / sizeof (dgFloat32));
+					dgVector p (&boxArray[i0].m_x);
+					dgFloat32 dist = p.DotProduct3 (dir);
+					if (dist > frontSupportDist) {
+						frontSupportDist = dist;
+						vertex = p;
 					}
+				}
+				if (frontSupportDist > maxProj) {
+					maxProj = frontSupportDist;
+					supportVertex = vertex; 
+				}
 
-					if (!me->m_right.IsLeaf()) {
-						aabbProjection[stack] = frontSupportDist;
-						stackPool[stack] = me->m_right.GetNode(m_aabb);
-						stack++;
-					}
+			} else {
+				dgVector box[2];
+				GetNodeBox (GetChildNode (me, me->m_right), box[0], box[1]);
 
-				} else {
+				dgVector supportPoint (box[ix].m_x, box[iy].m_y, box[iz].m_z, dgFloat32 (0.0f));
+				frontSupportDist = supportPoint.DotProduct3 (dir);
+			}
 
-					if (!me->m_right.IsLeaf()) {
-						aabbProjection[stack] = frontSupportDist;
-						stackPool[stack] = me->m_right.GetNode(m_aabb);
-						stack++;
-					}
+			if (frontSupportDist >= backSupportDist) {
+				if (!me->m_left.IsLeaf()) {
+					aabbProjection[stack] = backSupportDist;
+					stackPool[stack] = GetChildNode (me, me->m_left);
+					stack++;
+				}
 
-					if (!me->m_left.IsLeaf()) {
-						aabbProjection[stack] = backSupportDist;
-						stackPool[stack] = me->m_left.GetNode(m_aabb);
-						stack++;
-					}
+				if (!me->m_right.IsLeaf()) {
+					aabbProjection[stack] = frontSupportDist;
+					stackPool[stack] = GetChildNode (me, me->m_right);
+					stack++;
+				}
+
+			} else {
+
+				if (!me->m_right.IsLeaf()) {
+					aabbProjection[stack] = frontSupportDist;
+					stackPool[stack] = GetChildNode (me, me->m_right);
+					stack++;
+				}
+
+				if (!me->m_left.IsLeaf()) {
+					aabbProjection[stack] = backSupportDist;
+					stackPool[stack] = GetChildNode (me, me->m_left);
+					stack++;
 				}
 			}
 		}
@@ -1107,22 +1270,35 @@ dgVector dgAABBPolygonSoup::ForAllSectorsSupportVectex (const dgVector& dir) con
 
 void dgAABBPolygonSoup::ForAllSectorsRayHit (const dgFastRayTest& raySrc, dgFloat32 maxParam, dgRayIntersectCallback callback, void* const context) const
 {
-	const dgNode *stackPool[DG_STACK_DEPTH];
+	if (m_compressedAabb) {
+		ForAllSectorsRayHitLow (GetCompressedRoot(), raySrc, maxParam, callback, context);
+	} else {
+		ForAllSectorsRayHitLow<const dgNode*> (m_aabb, raySrc, maxParam, callback, context);
+	}
+}
+
+template<class dgNodeRef>
+void dgAABBPolygonSoup::ForAllSectorsRayHitLow (const dgNodeRef& root, const dgFastRayTest& raySrc, dgFloat32 maxParam, dgRayIntersectCallback callback, void* const context) const
+{
+	dgNodeRef stackPool[DG_STACK_DEPTH];
 	dgFloat32 distance[DG_STACK_DEPTH];
 	dgFastRayTest ray (raySrc);
 
 	dgInt32 stack = 1;
 	const dgTriplex* const vertexArray = (dgTriplex*) m_localVertex;
 
-	stackPool[0] = m_aabb;
-	distance[0] = m_aabb->RayDistance(ray, vertexArray);
+	dgVector p0;
+	dgVector p1;
+	GetNodeBox (root, p0, p1);
+	stackPool[0] = root;
+	distance[0] = ray.BoxIntersect(p0, p1);
 	while (stack) {
 		stack --;
 		dgFloat32 dist = distance[stack];
 		if (dist > maxParam) {
 			break;
 		} else {
-			const dgNode *const me = stackPool[stack];
+			const dgNodeRef me (stackPool[stack]);
 			if (me->m_left.IsLeaf()) {
 				dgInt32 vCount = me->m_left.GetCount();
 				if (vCount > 0) {
@@ -1138,8 +1314,9 @@ void dgAABBPolygonSoup::ForAllSectorsRayHit (const dgFastRayTest& raySrc, dgFloa
 				}
 
 			} else {
-				const dgNode* const node = me->m_left.GetNode(m_aabb);
-				dgFloat32 dist1 = node->RayDistance(ray, vertexArray);
+				const dgNodeRef node (GetChildNode (me, me->m_left));
+				GetNodeBox (node, p0, p1);
+				dgFloat32 dist1 = ray.BoxIntersect(p0, p1);
 				if (dist1 < maxParam) {
 					dgInt32 j = stack;
 					for ( ; j && (dist1 > distance[j - 1]); j --) {
@@ -1168,8 +1345,9 @@ void dgAABBPolygonSoup::ForAllSectorsRayHit (const dgFastRayTest& raySrc, dgFloa
 				}
 
 			} else {
-				const dgNode* const node = me->m_right.GetNode(m_aabb);
-				dgFloat32 dist1 = node->RayDistance(ray, vertexArray);
+				const dgNodeRef node (GetChildNode (me, me->m_right));
+				GetNodeBox (node, p0, p1);
+				dgFloat32 dist1 = ray.BoxIntersect(p0, p1);
 				if (dist1 < maxParam) {
 					dgInt32 j = stack;
 					for ( ; j && (dist1 > distance[j - 1]); j --) {
@@ -1197,177 +1375,193 @@ void dgAABBPolygonSoup::ForAllSectors (const dgFastAABBInfo& obbAabbInfo, const
 	dgAssert (dgAbsf(dgAbsf(obbAabbInfo[0][2]) - obbAabbInfo.m_absDir[2][0]) < dgFloat32 (1.0e-4f));
 	dgAssert (dgAbsf(dgAbsf(obbAabbInfo[1][2]) - obbAabbInfo.m_absDir[2][1]) < dgFloat32 (1.0e-4f));
 
-	if (m_aabb) {
-		dgFloat32 distance[DG_STACK_DEPTH];
-		const dgNode* stackPool[DG_STACK_DEPTH];
+	if (m_compressedAabb) {
+		ForAllSectorsLow (GetCompressedRoot(), obbAabbInfo, boxDistanceTravel, callback, context);
+	} else if (m_aabb) {
+		ForAllSectorsLow<const dgNode*> (m_aabb, obbAabbInfo, boxDistanceTravel, callback, context);
+	}
+}
+
+template<class dgNodeRef>
+void dgAABBPolygonSoup::ForAllSectorsLow (const dgNodeRef& root, const dgFastAABBInfo& obbAabbInfo, const dgVector& boxDistanceTravel, dgAABBIntersectCallback callback, void* const context) const
+{
+	dgFloat32 distance[DG_STACK_DEPTH];
+	dgNodeRef stackPool[DG_STACK_DEPTH];
 
-		const dgInt32 stride = sizeof (dgTriplex) / sizeof (dgFloat32);
-		const dgTriplex* const vertexArray = (dgTriplex*) m_localVertex;
+	const dgInt32 stride = sizeof (dgTriplex) / sizeof (dgFloat32);
+	const dgTriplex* const vertexArray = (dgTriplex*) m_localVertex;
 
-		if (boxDistanceTravel.DotProduct3 (boxDistanceTravel) < dgFloat32 (1.0e-8f)) {
+	dgVector p0;
+	dgVector p1;
+	GetNodeBox (root, p0, p1);
 
-			dgInt32 stack = 1;
-			stackPool[0] = m_aabb;
-			distance[0] = m_aabb->BoxPenetration(obbAabbInfo, vertexArray);
-			if (distance[0] <= dgFloat32(0.0f)) {
-				obbAabbInfo.m_separationDistance = dgMin(obbAabbInfo.m_separationDistance, -distance[0]);
-			}
-			while (stack) {
-				stack --;
-				dgFloat32 dist = distance[stack];
-				if (dist > dgFloat32 (0.0f)) {
-					const dgNode* const me = stackPool[stack];
-					if (me->m_left.IsLeaf()) {
-						dgInt32 index = dgInt32 (me->m_left.GetIndex());
-						dgInt32 vCount = me->m_left.GetCount();
-						if (vCount > 0) {
-							const dgInt32* const indices = &m_indices[index];
-							dgInt32 normalIndex = indices[vCount + 1];
-							dgVector faceNormal (&vertexArray[normalIndex].m_x);
-							dgFloat32 dist1 = obbAabbInfo.PolygonBoxDistance (faceNormal, vCount, indices, stride, &vertexArray[0].m_x);
-							if (dist1 > dgFloat32 (0.0f)) {
-								obbAabbInfo.m_separationDistance = dgFloat32(0.0f);
-								dgAssert (vCount >= 3);
-								if (callback(context, &vertexArray[0].m_x, sizeof (dgTriplex), indices, vCount, dist1) == t_StopSearh) {
-									return;
-								}
-							} else {
-								obbAabbInfo.m_separationDistance = dgMin(obbAabbInfo.m_separationDistance, -dist1);
-							}
-						}
+	if (boxDistanceTravel.DotProduct3 (boxDistanceTravel) < dgFloat32 (1.0e-8f)) {
 
-					} else {
-						const dgNode* const node = me->m_left.GetNode(m_aabb);
-						dgFloat32 dist1 = node->BoxPenetration(obbAabbInfo, vertexArray);
+		dgInt32 stack = 1;
+		stackPool[0] = root;
+		distance[0] = dgNode::BoxPenetration(obbAabbInfo, p0, p1);
+		if (distance[0] <= dgFloat32(0.0f)) {
+			obbAabbInfo.m_separationDistance = dgMin(obbAabbInfo.m_separationDistance, -distance[0]);
+		}
+		while (stack) {
+			stack --;
+			dgFloat32 dist = distance[stack];
+			if (dist > dgFloat32 (0.0f)) {
+				const dgNodeRef me (stackPool[stack]);
+				if (me->m_left.IsLeaf()) {
+					dgInt32 index = dgInt32 (me->m_left.GetIndex());
+					dgInt32 vCount = me->m_left.GetCount();
+					if (vCount > 0) {
+						const dgInt32* const indices = &m_indices[index];
+						dgInt32 normalIndex = indices[vCount + 1];
+						dgVector faceNormal (&vertexArray[normalIndex].m_x);
+						dgFloat32 dist1 = obbAabbInfo.PolygonBoxDistance (faceNormal, vCount, indices, stride, &vertexArray[0].m_x);
 						if (dist1 > dgFloat32 (0.0f)) {
-							dgInt32 j = stack;
-							for ( ; j && (dist1 > distance[j - 1]); j --) {
-								stackPool[j] = stackPool[j - 1];
-								distance[j] = distance[j - 1];
+							obbAabbInfo.m_separationDistance = dgFloat32(0.0f);
+							dgAssert (vCount >= 3);
+							if (callback(context, &vertexArray[0].m_x, sizeof (dgTriplex), indices, vCount, dist1) == t_StopSearh) {
+								return;
 							}
-							dgAssert (stack < DG_STACK_DEPTH);
-							stackPool[j] = node;
-							distance[j] = dist1;
-							stack++;
 						} else {
 							obbAabbInfo.m_separationDistance = dgMin(obbAabbInfo.m_separationDistance, -dist1);
 						}
 					}
 
-					if (me->m_right.IsLeaf()) {
-						dgInt32 index = dgInt32 (me->m_right.GetIndex());
-						dgInt32 vCount = me->m_right.GetCount();
-						if (vCount > 0) {
-							const dgInt32* const indices = &m_indices[index];
-							dgInt32 normalIndex = indices[vCount + 1];
-							dgVector faceNormal (&vertexArray[normalIndex].m_x);
-							dgFloat32 dist1 = obbAabbInfo.PolygonBoxDistance (faceNormal, vCount, indices, stride, &vertexArray[0].m_x);
-							if (dist1 > dgFloat32 (0.0f)) {
-								dgAssert (vCount >= 3);
-								obbAabbInfo.m_separationDistance = dgFloat32(0.0f);
-								if (callback(context, &vertexArray[0].m_x, sizeof (dgTriplex), indices, vCount, dist1) == t_StopSearh) {
-									return;
-								}
-							} else {
-								obbAabbInfo.m_separationDistance = dgMin(obbAabbInfo.m_separationDistance, -dist1);
-							}
+				} else {
+					const dgNodeRef node (GetChildNode (me, me->m_left));
+					GetNodeBox (node, p0, p1);
+					dgFloat32 dist1 = dgNode::BoxPenetration(obbAabbInfo, p0, p1);
+					if (dist1 > dgFloat32 (0.0f)) {
+						dgInt32 j = stack;
+						for ( ; j && (dist1 > distance[j - 1]); j --) {
+							stackPool[j] = stackPool[j - 1];
+							distance[j] = distance[j - 1];
 						}
-
+						dgAssert (stack < DG_STACK_DEPTH);
+						stackPool[j] = node;
+						distance[j] = dist1;
+						stack++;
 					} else {
-						const dgNode* const node = me->m_right.GetNode(m_aabb);
-						dgFloat32 dist1 = node->BoxPenetration(obbAabbInfo, vertexArray);
+						obbAabbInfo.m_separationDistance = dgMin(obbAabbInfo.m_separationDistance, -dist1);
+					}
+				}
+
+				if (me->m_right.IsLeaf()) {
+					dgInt32 index = dgInt32 (me->m_right.GetIndex());
+					dgInt32 vCount = me->m_right.GetCount();
+					if (vCount > 0) {
+						const dgInt32* const indices = &m_indices[index];
+						dgInt32 normalIndex = indices[vCount + 1];
+						dgVector faceNormal (&vertexArray[normalIndex].m_x);
+						dgFloat32 dist1 = obbAabbInfo.PolygonBoxDistance (faceNormal, vCount, indices, stride, &vertexArray[0].m_x);
 						if (dist1 > dgFloat32 (0.0f)) {
-							dgInt32 j = stack;
-							for ( ; j && (dist1 > distance[j - 1]); j --) {
-								stackPool[j] = stackPool[j - 1];
-								distance[j] = distance[j - 1];
+							dgAssert (vCount >= 3);
+							obbAabbInfo.m_separationDistance = dgFloat32(0.0f);
+							if (callback(context, &vertexArray[0].m_x, sizeof (dgTriplex), indices, vCount, dist1) == t_StopSearh) {
+								return;
 							}
-							dgAssert (stack < DG_STACK_DEPTH);
-							stackPool[j] = node;
-							distance[j] = dist1;
-							stack++;
 						} else {
 							obbAabbInfo.m_separationDistance = dgMin(obbAabbInfo.m_separationDistance, -dist1);
 						}
 					}
+
+				} else {
+					const dgNodeRef node (GetChildNode (me, me->m_right));
+					GetNodeBox (node, p0, p1);
+					dgFloat32 dist1 = dgNode::BoxPenetration(obbAabbInfo, p0, p1);
+					if (dist1 > dgFloat32 (0.0f)) {
+						dgInt32 j = stack;
+						for ( ; j && (dist1 > distance[j - 1]); j --) {
+							stackPool[j] = stackPool[j - 1];
+							distance[j] = distance[j - 1];
+						}
+						dgAssert (stack < DG_STACK_DEPTH);
+						stackPool[j] = node;
+						distance[j] = dist1;
+						stack++;
+					} else {
+						obbAabbInfo.m_separationDistance = dgMin(obbAabbInfo.m_separationDistance, -dist1);
+					}
 				}
 			}
+		}
 
-		} else {
-			dgFastRayTest ray (dgVector (dgFloat32 (0.0f)), boxDistanceTravel);
-			dgFastRayTest obbRay (dgVector (dgFloat32 (0.0f)), obbAabbInfo.UnrotateVector(boxDistanceTravel));
-			dgInt32 stack = 1;
-			stackPool[0] = m_aabb;
-			distance [0] = m_aabb->BoxIntersect (ray, obbRay, obbAabbInfo, vertexArray);
-
-			while (stack) {
-				stack --;
-				const dgFloat32 dist = distance[stack];
-				const dgNode* const me = stackPool[stack];
-				if (dist < dgFloat32 (1.0f)) {
-
-					if (me->m_left.IsLeaf()) {
-						dgInt32 index = dgInt32 (me->m_left.GetIndex());
-						dgInt32 vCount = me->m_left.GetCount();
-						if (vCount > 0) {
-							const dgInt32* const indices = &m_indices[index];
-							dgInt32 normalIndex = indices[vCount + 1];
-							dgVector faceNormal (&vertexArray[normalIndex].m_x);
-							dgFloat32 hitDistance = obbAabbInfo.PolygonBoxRayDistance (faceNormal, vCount, indices, stride, &vertexArray[0].m_x, ray);
-							if (hitDistance < dgFloat32 (1.0f)) {
-								dgAssert (vCount >= 3);
-								if (callback(context, &vertexArray[0].m_x, sizeof (dgTriplex), indices, vCount, hitDistance) == t_StopSearh) {
-									return;
-								}
+	} else {
+		dgFastRayTest ray (dgVector (dgFloat32 (0.0f)), boxDistanceTravel);
+		dgFastRayTest obbRay (dgVector (dgFloat32 (0.0f)), obbAabbInfo.UnrotateVector(boxDistanceTravel));
+		dgInt32 stack = 1;
+		stackPool[0] = root;
+		distance [0] = dgNode::BoxIntersect (ray, obbRay, obbAabbInfo, p0, p1);
+
+		while (stack) {
+			stack --;
+			const dgFloat32 dist = distance[stack];
+			const dgNodeRef me (stackPool[stack]);
+			if (dist < dgFloat32 (1.0f)) {
+
+				if (me->m_left.IsLeaf()) {
+					dgInt32 index = dgInt32 (me->m_left.GetIndex());
+					dgInt32 vCount = me->m_left.GetCount();
+					if (vCount > 0) {
+						const dgInt32* const indices = &m_indices[index];
+						dgInt32 normalIndex = indices[vCount + 1];
+						dgVector faceNormal (&vertexArray[normalIndex].m_x);
+						dgFloat32 hitDistance = obbAabbInfo.PolygonBoxRayDistance (faceNormal, vCount, indices, stride, &vertexArray[0].m_x, ray);
+						if (hitDistance < dgFloat32 (1.0f)) {
+							dgAssert (vCount >= 3);
+							if (callback(context, &vertexArray[0].m_x, sizeof (dgTriplex), indices, vCount, hitDistance) == t_StopSearh) {
+								return;
 							}
 						}
+					}
 
-					} else {
-						const dgNode* const node = me->m_left.GetNode(m_aabb);
-						dgFloat32 dist1 = node->BoxIntersect (ray, obbRay, obbAabbInfo, vertexArray);
-						if (dist1 < dgFloat32 (1.0f)) {
-							dgInt32 j = stack;
-							for ( ; j && (dist1 > distance[j - 1]); j --) {
-								stackPool[j] = stackPool[j - 1];
-								distance[j] = distance[j - 1];
-							}
-							dgAssert (stack < DG_STACK_DEPTH);
-							stackPool[j] = node;
-							distance[j] = dist1;
-							stack++;
+				} else {
+					const dgNodeRef node (GetChildNode (me, me->m_left));
+					GetNodeBox (node, p0, p1);
+					dgFloat32 dist1 = dgNode::BoxIntersect (ray, obbRay, obbAabbInfo, p0, p1);
+					if (dist1 < dgFloat32 (1.0f)) {
+						dgInt32 j = stack;
+						for ( ; j && (dist1 > distance[j - 1]); j --) {
+							stackPool[j] = stackPool[j - 1];
+							distance[j] = distance[j - 1];
 						}
+						dgAssert (stack < DG_STACK_DEPTH);
+						stackPool[j] = node;
+						distance[j] = dist1;
+						stack++;
 					}
+				}
 
-					if (me->m_right.IsLeaf()) {
-						dgInt32 index = dgInt32 (me->m_right.GetIndex());
-						dgInt32 vCount = me->m_right.GetCount();
-						if (vCount > 0) {
-							const dgInt32* const indices = &m_indices[index];
-							dgInt32 normalIndex = indices[vCount + 1];
-							dgVector faceNormal (&vertexArray[normalIndex].m_x);
-							dgFloat32 hitDistance = obbAabbInfo.PolygonBoxRayDistance (faceNormal, vCount, indices, stride, &vertexArray[0].m_x, ray);
-							if (hitDistance < dgFloat32 (1.0f)) {
-								dgAssert (vCount >= 3);
-								if (callback(context, &vertexArray[0].m_x, sizeof (dgTriplex), indices, vCount, hitDistance) == t_StopSearh) {
-									return;
-								}
+				if (me->m_right.IsLeaf()) {
+					dgInt32 index = dgInt32 (me->m_right.GetIndex());
+					dgInt32 vCount = me->m_right.GetCount();
+					if (vCount > 0) {
+						const dgInt32* const indices = &m_indices[index];
+						dgInt32 normalIndex = indices[vCount + 1];
+						dgVector faceNormal (&vertexArray[normalIndex].m_x);
+						dgFloat32 hitDistance = obbAabbInfo.PolygonBoxRayDistance (faceNormal, vCount, indices, stride, &vertexArray[0].m_x, ray);
+						if (hitDistance < dgFloat32 (1.0f)) {
+							dgAssert (vCount >= 3);
+							if (callback(context, &vertexArray[0].m_x, sizeof (dgTriplex), indices, vCount, hitDistance) == t_StopSearh) {
+								return;
 							}
 						}
+					}
 
-					} else {
-						const dgNode* const node = me->m_right.GetNode(m_aabb);
-						dgFloat32 dist1 = node->BoxIntersect (ray, obbRay, obbAabbInfo, vertexArray);
-						if (dist1 < dgFloat32 (1.0f)) {
-							dgInt32 j = stack;
-							for ( ; j && (dist1 > distance[j - 1]); j --) {
-								stackPool[j] = stackPool[j - 1];
-								distance[j] = distance[j - 1];
-							}
-							dgAssert (stack < DG_STACK_DEPTH);
-							stackPool[j] = node;
-							distance[j] = dist1;
-							stack ++;
+				} else {
+					const dgNodeRef node (GetChildNode (me, me->m_right));
+					GetNodeBox (node, p0, p1);
+					dgFloat32 dist1 = dgNode::BoxIntersect (ray, obbRay, obbAabbInfo, p0, p1);
+					if (dist1 < dgFloat32 (1.0f)) {
+						dgInt32 j = stack;
+						for ( ; j && (dist1 > distance[j - 1]); j --) {
+							stackPool[j] = stackPool[j - 1];
+							distance[j] = distance[j - 1];
 						}
+						dgAssert (stack < DG_STACK_DEPTH);
+						stackPool[j] = node;
+						distance[j] = dist1;
+						stack ++;
 					}
 				}
 			}
@@ -26,6 +26,8 @@
 #include "dgIntersections.h"
 #include "dgPolygonSoupDatabase.h"
 
+class dgThreadHive;
+
 
 class dgPolygonSoupDatabaseBuilder;
 
@@ -112,6 +114,18 @@ class dgAABBPolygonSoup: public dgPolygonSoupDatabase
 		{
 			dgVector p0 (&vertexArray[m_indexBox0].m_x);
 			dgVector p1 (&vertexArray[m_indexBox1].m_x);
+			return BoxPenetration (obb, p0, p1);
+		}
+
+		DG_INLINE dgFloat32 BoxIntersect (const dgFastRayTest& ray, const dgFastRayTest& obbRay, const dgFastAABBInfo& obb, const dgTriplex* const vertexArray) const
+		{
+			dgVector p0 (&vertexArray[m_indexBox0].m_x);
+			dgVector p1 (&vertexArray[m_indexBox1].m_x);
+			return BoxIntersect (ray, obbRay, obb, p0, p1);
+		}
+
+		static DG_INLINE dgFloat32 BoxPenetration (const dgFastAABBInfo& obb, const dgVector& p0, const dgVector& p1)
+		{
 			dgVector minBox (p0 - obb.m_p1);
 			dgVector maxBox (p1 - obb.m_p0);
 			dgAssert(maxBox.m_x >= minBox.m_x);
@@ -149,10 +163,8 @@ class dgAABBPolygonSoup: public dgPolygonSoupDatabase
 			return	dist.GetScalar();
 		}
 
-		DG_INLINE dgFloat32 BoxIntersect (const dgFastRayTest& ray, const dgFastRayTest& obbRay, const dgFastAABBInfo& obb, const dgTriplex* const vertexArray) const
+		static DG_INLINE dgFloat32 BoxIntersect (const dgFastRayTest& ray, const dgFastRayTest& obbRay, const dgFastAABBInfo& obb, const dgVector& p0, const dgVector& p1)
 		{
-			dgVector p0 (&vertexArray[m_indexBox0].m_x);
-			dgVector p1 (&vertexArray[m_indexBox1].m_x);
 			dgVector minBox (p0 - obb.m_p1);
 			dgVector maxBox (p1 - obb.m_p0);
 			dgFloat32 dist = ray.BoxIntersect(minBox, maxBox);
@@ -179,8 +191,56 @@ class dgAABBPolygonSoup: public dgPolygonSoupDatabase
 		dgLeafNodePtr m_right;
 	};
 
+	// node with its box quantized to 16 bits relative to the box of its parent
+	class dgCompressedNode
+	{
+		public:
+		DG_INLINE dgCompressedNode ()
+			:m_left (0)
+			,m_right (0)
+		{
+			for (dgInt32 i = 0; i < 6; i ++) {
+				m_box[i] = 0;
+			}
+		}
+
+		dgUnsigned16 m_box[6];
+		dgNode::dgLeafNodePtr m_left;
+		dgNode::dgLeafNodePtr m_right;
+	};
+
+	// a node and its two children share one cache line, children are addressed as (group << 2) + slot
+	class dgCompressedNodeGroup
+	{
+		public:
+		DG_INLINE dgCompressedNodeGroup ()
+			:m_unused (0)
+		{
+		}
+
+		dgCompressedNode m_nodes[3];
+		dgInt32 m_unused;
+	};
+
+	// a compressed node and its decoded box, the boxes of its children are decoded from it
+	class dgCompressedNodeRef
+	{
+		public:
+		DG_INLINE const dgCompressedNode* operator-> () const
+		{
+			return m_node;
+		}
+
+		dgVector m_p0;
+		dgVector m_p1;
+		const dgCompressedNode* m_node;
+	};
+
 	class dgSpliteInfo;
 	class dgNodeBuilder;
+	class dgBuildTask;
+	class dgBuildContext;
+	class dgAdjacencyContext;
 
 	virtual void GetAABB (dgVector& p0, dgVector& p1) const;
 	virtual void Serialize (dgSerialize callback, void* const userData) const;
@@ -190,51 +250,131 @@ class dgAABBPolygonSoup: public dgPolygonSoupDatabase
 	dgAABBPolygonSoup ();
 	virtual ~dgAABBPolygonSoup ();
 
-	void Create (const dgPolygonSoupDatabaseBuilder& builder, bool optimizedBuild);
-	void CalculateAdjacendy ();
+	void Create (const dgPolygonSoupDatabaseBuilder& builder, bool optimizedBuild, dgThreadHive* const threadPool = NULL);
+	void CalculateAdjacendy (dgThreadHive* const threadPool = NULL);
+	void Compress ();
 	virtual void ForAllSectorsRayHit (const dgFastRayTest& ray, dgFloat32 maxT, dgRayIntersectCallback callback, void* const context) const;
 	virtual void ForAllSectors (const dgFastAABBInfo& obbAabb, const dgVector& boxDistanceTravel, dgFloat32 m_maxT, dgAABBIntersectCallback callback, void* const context) const;
 	
 
 	DG_INLINE void* GetRootNode() const 
 	{
-		return m_aabb;
+		return m_compressedAabb ? (void*)&m_compressedAabb[0].m_nodes[0] : (void*)m_aabb;
 	}
 
 	DG_INLINE void* GetBackNode(const void* const root) const 
 	{
+		if (m_compressedAabb) {
+			const dgCompressedNode* const node = (dgCompressedNode*) root;
+			return node->m_left.IsLeaf() ? NULL : (void*)GetChildNode (node, node->m_left);
+		}
 		dgNode* const node = (dgNode*) root;
 		return node->m_left.IsLeaf() ? NULL : node->m_left.GetNode(m_aabb);
 	}
 
 	DG_INLINE void* GetFrontNode(const void* const root) const 
 	{
+		if (m_compressedAabb) {
+			const dgCompressedNode* const node = (dgCompressedNode*) root;
+			return node->m_right.IsLeaf() ? NULL : (void*)GetChildNode (node, node->m_right);
+		}
 		dgNode* const node = (dgNode*) root;
 		return node->m_right.IsLeaf() ? NULL : node->m_right.GetNode(m_aabb);
 	}
 
-	DG_INLINE void GetNodeAABB(const void* const root, dgVector& p0, dgVector& p1) const 
+	// compressed boxes are decoded from the box the caller got for the parent of the node,
+	// the root and the float boxes ignore it
+	DG_INLINE void GetNodeAABB(const void* const node, const dgVector& parentP0, const dgVector& parentP1, dgVector& p0, dgVector& p1) const 
+	{
+		if (m_compressedAabb) {
+			if (node == GetRootNode()) {
+				DecodeNodeBox ((dgCompressedNode*)node, m_compressedBox0, m_compressedBox1, p0, p1);
+			} else {
+				DecodeNodeBox ((dgCompressedNode*)node, parentP0, parentP1, p0, p1);
+			}
+		} else {
+			GetNodeBox ((dgNode*)node, p0, p1);
+		}
+	}
+
+	DG_INLINE void GetNodeBox (const dgNode* const node, dgVector& p0, dgVector& p1) const 
 	{
-		const dgNode* const node = (dgNode*)root;
 		p0 = dgVector (&((dgTriplex*)m_localVertex)[node->m_indexBox0].m_x);
 		p1 = dgVector (&((dgTriplex*)m_localVertex)[node->m_indexBox1].m_x);
 	}
+
+	DG_INLINE void GetNodeBox (const dgCompressedNodeRef& node, dgVector& p0, dgVector& p1) const 
+	{
+		p0 = node.m_p0;
+		p1 = node.m_p1;
+	}
+
+	// the parent box is split in 65000 steps per axis, which leaves room for rounding the boxes outward
+	DG_INLINE void DecodeNodeBox (const dgCompressedNode* const node, const dgVector& parentP0, const dgVector& parentP1, dgVector& p0, dgVector& p1) const 
+	{
+		const dgVector scale ((parentP1 - parentP0) * dgVector (dgFloat32 (1.0f / 65000.0f)));
+		const dgVector q0 (dgFloat32 (node->m_box[0]), dgFloat32 (node->m_box[1]), dgFloat32 (node->m_box[2]), dgFloat32 (0.0f));
+		const dgVector q1 (dgFloat32 (node->m_box[3]), dgFloat32 (node->m_box[4]), dgFloat32 (node->m_box[5]), dgFloat32 (0.0f));
+		p0 = parentP0 + q0 * scale;
+		p1 = parentP0 + q1 * scale;
+	}
+
+	DG_INLINE dgCompressedNodeRef GetCompressedRoot () const 
+	{
+		dgCompressedNodeRef root;
+		root.m_node = &m_compressedAabb[0].m_nodes[0];
+		DecodeNodeBox (root.m_node, m_compressedBox0, m_compressedBox1, root.m_p0, root.m_p1);
+		return root;
+	}
+
+	DG_INLINE const dgNode* GetChildNode (const dgNode* const parent, dgNode::dgLeafNodePtr child) const 
+	{
+		return child.GetNode(m_aabb);
+	}
+
+	DG_INLINE const dgCompressedNode* GetChildNode (const dgCompressedNode* const parent, dgNode::dgLeafNodePtr child) const 
+	{
+		return &m_compressedAabb[child.m_node >> 2].m_nodes[child.m_node & 3];
+	}
+
+	DG_INLINE dgCompressedNodeRef GetChildNode (const dgCompressedNodeRef& parent, dgNode::dgLeafNodePtr child) const 
+	{
+		dgCompressedNodeRef node;
+		node.m_node = GetChildNode (parent.m_node, child);
+		DecodeNodeBox (node.m_node, parent.m_p0, parent.m_p1, node.m_p0, node.m_p1);
+		return node;
+	}
+
 	virtual dgVector ForAllSectorsSupportVectex (const dgVector& dir) const;
 
 	
 
 	private:
-	dgNodeBuilder* BuildTopDown (dgNodeBuilder* const leafArray, dgInt32 firstBox, dgInt32 lastBox, dgNodeBuilder** const allocator) const;
+	dgNodeBuilder* BuildTopDown (dgNodeBuilder* const leafArray, dgInt32 firstBox, dgInt32 lastBox, dgNodeBuilder* const nodeArray) const;
+	dgNodeBuilder* BuildTopDownTasks (dgBuildContext& context, dgInt32 firstBox, dgInt32 lastBox, dgNodeBuilder* const parent, dgNodeBuilder** const link) const;
+	dgNodeBuilder* BuildTopDownParallel (dgNodeBuilder* const leafArray, dgInt32 boxCount, dgNodeBuilder* const nodeArray, dgThreadHive* const threadPool) const;
+	static void BuildTopDownKernel (void* const context, void* const worker, dgInt32 threadID);
+	static void CalculateAdjacendyKernel (void* const context, void* const worker, dgInt32 threadID);
 	dgFloat32 CalculateFaceMaxSize (const dgVector* const vertex, dgInt32 indexCount, const dgInt32* const indexArray) const;
 //	static dgIntersectStatus CalculateManifoldFaceEdgeNormals (void* const context, const dgFloat32* const polygon, dgInt32 strideInBytes, const dgInt32* const indexArray, dgInt32 indexCount);
 	static dgIntersectStatus CalculateDisjointedFaceEdgeNormals (void* const context, const dgFloat32* const polygon, dgInt32 strideInBytes, const dgInt32* const indexArray, dgInt32 indexCount, dgFloat32 hitDistance);
 	static dgIntersectStatus CalculateAllFaceEdgeNormals (void* const context, const dgFloat32* const polygon, dgInt32 strideInBytes, const dgInt32* const indexArray, dgInt32 indexCount, dgFloat32 hitDistance);
-	void ImproveNodeFitness (dgNodeBuilder* const node) const;
+
+	void EncodeNodeBox (dgCompressedNode& node, const dgVector& parentP0, const dgVector& parentP1, const dgVector& p0, const dgVector& p1) const;
+
+	template<class dgNodeRef> dgVector ForAllSectorsSupportVectexLow (const dgNodeRef& root, const dgVector& dir) const;
+	template<class dgNodeRef> void ForAllSectorsRayHitLow (const dgNodeRef& root, const dgFastRayTest& ray, dgFloat32 maxT, dgRayIntersectCallback callback, void* const context) const;
+	template<class dgNodeRef> void ForAllSectorsLow (const dgNodeRef& root, const dgFastAABBInfo& obbAabb, const dgVector& boxDistanceTravel, dgAABBIntersectCallback callback, void* const context) const;
 
 	dgInt32 m_nodesCount;
 	dgInt32 m_indexCount;
 	dgNode* m_aabb;
 	dgInt32* m_indices;
+	dgCompressedNodeGroup* m_compressedAabb;
+	dgInt32 m_compressedGroupCount;
+	dgVector m_compressedBox0;
+	dgVector m_compressedBox1;
+	bool m_inPlace;
 };
 
 
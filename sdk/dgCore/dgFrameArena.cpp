@@ -0,0 +1,113 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dgStdafx.h"
+#include "dgFrameArena.h"
+
+
+dgFrameArena::dgFrameArena (dgMemoryAllocator* const allocator, dgInt32 threadCount)
+	:m_arenas(NULL)
+	,m_allocator(allocator)
+	,m_threadCount(threadCount)
+{
+	dgAssert (sizeof (dgOverflowBlock) <= DG_FRAME_ARENA_ALIGNMENT);
+	m_arenas = (dgSubArena*) m_allocator->MallocLow (m_threadCount * sizeof (dgSubArena));
+	memset (m_arenas, 0, m_threadCount * sizeof (dgSubArena));
+}
+
+dgFrameArena::~dgFrameArena ()
+{
+	for (dgInt32 i = 0; i < m_threadCount; i ++) {
+		Release (i, 0, NULL);
+		if (m_arenas[i].m_pool) {
+			m_allocator->FreeLow (m_arenas[i].m_pool);
+		}
+	}
+	m_allocator->FreeLow (m_arenas);
+}
+
+dgInt32 dgFrameArena::GetHighWaterMark () const
+{
+	dgInt32 size = 0;
+	for (dgInt32 i = 0; i < m_threadCount; i ++) {
+		size += m_arenas[i].m_highWaterMark;
+	}
+	return size;
+}
+
+void dgFrameArena::Reset ()
+{
+	for (dgInt32 i = 0; i < m_threadCount; i ++) {
+		dgSubArena& arena = m_arenas[i];
+		Release (i, 0, NULL);
+
+		if (arena.m_highWaterMark > arena.m_size) {
+			if (arena.m_pool) {
+				m_allocator->FreeLow (arena.m_pool);
+			}
+			arena.m_size = (arena.m_highWaterMark + DG_FRAME_ARENA_INITIAL_SIZE - 1) & -DG_FRAME_ARENA_INITIAL_SIZE;
+			arena.m_pool = (dgInt8*) m_allocator->MallocLow (arena.m_size);
+		}
+	}
+}
+
+void* dgFrameArena::Alloc (dgInt32 threadID, dgInt32 sizeInBytes)
+{
+	dgAssert (threadID < m_threadCount);
+	dgSubArena& arena = m_arenas[threadID];
+
+	sizeInBytes = (sizeInBytes + DG_FRAME_ARENA_ALIGNMENT - 1) & -DG_FRAME_ARENA_ALIGNMENT;
+	if (!arena.m_pool) {
+		arena.m_size = dgMax (sizeInBytes, DG_FRAME_ARENA_INITIAL_SIZE);
+		arena.m_pool = (dgInt8*) m_allocator->MallocLow (arena.m_size);
+	}
+
+	void* ptr;
+	if ((arena.m_index + sizeInBytes) <= arena.m_size) {
+		ptr = &arena.m_pool[arena.m_index];
+		arena.m_index += sizeInBytes;
+	} else {
+		dgOverflowBlock* const block = (dgOverflowBlock*) m_allocator->MallocLow (sizeInBytes + DG_FRAME_ARENA_ALIGNMENT);
+		block->m_next = arena.m_overflow;
+		block->m_size = sizeInBytes;
+		arena.m_overflow = block;
+		arena.m_overflowSize += sizeInBytes;
+		ptr = ((dgInt8*)block) + DG_FRAME_ARENA_ALIGNMENT;
+	}
+
+	arena.m_highWaterMark = dgMax (arena.m_highWaterMark, arena.m_index + arena.m_overflowSize);
+	dgAssert (!(PointerToInt (ptr) & (DG_FRAME_ARENA_ALIGNMENT - 1)));
+	return ptr;
+}
+
+void dgFrameArena::Release (dgInt32 threadID, dgInt32 index, void* const overflow)
+{
+	dgSubArena& arena = m_arenas[threadID];
+	dgAssert (index <= arena.m_index);
+	while (arena.m_overflow != overflow) {
+		dgOverflowBlock* const block = arena.m_overflow;
+		arena.m_overflow = block->m_next;
+		arena.m_overflowSize -= block->m_size;
+		m_allocator->FreeLow (block);
+	}
+	arena.m_index = index;
+}
+
@@ -0,0 +1,120 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __dgFrameArena__
+#define __dgFrameArena__
+
+#include "dgStdafx.h"
+#include "dgMemory.h"
+
+#define DG_FRAME_ARENA_ALIGNMENT		16
+#define DG_FRAME_ARENA_INITIAL_SIZE		(1024 * 32)
+
+// linear allocator for the scratch memory of one simulation step.
+// each thread allocates from its own sub arena, memory is given back in stack order by dgScope 
+// or all at once by Reset. Requests that do not fit in a sub arena get a block from the allocator, 
+// the next Reset grows the sub arena to its high water mark, so later frames run out of a single block.
+class dgFrameArena
+{
+	public:
+	class dgScope
+	{
+		public:
+		dgScope (dgFrameArena& arena, dgInt32 threadID);
+		~dgScope ();
+
+		protected:
+		dgFrameArena& m_arena;
+		void* m_overflow;
+		dgInt32 m_threadID;
+		dgInt32 m_index;
+	};
+
+	template<class T>
+	class dgBuffer: public dgScope
+	{
+		public:
+		dgBuffer (dgFrameArena& arena, dgInt32 threadID, dgInt32 elements)
+			:dgScope (arena, threadID)
+			,m_ptr ((T*) arena.Alloc (threadID, dgInt32 (elements * sizeof (T))))
+		{
+		}
+
+		T* GetBuffer() const
+		{
+			return m_ptr;
+		}
+
+		private:
+		T* m_ptr;
+	};
+
+	dgFrameArena (dgMemoryAllocator* const allocator, dgInt32 threadCount);
+	~dgFrameArena ();
+
+	void Reset ();
+	void* Alloc (dgInt32 threadID, dgInt32 sizeInBytes);
+
+	// sum of the most scratch memory each thread has had in use at once
+	dgInt32 GetHighWaterMark () const;
+
+	private:
+	class dgOverflowBlock
+	{
+		public:
+		dgOverflowBlock* m_next;
+		dgInt32 m_size;
+	};
+
+	class dgSubArena
+	{
+		public:
+		dgInt8* m_pool;
+		dgOverflowBlock* m_overflow;
+		dgInt32 m_size;
+		dgInt32 m_index;
+		dgInt32 m_overflowSize;
+		dgInt32 m_highWaterMark;
+		dgInt8 m_padding[32];
+	};
+
+	void Release (dgInt32 threadID, dgInt32 index, void* const overflow);
+
+	dgSubArena* m_arenas;
+	dgMemoryAllocator* m_allocator;
+	dgInt32 m_threadCount;
+};
+
+DG_INLINE dgFrameArena::dgScope::dgScope (dgFrameArena& arena, dgInt32 threadID)
+	:m_arena(arena)
+	,m_overflow(arena.m_arenas[threadID].m_overflow)
+	,m_threadID(threadID)
+	,m_index(arena.m_arenas[threadID].m_index)
+{
+}
+
+DG_INLINE dgFrameArena::dgScope::~dgScope ()
+{
+	m_arena.Release (m_threadID, m_index, m_overflow);
+}
+
+#endif
+
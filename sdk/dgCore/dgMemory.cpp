@@ -25,15 +25,27 @@
 #include "dgMemory.h"
 
 
-#ifdef _DEBUG
-static dgInt32 m_threadSanityCheck = 0;
-#define DG_MEMORY_THREAD_SANITY_CHECK_LOCK()		\
-	dgAssert (!m_threadSanityCheck);				\
-	dgAtomicExchangeAndAdd(&m_threadSanityCheck, 1);
-	#define DG_MEMORY_THREAD_SANITY_CHECK_UNLOCK()	  dgAtomicExchangeAndAdd(&m_threadSanityCheck, -1);	
-#else 
-	#define DG_MEMORY_THREAD_SANITY_CHECK_LOCK()
-	#define DG_MEMORY_THREAD_SANITY_CHECK_UNLOCK()
+// each thread that allocates from the pools claims one of these slots, the slot index selects 
+// the thread cache in every allocator. Threads that can not get a slot use the shared directory.
+static dgInt32 m_threadCacheSlots[DG_MEMORY_THREAD_CACHE_COUNT];
+static DG_THREAD_LOCAL dgInt32 m_threadCacheSlot = 0;
+
+#if !defined (_MSC_VER) || (_MSC_VER >= 1900)
+// gives the slot back when the thread exits, so that application threads that allocate do not keep it forever
+class dgThreadCacheSlotRelease
+{
+	public:
+	~dgThreadCacheSlotRelease()
+	{
+		dgMemoryAllocator::ReleaseThreadCache();
+	}
+
+	void Register()
+	{
+	}
+};
+static thread_local dgThreadCacheSlotRelease m_threadCacheSlotRelease;
+#define DG_THREAD_CACHE_SLOT_RELEASE
 #endif
 
 
@@ -48,6 +60,7 @@ class dgMemoryAllocator::dgMemoryBin
 		dgInt32 m_stepInBites;
 		dgMemoryBin* m_next;
 		dgMemoryBin* m_prev;
+		dgThreadCache* m_owner;
 	};
 	char m_pool[DG_MEMORY_BIN_SIZE - sizeof (dgMemoryBinInfo)-DG_MEMORY_GRANULARITY * 2];
 	dgMemoryBinInfo m_info;
@@ -60,6 +73,18 @@ class dgMemoryAllocator::dgMemoryCacheEntry
 	dgMemoryCacheEntry* m_prev;
 };
 
+// bins directory owned by one thread, only the owner allocates from it and returns blocks to it.
+// other threads push the blocks they free into the remote stack, the owner reclaims them when it runs out
+// or when DG_MEMORY_REMOTE_FLUSH_COUNT blocks are waiting. 
+class dgMemoryAllocator::dgThreadCache
+{
+	public:
+	dgMemDirectory m_memoryDirectory[DG_MEMORY_BIN_ENTRIES + 1];
+	dgInt8 m_padding[DG_MEMORY_GRANULARITY];
+	dgMemoryCacheEntry* volatile m_remoteFree;
+	dgInt32 m_remoteCount;
+};
+
 class dgMemoryAllocator::dgMemoryInfo
 {
 	public:
@@ -138,7 +163,8 @@ class dgGlobalAllocator: public dgMemoryAllocator, public dgList<dgMemoryAllocat
 //dgGlobalAllocator dgGlobalAllocator::m_globalAllocator;
 
 dgMemoryAllocator::dgMemoryAllocator ()
-	:m_emumerator(0)
+	:m_lock(0)
+	,m_emumerator(0)
 	,m_memoryUsed(0)
 	,m_isInList(true)
 	,m_free(NULL)
@@ -146,11 +172,13 @@ dgMemoryAllocator::dgMemoryAllocator ()
 {
 	SetAllocatorsCallback (dgGlobalAllocator::GetGlobalAllocator().m_malloc, dgGlobalAllocator::GetGlobalAllocator().m_free);
 	memset (m_memoryDirectory, 0, sizeof (m_memoryDirectory));
+	memset (m_threadCaches, 0, sizeof (m_threadCaches));
 	dgGlobalAllocator::GetGlobalAllocator().Append(this);
 }
 
 dgMemoryAllocator::dgMemoryAllocator (dgMemAlloc memAlloc, dgMemFree memFree)
-	:m_emumerator(0)
+	:m_lock(0)
+	,m_emumerator(0)
 	,m_memoryUsed(0)
 	,m_isInList(false)
 	,m_free(NULL)
@@ -158,6 +186,7 @@ dgMemoryAllocator::dgMemoryAllocator (dgMemAlloc memAlloc, dgMemFree memFree)
 {
 	SetAllocatorsCallback (memAlloc, memFree);
 	memset (m_memoryDirectory, 0, sizeof (m_memoryDirectory));
+	memset (m_threadCaches, 0, sizeof (m_threadCaches));
 }
 
 
@@ -166,6 +195,13 @@ dgMemoryAllocator::~dgMemoryAllocator  ()
 	if (m_isInList) {
 		dgGlobalAllocator::GetGlobalAllocator().Remove(this);
 	}
+
+	for (dgInt32 i = 0; i < DG_MEMORY_THREAD_CACHE_COUNT; i ++) {
+		if (m_threadCaches[i]) {
+			FlushRemoteBlocks (m_threadCaches[i]);
+			FreeLow (m_threadCaches[i]);
+		}
+	}
 	dgAssert (m_memoryUsed == 0);
 }
 
@@ -230,150 +266,257 @@ void dgMemoryAllocator::FreeLow (void* const retPtr)
 	m_free (info->m_ptr, dgUnsigned32 (info->m_size));
 }
 
-// alloca memory on pool that are quantized to DG_MEMORY_GRANULARITY
-// if memory size is larger than DG_MEMORY_BIN_ENTRIES then the memory is not placed into a pool
-void *dgMemoryAllocator::Malloc (dgInt32 memsize)
+dgMemoryAllocator::dgThreadCache* dgMemoryAllocator::GetThreadCache ()
 {
-	dgAssert (dgInt32 (sizeof (dgMemoryCacheEntry) + sizeof (dgInt32) + sizeof(dgInt32)) <= DG_MEMORY_GRANULARITY);
+	if (!m_threadCacheSlot) {
+		m_threadCacheSlot = -1;
+		for (dgInt32 i = 0; i < DG_MEMORY_THREAD_CACHE_COUNT; i ++) {
+			if (!m_threadCacheSlots[i] && !dgInterlockedCompareExchange(&m_threadCacheSlots[i], 1, 0)) {
+				m_threadCacheSlot = i + 1;
+				#ifdef DG_THREAD_CACHE_SLOT_RELEASE
+				m_threadCacheSlotRelease.Register();
+				#endif
+				break;
+			}
+		}
+	}
+
+	if (m_threadCacheSlot < 0) {
+		return NULL;
+	}
+
+	// only the thread holding the slot ever writes the entry, no need for interlocked operations
+	dgThreadCache* cache = m_threadCaches[m_threadCacheSlot - 1];
+	if (!cache) {
+		cache = (dgThreadCache*) MallocLow (sizeof (dgThreadCache));
+		memset (cache, 0, sizeof (dgThreadCache));
+		m_threadCaches[m_threadCacheSlot - 1] = cache;
+	}
+	return cache;
+}
+
+void dgMemoryAllocator::ReleaseThreadCache ()
+{
+	if (m_threadCacheSlot > 0) {
+		// the next thread to claim the slot inherits the caches, make sure it sees all our writes 
+		dgMemoryBarrier();
+		dgInterlockedExchange(&m_threadCacheSlots[m_threadCacheSlot - 1], 0);
+	}
+	m_threadCacheSlot = 0;
+}
+
+// take back all the blocks other threads freed into this cache, must be called from the owner thread 
+void dgMemoryAllocator::FlushRemoteBlocks (dgThreadCache* const cache)
+{
+	dgInt32 count = 0;
+	dgMemoryCacheEntry* cashe = (dgMemoryCacheEntry*) dgInterlockedExchange((void**) &cache->m_remoteFree, NULL);
+	while (cashe) {
+		dgMemoryCacheEntry* const next = cashe->m_next;
+		FreeBlock (cache->m_memoryDirectory, ((dgInt8*)cashe) + DG_MEMORY_GRANULARITY);
+		cashe = next;
+		count ++;
+	}
+	dgAtomicExchangeAndAdd (&cache->m_remoteCount, -count);
+}
 
+void* dgMemoryAllocator::MallocBlock (dgMemDirectory* const directory, dgThreadCache* const owner, dgInt32 memsize)
+{
 	dgInt32 size = memsize + DG_MEMORY_GRANULARITY - 1;
 	size &= (-DG_MEMORY_GRANULARITY);
 
 	dgInt32 paddedSize = size + DG_MEMORY_GRANULARITY; 
 	dgInt32 entry = paddedSize >> DG_MEMORY_GRANULARITY_BITS;	
+	dgAssert (entry < DG_MEMORY_BIN_ENTRIES);
+
+	if (!directory[entry].m_cache) {
+		dgMemoryBin* const bin = (dgMemoryBin*) MallocLow (sizeof (dgMemoryBin));
+
+		dgInt32 count = dgInt32 (sizeof (bin->m_pool) / paddedSize);
+		bin->m_info.m_count = 0;
+		bin->m_info.m_totalCount = count;
+		bin->m_info.m_stepInBites = paddedSize;
+		bin->m_info.m_next = directory[entry].m_first;
+		bin->m_info.m_prev = NULL;
+		bin->m_info.m_owner = owner;
+		if (bin->m_info.m_next) {
+			bin->m_info.m_next->m_info.m_prev = bin;
+		}
 
-	void* ptr;
-	if (entry >= DG_MEMORY_BIN_ENTRIES) {
-		ptr = MallocLow (size);
-	} else {
-		if (!m_memoryDirectory[entry].m_cache) {
-			dgMemoryBin* const bin = (dgMemoryBin*) MallocLow (sizeof (dgMemoryBin));
-
-			dgInt32 count = dgInt32 (sizeof (bin->m_pool) / paddedSize);
-			bin->m_info.m_count = 0;
-			bin->m_info.m_totalCount = count;
-			bin->m_info.m_stepInBites = paddedSize;
-			bin->m_info.m_next = m_memoryDirectory[entry].m_first;
-			bin->m_info.m_prev = NULL;
-			if (bin->m_info.m_next) {
-				bin->m_info.m_next->m_info.m_prev = bin;
-			}
-
-			m_memoryDirectory[entry].m_first = bin;
+		directory[entry].m_first = bin;
 
-			dgInt8* charPtr = reinterpret_cast<dgInt8*>(bin->m_pool);
-			m_memoryDirectory[entry].m_cache = (dgMemoryCacheEntry*)charPtr;
+		dgInt8* charPtr = reinterpret_cast<dgInt8*>(bin->m_pool);
+		directory[entry].m_cache = (dgMemoryCacheEntry*)charPtr;
 
-			for (dgInt32 i = 0; i < count; i ++) {
-				dgMemoryCacheEntry* const cashe = (dgMemoryCacheEntry*) charPtr;
-				cashe->m_next = (dgMemoryCacheEntry*) (charPtr + paddedSize);
-				cashe->m_prev = (dgMemoryCacheEntry*) (charPtr - paddedSize);
-				dgMemoryInfo* const info = ((dgMemoryInfo*) (charPtr + DG_MEMORY_GRANULARITY)) - 1;						
-				info->SaveInfo(this, bin, entry, m_emumerator, memsize);
-				charPtr += paddedSize;
-			}
-			dgMemoryCacheEntry* const cashe = (dgMemoryCacheEntry*) (charPtr - paddedSize);
-			cashe->m_next = NULL;
-			m_memoryDirectory[entry].m_cache->m_prev = NULL;
+		for (dgInt32 i = 0; i < count; i ++) {
+			dgMemoryCacheEntry* const cashe = (dgMemoryCacheEntry*) charPtr;
+			cashe->m_next = (dgMemoryCacheEntry*) (charPtr + paddedSize);
+			cashe->m_prev = (dgMemoryCacheEntry*) (charPtr - paddedSize);
+			dgMemoryInfo* const info = ((dgMemoryInfo*) (charPtr + DG_MEMORY_GRANULARITY)) - 1;						
+			info->SaveInfo(this, bin, entry, m_emumerator, memsize);
+			charPtr += paddedSize;
 		}
+		dgMemoryCacheEntry* const cashe = (dgMemoryCacheEntry*) (charPtr - paddedSize);
+		cashe->m_next = NULL;
+		directory[entry].m_cache->m_prev = NULL;
+	}
 
 
-		dgAssert (m_memoryDirectory[entry].m_cache);
+	dgAssert (directory[entry].m_cache);
 
-		dgMemoryCacheEntry* const cashe = m_memoryDirectory[entry].m_cache;
-		m_memoryDirectory[entry].m_cache = cashe->m_next;
-		if (cashe->m_next) {
-			cashe->m_next->m_prev = NULL;
-		}
+	dgMemoryCacheEntry* const cashe = directory[entry].m_cache;
+	directory[entry].m_cache = cashe->m_next;
+	if (cashe->m_next) {
+		cashe->m_next->m_prev = NULL;
+	}
 
-		ptr = ((dgInt8*)cashe) + DG_MEMORY_GRANULARITY;
+	void* const ptr = ((dgInt8*)cashe) + DG_MEMORY_GRANULARITY;
 
-		dgMemoryInfo* info;
-		info = ((dgMemoryInfo*) (ptr)) - 1;
-		dgAssert (info->m_allocator == this);
+	dgMemoryInfo* const info = ((dgMemoryInfo*) (ptr)) - 1;
+	dgAssert (info->m_allocator == this);
 
-		dgMemoryBin* const bin = (dgMemoryBin*) info->m_ptr;
-		bin->m_info.m_count ++;
+	dgMemoryBin* const bin = (dgMemoryBin*) info->m_ptr;
+	bin->m_info.m_count ++;
 
-		#ifdef __TRACK_MEMORY_LEAKS__
-		m_leaklTracker.InsertBlock (dgInt32 (memsize), ptr);
-		#endif
+	#ifdef __TRACK_MEMORY_LEAKS__
+	m_leaklTracker.InsertBlock (dgInt32 (memsize), ptr);
+	#endif
 
-	}
 	return ptr;
 }
 
-// alloca memory on pool that are quantized to DG_MEMORY_GRANULARITY
-// if memory size is larger than DG_MEMORY_BIN_ENTRIES then the memory is not placed into a pool
-void dgMemoryAllocator::Free (void* const retPtr)
+void dgMemoryAllocator::FreeBlock (dgMemDirectory* const directory, void* const retPtr)
 {
 	dgMemoryInfo* const info = ((dgMemoryInfo*) (retPtr)) - 1;
 	dgAssert (info->m_allocator == this);
 
 	dgInt32 entry = info->m_size;
+	dgAssert (entry < DG_MEMORY_BIN_ENTRIES);
 
-	if (entry >= DG_MEMORY_BIN_ENTRIES) {
-		FreeLow (retPtr);
-	} else {
-		#ifdef __TRACK_MEMORY_LEAKS__
-		m_leaklTracker.RemoveBlock (retPtr);
-		#endif
+	#ifdef __TRACK_MEMORY_LEAKS__
+	m_leaklTracker.RemoveBlock (retPtr);
+	#endif
 
-		dgMemoryCacheEntry* const cashe = (dgMemoryCacheEntry*) (((char*)retPtr) - DG_MEMORY_GRANULARITY) ;
+	dgMemoryCacheEntry* const cashe = (dgMemoryCacheEntry*) (((char*)retPtr) - DG_MEMORY_GRANULARITY) ;
 
-		dgMemoryCacheEntry* const tmpCashe = m_memoryDirectory[entry].m_cache;
-		if (tmpCashe) {
-			dgAssert (!tmpCashe->m_prev);
-			tmpCashe->m_prev = cashe;
-		}
-		cashe->m_next = tmpCashe;
-		cashe->m_prev = NULL;
+	dgMemoryCacheEntry* const tmpCashe = directory[entry].m_cache;
+	if (tmpCashe) {
+		dgAssert (!tmpCashe->m_prev);
+		tmpCashe->m_prev = cashe;
+	}
+	cashe->m_next = tmpCashe;
+	cashe->m_prev = NULL;
 
-		m_memoryDirectory[entry].m_cache = cashe;
+	directory[entry].m_cache = cashe;
 
-		dgMemoryBin* const bin = (dgMemoryBin *) info->m_ptr;
+	dgMemoryBin* const bin = (dgMemoryBin *) info->m_ptr;
 
-		dgAssert (bin);
+	dgAssert (bin);
 #ifdef _DEBUG
-		dgAssert ((bin->m_info.m_stepInBites - DG_MEMORY_GRANULARITY) > 0);
-		memset (retPtr, 0, bin->m_info.m_stepInBites - DG_MEMORY_GRANULARITY);
+	dgAssert ((bin->m_info.m_stepInBites - DG_MEMORY_GRANULARITY) > 0);
+	memset (retPtr, 0, bin->m_info.m_stepInBites - DG_MEMORY_GRANULARITY);
 #endif
 
-		bin->m_info.m_count --;
-		if (bin->m_info.m_count == 0) {
-
-			dgInt32 count = bin->m_info.m_totalCount;
-			dgInt32 sizeInBytes = bin->m_info.m_stepInBites;
-			char* charPtr = bin->m_pool;
-			for (dgInt32 i = 0; i < count; i ++) {
-				dgMemoryCacheEntry* const tmpCashe1 = (dgMemoryCacheEntry*)charPtr;
-				charPtr += sizeInBytes;
-
-				if (tmpCashe1 == m_memoryDirectory[entry].m_cache) {
-					m_memoryDirectory[entry].m_cache = tmpCashe1->m_next;
-				}
+	bin->m_info.m_count --;
+	if (bin->m_info.m_count == 0) {
 
-				if (tmpCashe1->m_prev) {
-					tmpCashe1->m_prev->m_next = tmpCashe1->m_next;
-				}
+		dgInt32 count = bin->m_info.m_totalCount;
+		dgInt32 sizeInBytes = bin->m_info.m_stepInBites;
+		char* charPtr = bin->m_pool;
+		for (dgInt32 i = 0; i < count; i ++) {
+			dgMemoryCacheEntry* const tmpCashe1 = (dgMemoryCacheEntry*)charPtr;
+			charPtr += sizeInBytes;
 
-				if (tmpCashe1->m_next) {
-					tmpCashe1->m_next->m_prev = tmpCashe1->m_prev;
-				}
+			if (tmpCashe1 == directory[entry].m_cache) {
+				directory[entry].m_cache = tmpCashe1->m_next;
 			}
 
-			if (m_memoryDirectory[entry].m_first == bin) {
-				m_memoryDirectory[entry].m_first = bin->m_info.m_next;
+			if (tmpCashe1->m_prev) {
+				tmpCashe1->m_prev->m_next = tmpCashe1->m_next;
 			}
 
-			if (bin->m_info.m_next) {
-				bin->m_info.m_next->m_info.m_prev = bin->m_info.m_prev;
-			}
-			if (bin->m_info.m_prev) {
-				bin->m_info.m_prev->m_info.m_next = bin->m_info.m_next;
+			if (tmpCashe1->m_next) {
+				tmpCashe1->m_next->m_prev = tmpCashe1->m_prev;
 			}
+		}
+
+		if (directory[entry].m_first == bin) {
+			directory[entry].m_first = bin->m_info.m_next;
+		}
+
+		if (bin->m_info.m_next) {
+			bin->m_info.m_next->m_info.m_prev = bin->m_info.m_prev;
+		}
+		if (bin->m_info.m_prev) {
+			bin->m_info.m_prev->m_info.m_next = bin->m_info.m_next;
+		}
+
+		FreeLow (bin);
+	}
+}
+
+// alloca memory on pool that are quantized to DG_MEMORY_GRANULARITY
+// if memory size is larger than DG_MEMORY_BIN_ENTRIES then the memory is not placed into a pool
+// pool blocks come from the calling thread cache, so that worker threads can allocate without locks
+void *dgMemoryAllocator::Malloc (dgInt32 memsize)
+{
+	dgAssert (dgInt32 (sizeof (dgMemoryCacheEntry) + sizeof (dgInt32) + sizeof(dgInt32)) <= DG_MEMORY_GRANULARITY);
+
+	dgInt32 size = memsize + DG_MEMORY_GRANULARITY - 1;
+	size &= (-DG_MEMORY_GRANULARITY);
+
+	dgInt32 paddedSize = size + DG_MEMORY_GRANULARITY; 
+	dgInt32 entry = paddedSize >> DG_MEMORY_GRANULARITY_BITS;	
 
-			FreeLow (bin);
+	if (entry >= DG_MEMORY_BIN_ENTRIES) {
+		return MallocLow (size);
+	}
+
+	dgThreadCache* const cache = GetThreadCache();
+	if (cache) {
+		if ((!cache->m_memoryDirectory[entry].m_cache && cache->m_remoteFree) || (cache->m_remoteCount >= DG_MEMORY_REMOTE_FLUSH_COUNT)) {
+			FlushRemoteBlocks (cache);
+		}
+		return MallocBlock (cache->m_memoryDirectory, cache, memsize);
+	}
+
+	dgSpinLock (&m_lock, false);
+	void* const ptr = MallocBlock (m_memoryDirectory, NULL, memsize);
+	dgSpinUnlock (&m_lock);
+	return ptr;
+}
+
+// alloca memory on pool that are quantized to DG_MEMORY_GRANULARITY
+// if memory size is larger than DG_MEMORY_BIN_ENTRIES then the memory is not placed into a pool
+// blocks freed by a thread other than the owner of the bin are pushed into the owner remote stack
+void dgMemoryAllocator::Free (void* const retPtr)
+{
+	dgMemoryInfo* const info = ((dgMemoryInfo*) (retPtr)) - 1;
+	dgAssert (info->m_allocator == this);
+
+	dgInt32 entry = info->m_size;
+
+	if (entry >= DG_MEMORY_BIN_ENTRIES) {
+		FreeLow (retPtr);
+	} else {
+		dgMemoryBin* const bin = (dgMemoryBin *) info->m_ptr;
+		dgThreadCache* const owner = bin->m_info.m_owner;
+		if (!owner) {
+			dgSpinLock (&m_lock, false);
+			FreeBlock (m_memoryDirectory, retPtr);
+			dgSpinUnlock (&m_lock);
+		} else if ((m_threadCacheSlot > 0) && (m_threadCaches[m_threadCacheSlot - 1] == owner)) {
+			FreeBlock (owner->m_memoryDirectory, retPtr);
+			if (owner->m_remoteCount >= DG_MEMORY_REMOTE_FLUSH_COUNT) {
+				FlushRemoteBlocks (owner);
+			}
+		} else {
+			dgMemoryCacheEntry* const cashe = (dgMemoryCacheEntry*) (((char*)retPtr) - DG_MEMORY_GRANULARITY);
+			dgMemoryCacheEntry* head;
+			do {
+				head = owner->m_remoteFree;
+				cashe->m_next = head;
+			} while (dgInterlockedCompareExchange((void**) &owner->m_remoteFree, cashe, head) != head);
+			dgAtomicExchangeAndAdd (&owner->m_remoteCount, 1);
 		}
 	}
 }
@@ -470,17 +613,13 @@ dgInt32 dgMemoryAllocator::GetGlobalMemoryUsed ()
 // but because of many complaint I changed it to use malloc and free
 void* dgApi dgMallocStack (size_t size)
 {
-	DG_MEMORY_THREAD_SANITY_CHECK_LOCK();
 	void * const ptr = dgGlobalAllocator::GetGlobalAllocator().MallocLow (dgInt32 (size));
-	DG_MEMORY_THREAD_SANITY_CHECK_UNLOCK();
 	return ptr;
 }
 
 void* dgApi dgMallocAligned (size_t size, dgInt32 align)
 {
-	DG_MEMORY_THREAD_SANITY_CHECK_LOCK();
 	void * const ptr = dgGlobalAllocator::GetGlobalAllocator().MallocLow (dgInt32 (size), align);
-	DG_MEMORY_THREAD_SANITY_CHECK_UNLOCK();
 	return ptr;
 	
 }
@@ -491,9 +630,7 @@ void* dgApi dgMallocAligned (size_t size, dgInt32 align)
 // but because of many complaint I changed it to use malloc and free
 void  dgApi dgFreeStack (void* const ptr)
 {
-	DG_MEMORY_THREAD_SANITY_CHECK_LOCK();
 	dgGlobalAllocator::GetGlobalAllocator().FreeLow (ptr);
-	DG_MEMORY_THREAD_SANITY_CHECK_UNLOCK();
 }
 
 
@@ -503,12 +640,10 @@ void* dgApi dgMalloc (size_t size, dgMemoryAllocator* const allocator)
 	void* ptr = NULL;
 	dgAssert (allocator);
 
-	DG_MEMORY_THREAD_SANITY_CHECK_LOCK();
 	if (size) {
 		ptr = allocator->Malloc (dgInt32 (size));
 	}
 
-	DG_MEMORY_THREAD_SANITY_CHECK_UNLOCK();
 	return ptr;
 }
 
@@ -517,13 +652,11 @@ void* dgApi dgMalloc (size_t size, dgMemoryAllocator* const allocator)
 void dgApi dgFree (void* const ptr)
 {
 	if (ptr) {
-		DG_MEMORY_THREAD_SANITY_CHECK_LOCK();
-		dgMemoryAllocator::dgMemoryInfo* info;
+			dgMemoryAllocator::dgMemoryInfo* info;
 		info = ((dgMemoryAllocator::dgMemoryInfo*) ptr) - 1; 
 		dgAssert (info->m_allocator);
 		info->m_allocator->Free (ptr);
-		DG_MEMORY_THREAD_SANITY_CHECK_UNLOCK();
-	}
+		}
 }
 
 
@@ -75,10 +75,13 @@ class dgMemoryAllocator
 	#define DG_MEMORY_SIZE						(1024 - 64)
 	#define DG_MEMORY_BIN_SIZE					(1024 * 16)
 	#define DG_MEMORY_BIN_ENTRIES				(DG_MEMORY_SIZE / DG_MEMORY_GRANULARITY)
+	#define DG_MEMORY_THREAD_CACHE_COUNT		64
+	#define DG_MEMORY_REMOTE_FLUSH_COUNT		256
 
 	public: 
 	class dgMemoryBin;
 	class dgMemoryInfo;
+	class dgThreadCache;
 	class dgMemoryCacheEntry;
 
 	class dgMemDirectory
@@ -131,20 +134,33 @@ class dgMemoryAllocator
 	static dgInt32 GetGlobalMemoryUsed ();
 	static void SetGlobalAllocators (dgMemAlloc alloc, dgMemFree free);
 
+	// gives back the thread cache slot of the calling thread, 
+	// it is also called when a thread that allocated memory exits.
+	static void ReleaseThreadCache ();
+
 	protected:
 	dgMemoryAllocator (bool init)
 	{	
+		m_lock = 0;
 		m_memoryUsed = 0;
 		m_isInList = false;
+		memset (m_threadCaches, 0, sizeof (m_threadCaches));
 	}
 	dgMemoryAllocator (dgMemAlloc memAlloc, dgMemFree memFree);
 
+	dgThreadCache* GetThreadCache ();
+	void FlushRemoteBlocks (dgThreadCache* const cache);
+	void* MallocBlock (dgMemDirectory* const directory, dgThreadCache* const owner, dgInt32 memsize);
+	void FreeBlock (dgMemDirectory* const directory, void* const retPtr);
+
+	dgInt32 m_lock;
 	dgInt32 m_emumerator;
 	dgInt32 m_memoryUsed;
 	bool m_isInList;
 	dgMemFree m_free;
 	dgMemAlloc m_malloc;
 	dgMemDirectory m_memoryDirectory[DG_MEMORY_BIN_ENTRIES + 1]; 
+	dgThreadCache* m_threadCaches[DG_MEMORY_THREAD_CACHE_COUNT];
 
 #ifdef __TRACK_MEMORY_LEAKS__
 	dgMemoryLeaksTracker m_leaklTracker;
@@ -21,6 +21,7 @@
 
 #include "dgStdafx.h"
 #include "dgThread.h"
+#include "dgMemory.h"
 
 
 
@@ -71,6 +72,10 @@ void dgThread::dgSemaphore::Release ()
 {
 }
 
+void dgThread::dgSemaphore::Wait()
+{
+}
+
 
 dgThread::~dgThread ()
 {
@@ -164,6 +169,7 @@ void* dgThread::dgThreadSystemCallback(void* threadData)
 
 	dgInterlockedExchange(&me->m_threadRunning, 1);
 	me->Execute(me->m_id);
+	dgMemoryAllocator::ReleaseThreadCache();
 	dgInterlockedExchange(&me->m_threadRunning, 0);
 	dgThreadYield();
 	return 0;
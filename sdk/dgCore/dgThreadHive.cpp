@@ -29,8 +29,10 @@ dgThreadHive::dgThreadBee::dgThreadBee()
 	:dgThread()
 	,m_isBusy(0)
 	,m_myMutex()
+	,m_masterMutex()
 	,m_hive(NULL)
 	,m_allocator(NULL)
+	,m_jobsPool()
 {
 }
 
@@ -47,6 +49,7 @@ void dgThreadHive::dgThreadBee::SetUp(dgMemoryAllocator* const allocator, const
 {
 	m_allocator = allocator;
 	m_hive = hive;
+	m_jobsPool.Init(allocator, DG_THREAD_POOL_JOB_SIZE);
 	Init (name, id);
 }
 
@@ -65,8 +68,8 @@ void dgThreadHive::dgThreadBee::Execute (dgInt32 threadId)
 		SuspendExecution(m_myMutex);
 		dgInterlockedExchange(&m_isBusy, 1);
 		if (!m_terminate) {
-			RunNextJobInQueue(threadId);
-			m_hive->m_myMutex[threadId].Release();
+			RunJobs(threadId);
+			m_masterMutex.Release();
 		}
 	}
 
@@ -76,37 +79,39 @@ void dgThreadHive::dgThreadBee::Execute (dgInt32 threadId)
 }
 
 
-void dgThreadHive::dgThreadBee::RunNextJobInQueue(dgInt32 threadId)
+void dgThreadHive::dgThreadBee::RunJobs(dgInt32 threadId)
 {
-	bool isEmpty = false;
-	do {
+	dgAssert (threadId == m_id);
+	// keep running and stealing until every queued job, including the continuations queued by other jobs, is completed
+	while (*((volatile dgInt32*)&m_hive->m_pendingJobs)) {
 		dgThreadJob job;
-		dgAssert (threadId == m_id);
-		m_hive->m_jobsCriticalSection.Lock(false);
-		isEmpty = m_hive->m_jobsPool.IsEmpty();
-		if (!isEmpty) {
-			job = m_hive->m_jobsPool.GetHead();
-			m_hive->m_jobsPool.Pop();
-		}
-		m_hive->m_jobsCriticalSection.Unlock();
-
-		if (!isEmpty) {
-			job.m_callback (job.m_context0, job.m_context1, m_id);
+		if (m_hive->GetNextJob(threadId, job)) {
+			m_hive->ExecuteJob(threadId, job);
+			if (dgAtomicExchangeAndAdd(&m_hive->m_pendingJobs, -1) == 1) {
+				m_hive->WakeIdleBees(m_hive->m_beesCount);
+			}
+		} else {
+			m_hive->WaitForJobs();
 		}
-	} while (!isEmpty);
+	}
 }
 
 
 dgThreadHive::dgThreadHive(dgMemoryAllocator* const allocator)
 	:m_beesCount(0)
+	,m_maxBeesCount(DG_MIN_THREADS_HIVE_LIMIT)
 	,m_currentIdleBee(0)
+	,m_pendingJobs(0)
+	,m_idleBees(0)
 	,m_workerBees(NULL)
 	,m_myMasterThread(NULL)
 	,m_allocator(allocator)
-	,m_jobsCriticalSection()
+	,m_jobsSemaphore()
 	,m_globalCriticalSection()
-    ,m_jobsPool(allocator)
 {
+	#ifndef DG_USE_THREAD_EMULATION
+		m_maxBeesCount = dgMax (dgInt32 (std::thread::hardware_concurrency()), m_maxBeesCount);
+	#endif
 }
 
 dgThreadHive::~dgThreadHive()
@@ -135,14 +140,14 @@ dgInt32 dgThreadHive::GetThreadCount() const
 
 dgInt32 dgThreadHive::GetMaxThreadCount() const
 {
-	return DG_MAX_THREADS_HIVE_COUNT;
+	return m_maxBeesCount;
 }
 
 void dgThreadHive::SetThreadsCount (dgInt32 threads)
 {
 	DestroyThreads();
 
-	m_beesCount = dgMin (threads, DG_MAX_THREADS_HIVE_COUNT);
+	m_beesCount = dgMin (threads, m_maxBeesCount);
 	if (m_beesCount == 1) {
 		m_beesCount = 0;
 	}
@@ -159,24 +164,180 @@ void dgThreadHive::SetThreadsCount (dgInt32 threads)
 }
 
 
-void dgThreadHive::QueueJob (dgWorkerThreadTaskCallback callback, void* const context0, void* const context1)
+bool dgThreadHive::HasJobs () const
+{
+	for (dgInt32 i = 0; i < m_beesCount; i ++) {
+		if (!m_workerBees[i].m_jobsPool.IsEmpty()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+bool dgThreadHive::GetNextJob (dgInt32 threadID, dgThreadJob& job)
+{
+	if (m_workerBees[threadID].m_jobsPool.Pop(job)) {
+		return true;
+	}
+
+	for (dgInt32 i = 1; i < m_beesCount; i ++) {
+		dgInt32 victim = threadID + i;
+		victim = (victim >= m_beesCount) ? victim - m_beesCount : victim;
+		if (m_workerBees[victim].m_jobsPool.Steal(job)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+void dgThreadHive::PushJob (dgInt32 threadID, const dgThreadJob& job)
+{
+	dgWorkStealingQueue<dgThreadJob>& queue = m_workerBees[threadID].m_jobsPool;
+	if (queue.IsFull()) {
+		// the owner can not grow the queue while other workers may be allocating memory, run the job in place.
+		ExecuteJob (threadID, job);
+	} else {
+		dgAtomicExchangeAndAdd(&m_pendingJobs, 1);
+		queue.Push(job);
+		WakeIdleBees(1);
+	}
+}
+
+
+void dgThreadHive::PushMasterJob (const dgThreadJob& job)
+{
+	// workers are suspended, so the master thread can fill and grow their queues
+	dgWorkStealingQueue<dgThreadJob>& queue = m_workerBees[m_currentIdleBee].m_jobsPool;
+	if (queue.IsFull()) {
+		queue.Grow();
+	}
+	queue.Push(job);
+	m_pendingJobs ++;
+	m_currentIdleBee = (m_currentIdleBee + 1 < m_beesCount) ? m_currentIdleBee + 1 : 0;
+}
+
+
+void dgThreadHive::ExecuteJob (dgInt32 threadID, const dgThreadJob& job)
+{
+	job.m_callback (job.m_context0, job.m_context1, threadID);
+	if (job.m_counter) {
+		CompleteJob (threadID, job.m_counter);
+	}
+}
+
+
+void dgThreadHive::CompleteJob (dgInt32 threadID, dgThreadJobCounter* const counter)
+{
+	// the counter can go out of scope as soon as it reaches zero, read the continuation first
+	const dgThreadJob continuation (counter->m_continuation);
+	if ((dgAtomicExchangeAndAdd(&counter->m_pending, -1) == 1) && continuation.m_callback) {
+		if (!m_beesCount) {
+			ExecuteJob (dgMax (threadID, 0), continuation);
+		} else {
+			#ifdef DG_USE_THREAD_EMULATION
+				ExecuteJob (dgMax (threadID, 0), continuation);
+			#else 
+				if (threadID >= 0) {
+					PushJob (threadID, continuation);
+				} else {
+					PushMasterJob (continuation);
+				}
+			#endif
+		}
+	}
+}
+
+
+void dgThreadHive::QueueJob (dgWorkerThreadTaskCallback callback, void* const context0, void* const context1, dgThreadJobCounter* const counter)
 {
+	if (counter) {
+		dgAtomicExchangeAndAdd(&counter->m_pending, 1);
+	}
+	dgThreadJob job (context0, context1, callback, counter);
 	if (!m_beesCount) {
-		callback (context0, context1, 0);
+		ExecuteJob (0, job);
 	} else {
 		#ifdef DG_USE_THREAD_EMULATION
-			callback (context0, context1, 0);
+			ExecuteJob (0, job);
 		#else 
-			dgThreadJob job (context0, context1, callback);
-			m_jobsPool.Push(job);
-			if (m_jobsPool.IsFull()) {
-				SynchronizationBarrier ();
-			}
+			PushMasterJob (job);
 		#endif
 	}
 }
 
 
+void dgThreadHive::CloseJobGroup (dgThreadJobCounter* const counter)
+{
+	CompleteJob (-1, counter);
+}
+
+
+void dgThreadHive::SpawnJob (dgInt32 threadID, dgWorkerThreadTaskCallback callback, void* const context0, void* const context1, dgThreadJobCounter* const counter)
+{
+	if (counter) {
+		dgAtomicExchangeAndAdd(&counter->m_pending, 1);
+	}
+	dgThreadJob job (context0, context1, callback, counter);
+	if (!m_beesCount) {
+		ExecuteJob (threadID, job);
+	} else {
+		#ifdef DG_USE_THREAD_EMULATION
+			ExecuteJob (threadID, job);
+		#else 
+			PushJob (threadID, job);
+		#endif
+	}
+}
+
+
+void dgThreadHive::CloseJobGroup (dgInt32 threadID, dgThreadJobCounter* const counter)
+{
+	dgAssert (threadID >= 0);
+	CompleteJob (threadID, counter);
+}
+
+
+// the waiting job still counts as pending, so the other workers keep running until the group is done.
+// without workers the jobs of the group already ran inline when they were spawned.
+void dgThreadHive::WaitForJobGroup (dgInt32 threadID, dgThreadJobCounter* const counter)
+{
+	while (!counter->IsDone()) {
+		dgThreadJob job;
+		if (m_beesCount && GetNextJob(threadID, job)) {
+			ExecuteJob(threadID, job);
+			dgAtomicExchangeAndAdd(&m_pendingJobs, -1);
+		} else {
+			dgThreadYield();
+		}
+	}
+}
+
+
+// a bee that finds nothing to run or steal sleeps until a job is pushed or the last pending job is completed.
+// the pusher and the sleeper each announce themselves before checking the other side, so a wake up is never lost,
+// a release that finds the bee already awake only costs one extra pass of the loop.
+void dgThreadHive::WaitForJobs ()
+{
+	dgAtomicExchangeAndAdd(&m_idleBees, 1);
+	if (*((volatile dgInt32*)&m_pendingJobs) && !HasJobs()) {
+		m_jobsSemaphore.Wait();
+	}
+	dgAtomicExchangeAndAdd(&m_idleBees, -1);
+}
+
+
+void dgThreadHive::WakeIdleBees (dgInt32 count)
+{
+	dgMemoryBarrier();
+	count = dgMin (count, *((volatile dgInt32*)&m_idleBees));
+	for (dgInt32 i = 0; i < count; i ++) {
+		m_jobsSemaphore.Release();
+	}
+}
+
+
 void dgThreadHive::OnBeginWorkerThread (dgInt32 threadId)
 {
 }
@@ -193,9 +354,13 @@ void dgThreadHive::SynchronizationBarrier ()
 			m_workerBees[i].m_myMutex.Release();
 		}
 
-		m_myMasterThread->SuspendExecution(m_beesCount, m_myMutex);
-		dgAssert (m_jobsPool.IsEmpty());
+		for (dgInt32 i = 0; i < m_beesCount; i ++) {
+			m_myMasterThread->SuspendExecution(m_workerBees[i].m_masterMutex);
+		}
+		dgAssert (!m_pendingJobs);
+		for (dgInt32 i = 0; i < m_beesCount; i ++) {
+			m_workerBees[i].m_jobsPool.Reset();
+		}
+		m_currentIdleBee = 0;
 	}
 }
-
-
@@ -25,18 +25,18 @@
 
 #include "dgThread.h"
 #include "dgMemory.h"
-#include "dgFastQueue.h"
+#include "dgWorkStealingQueue.h"
 
 
-
-//#define DG_THREAD_POOL_JOB_SIZE (512)
-#define DG_THREAD_POOL_JOB_SIZE (1024 * 8)
+// initial capacity of each worker's job queue, the queues grow on demand
+#define DG_THREAD_POOL_JOB_SIZE (1024)
 
 typedef void (*dgWorkerThreadTaskCallback) (void* const context0, void* const context1, dgInt32 threadID);
 
 class dgThreadHive  
 {
 	public:
+	class dgThreadJobCounter;
 
 	class dgThreadJob
 	{
@@ -45,17 +45,48 @@ class dgThreadHive
 		{
 		}
 
-		dgThreadJob (void* const context0, void* const context1, dgWorkerThreadTaskCallback callback)
+		dgThreadJob (void* const context0, void* const context1, dgWorkerThreadTaskCallback callback, dgThreadJobCounter* const counter = NULL)
 			:m_context0(context0)
 			,m_context1(context1)
 			,m_callback(callback)
+			,m_counter(counter)
 		{
 		}
 		void* m_context0;
 		void* m_context1;
 		dgWorkerThreadTaskCallback m_callback;
+		dgThreadJobCounter* m_counter;
 	};
 
+	// tracks a group of jobs queued by the master thread or spawned by a running job.
+	// A group stays open until it is closed, after that the thread that completes the last job 
+	// queues the optional continuation, which can in turn belong to a parent group.
+	class dgThreadJobCounter
+	{
+		public:
+		dgThreadJobCounter ()
+			:m_pending(1)
+			,m_continuation(NULL, NULL, NULL, NULL)
+		{
+		}
+
+		dgThreadJobCounter (dgWorkerThreadTaskCallback continuation, void* const context0, void* const context1, dgThreadJobCounter* const parent = NULL)
+			:m_pending(1)
+			,m_continuation(context0, context1, continuation, parent)
+		{
+			if (parent) {
+				dgAtomicExchangeAndAdd(&parent->m_pending, 1);
+			}
+		}
+
+		bool IsDone() const
+		{
+			return *((volatile dgInt32*)&m_pending) == 0;
+		}
+
+		dgInt32 m_pending;
+		dgThreadJob m_continuation;
+	};
 
 	class dgThreadBee: public dgThread
 	{
@@ -69,12 +100,14 @@ class dgThreadHive
 		void SetUp(dgMemoryAllocator* const allocator, const char* const name, dgInt32 id, dgThreadHive* const hive);
 		virtual void Execute (dgInt32 threadId);
 
-		void RunNextJobInQueue(dgInt32 threadId);
+		void RunJobs(dgInt32 threadId);
 
 		dgInt32 m_isBusy;
 		dgSemaphore m_myMutex;
+		dgSemaphore m_masterMutex;
 		dgThreadHive* m_hive;
 		dgMemoryAllocator* m_allocator; 
+		dgWorkStealingQueue<dgThreadJob> m_jobsPool;
 	};
 
 	dgThreadHive(dgMemoryAllocator* const allocator);
@@ -95,21 +128,38 @@ class dgThreadHive
 	dgInt32 GetMaxThreadCount() const;
 	void SetThreadsCount (dgInt32 count);
 
-	void QueueJob (dgWorkerThreadTaskCallback callback, void* const context0, void* const context1);
+	// called from the master thread, jobs run at the next synchronization barrier
+	void QueueJob (dgWorkerThreadTaskCallback callback, void* const context0, void* const context1, dgThreadJobCounter* const counter = NULL);
+	void CloseJobGroup (dgThreadJobCounter* const counter);
 	void SynchronizationBarrier ();
 
+	// called from inside a running job, the job goes to the queue of the calling thread where idle workers can steal it
+	void SpawnJob (dgInt32 threadID, dgWorkerThreadTaskCallback callback, void* const context0, void* const context1, dgThreadJobCounter* const counter = NULL);
+	void CloseJobGroup (dgInt32 threadID, dgThreadJobCounter* const counter);
+	// called from inside a running job, runs queued jobs until every job of a closed group is completed
+	void WaitForJobGroup (dgInt32 threadID, dgThreadJobCounter* const counter);
+
 	private:
 	void DestroyThreads();
+	bool HasJobs () const;
+	bool GetNextJob (dgInt32 threadID, dgThreadJob& job);
+	void ExecuteJob (dgInt32 threadID, const dgThreadJob& job);
+	void CompleteJob (dgInt32 threadID, dgThreadJobCounter* const counter);
+	void PushJob (dgInt32 threadID, const dgThreadJob& job);
+	void PushMasterJob (const dgThreadJob& job);
+	void WaitForJobs ();
+	void WakeIdleBees (dgInt32 count);
 
 	dgInt32 m_beesCount;
+	dgInt32 m_maxBeesCount;
 	dgInt32 m_currentIdleBee;
+	dgInt32 m_pendingJobs;
+	dgInt32 m_idleBees;
 	dgThreadBee* m_workerBees;
 	dgThread* m_myMasterThread;
 	dgMemoryAllocator* m_allocator;
-	dgThread::dgCriticalSection m_jobsCriticalSection;
+	dgThread::dgSemaphore m_jobsSemaphore;
 	mutable dgThread::dgCriticalSection m_globalCriticalSection;
-	dgThread::dgSemaphore m_myMutex[DG_MAX_THREADS_HIVE_COUNT];
-	dgFastQueue<dgThreadJob, DG_THREAD_POOL_JOB_SIZE> m_jobsPool;
 };
 
 
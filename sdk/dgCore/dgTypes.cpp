@@ -545,6 +545,61 @@ dgInt32 dgDeserializeMarker(dgDeserialize serializeCallback, void* const userDat
 }
 
 
+void dgApi dgImageWriterCallback (void* const userData, const void* const buffer, dgInt32 size)
+{
+	// a writer without a callback only measures the image
+	dgImageWriter* const writer = (dgImageWriter*) userData;
+	if (writer->m_callback) {
+		writer->m_callback (writer->m_userData, buffer, size);
+	}
+	writer->m_offset += size;
+}
+
+void dgApi dgImageReaderCallback (void* const userData, void* buffer, dgInt32 size)
+{
+	dgImageReader* const reader = (dgImageReader*) userData;
+	dgAssert ((reader->m_offset + size) <= reader->m_size);
+	memcpy (buffer, &reader->m_image[reader->m_offset], size);
+	reader->m_offset += size;
+}
+
+void dgSerializeAlign (dgSerialize serializeCallback, void* const userData)
+{
+	// regular streams are not padded, so that they stay compatible with older files
+	if (serializeCallback == dgImageWriterCallback) {
+		const dgImageWriter* const writer = (dgImageWriter*) userData;
+		const dgInt32 padding = (DG_IMAGE_ALIGNMENT - (writer->m_offset & (DG_IMAGE_ALIGNMENT - 1))) & (DG_IMAGE_ALIGNMENT - 1);
+		if (padding) {
+			const dgInt8 zeros[DG_IMAGE_ALIGNMENT] = {0};
+			serializeCallback (userData, zeros, padding);
+		}
+	}
+}
+
+void dgSerializeArray (dgSerialize serializeCallback, void* const userData, const void* const buffer, dgInt32 size)
+{
+	dgSerializeAlign (serializeCallback, userData);
+	serializeCallback (userData, buffer, size);
+}
+
+void* dgDeserializeArray (dgDeserialize serializeCallback, void* const userData, dgInt32 size, bool& inPlace)
+{
+	if (serializeCallback == dgImageReaderCallback) {
+		dgImageReader* const reader = (dgImageReader*) userData;
+		reader->m_offset = (reader->m_offset + DG_IMAGE_ALIGNMENT - 1) & -DG_IMAGE_ALIGNMENT;
+		dgAssert ((reader->m_offset + size) <= reader->m_size);
+		void* const buffer = (void*) &reader->m_image[reader->m_offset];
+		reader->m_offset += size;
+		inPlace = true;
+		return buffer;
+	}
+	void* const buffer = dgMallocStack (size);
+	serializeCallback (userData, buffer, size);
+	inPlace = false;
+	return buffer;
+}
+
+
 void dgSpinLock (dgInt32* const ptr, bool yield)
 {
 	#ifndef DG_USE_THREAD_EMULATION 
@@ -201,7 +201,9 @@
 #endif
 
 
-#define	DG_MAX_THREADS_HIVE_COUNT		16
+// lower bound of the number of worker threads a thread hive can be configured with, 
+// the actual limit is the number of hardware threads when that is larger.
+#define	DG_MIN_THREADS_HIVE_LIMIT		16
 
 #ifdef _DEBUG
 //#define __ENABLE_DG_CONTAINERS_SANITY_CHECK 
@@ -220,6 +222,13 @@
 #endif
 
 
+#if (defined (_WIN_32_VER) || defined (_WIN_64_VER))
+	#define DG_THREAD_LOCAL __declspec(thread)
+#else 
+	#define DG_THREAD_LOCAL __thread
+#endif
+
+
 #define DG_VECTOR_SIMD_SIZE		16
 #define DG_VECTOR_AVX2_SIZE		32
 
@@ -540,7 +549,7 @@ void dgRadixSort (T* const array, T* const tmpArray, dgInt32 elements, dgInt32 r
 			
 			dgInt32 radixShift = (radix + 1) << 3;
 			for (dgInt32 i = 0; i < elements; i ++) {
-				dgInt32 key = (getRadixKey (&array[i], context) >> radixShift) & 0xff;
+				dgInt32 key = (getRadixKey (&tmpArray[i], context) >> radixShift) & 0xff;
 				dgInt32 index = scanCount[key];
 				array[index] = tmpArray[i];
 				scanCount[key] = index + 1;
@@ -552,7 +561,7 @@ void dgRadixSort (T* const array, T* const tmpArray, dgInt32 elements, dgInt32 r
 
 #ifdef _DEBUG
 	for (dgInt32 i = 0; i < (elements - 1); i ++) {
-		dgAssert (getRadixKey (&array[i], context) <= getRadixKey (&array[i + 1], context));
+		dgAssert (dgUnsigned32 (getRadixKey (&array[i], context)) <= dgUnsigned32 (getRadixKey (&array[i + 1], context)));
 	}
 #endif
 }
@@ -771,6 +780,32 @@ dgFloat64 dgRoundToFloat(dgFloat64 val);
 void dgSerializeMarker(dgSerialize serializeCallback, void* const userData);
 dgInt32 dgDeserializeMarker(dgDeserialize serializeCallback, void* const userData);
 
+// a relocatable image is a regular serialization stream in which large arrays start at a 16 byte offset from 
+// the beginning of the image, shapes loaded from an image that is kept in memory use those arrays in place.
+#define DG_IMAGE_ALIGNMENT	16
+
+class dgImageWriter
+{
+	public:
+	dgSerialize m_callback;
+	void* m_userData;
+	dgInt32 m_offset;
+};
+
+class dgImageReader
+{
+	public:
+	const dgInt8* m_image;
+	dgInt32 m_offset;
+	dgInt32 m_size;
+};
+
+void dgApi dgImageWriterCallback (void* const userData, const void* const buffer, dgInt32 size);
+void dgApi dgImageReaderCallback (void* const userData, void* buffer, dgInt32 size);
+void dgSerializeAlign (dgSerialize serializeCallback, void* const userData);
+void dgSerializeArray (dgSerialize serializeCallback, void* const userData, const void* const buffer, dgInt32 size);
+void* dgDeserializeArray (dgDeserialize serializeCallback, void* const userData, dgInt32 size, bool& inPlace);
+
 class dgFloatExceptions
 {
 	public:
@@ -829,6 +864,62 @@ DG_INLINE dgInt32 dgInterlockedExchange(dgInt32* const ptr, dgInt32 value)
 	#endif
 }
 
+DG_INLINE dgInt32 dgInterlockedCompareExchange(dgInt32* const ptr, dgInt32 value, dgInt32 comparand)
+{
+	#if (defined (_WIN_32_VER) || defined (_WIN_64_VER))
+		return _InterlockedCompareExchange((long*) ptr, value, comparand);
+	#endif
+
+	#if (defined (_MINGW_32_VER) || defined (_MINGW_64_VER))
+		return InterlockedCompareExchange((long*) ptr, value, comparand);
+	#endif
+
+	#if (defined (_POSIX_VER) || defined (_POSIX_VER_64) ||defined (_MACOSX_VER))
+		return __sync_val_compare_and_swap((int32_t*)ptr, comparand, value);
+	#endif
+}
+
+DG_INLINE void* dgInterlockedExchange(void** const ptr, void* const value)
+{
+	#if (defined (_WIN_32_VER) || defined (_WIN_64_VER))
+		return _InterlockedExchangePointer(ptr, value);
+	#endif
+
+	#if (defined (_MINGW_32_VER) || defined (_MINGW_64_VER))
+		return InterlockedExchangePointer(ptr, value);
+	#endif
+
+	#if (defined (_POSIX_VER) || defined (_POSIX_VER_64) ||defined (_MACOSX_VER))
+		return __sync_lock_test_and_set(ptr, value);
+	#endif
+}
+
+DG_INLINE void* dgInterlockedCompareExchange(void** const ptr, void* const value, void* const comparand)
+{
+	#if (defined (_WIN_32_VER) || defined (_WIN_64_VER))
+		return _InterlockedCompareExchangePointer(ptr, value, comparand);
+	#endif
+
+	#if (defined (_MINGW_32_VER) || defined (_MINGW_64_VER))
+		return InterlockedCompareExchangePointer(ptr, value, comparand);
+	#endif
+
+	#if (defined (_POSIX_VER) || defined (_POSIX_VER_64) ||defined (_MACOSX_VER))
+		return __sync_val_compare_and_swap(ptr, comparand, value);
+	#endif
+}
+
+DG_INLINE void dgMemoryBarrier()
+{
+	#if (defined (_WIN_32_VER) || defined (_WIN_64_VER) || defined (_MINGW_32_VER) || defined (_MINGW_64_VER))
+		MemoryBarrier();
+	#endif
+
+	#if (defined (_POSIX_VER) || defined (_POSIX_VER_64) ||defined (_MACOSX_VER))
+		__sync_synchronize();
+	#endif
+}
+
 DG_INLINE void dgThreadYield()
 {
 	#ifndef DG_USE_THREAD_EMULATION
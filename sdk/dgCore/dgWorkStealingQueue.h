@@ -0,0 +1,204 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __dgWorkStealingQueue__
+#define __dgWorkStealingQueue__
+
+#include "dgStdafx.h"
+#include "dgMemory.h"
+
+// Chase-Lev double ended queue.
+// The owner thread pushes and pops at the bottom, any other thread can steal from the top.
+// Only the owner can grow the queue, old buffers are retired until the queue is reset,
+// so that a thief that read a stale buffer pointer still reads valid items.
+template<class T>
+class dgWorkStealingQueue
+{
+	public:
+	dgWorkStealingQueue ();
+	~dgWorkStealingQueue ();
+
+	void Init (dgMemoryAllocator* const allocator, dgInt32 sizeInPowerOfTwo);
+
+	bool IsEmpty() const;
+	bool IsFull() const;
+
+	// owner thread only
+	void Push(const T& object);
+	bool Pop(T& object);
+	void Grow();
+
+	// any thread
+	bool Steal(T& object);
+
+	// only when no other thread is accessing the queue
+	void Reset();
+
+	private:
+	class dgRingBuffer
+	{
+		public:
+		T* m_pool;
+		dgRingBuffer* m_retired;
+		dgInt32 m_mask;
+	};
+
+	dgRingBuffer* CreateBuffer (dgInt32 size) const;
+	void DestroyBuffers (dgRingBuffer* buffer) const;
+
+	dgInt32 m_top;
+	dgInt32 m_padding[15];
+	dgInt32 m_bottom;
+	dgRingBuffer* volatile m_buffer;
+	dgMemoryAllocator* m_allocator;
+};
+
+
+template<class T>
+dgWorkStealingQueue<T>::dgWorkStealingQueue ()
+	:m_top(0)
+	,m_bottom(0)
+	,m_buffer(NULL)
+	,m_allocator(NULL)
+{
+}
+
+template<class T>
+dgWorkStealingQueue<T>::~dgWorkStealingQueue ()
+{
+	DestroyBuffers (m_buffer);
+}
+
+template<class T>
+void dgWorkStealingQueue<T>::Init (dgMemoryAllocator* const allocator, dgInt32 sizeInPowerOfTwo)
+{
+	dgAssert (!m_buffer);
+	dgAssert (((sizeInPowerOfTwo -1) & (-sizeInPowerOfTwo)) == 0);
+	m_allocator = allocator;
+	m_buffer = CreateBuffer (sizeInPowerOfTwo);
+}
+
+template<class T>
+typename dgWorkStealingQueue<T>::dgRingBuffer* dgWorkStealingQueue<T>::CreateBuffer (dgInt32 size) const
+{
+	dgRingBuffer* const buffer = (dgRingBuffer*) m_allocator->MallocLow(sizeof (dgRingBuffer));
+	buffer->m_pool = (T*) m_allocator->MallocLow(size * sizeof (T));
+	buffer->m_retired = NULL;
+	buffer->m_mask = size - 1;
+	return buffer;
+}
+
+template<class T>
+void dgWorkStealingQueue<T>::DestroyBuffers (dgRingBuffer* buffer) const
+{
+	while (buffer) {
+		dgRingBuffer* const retired = buffer->m_retired;
+		m_allocator->FreeLow(buffer->m_pool);
+		m_allocator->FreeLow(buffer);
+		buffer = retired;
+	}
+}
+
+template<class T>
+bool dgWorkStealingQueue<T>::IsEmpty() const
+{
+	return *((volatile dgInt32*)&m_bottom) <= *((volatile dgInt32*)&m_top);
+}
+
+template<class T>
+bool dgWorkStealingQueue<T>::IsFull() const
+{
+	return (m_bottom - *((volatile dgInt32*)&m_top)) > m_buffer->m_mask;
+}
+
+template<class T>
+void dgWorkStealingQueue<T>::Grow()
+{
+	dgRingBuffer* const buffer = m_buffer;
+	dgRingBuffer* const newBuffer = CreateBuffer ((buffer->m_mask + 1) * 2);
+	for (dgInt32 i = m_top; i < m_bottom; i ++) {
+		newBuffer->m_pool[i & newBuffer->m_mask] = buffer->m_pool[i & buffer->m_mask];
+	}
+	newBuffer->m_retired = buffer;
+	dgMemoryBarrier();
+	m_buffer = newBuffer;
+}
+
+template<class T>
+void dgWorkStealingQueue<T>::Push(const T& object)
+{
+	dgAssert (!IsFull());
+	const dgInt32 bottom = m_bottom;
+	dgRingBuffer* const buffer = m_buffer;
+	buffer->m_pool[bottom & buffer->m_mask] = object;
+	dgInterlockedExchange(&m_bottom, bottom + 1);
+}
+
+template<class T>
+bool dgWorkStealingQueue<T>::Pop(T& object)
+{
+	const dgInt32 bottom = m_bottom - 1;
+	dgRingBuffer* const buffer = m_buffer;
+	dgInterlockedExchange(&m_bottom, bottom);
+	const dgInt32 top = *((volatile dgInt32*)&m_top);
+	if (top > bottom) {
+		dgInterlockedExchange(&m_bottom, bottom + 1);
+		return false;
+	}
+
+	object = buffer->m_pool[bottom & buffer->m_mask];
+	if (top != bottom) {
+		return true;
+	}
+
+	// last item, race against the thieves
+	const bool succeeded = dgInterlockedCompareExchange(&m_top, top + 1, top) == top;
+	dgInterlockedExchange(&m_bottom, bottom + 1);
+	return succeeded;
+}
+
+template<class T>
+bool dgWorkStealingQueue<T>::Steal(T& object)
+{
+	const dgInt32 top = *((volatile dgInt32*)&m_top);
+	dgMemoryBarrier();
+	const dgInt32 bottom = *((volatile dgInt32*)&m_bottom);
+	if (top >= bottom) {
+		return false;
+	}
+
+	dgRingBuffer* const buffer = m_buffer;
+	object = buffer->m_pool[top & buffer->m_mask];
+	return dgInterlockedCompareExchange(&m_top, top + 1, top) == top;
+}
+
+template<class T>
+void dgWorkStealingQueue<T>::Reset()
+{
+	dgAssert (IsEmpty());
+	DestroyBuffers (m_buffer->m_retired);
+	m_buffer->m_retired = NULL;
+	m_top = 0;
+	m_bottom = 0;
+}
+
+#endif
+
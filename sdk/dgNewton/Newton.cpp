@@ -200,6 +200,18 @@ int NewtonGetBroadphaseAlgorithm (const NewtonWorld* const newtonWorld)
 	return world->GetBroadPhaseType();
 }
 
+/*!
+  Select the broad phase algorithm.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param algorithmType NEWTON_BROADPHASE_DEFAULT, NEWTON_BROADPHASE_PERSINTENT or NEWTON_BROADPHASE_SAP.
+
+  NEWTON_BROADPHASE_SAP sweeps the bodies sorted along the axis of largest spread,
+  in slabs across the second axis. It does not keep a tree, and is usually faster
+  for scenes with many moving bodies of similar size.
+
+  This function must be called outside of a Newton Update.
+*/
 void NewtonSelectBroadphaseAlgorithm (const NewtonWorld* const newtonWorld, int algorithmType)
 {
 	TRACE_FUNCTION(__FUNCTION__);
@@ -564,6 +576,12 @@ int NewtonGetMultiThreadSolverOnSingleIsland(const NewtonWorld* const newtonWorl
   of the joint residual acceleration. 
   If it happen that the joints residual acceleration fall below the minimum tolerance 1.0e-5
   then the solve will terminate before the number of iteration reach N.
+
+  n | NEWTON_SOLVER_MODE_SOA_JOINTS: same as n, but the joints of each cluster are packed in groups of 4 (8 when the 
+  engine is built with AVX2) joints that do not share a body, and each group is solved in the lanes of one simd register. 
+  This is faster on clusters with many similar joints like stacks and piles, each iteration is a plain projected Gauss Seidel 
+  pass so large mass ratios may need more iterations. Clusters with articulations and clusters with few joints 
+  are solved one joint at the time.
 */
 void NewtonSetSolverModel(const NewtonWorld* const newtonWorld, int model)
 {
@@ -657,6 +675,119 @@ int NewtonGetNumberOfSubsteps (const NewtonWorld* const newtonWorld)
 	return world->GetSubsteps ();
 }
 
+/*!
+  Return the largest amount of per step scratch memory the world has used.
+
+  @param *newtonWorld is the pointer to the Newton world.
+
+  @return the high water mark in bytes, added over all threads.
+
+  The scratch memory is reserved at the beginning of each update, so this is
+  the memory a simulation needs beyond its bodies, joints and contacts.
+*/
+int NewtonGetFrameMemoryHighWaterMark (const NewtonWorld* const newtonWorld)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	return world->GetFrameMemoryHighWaterMark ();
+}
+
+/*!
+  Return the per phase timing of the last update.
+
+  @param *newtonWorld is the pointer to the Newton world.
+  @param *phases array that receives one record per update phase, can be NULL.
+  @param maxPhases size of the phases array.
+
+  @return the number of phases the engine reports, zero if no update was profiled yet
+  or if the engine was built without DG_PROFILE_PHYSICS.
+
+  Times are in milliseconds. Phases that fan out to the worker threads report the
+  sum of all workers in m_threadTime, the ratio m_threadTime / (m_maxThreadTime * threadCount)
+  is the load balance of the phase.
+*/
+int NewtonWorldGetProfile (const NewtonWorld* const newtonWorld, NewtonWorldProfilePhase* const phases, int maxPhases)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	const dgProfiler& profiler = world->GetProfiler();
+	if (!profiler.HasFrame()) {
+		return 0;
+	}
+
+	const dgInt32 updateTrack = profiler.GetUpdateThreadID();
+	const dgInt32 count = phases ? dgMin (dgInt32 (dgProfiler::m_phaseCount), maxPhases) : 0;
+	for (dgInt32 i = 0; i < count; i ++) {
+		const dgProfiler::dgPhase phase = dgProfiler::dgPhase (i);
+		const dgProfiler::dgPhaseInfo& update = profiler.GetPhaseInfo (updateTrack, phase);
+
+		dgUnsigned64 threadTime = 0;
+		dgUnsigned64 maxThreadTime = 0;
+		dgInt32 calls = update.m_calls;
+		dgInt32 items = update.m_items;
+		for (dgInt32 j = 0; j < updateTrack; j ++) {
+			const dgProfiler::dgPhaseInfo& info = profiler.GetPhaseInfo (j, phase);
+			threadTime += info.m_time;
+			maxThreadTime = dgMax (maxThreadTime, info.m_time);
+			calls += info.m_calls;
+			items += info.m_items;
+		}
+
+		NewtonWorldProfilePhase& record = phases[i];
+		record.m_name = dgProfiler::GetPhaseName (phase);
+		record.m_wallTime = dFloat (dgFloat64 (update.m_calls ? update.m_time : maxThreadTime) * 1.0e-6);
+		record.m_threadTime = dFloat (dgFloat64 (threadTime) * 1.0e-6);
+		record.m_maxThreadTime = dFloat (dgFloat64 (maxThreadTime) * 1.0e-6);
+		record.m_calls = calls;
+		record.m_items = items;
+	}
+	return dgProfiler::m_phaseCount;
+}
+
+/*!
+  Return the time each worker thread spent in one phase of the last update.
+
+  @param *newtonWorld is the pointer to the Newton world.
+  @param phase index of the phase, in the order reported by NewtonWorldGetProfile.
+  @param *times array that receives the milliseconds of each worker thread.
+  @param maxThreads size of the times array.
+
+  @return the number of worker threads, zero if no update was profiled yet.
+*/
+int NewtonWorldGetProfileThreadTimes (const NewtonWorld* const newtonWorld, int phase, dFloat* const times, int maxThreads)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	const dgProfiler& profiler = world->GetProfiler();
+	if (!profiler.HasFrame() || (phase < 0) || (phase >= dgProfiler::m_phaseCount)) {
+		return 0;
+	}
+
+	const dgInt32 workers = profiler.GetUpdateThreadID();
+	const dgInt32 count = dgMin (workers, maxThreads);
+	for (dgInt32 i = 0; i < count; i ++) {
+		times[i] = dFloat (dgFloat64 (profiler.GetPhaseInfo (i, dgProfiler::dgPhase (phase)).m_time) * 1.0e-6);
+	}
+	return workers;
+}
+
+/*!
+  Write the last update as a chrome trace, that can be loaded in chrome://tracing.
+
+  @param *newtonWorld is the pointer to the Newton world.
+  @param *buffer destination of the json text, can be NULL to query the size.
+  @param bufferSize size of the buffer in bytes.
+
+  @return the size in bytes of the whole trace including the terminator. If this is
+  larger than bufferSize the buffer was too small and holds an empty string.
+*/
+int NewtonWorldGetProfileTrace (const NewtonWorld* const newtonWorld, char* const buffer, int bufferSize)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	return world->GetProfiler().ExportChromeTrace (buffer, buffer ? bufferSize : 0);
+}
+
 
 
 /*!
@@ -1068,6 +1199,118 @@ int NewtonWorldGetConstraintCount(const NewtonWorld* const newtonWorld)
 	return world->GetConstraintsCount();
 }
 
+/*!
+  Copy the position, rotation, velocity and angular velocity of a set of bodies into flat arrays.
+
+  @param *newtonWorld pointer to the Newton world.
+  @param *bodies array of *count* bodies, or NULL to read the bodies that moved on the last update, see ::NewtonWorldGetMovedBodies.
+  @param count number of entries in *bodies*, or the capacity of the *states* arrays when *bodies* is NULL.
+  @param *states destination arrays, entry i of each array belongs to the body i. a NULL array is skipped.
+
+  @return the number of bodies in the set, when *bodies* is NULL this can be larger than *count*, and only the first *count* are copied.
+
+  when *bodies* is NULL the moved bodies are also written to states->m_bodies, if it is not NULL.
+  the copy is split over the worker threads of the world, it can not be called from inside the world update.
+
+  See also: ::NewtonWorldSetBodyStates, ::NewtonBodyGetRotation
+*/
+int NewtonWorldGetBodyStates (const NewtonWorld* const newtonWorld, const NewtonBody* const* const bodies, int count, NewtonBodyStateArrays* const states)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	return world->GetBodyStates ((const dgBody* const*) bodies, count, (dgBodyStateArrays*) states);
+}
+
+/*!
+  Set the position, rotation, velocity and angular velocity of a set of bodies from flat arrays.
+
+  @param *newtonWorld pointer to the Newton world.
+  @param *bodies array of *count* bodies, or NULL to use states->m_bodies.
+  @param count number of bodies.
+  @param *states source arrays, entry i of each array belongs to the body i. a NULL array leaves that value unchanged.
+
+  the bodies are woken up, as if each one was set with ::NewtonBodySetMatrix, ::NewtonBodySetVelocity and ::NewtonBodySetOmega.
+  the copy is split over the worker threads of the world, it can not be called from inside the world update.
+
+  See also: ::NewtonWorldGetBodyStates
+*/
+void NewtonWorldSetBodyStates (const NewtonWorld* const newtonWorld, const NewtonBody* const* const bodies, int count, const NewtonBodyStateArrays* const states)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	world->SetBodyStates ((const dgBody* const*) bodies, count, (const dgBodyStateArrays*) states);
+}
+
+/*!
+  Iterate over the bodies whose matrix changed on the last update.
+
+  @param *newtonWorld pointer to the Newton world.
+  @param callback function to be called for each moved body, the iteration stops when it returns zero. it can be NULL.
+  @param *userData user data to be passed to the callback.
+
+  @return the number of bodies that moved on the last update.
+
+  these are the same bodies that got their transform callback at the end of the update, moving a body between updates
+  adds it to the set of the next update. the order of the bodies is not specified.
+
+  See also: ::NewtonWorldGetBodyStates, ::NewtonBodySetTransformCallback
+*/
+int NewtonWorldGetMovedBodies (const NewtonWorld* const newtonWorld, NewtonBodyIterator callback, void* const userData)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	return world->GetMovedBodies ((OnBodiesInAABB) callback, userData);
+}
+
+/*!
+  Save the simulation state of the world to a buffer, for rolling the simulation back with ::NewtonWorldRestoreState.
+
+  @param *newtonWorld pointer to the Newton world.
+  @param *buffer destination buffer, it can be NULL to query the size.
+  @param bufferSize size of the buffer in bytes.
+
+  @return the number of bytes the state takes, the buffer only holds a valid state when this is not larger than *bufferSize*.
+
+  the state has the matrix, velocities, forces and sleep state of the bodies, the contact joints with their contact points,
+  the warm start forces of the bilateral joints and the broad phase tree. bodies, joints and collision shapes are referenced,
+  not copied, so the size only changes with the number of bodies, joints and contacts.
+  the internal data of user joints and of deformable bodies is not part of the state, the application has to save it if it needs to.
+  it can not be called from inside the world update.
+
+  See also: ::NewtonWorldRestoreState
+*/
+int NewtonWorldSaveState (const NewtonWorld* const newtonWorld, void* const buffer, int bufferSize)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	return world->SaveState (buffer, bufferSize);
+}
+
+/*!
+  Restore the simulation state saved with ::NewtonWorldSaveState.
+
+  @param *newtonWorld pointer to the Newton world.
+  @param *buffer buffer with the saved state.
+  @param bufferSize size of the buffer in bytes.
+
+  @return one if the state was restored, zero if it does not apply to the world, in which case the world is not changed.
+
+  the state only applies to the world it was saved from, with the same bodies, bilateral joints, aggregates and broad phase.
+  creating or destroying any of them in between, or changing a body between static and dynamic, invalidates the saved states.
+  a world that is updated again after the restore produces the same results it produced after the state was saved,
+  as long as the update itself is deterministic, with more than one worker thread it is not bit exact between runs.
+  the transform callback is called on the next update for every body whose matrix changed.
+  it can not be called from inside the world update.
+
+  See also: ::NewtonWorldSaveState
+*/
+int NewtonWorldRestoreState (const NewtonWorld* const newtonWorld, const void* const buffer, int bufferSize)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	return world->RestoreState (buffer, bufferSize) ? 1 : 0;
+}
+
 
 /*!
   Shoot ray from point p0 to p1 and trigger callback for each body on that line.
@@ -1185,6 +1428,56 @@ int NewtonWorldCollide (const NewtonWorld* const newtonWorld, const dFloat* cons
 	return world->GetBroadPhase()->Collide((dgCollisionInstance*)shape, dgMatrix(matrix), (OnRayPrecastAction)prefilter, userData, (dgConvexCastReturnInfo*)info, maxContactsCount, threadIndex);
 }
 
+/*!
+  cast an array of rays and get the closest hit of each one.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param *queries array of *count* rays, each one going from m_p0 to m_p1 in global space.
+  @param *hits array of *count* entries that receive the closest hit of the ray with the same index.
+  @param count number of rays in the batch.
+  @param *userData user data to be passed to the prefilter callback.
+  @param prefilter user define function to be called for each body before intersection, it can be NULL.
+
+  the batch is split over the worker threads of the world, each ray is traversed on its own.
+  a ray that does not hit anything gets a NULL *m_hitBody* and a *m_param* of 1.0.
+
+  the prefilter is called concurrently from the worker threads. this function can not be called from inside the world update,
+  with the exception of the listeners update callbacks.
+
+  See also: ::NewtonWorldRayCast, ::NewtonWorldConvexCastBatch
+*/
+void NewtonWorldRayCastBatch (const NewtonWorld* const newtonWorld, const NewtonWorldRayCastQuery* const queries, NewtonWorldRayCastHitInfo* const hits, int count, void* const userData, NewtonWorldRayPrefilterCallback prefilter)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	world->GetBroadPhase()->RayCastBatch((const dgRayCastBatchQuery*)queries, (dgRayCastBatchHit*)hits, count, (OnRayPrecastAction)prefilter, userData);
+}
+
+/*!
+  cast an array of convex shapes, the batch version of ::NewtonWorldConvexCast.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param *queries array of *count* queries, each one sweeps m_shape from m_matrix to m_target in global space.
+  @param *params array of *count* values that receive the time of impact of each query, 1.0 for no impact.
+  @param *contactCounts array of *count* values that receive the number of contacts of each query, it can be NULL.
+  @param *info array of *count* x *maxContactsCount* contacts, query i writes its contacts starting at info[i * maxContactsCount].
+  @param maxContactsCount maximum number of contacts of each query, zero to only calculate the time of impact.
+  @param count number of queries in the batch.
+  @param *userData user data to be passed to the prefilter callback.
+  @param prefilter user define function to be called for each body before intersection, it can be NULL.
+
+  the batch is split over the worker threads of the world. the prefilter is called concurrently from the worker threads.
+  this function can not be called from inside the world update, with the exception of the listeners update callbacks.
+
+  See also: ::NewtonWorldConvexCast, ::NewtonWorldRayCastBatch
+*/
+void NewtonWorldConvexCastBatch (const NewtonWorld* const newtonWorld, const NewtonWorldConvexCastQuery* const queries, dFloat* const params, int* const contactCounts, NewtonWorldConvexCastReturnInfo* const info, int maxContactsCount, int count, void* const userData, NewtonWorldRayPrefilterCallback prefilter)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	world->GetBroadPhase()->ConvexCastBatch((const dgConvexCastBatchQuery*)queries, params, contactCounts, (dgConvexCastReturnInfo*)info, maxContactsCount, count, (OnRayPrecastAction)prefilter, userData);
+}
+
 
 /*!
   Retrieve body by index from island.
@@ -3233,6 +3526,46 @@ void NewtonHeightFieldSetHorizontalDisplacement (const NewtonCollision* const he
 	}
 }
 
+/*!
+  Set how far ahead of the colliding bodies a tiled height field request tiles from its loader thread.
+
+  @param *heightField pointer to a tiled height field collision.
+  @param distance extra distance added to each query box before prefetching, zero disables prefetching.
+
+  @return Nothing.
+
+  See also: ::NewtonCreateTiledHeightFieldCollision
+*/
+void NewtonHeightFieldSetTilePrefetchDistance (const NewtonCollision* const heightField, dFloat distance)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionInstance* const collision = (dgCollisionInstance*)heightField;
+	if (collision->IsType(dgCollision::dgCollisionHeightField_RTTI)) {
+		dgCollisionHeightField* const shape = (dgCollisionHeightField*)collision->GetChildShape();
+		shape->SetTilePrefetchDistance (dgFloat32 (distance));
+	}
+}
+
+/*!
+  Return the number of tiles a tiled height field currently keeps in memory.
+
+  @param *heightField pointer to a height field collision.
+
+  @return number of resident tiles, zero for a regular height field.
+
+  See also: ::NewtonCreateTiledHeightFieldCollision
+*/
+int NewtonHeightFieldGetResidentTileCount (const NewtonCollision* const heightField)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionInstance* const collision = (dgCollisionInstance*)heightField;
+	if (collision->IsType(dgCollision::dgCollisionHeightField_RTTI)) {
+		dgCollisionHeightField* const shape = (dgCollisionHeightField*)collision->GetChildShape();
+		return shape->GetResidentTileCount ();
+	}
+	return 0;
+}
+
 /*!
   Prepare a *TreeCollision* to begin to accept the polygons that comprise the collision mesh.
 
@@ -3302,6 +3635,50 @@ void NewtonTreeCollisionEndBuild(const NewtonCollision* const treeCollision, int
 	collision->EndBuild(optimize);
 }
 
+/*!
+  Select the compact node format for the next call to ::NewtonTreeCollisionEndBuild.
+
+  @param *treeCollision is the pointer to the collision tree.
+  @param state 1 to store the node boxes quantized to 16 bits relative to the box of their parent, 0 for full precision boxes.
+
+  @return Nothing.
+
+  Only the tree nodes are compressed, the vertices and the face indices keep their format because ::NewtonTreeCollisionGetVertexListTriangleListInAABB
+  and ::NewtonCollisionGetInfo hand them to the application. Since the nodes are a small part of a mesh the saving is modest, about 15% on a height field
+  like mesh. The node boxes are slightly larger than the polygons they hold.
+
+  See also: ::NewtonTreeCollisionBeginBuild, ::NewtonTreeCollisionEndBuild
+*/
+void NewtonTreeCollisionSetCompressedBuild(const NewtonCollision* const treeCollision, int state)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionBVH* const collision = (dgCollisionBVH*) ((dgCollisionInstance*)treeCollision)->GetChildShape();
+	dgAssert (collision->IsType (dgCollision::dgCollisionBVH_RTTI));
+	collision->SetCompressedBuild(state ? true : false);
+}
+
+/*!
+  Let the next call to ::NewtonTreeCollisionEndBuild use the worker threads of the world that owns the collision tree.
+
+  @param *treeCollision is the pointer to the collision tree.
+  @param state 1 to build the tree hierarchy and the face adjacency over the world worker threads, 0 to build it on the calling thread.
+
+  @return Nothing.
+
+  Off by default. The worker threads are not reentrant, with the parallel build enabled ::NewtonTreeCollisionEndBuild must be called
+  from the thread that owns the world, never while ::NewtonUpdate or ::NewtonUpdateAsync is running and never from inside a Newton callback.
+  Trees built in parallel are identical to trees built on a single thread.
+
+  See also: ::NewtonTreeCollisionBeginBuild, ::NewtonTreeCollisionEndBuild, ::NewtonSetThreadsCount
+*/
+void NewtonTreeCollisionSetParallelBuild(const NewtonCollision* const treeCollision, int state)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionBVH* const collision = (dgCollisionBVH*) ((dgCollisionInstance*)treeCollision)->GetChildShape();
+	dgAssert (collision->IsType (dgCollision::dgCollisionBVH_RTTI));
+	collision->SetParallelBuild(state ? true : false);
+}
+
 
 /*!
   Get the user defined collision attributes stored with each face of the collision mesh.
@@ -3449,6 +3826,45 @@ int NewtonTreeCollisionGetVertexListTriangleListInAABB(const NewtonCollision* co
 	return (NewtonCollision*) collision;
 }
 
+/*!
+  Create a height field collision geometry whose elevation data is streamed in tiles.
+
+  Only up to maxResidentTiles tiles are kept in memory, the least recently used tile is evicted when a new one is loaded.
+  The application loads each tile in loadTile, which may be called from the engine loader thread.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param width number of vertices along x of the whole terrain.
+  @param height number of vertices along z of the whole terrain.
+  @param tileSize number of cells along each side of a tile, rounded up to an even number.
+  @param maxResidentTiles maximum number of tiles kept in memory.
+  @param gridsDiagonals diagonal construction mode, same as ::NewtonCreateHeightFieldCollision.
+  @param elevationdatType 0 for float elevations, 1 for unsigned short elevations.
+  @param minElevation lowest elevation value of the whole terrain, before vertical scale.
+  @param maxElevation highest elevation value of the whole terrain, before vertical scale.
+  @param verticalScale elevation scale.
+  @param horizontalScale_x cell size along x.
+  @param horizontalScale_z cell size along z.
+  @param loadTile callback that fills a width x height window of vertices starting at x0, z0.
+  @param *tileUserData user data passed to loadTile.
+  @param shapeID shape user id.
+
+  @return Pointer to the collision.
+
+  See also: ::NewtonCreateHeightFieldCollision, ::NewtonHeightFieldSetTilePrefetchDistance
+*/
+NewtonCollision* NewtonCreateTiledHeightFieldCollision (const NewtonWorld* const newtonWorld, int width, int height, int tileSize, int maxResidentTiles, int gridsDiagonals, int elevationdatType,
+														dFloat minElevation, dFloat maxElevation, dFloat verticalScale, dFloat horizontalScale_x, dFloat horizontalScale_z, 
+														NewtonHeightFieldTileCallback loadTile, void* const tileUserData, int shapeID)
+{
+	Newton* const world = (Newton *)newtonWorld;
+
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionInstance* const collision = world->CreateTiledHeightField(width, height, tileSize, maxResidentTiles, gridsDiagonals, elevationdatType, 
+																		 dgFloat32 (minElevation), dgFloat32 (maxElevation), dgFloat32 (verticalScale), dgFloat32 (horizontalScale_x), dgFloat32 (horizontalScale_z), 
+																		 (dgCollisionHeightFieldTileCallback) loadTile, tileUserData);
+	collision->SetUserDataID(dgUnsigned32 (shapeID));
+	return (NewtonCollision*) collision;
+}
 
 
 /*!
@@ -4107,6 +4523,52 @@ NewtonCollision* NewtonCreateCollisionFromSerialization(const NewtonWorld* const
 	return  (NewtonCollision*) world->CreateCollisionFromSerialization ((dgDeserialize) deserializeFunction, serializeHandle);
 }
 
+/*!
+  Serialize a collision shape as a relocatable image.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param *collision is the pointer to the collision shape.
+  @param serializeFunction pointer to the event function that will do the serialization.
+  @param *serializeHandle user data that will be passed to the _NewtonSerialize_ callback.
+
+  @return Nothing.
+
+  The image is a versioned header followed by the same data *NewtonCollisionSerialize* writes, with the large arrays of 
+  tree collisions and height fields, including the ones in compound collisions, padded to 16 byte boundaries. 
+  The image does not contain any pointers, so it can be written to a file and loaded back at any address with *NewtonCreateCollisionFromImage*.
+
+  See also: ::NewtonCreateCollisionFromImage, ::NewtonCollisionSerialize
+*/
+void NewtonCollisionSerializeImage(const NewtonWorld* const newtonWorld, const NewtonCollision* const collision, NewtonSerializeCallback serializeFunction, void* const serializeHandle)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	world->SerializeCollisionImage((dgCollisionInstance*) collision, (dgSerialize) serializeFunction, serializeHandle);
+}
+
+/*!
+  Create a collision shape from a relocatable image in memory.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param *image pointer to an image written by *NewtonCollisionSerializeImage*, it must be 16 byte aligned.
+  @param sizeInBytes size of the image.
+
+  @return the collision shape, or NULL if the buffer is not an image of this version.
+
+  The tree collisions and height fields of the shape use their vertex, index, node and elevation arrays in place, without copying them, 
+  so that an image mapped from a file is ready to use as soon as this function returns. The application must keep the image 
+  in memory until the shape is destroyed. Functions that edit a tree collision face attributes write into the image, so read only 
+  mappings must only be used with shapes that are not edited.
+
+  See also: ::NewtonCollisionSerializeImage
+*/
+NewtonCollision* NewtonCreateCollisionFromImage(const NewtonWorld* const newtonWorld, const void* const image, int sizeInBytes)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	return (NewtonCollision*) world->CreateCollisionFromImage (image, sizeInBytes);
+}
+
 
 /*!
   Get creation parameters for this collision objects.
@@ -5346,7 +5808,7 @@ void* NewtonContactJointGetFirstContact(const NewtonJoint* const contactJoint)
 	TRACE_FUNCTION(__FUNCTION__);
 	dgContact* const joint = (dgContact *)contactJoint;
 	if ((joint->GetId() == dgConstraint::m_contactConstraint) && joint->GetCount() && joint->GetMaxDOF()){
-		return joint->GetFirst();
+		return joint->GetFirstContact();
 	} else {
 		return NULL;
 	}
@@ -5368,8 +5830,7 @@ void* NewtonContactJointGetNextContact(const NewtonJoint* const contactJoint, vo
 	dgContact* const joint = (dgContact *)contactJoint;
 
 	if ((joint->GetId() == dgConstraint::m_contactConstraint) && joint->GetCount()){
-		dgList<dgContactMaterial>::dgListNode* const node = (dgList<dgContactMaterial>::dgListNode*) contact;
-		return node->GetNext();
+		return joint->GetNextContact((dgContactMaterial*) contact);
 	} else {
 		return NULL;
 	}
@@ -5392,15 +5853,13 @@ void NewtonContactJointRemoveContact(const NewtonJoint* const contactJoint, void
 	dgContact* const joint = (dgContact *)contactJoint;
 
 	if ((joint->GetId() == dgConstraint::m_contactConstraint) && joint->GetCount()){
-		dgList<dgContactMaterial>::dgListNode* const node = (dgList<dgContactMaterial>::dgListNode*) contact;
-
 		dgAssert (joint->GetBody0());
 		dgAssert (joint->GetBody1());
 		//dgBody* const body = joint->GetBody0() ? joint->GetBody0() : joint->GetBody1();
 		//dgWorld* const world = body->GetWorld();
 		dgWorld* const world = joint->GetBody0()->GetWorld();
 		world->GlobalLock(false);
-		joint->Remove(node);
+		joint->RemoveContact((dgContactMaterial*) contact);
 		joint->GetBody0()->SetSleepState(false);
 		joint->GetBody1()->SetSleepState(false);
 		world->GlobalUnlock();
@@ -5427,17 +5886,15 @@ NewtonMaterial* NewtonContactGetMaterial(const void* const contact)
 {
 	TRACE_FUNCTION(__FUNCTION__);
 
-	dgList<dgContactMaterial>::dgListNode* const node = (dgList<dgContactMaterial>::dgListNode*) contact;
-	dgContactMaterial& contactMaterial = node->GetInfo();
-	return (NewtonMaterial*) &contactMaterial;
+	dgContactMaterial* const contactMaterial = (dgContactMaterial*) contact;
+	return (NewtonMaterial*) contactMaterial;
 }
 
 NewtonCollision* NewtonContactGetCollision0(const void* const contact)
 {
 	TRACE_FUNCTION(__FUNCTION__);
 
-	dgList<dgContactMaterial>::dgListNode* const node = (dgList<dgContactMaterial>::dgListNode*) contact;
-	dgContactMaterial& contactMaterial = node->GetInfo();
+	const dgContactMaterial& contactMaterial = *((dgContactMaterial*) contact);
 	return (NewtonCollision*) contactMaterial.m_collision0;
 }
 
@@ -5445,8 +5902,7 @@ NewtonCollision* NewtonContactGetCollision1(const void* const contact)
 {
 	TRACE_FUNCTION(__FUNCTION__);
 
-	dgList<dgContactMaterial>::dgListNode* const node = (dgList<dgContactMaterial>::dgListNode*) contact;
-	dgContactMaterial& contactMaterial = node->GetInfo();
+	const dgContactMaterial& contactMaterial = *((dgContactMaterial*) contact);
 	return (NewtonCollision*) contactMaterial.m_collision1;
 }
 
@@ -5454,8 +5910,7 @@ void* NewtonContactGetCollisionID0(const void* const contact)
 {
 	TRACE_FUNCTION(__FUNCTION__);
 
-	dgList<dgContactMaterial>::dgListNode* const node = (dgList<dgContactMaterial>::dgListNode*) contact;
-	dgContactMaterial& contactMaterial = node->GetInfo();
+	const dgContactMaterial& contactMaterial = *((dgContactMaterial*) contact);
 	return (void*) contactMaterial.m_shapeId0;
 }
 
@@ -5463,8 +5918,7 @@ void* NewtonContactGetCollisionID1(const void* const contact)
 {
 	TRACE_FUNCTION(__FUNCTION__);
 
-	dgList<dgContactMaterial>::dgListNode* const node = (dgList<dgContactMaterial>::dgListNode*) contact;
-	dgContactMaterial& contactMaterial = node->GetInfo();
+	const dgContactMaterial& contactMaterial = *((dgContactMaterial*) contact);
 	return (NewtonCollision*) contactMaterial.m_shapeId1;
 }
 
@@ -72,6 +72,9 @@ extern "C" {
 	
 	#define NEWTON_BROADPHASE_DEFAULT						0
 	#define NEWTON_BROADPHASE_PERSINTENT					1
+	#define NEWTON_BROADPHASE_SAP							2
+
+	#define NEWTON_SOLVER_MODE_SOA_JOINTS					0x10000
 
 	#define NEWTON_DYNAMIC_BODY								0
 	#define NEWTON_KINEMATIC_BODY							1
@@ -281,6 +284,37 @@ extern "C" {
 		const NewtonBody* m_hitBody;			// body hit at contact point
 		dFloat m_penetration;                   // contact penetration at collision point
 	} NewtonWorldConvexCastReturnInfo;
+
+	typedef struct NewtonWorldRayCastQuery
+	{
+		dFloat m_p0[4];							// ray origin in global space
+		dFloat m_p1[4];							// ray end in global space
+	} NewtonWorldRayCastQuery;
+
+	typedef struct NewtonWorldRayCastHitInfo
+	{
+		dFloat m_point[4];						// closest hit point in global space
+		dFloat m_normal[4];						// surface normal at the hit point in global space
+		dLong m_contactID;						// collision ID at the hit point
+		const NewtonBody* m_hitBody;			// body hit by the ray, NULL if the ray did not hit anything
+		dFloat m_param;							// intersection parameter along the ray, 1.0 if the ray did not hit anything
+	} NewtonWorldRayCastHitInfo;
+
+	typedef struct NewtonBodyStateArrays
+	{
+		const NewtonBody** m_bodies;			// body of each entry
+		dFloat* m_position;						// three values per body, NULL to skip the position
+		dFloat* m_rotation;						// four values per body, same quaternion as NewtonBodyGetRotation, NULL to skip the rotation
+		dFloat* m_veloc;						// three values per body, NULL to skip the velocity
+		dFloat* m_omega;						// three values per body, NULL to skip the angular velocity
+	} NewtonBodyStateArrays;
+
+	typedef struct NewtonWorldConvexCastQuery
+	{
+		dFloat m_matrix[16];					// start matrix of the shape in global space
+		dFloat m_target[4];						// end position of the shape in global space
+		const NewtonCollision* m_shape;			// shape to cast
+	} NewtonWorldConvexCastQuery;
 	
 	typedef struct NewtonUserMeshCollisionRayHitDesc
 	{
@@ -337,6 +371,16 @@ extern "C" {
 		NewtonMeshFloatData m_vertexColor;
 	} NewtonMeshVertexFormat;
 
+	typedef struct NewtonWorldProfilePhase
+	{
+		const char* m_name;							// name of the update phase
+		dFloat m_wallTime;							// milliseconds the phase took in the update thread, or in the slowest worker when the phase only runs in the workers
+		dFloat m_threadTime;						// milliseconds added over all worker threads
+		dFloat m_maxThreadTime;						// milliseconds of the busiest worker thread
+		int m_calls;								// times the phase was entered, added over all threads
+		int m_items;								// bodies, pairs, joints or clusters processed by the phase
+	} NewtonWorldProfilePhase;
+
 	// Newton callback functions
 	typedef void* (*NewtonAllocMemory) (int sizeInBytes);
 	typedef void (*NewtonFreeMemory) (void* const ptr, int sizeInBytes);
@@ -376,6 +420,7 @@ extern "C" {
 
 	typedef dFloat (*NewtonCollisionTreeRayCastCallback) (const NewtonBody* const body, const NewtonCollision* const treeCollision, dFloat intersection, dFloat* const normal, int faceId, void* const usedData);
 	typedef dFloat (*NewtonHeightFieldRayCastCallback) (const NewtonBody* const body, const NewtonCollision* const heightFieldCollision, dFloat intersection, int row, int col, dFloat* const normal, int faceId, void* const usedData);
+	typedef void (*NewtonHeightFieldTileCallback) (int x0, int z0, int width, int height, void* const elevationMap, char* const attributeMap, void* const userData);
 
 	typedef void (*NewtonCollisionCopyConstructionCallback) (const NewtonWorld* const newtonWorld, NewtonCollision* const collision, const NewtonCollision* const sourceCollision);
 	typedef void (*NewtonCollisionDestructorCallback) (const NewtonWorld* const newtonWorld, const NewtonCollision* const collision);
@@ -468,6 +513,10 @@ extern "C" {
 	NEWTON_API int NewtonGetNumberOfSubsteps (const NewtonWorld* const newtonWorld);
 	NEWTON_API void NewtonSetNumberOfSubsteps (const NewtonWorld* const newtonWorld, int subSteps);
 	NEWTON_API dFloat NewtonGetLastUpdateTime (const NewtonWorld* const newtonWorld);
+	NEWTON_API int NewtonGetFrameMemoryHighWaterMark (const NewtonWorld* const newtonWorld);
+	NEWTON_API int NewtonWorldGetProfile (const NewtonWorld* const newtonWorld, NewtonWorldProfilePhase* const phases, int maxPhases);
+	NEWTON_API int NewtonWorldGetProfileThreadTimes (const NewtonWorld* const newtonWorld, int phase, dFloat* const times, int maxThreads);
+	NEWTON_API int NewtonWorldGetProfileTrace (const NewtonWorld* const newtonWorld, char* const buffer, int bufferSize);
 
 	NEWTON_API void NewtonSerializeToFile (const NewtonWorld* const newtonWorld, const char* const filename, NewtonOnBodySerializationCallback bodyCallback, void* const bodyUserData);
 	NEWTON_API void NewtonDeserializeFromFile (const NewtonWorld* const newtonWorld, const char* const filename, NewtonOnBodyDeserializationCallback bodyCallback, void* const bodyUserData);
@@ -525,10 +574,17 @@ extern "C" {
 	NEWTON_API void NewtonWorldRayCast (const NewtonWorld* const newtonWorld, const dFloat* const p0, const dFloat* const p1, NewtonWorldRayFilterCallback filter, void* const userData, NewtonWorldRayPrefilterCallback prefilter, int threadIndex);
 	NEWTON_API int NewtonWorldConvexCast (const NewtonWorld* const newtonWorld, const dFloat* const matrix, const dFloat* const target, const NewtonCollision* const shape, dFloat* const param, void* const userData, NewtonWorldRayPrefilterCallback prefilter, NewtonWorldConvexCastReturnInfo* const info, int maxContactsCount, int threadIndex);
 	NEWTON_API int NewtonWorldCollide (const NewtonWorld* const newtonWorld, const dFloat* const matrix, const NewtonCollision* const shape, void* const userData, NewtonWorldRayPrefilterCallback prefilter, NewtonWorldConvexCastReturnInfo* const info, int maxContactsCount, int threadIndex);
+	NEWTON_API void NewtonWorldRayCastBatch (const NewtonWorld* const newtonWorld, const NewtonWorldRayCastQuery* const queries, NewtonWorldRayCastHitInfo* const hits, int count, void* const userData, NewtonWorldRayPrefilterCallback prefilter);
+	NEWTON_API void NewtonWorldConvexCastBatch (const NewtonWorld* const newtonWorld, const NewtonWorldConvexCastQuery* const queries, dFloat* const params, int* const contactCounts, NewtonWorldConvexCastReturnInfo* const info, int maxContactsCount, int count, void* const userData, NewtonWorldRayPrefilterCallback prefilter);
 	
 	// world utility functions
 	NEWTON_API int NewtonWorldGetBodyCount(const NewtonWorld* const newtonWorld);
 	NEWTON_API int NewtonWorldGetConstraintCount(const NewtonWorld* const newtonWorld);
+	NEWTON_API int NewtonWorldGetBodyStates (const NewtonWorld* const newtonWorld, const NewtonBody* const* const bodies, int count, NewtonBodyStateArrays* const states);
+	NEWTON_API void NewtonWorldSetBodyStates (const NewtonWorld* const newtonWorld, const NewtonBody* const* const bodies, int count, const NewtonBodyStateArrays* const states);
+	NEWTON_API int NewtonWorldGetMovedBodies (const NewtonWorld* const newtonWorld, NewtonBodyIterator callback, void* const userData);
+	NEWTON_API int NewtonWorldSaveState (const NewtonWorld* const newtonWorld, void* const buffer, int bufferSize);
+	NEWTON_API int NewtonWorldRestoreState (const NewtonWorld* const newtonWorld, const void* const buffer, int bufferSize);
 
 	// **********************************************************************************************
 	//
@@ -734,6 +790,8 @@ extern "C" {
 	// ***********************************************************************************************************
 	NEWTON_API NewtonCollision* NewtonCreateCollisionFromSerialization (const NewtonWorld* const newtonWorld, NewtonDeserializeCallback deserializeFunction, void* const serializeHandle);
 	NEWTON_API void NewtonCollisionSerialize (const NewtonWorld* const newtonWorld, const NewtonCollision* const collision, NewtonSerializeCallback serializeFunction, void* const serializeHandle);
+	NEWTON_API void NewtonCollisionSerializeImage (const NewtonWorld* const newtonWorld, const NewtonCollision* const collision, NewtonSerializeCallback serializeFunction, void* const serializeHandle);
+	NEWTON_API NewtonCollision* NewtonCreateCollisionFromImage (const NewtonWorld* const newtonWorld, const void* const image, int sizeInBytes);
 	NEWTON_API void NewtonCollisionGetInfo (const NewtonCollision* const collision, NewtonCollisionInfoRecord* const collisionInfo);
 
 	// **********************************************************************************************
@@ -745,6 +803,11 @@ extern "C" {
 																  const void* const elevationMap, const char* const attributeMap, dFloat verticalScale, dFloat horizontalScale_x, dFloat horizontalScale_z, int shapeID);
 	NEWTON_API void NewtonHeightFieldSetUserRayCastCallback (const NewtonCollision* const heightfieldCollision, NewtonHeightFieldRayCastCallback rayHitCallback);
 	NEWTON_API void NewtonHeightFieldSetHorizontalDisplacement (const NewtonCollision* const heightfieldCollision, const unsigned short* const horizontalMap, dFloat scale);
+	NEWTON_API NewtonCollision* NewtonCreateTiledHeightFieldCollision (const NewtonWorld* const newtonWorld, int width, int height, int tileSize, int maxResidentTiles, int gridsDiagonals, int elevationdatType,
+																	   dFloat minElevation, dFloat maxElevation, dFloat verticalScale, dFloat horizontalScale_x, dFloat horizontalScale_z, 
+																	   NewtonHeightFieldTileCallback loadTile, void* const tileUserData, int shapeID);
+	NEWTON_API void NewtonHeightFieldSetTilePrefetchDistance (const NewtonCollision* const heightfieldCollision, dFloat distance);
+	NEWTON_API int NewtonHeightFieldGetResidentTileCount (const NewtonCollision* const heightfieldCollision);
 
 	NEWTON_API NewtonCollision* NewtonCreateTreeCollision (const NewtonWorld* const newtonWorld, int shapeID);
 	NEWTON_API NewtonCollision* NewtonCreateTreeCollisionFromMesh (const NewtonWorld* const newtonWorld, const NewtonMesh* const mesh, int shapeID);
@@ -753,6 +816,8 @@ extern "C" {
 	NEWTON_API void NewtonTreeCollisionBeginBuild (const NewtonCollision* const treeCollision);
 	NEWTON_API void NewtonTreeCollisionAddFace (const NewtonCollision* const treeCollision, int vertexCount, const dFloat* const vertexPtr, int strideInBytes, int faceAttribute);
 	NEWTON_API void NewtonTreeCollisionEndBuild (const NewtonCollision* const treeCollision, int optimize);
+	NEWTON_API void NewtonTreeCollisionSetCompressedBuild (const NewtonCollision* const treeCollision, int state);
+	NEWTON_API void NewtonTreeCollisionSetParallelBuild (const NewtonCollision* const treeCollision, int state);
 
 	NEWTON_API int NewtonTreeCollisionGetFaceAttribute (const NewtonCollision* const treeCollision, const int* const faceIndexArray, int indexCount); 
 	NEWTON_API void NewtonTreeCollisionSetFaceAttribute (const NewtonCollision* const treeCollision, const int* const faceIndexArray, int indexCount, int attribute);
@@ -73,6 +73,7 @@ class dgBilateralConstraint: public dgConstraint
 	dgInt8	  m_rowIsMotor;
 	dgInt8	  m_rowIsIk;
 
+	friend class dgWorld;
 	friend class dgInverseDynamics;
 	friend class dgWorldDynamicUpdate;
 };
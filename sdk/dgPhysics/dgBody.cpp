@@ -67,6 +67,10 @@ dgBody::dgBody()
 	,m_matrixUpdate(NULL)
 	,m_index(0)
 	,m_uniqueID(0)
+	,m_activeIndex(-1)
+	,m_movedIndex(-1)
+	,m_movedList(-1)
+	,m_movedListEntry(-1)
 	,m_bodyGroupId(0)
 	,m_rtti(m_baseBodyRTTI)
 	,m_type(0)
@@ -76,7 +80,7 @@ dgBody::dgBody()
 {
 	m_autoSleep = true;
 	m_collidable = true;
-	m_transformIsDirty = true;
+	m_transformIsDirty = false;
 	m_collideWithLinkedBodies = true;
 	m_invWorldInertiaMatrix[3][3] = dgFloat32 (1.0f);
 }
@@ -110,6 +114,10 @@ dgBody::dgBody (dgWorld* const world, const dgTree<const dgCollision*, dgInt32>*
 	,m_matrixUpdate(NULL)
 	,m_index(0)
 	,m_uniqueID(0)
+	,m_activeIndex(-1)
+	,m_movedIndex(-1)
+	,m_movedList(-1)
+	,m_movedListEntry(-1)
 	,m_bodyGroupId(0)
 	,m_rtti(m_baseBodyRTTI)
 	,m_type(0)
@@ -119,7 +127,7 @@ dgBody::dgBody (dgWorld* const world, const dgTree<const dgCollision*, dgInt32>*
 {
 	m_autoSleep = true;
 	m_collidable = true;
-	m_transformIsDirty = true;
+	m_transformIsDirty = false;
 	m_collideWithLinkedBodies = true;
 	m_invWorldInertiaMatrix[3][3] = dgFloat32 (1.0f);
 
@@ -179,6 +187,7 @@ void dgBody::AttachCollision (dgCollisionInstance* const collisionSrc)
 	}
 	m_collision = instance;
 	m_equilibrium = 0;
+	Activate();
 }
 
 void dgBody::Serialize (const dgTree<dgInt32, const dgCollision*>& collisionRemapId, dgSerialize serializeCallback, void* const userData)
@@ -230,6 +239,7 @@ void dgBody::SetMatrixNoSleep(const dgMatrix& matrix)
 void dgBody::SetMatrixResetSleep(const dgMatrix& matrix)
 {
 	m_sleeping = false;
+	Activate();
 	SetMatrix(matrix);
 }
 
@@ -240,9 +250,20 @@ void dgBody::UpdateWorlCollisionMatrix() const
 
 
 
+void dgBody::MarkMoved (dgInt32 threadIndex)
+{
+	// the first matrix change since the last transform update puts the body in the world moved list
+	if (!m_transformIsDirty) {
+		m_transformIsDirty = true;
+		if (m_masterNode) {
+			m_world->AddMovedBody (this, threadIndex);
+		}
+	}
+}
+
 void dgBody::UpdateCollisionMatrix (dgFloat32 timestep, dgInt32 threadIndex)
 {
-	m_transformIsDirty = true;
+	MarkMoved (threadIndex);
 	m_collision->SetGlobalMatrix (m_collision->GetLocalMatrix() * m_matrix);
 	m_collision->CalcAABB (m_collision->GetGlobalMatrix(), m_minAABB, m_maxAABB);
 
@@ -428,6 +449,14 @@ void dgBody::SetFreeze (bool state)
 }
 
 
+void dgBody::Activate ()
+{
+	// bodies that are woken up join the broad phase active set, they leave it again when they go back to sleep
+	if ((m_activeIndex < 0) && m_masterNode) {
+		m_world->GetBroadPhase()->ActivateBody (this);
+	}
+}
+
 void dgBody::Freeze ()
 {
 	if (GetInvMass().m_w > dgFloat32 (0.0f)) {
@@ -537,6 +566,7 @@ void dgBody::SetMassMatrix(dgFloat32 mass, const dgMatrix& inertia)
 	}
 #endif
 	UpdateLumpedMatrix();
+	Activate();
 }
 
 
@@ -632,6 +662,7 @@ void dgBody::InvalidateCache ()
 	m_sleeping = false;
 	m_equilibrium = false;
 	m_genericLRUMark = 0;
+	Activate();
 	dgMatrix matrix (m_matrix);
 	SetMatrixOriginAndRotation(matrix);
 }
@@ -692,6 +723,7 @@ void dgBody::AddImpulse (const dgVector& pointDeltaVeloc, const dgVector& pointP
 	m_sleeping	= false;
 	m_equilibrium = false;
 	Unfreeze ();
+	Activate();
 }
 
 void dgBody::ApplyImpulsePair (const dgVector& linearImpulseIn, const dgVector& angularImpulseIn, dgFloat32 timestep)
@@ -709,6 +741,7 @@ void dgBody::ApplyImpulsePair (const dgVector& linearImpulseIn, const dgVector&
 	m_sleeping	= false;
 	m_equilibrium = false;
 	Unfreeze ();
+	Activate();
 }
 
 void dgBody::ApplyImpulsesAtPoint (dgInt32 count, dgInt32 strideInBytes, const dgFloat32* const impulseArray, const dgFloat32* const pointArray, dgFloat32 timestep)
@@ -742,5 +775,6 @@ void dgBody::ApplyImpulsesAtPoint (dgInt32 count, dgInt32 strideInBytes, const d
 	m_sleeping	= false;
 	m_equilibrium = false;
 	Unfreeze ();
+	Activate();
 }
 
@@ -131,6 +131,7 @@ class dgBody
 
 	bool GetSleepState () const;
 	void SetSleepState (bool state);
+	void Activate ();
 
 	bool GetAutoSleep () const;
 	void SetAutoSleep (bool state);
@@ -220,6 +221,7 @@ class dgBody
 
 	protected:
 	void UpdateWorlCollisionMatrix() const;
+	void MarkMoved (dgInt32 threadIndex);
 
 	// member variables:
 	protected:
@@ -274,6 +276,10 @@ class dgBody
 	
 	dgInt32 m_index;
 	dgInt32 m_uniqueID;
+	dgInt32 m_activeIndex;
+	dgInt32 m_movedIndex;
+	dgInt32 m_movedList;
+	dgInt32 m_movedListEntry;
 	dgInt32 m_bodyGroupId;
 	dgInt32 m_rtti;
 	dgInt32 m_type;
@@ -286,6 +292,7 @@ class dgBody
 	friend class dgConstraint;
 	friend class dgBroadPhase;
 	friend class dgCollisionBVH;
+	friend class dgBroadPhaseSAP;
 	friend class dgBroadPhaseNode;
 	friend class dgBodyMasterList;
 	friend class dgCollisionScene;
@@ -294,6 +301,7 @@ class dgBody
 	friend class dgCollisionCompound;
 	friend class dgCollisionUserMesh;
 	friend class dgBodyMasterListRow;
+	friend class dgSoaJointSolver;
 	friend class dgWorldDynamicUpdate;
 	friend class dgBroadPhaseBodyNode;
 	friend class dgBilateralConstraint;
@@ -403,6 +411,7 @@ DG_INLINE void dgBody::SetOmega (const dgVector& omega)
 {
 	SetOmegaNoSleep(omega);
 	m_equilibrium = false;
+	Activate();
 }
 
 
@@ -420,6 +429,7 @@ DG_INLINE void dgBody::SetVelocity (const dgVector& velocity)
 {
 	SetVelocityNoSleep(velocity);
 	m_equilibrium = false;
+	Activate();
 }
 
 
@@ -524,6 +534,7 @@ DG_INLINE void dgBody::SetAutoSleep (bool state)
 	m_autoSleep = dgUnsigned32 (state);
 	if (m_autoSleep == 0) {
 		m_sleeping = false;
+		Activate();
 	}
 }
 
@@ -542,6 +553,9 @@ DG_INLINE void dgBody::SetSleepState (bool state)
 {
 	m_sleeping = state;
 	m_equilibrium = state;
+	if (!state) {
+		Activate();
+	}
 }
 
 
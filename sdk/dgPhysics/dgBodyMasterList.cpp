@@ -45,9 +45,7 @@ dgBodyMasterListRow::dgListNode* dgBodyMasterListRow::AddContactJoint (dgConstra
 {
 	dgThreadHiveScopeLock lock (body->m_world, &m_body->m_criticalSectionLock, false);
 
-	body->m_world->GlobalLock(false);
 	dgListNode* const node = Addtop();
-	body->m_world->GlobalUnlock();
 
 #ifdef _DEBUG
 	for (dgListNode* ptr = GetFirst()->GetNext(); ptr && (ptr->GetInfo().m_joint->GetId() == dgConstraint::m_contactConstraint); ptr = ptr->GetNext()) { 
@@ -89,9 +87,7 @@ dgBodyMasterListRow::dgListNode* dgBodyMasterListRow::AddBilateralJoint (dgConst
 {
 	dgThreadHiveScopeLock lock (body->m_world, &m_body->m_criticalSectionLock, false);
 
-	body->m_world->GlobalLock(false);
 	dgListNode* const node = Append();
-	body->m_world->GlobalUnlock();
 	
 	node->GetInfo().m_joint = joint;
 	node->GetInfo().m_bodyNode = body;
@@ -113,9 +109,7 @@ void dgBodyMasterListRow::RemoveContactJoint (dgListNode* const link)
 {
 	dgThreadHiveScopeLock lock (m_body->m_world, &m_body->m_criticalSectionLock, false);
 	
-	m_body->m_world->GlobalLock(false);
 	Remove(link);
-	m_body->m_world->GlobalUnlock();
 	
 	m_contactCount --;
 	SetAcceleratedSearch();
@@ -125,9 +119,7 @@ void dgBodyMasterListRow::RemoveBilateralJoint (dgListNode* const link)
 {
 	dgThreadHiveScopeLock lock (m_body->m_world, &m_body->m_criticalSectionLock, false);
 	
-	m_body->m_world->GlobalLock(false);
 	Remove(link);
-	m_body->m_world->GlobalUnlock();
 }
 
 
@@ -260,6 +252,8 @@ void dgBodyMasterList::AddBody (dgBody* const body)
 	if (GetFirst() != node) {
 		InsertAfter (GetFirst(), node);
 	}
+	body->Activate();
+	body->MarkMoved (0);
 }
 
 void dgBodyMasterList::RemoveBody (dgBody* const body)
@@ -269,6 +263,7 @@ void dgBodyMasterList::RemoveBody (dgBody* const body)
 	
 	node->GetInfo().RemoveAllJoints();
 	dgAssert (node->GetInfo().GetCount() == 0);
+	body->GetWorld()->GetBroadPhase()->DeactivateBody (body);
 
 	Remove (node);
 	body->m_masterNode = NULL;
@@ -327,6 +322,12 @@ void dgBodyMasterList::AttachConstraint(dgConstraint* const constraint,	dgBody*
 
 		body0->m_equilibrium = body0->GetInvMass().m_w ? false : true;
 		body1->m_equilibrium = body1->GetInvMass().m_w ? false : true;
+		if (!body0->m_equilibrium) {
+			body0->Activate();
+		}
+		if (!body1->m_equilibrium) {
+			body1->Activate();
+		}
 		constraint->m_link0 = body0->m_masterNode->GetInfo().AddBilateralJoint (constraint, body1);
 		constraint->m_link1 = body1->m_masterNode->GetInfo().AddBilateralJoint (constraint, body0);
 	} else {
@@ -375,6 +376,12 @@ void dgBodyMasterList::RemoveConstraint (dgConstraint* const constraint)
 		if (contact->m_maxDOF) {
 			body0->m_equilibrium = body0->GetInvMass().m_w ? false : true;
 			body1->m_equilibrium = body1->GetInvMass().m_w ? false : true;
+			if (!body0->m_equilibrium) {
+				body0->Activate();
+			}
+			if (!body1->m_equilibrium) {
+				body1->Activate();
+			}
 		}
 		row0.RemoveContactJoint(constraint->m_link0);
 		row1.RemoveContactJoint(constraint->m_link1);
@@ -391,6 +398,12 @@ void dgBodyMasterList::RemoveConstraint (dgConstraint* const constraint)
 
 		body0->m_equilibrium = body0->GetInvMass().m_w ? false : true;
 		body1->m_equilibrium = body1->GetInvMass().m_w ? false : true;
+		if (!body0->m_equilibrium) {
+			body0->Activate();
+		}
+		if (!body1->m_equilibrium) {
+			body1->Activate();
+		}
 		row0.RemoveBilateralJoint(constraint->m_link0);
 		row1.RemoveBilateralJoint(constraint->m_link1);
 	}
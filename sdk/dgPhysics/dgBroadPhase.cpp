@@ -27,13 +27,13 @@
 #include "dgDynamicBody.h"
 #include "dgCollisionConvex.h"
 #include "dgCollisionInstance.h"
+#include "dgCollisionCompound.h"
 #include "dgWorldDynamicUpdate.h"
 #include "dgBilateralConstraint.h"
 #include "dgBroadPhaseAggregate.h"
 #include "dgCollisionLumpedMassParticles.h"
 //#include "dgCollisionLumpedMassParticles.h"
 
-#define DG_CONVEX_CAST_POOLSIZE			32
 #define DG_BROADPHASE_AABB_SCALE		dgFloat32 (8.0f)
 #define DG_BROADPHASE_AABB_INV_SCALE	(dgFloat32 (1.0f) / DG_BROADPHASE_AABB_SCALE)
 #define DG_CONTACT_TRANSLATION_ERROR	dgFloat32 (1.0e-3f)
@@ -161,8 +161,20 @@ dgBroadPhase::dgBroadPhase(dgWorld* const world)
 	,m_lru(DG_CONTACT_DELAY_FRAMES)
 	,m_contacJointLock()
 	,m_criticalSectionLock()
+	,m_activeBodiesLock()
 	,m_pendingSoftBodyCollisions(world->GetAllocator(), 64)
+	,m_activeBodies(world->GetAllocator())
+	,m_activeContacts(world->GetAllocator())
+	,m_pendingSplitContacts(world->GetAllocator())
+	,m_splitContactShadows(world->GetAllocator())
+	,m_splitContactBuffer(world->GetAllocator())
+	,m_queryTree(world->GetAllocator())
 	,m_pendingSoftBodyPairsCount(0)
+	,m_pendingSplitContactsCount(0)
+	,m_splitContactShadowsCount(0)
+	,m_activeBodiesCount(0)
+	,m_sortedActiveBodiesCount(0)
+	,m_activeContactsCount(0)
 	,m_dirtyNodesCount(0)
 	,m_scanTwoWays(false)
 	,m_recursiveChunks(false)
@@ -171,6 +183,9 @@ dgBroadPhase::dgBroadPhase(dgWorld* const world)
 
 dgBroadPhase::~dgBroadPhase()
 {
+	for (dgInt32 i = 0; i < m_splitContactShadowsCount; i ++) {
+		delete m_splitContactShadows[i];
+	}
 }
 
 
@@ -196,6 +211,270 @@ void dgBroadPhase::MoveNodes (dgBroadPhase* const dst)
 		UnlinkAggregate(aggregate);
 		dst->LinkAggregate(aggregate);
 	}
+
+	for (dgInt32 i = 0; i < m_activeBodiesCount; i ++) {
+		dgBody* const body = m_activeBodies[i];
+		body->m_activeIndex = -1;
+		dst->ActivateBody(body);
+	}
+	m_activeBodiesCount = 0;
+	m_sortedActiveBodiesCount = 0;
+}
+
+dgInt32 dgBroadPhase::SaveStateNodes (dgBroadPhaseNode* const root, dgWorldStateStream* const stream, dgWorldStatePointerSet* const nodes) const
+{
+	// aggregates are leaves here, their trees are saved on their own
+	dgInt32 count = 0;
+	dgBroadPhaseNode* stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];
+	stackPool[0] = root;
+	dgInt32 stack = 1;
+	while (stack) {
+		stack --;
+		dgBroadPhaseNode* const node = stackPool[stack];
+		count ++;
+		if (nodes) {
+			nodes->Add (node);
+		}
+		if (stream) {
+			stream->Write (node);
+			stream->Write (node->m_parent);
+			stream->Write (node->GetLeft());
+			stream->Write (node->GetRight());
+			stream->Write (node->m_minBox);
+			stream->Write (node->m_maxBox);
+			stream->Write (node->m_surfaceArea);
+			stream->Write (dgUnsigned32 (m_lru - node->m_nodeIsDirtyLru));
+		}
+
+		if (!node->IsLeafNode()) {
+			// the children of the persistent root can be NULL
+			if (node->GetLeft()) {
+				stackPool[stack] = node->GetLeft();
+				stack ++;
+			}
+			if (node->GetRight()) {
+				stackPool[stack] = node->GetRight();
+				stack ++;
+			}
+			dgAssert (stack < dgInt32 (sizeof (stackPool) / sizeof (stackPool[0])));
+		}
+	}
+	return count;
+}
+
+dgInt32 dgBroadPhase::SaveStateNodes (dgWorldStateStream* const stream, dgWorldStatePointerSet* const nodes) const
+{
+	dgInt32 count = 0;
+	if (m_rootNode) {
+		count += SaveStateNodes (m_rootNode, stream, nodes);
+	}
+
+	// the top level nodes of the sweep and prune broad phase are not in a tree
+	for (dgList<dgBroadPhaseNode*>::dgListNode* ptr = m_updateList.GetFirst(); ptr; ptr = ptr->GetNext()) {
+		dgBroadPhaseNode* const node = ptr->GetInfo();
+		if (!node->m_parent && (node != m_rootNode)) {
+			count += SaveStateNodes (node, stream, nodes);
+		}
+	}
+
+	for (dgList<dgBroadPhaseAggregate*>::dgListNode* ptr = m_aggregateList.GetFirst(); ptr; ptr = ptr->GetNext()) {
+		dgBroadPhaseAggregate* const aggregate = ptr->GetInfo();
+		if (aggregate->m_root) {
+			count += SaveStateNodes (aggregate->m_root, stream, nodes);
+		}
+	}
+	return count;
+}
+
+dgInt32 dgBroadPhase::GetStateNodeCount() const
+{
+	return SaveStateNodes (NULL, NULL);
+}
+
+void dgBroadPhase::SaveFitnessState (dgWorldStateStream& stream, const dgList<dgBroadPhaseTreeNode*>& fitness) const
+{
+	// a tree rebuild reuses the nodes in fitness list order
+	stream.Write (fitness.GetCount());
+	for (dgList<dgBroadPhaseTreeNode*>::dgListNode* ptr = fitness.GetFirst(); ptr; ptr = ptr->GetNext()) {
+		stream.Write (ptr->GetInfo());
+	}
+}
+
+bool dgBroadPhase::ValidateFitnessState (dgWorldStateStream& stream, const dgList<dgBroadPhaseTreeNode*>& fitness) const
+{
+	dgInt32 count;
+	stream.Read (count);
+	if (count != fitness.GetCount()) {
+		return false;
+	}
+
+	dgWorldStatePointerSet nodes (count);
+	for (dgList<dgBroadPhaseTreeNode*>::dgListNode* ptr = fitness.GetFirst(); ptr; ptr = ptr->GetNext()) {
+		nodes.Add (ptr->GetInfo());
+	}
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgBroadPhaseTreeNode* node;
+		stream.Read (node);
+		if (!nodes.Find (node)) {
+			return false;
+		}
+	}
+	return !stream.IsOverflow();
+}
+
+void dgBroadPhase::RestoreFitnessState (dgWorldStateStream& stream, dgList<dgBroadPhaseTreeNode*>& fitness)
+{
+	dgInt32 count;
+	stream.Read (count);
+	dgAssert (count == fitness.GetCount());
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgBroadPhaseTreeNode* node;
+		stream.Read (node);
+		dgAssert (node->m_fitnessNode->GetInfo() == node);
+		fitness.RotateToEnd (node->m_fitnessNode);
+	}
+}
+
+void dgBroadPhase::SaveState (dgWorldStateStream& stream) const
+{
+	stream.Write (m_rootNode);
+	stream.Write (m_dirtyNodesCount);
+	stream.Write (GetStateNodeCount());
+	SaveStateNodes (&stream, NULL);
+
+	for (dgList<dgBroadPhaseAggregate*>::dgListNode* ptr = m_aggregateList.GetFirst(); ptr; ptr = ptr->GetNext()) {
+		dgBroadPhaseAggregate* const aggregate = ptr->GetInfo();
+		stream.Write (aggregate->m_root);
+		stream.Write (aggregate->m_treeEntropy);
+		stream.Write (dgInt32 (aggregate->m_isInEquilibrium));
+		SaveFitnessState (stream, aggregate->m_fitnessList);
+	}
+
+	stream.Write (m_activeBodiesCount);
+	stream.Write (m_sortedActiveBodiesCount);
+	for (dgInt32 i = 0; i < m_activeBodiesCount; i ++) {
+		stream.Write (m_activeBodies[i]);
+	}
+}
+
+bool dgBroadPhase::ValidateState (dgWorldStateStream& stream, const dgWorldStatePointerSet& bodies) const
+{
+	// reads the same layout as RestoreState without changing anything, every saved address has to be a live node or body
+	const dgInt32 liveNodeCount = GetStateNodeCount();
+	dgWorldStatePointerSet nodes (liveNodeCount);
+	SaveStateNodes (NULL, &nodes);
+
+	dgBroadPhaseNode* root;
+	dgInt32 dirtyNodesCount;
+	dgInt32 nodeCount;
+	stream.Read (root);
+	stream.Read (dirtyNodesCount);
+	stream.Read (nodeCount);
+	if ((nodeCount != liveNodeCount) || (root && !nodes.Find (root))) {
+		return false;
+	}
+	for (dgInt32 i = 0; i < nodeCount; i ++) {
+		dgBroadPhaseNode* node;
+		dgBroadPhaseNode* parent;
+		dgBroadPhaseNode* left;
+		dgBroadPhaseNode* right;
+		dgVector minBox;
+		dgVector maxBox;
+		dgFloat32 surfaceArea;
+		dgUnsigned32 lru;
+		stream.Read (node);
+		stream.Read (parent);
+		stream.Read (left);
+		stream.Read (right);
+		stream.Read (minBox);
+		stream.Read (maxBox);
+		stream.Read (surfaceArea);
+		stream.Read (lru);
+		if (!nodes.Find (node) || (parent && !nodes.Find (parent))) {
+			return false;
+		}
+		if (!node->IsLeafNode() && ((left && !nodes.Find (left)) || (right && !nodes.Find (right)))) {
+			return false;
+		}
+	}
+
+	for (dgList<dgBroadPhaseAggregate*>::dgListNode* ptr = m_aggregateList.GetFirst(); ptr; ptr = ptr->GetNext()) {
+		dgBroadPhaseNode* aggregateRoot;
+		dgFloat64 treeEntropy;
+		dgInt32 equilibrium;
+		stream.Read (aggregateRoot);
+		stream.Read (treeEntropy);
+		stream.Read (equilibrium);
+		if ((aggregateRoot && !nodes.Find (aggregateRoot)) || !ValidateFitnessState (stream, ptr->GetInfo()->m_fitnessList)) {
+			return false;
+		}
+	}
+
+	dgInt32 activeBodiesCount;
+	dgInt32 sortedActiveBodiesCount;
+	stream.Read (activeBodiesCount);
+	stream.Read (sortedActiveBodiesCount);
+	if ((activeBodiesCount < 0) || (activeBodiesCount > bodies.GetCount()) || (sortedActiveBodiesCount < 0) || (sortedActiveBodiesCount > activeBodiesCount)) {
+		return false;
+	}
+	for (dgInt32 i = 0; i < activeBodiesCount; i ++) {
+		dgBody* body;
+		stream.Read (body);
+		if (!bodies.Find (body)) {
+			return false;
+		}
+	}
+	return !stream.IsOverflow();
+}
+
+void dgBroadPhase::RestoreState (dgWorldStateStream& stream)
+{
+	dgInt32 nodeCount;
+	stream.Read (m_rootNode);
+	stream.Read (m_dirtyNodesCount);
+	stream.Read (nodeCount);
+	for (dgInt32 i = 0; i < nodeCount; i ++) {
+		dgBroadPhaseNode* node;
+		dgBroadPhaseNode* left;
+		dgBroadPhaseNode* right;
+		dgUnsigned32 lru;
+		stream.Read (node);
+		stream.Read (node->m_parent);
+		stream.Read (left);
+		stream.Read (right);
+		stream.Read (node->m_minBox);
+		stream.Read (node->m_maxBox);
+		stream.Read (node->m_surfaceArea);
+		stream.Read (lru);
+		node->m_nodeIsDirtyLru = m_lru - lru;
+		if (!node->IsLeafNode()) {
+			dgBroadPhaseTreeNode* const treeNode = (dgBroadPhaseTreeNode*)node;
+			treeNode->m_left = left;
+			treeNode->m_right = right;
+		}
+	}
+
+	for (dgList<dgBroadPhaseAggregate*>::dgListNode* ptr = m_aggregateList.GetFirst(); ptr; ptr = ptr->GetNext()) {
+		dgInt32 equilibrium;
+		dgBroadPhaseAggregate* const aggregate = ptr->GetInfo();
+		stream.Read (aggregate->m_root);
+		stream.Read (aggregate->m_treeEntropy);
+		stream.Read (equilibrium);
+		aggregate->m_isInEquilibrium = equilibrium;
+		RestoreFitnessState (stream, aggregate->m_fitnessList);
+	}
+
+	// the bodies already have their active index reset
+	stream.Read (m_activeBodiesCount);
+	stream.Read (m_sortedActiveBodiesCount);
+	m_activeBodies.ResizeIfNecessary (m_activeBodiesCount);
+	for (dgInt32 i = 0; i < m_activeBodiesCount; i ++) {
+		dgBody* body;
+		stream.Read (body);
+		body->m_activeIndex = i;
+		m_activeBodies[i] = body;
+	}
+	m_queryTree.Invalidate (true);
 }
 
 dgBroadPhaseTreeNode* dgBroadPhase::InsertNode(dgBroadPhaseNode* const root, dgBroadPhaseNode* const node)
@@ -237,6 +516,7 @@ dgBroadPhaseTreeNode* dgBroadPhase::InsertNode(dgBroadPhaseNode* const root, dgB
 	}
 
 	dgBroadPhaseTreeNode* const parent = new (m_world->GetAllocator()) dgBroadPhaseTreeNode(sibling, node);
+	m_queryTree.Invalidate(true);
 	return parent;
 }
 
@@ -245,33 +525,42 @@ void dgBroadPhase::UpdateAggregateEntropyKernel(void* const context, void* const
 {
 	dgBroadphaseSyncDescriptor* const descriptor = (dgBroadphaseSyncDescriptor*)context;
 	dgWorld* const world = descriptor->m_world;
+	DG_PROFILE_PHASE (world, m_aggregateEntropy, threadID);
 	dgBroadPhase* const broadPhase = world->GetBroadPhase();
 	broadPhase->UpdateAggregateEntropy(descriptor, (dgList<dgBroadPhaseAggregate*>::dgListNode*) node, threadID);
 }
 
-void dgBroadPhase::ForceAndToqueKernel(void* const context, void* const node, dgInt32 threadID)
+void dgBroadPhase::ForceAndToqueKernel(void* const context, void* const worldContext, dgInt32 threadID)
 {
 	dgBroadphaseSyncDescriptor* const descriptor = (dgBroadphaseSyncDescriptor*)context;
 	dgWorld* const world = descriptor->m_world;
+	DG_PROFILE_PHASE (world, m_forceCallbacks, threadID);
 	dgBroadPhase* const broadPhase = world->GetBroadPhase();
-	broadPhase->ApplyForceAndtorque(descriptor, (dgBodyMasterList::dgListNode*) node, threadID);
+	broadPhase->ApplyForceAndtorque(descriptor, threadID);
 }
 
-void dgBroadPhase::SleepingStateKernel(void* const context, void* const node, dgInt32 threadID)
+void dgBroadPhase::SleepingStateKernel(void* const context, void* const worldContext, dgInt32 threadID)
 {
 	dgBroadphaseSyncDescriptor* const descriptor = (dgBroadphaseSyncDescriptor*)context;
 	dgWorld* const world = descriptor->m_world;
 	dgBroadPhase* const broadPhase = world->GetBroadPhase();
-	broadPhase->SleepingState(descriptor, (dgBodyMasterList::dgListNode*) node, threadID);
+	broadPhase->SleepingState(descriptor, threadID);
 }
 
-bool dgBroadPhase::DoNeedUpdate(dgBodyMasterList::dgListNode* const node) const
+void dgBroadPhase::UpdateBodyPhasesKernel(void* const context, void* const worldContext, dgInt32 threadID)
 {
-	dgBody* const body = node->GetInfo().GetBody();
+	dgBroadphaseSyncDescriptor* const descriptor = (dgBroadphaseSyncDescriptor*)context;
+	dgWorld* const world = descriptor->m_world;
+	dgBroadPhase* const broadPhase = world->GetBroadPhase();
+	broadPhase->UpdateBodyPhases(descriptor, threadID);
+}
 
-	bool state = body->GetInvMass().m_w != dgFloat32 (0.0f);
-	state = state || !body->m_equilibrium || (body->GetExtForceAndTorqueCallback() != NULL);
-	return state;
+bool dgBroadPhase::DoNeedUpdate(const dgBody* const body) const
+{
+	if (body->GetInvMass().m_w != dgFloat32 (0.0f)) {
+		return !(body->m_sleeping & body->m_equilibrium);
+	}
+	return !body->m_equilibrium || (body->GetExtForceAndTorqueCallback() != NULL);
 }
 
 void dgBroadPhase::UpdateAggregateEntropy (dgBroadphaseSyncDescriptor* const descriptor, dgList<dgBroadPhaseAggregate*>::dgListNode* node, dgInt32 threadID)
@@ -285,38 +574,156 @@ void dgBroadPhase::UpdateAggregateEntropy (dgBroadphaseSyncDescriptor* const des
 	}
 }
 
+void dgBroadPhase::RunBodyPhase (dgBroadphaseSyncDescriptor* const descriptor, dgWorkerThreadTaskCallback kernel, dgInt32 threadID)
+{
+	const dgInt32 threadsCount = m_world->GetThreadCount();
+	dgThreadHive::dgThreadJobCounter group;
+	descriptor->m_atomicIndex = 0;
+	for (dgInt32 i = 0; i < threadsCount; i++) {
+		m_world->SpawnJob(threadID, kernel, descriptor, m_world, &group);
+	}
+	m_world->CloseJobGroup(threadID, &group);
+	m_world->WaitForJobGroup(threadID, &group);
+}
 
-void dgBroadPhase::ApplyForceAndtorque(dgBroadphaseSyncDescriptor* const descriptor, dgBodyMasterList::dgListNode* node, dgInt32 threadID)
+void dgBroadPhase::UpdateBodyPhases (dgBroadphaseSyncDescriptor* const descriptor, dgInt32 threadID)
 {
-	dgFloat32 timestep = descriptor->m_timestep;
+	// each phase is a job group that starts when the previous one is completed,
+	// the thread running this job helps with the work while it waits
+	if (descriptor->m_applyForces) {
+		RunBodyPhase (descriptor, ForceAndToqueKernel, threadID);
+	}
+	RunBodyPhase (descriptor, SleepingStateKernel, threadID);
 
-	const dgInt32 threadCount = descriptor->m_world->GetThreadCount();
-	while (node) {
-		if (DoNeedUpdate(node)) {
-			dgBody* const body = node->GetInfo().GetBody();
+	// the aggregates read the body boxes updated by the sleeping state phase
+	const dgInt32 threadsCount = m_world->GetThreadCount();
+	dgThreadHive::dgThreadJobCounter group;
+	dgList<dgBroadPhaseAggregate*>::dgListNode* aggregateNode = m_aggregateList.GetFirst();
+	for (dgInt32 i = 0; (i < threadsCount) && aggregateNode; i++) {
+		m_world->SpawnJob(threadID, UpdateAggregateEntropyKernel, descriptor, aggregateNode, &group);
+		aggregateNode = aggregateNode->GetNext();
+	}
+	m_world->CloseJobGroup(threadID, &group);
+	m_world->WaitForJobGroup(threadID, &group);
+}
 
-			if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
-				dgDynamicBody* const dynamicBody = (dgDynamicBody*)body;
-				dynamicBody->ApplyExtenalForces(timestep, threadID);
-			}
+
+dgInt32 dgBroadPhase::CompareActiveBodies(dgBody* const* const bodyA, dgBody* const* const bodyB, void* const)
+{
+	const dgInt32 idA = (*bodyA)->m_uniqueID;
+	const dgInt32 idB = (*bodyB)->m_uniqueID;
+	if (idA < idB) {
+		return -1;
+	} else if (idA > idB) {
+		return 1;
+	}
+	return 0;
+}
+
+void dgBroadPhase::ActivateBody (dgBody* const body)
+{
+	dgThreadHiveScopeLock lock (m_world, &m_activeBodiesLock, false);
+	if (body->m_activeIndex < 0) {
+		// the array is presized at the beginning of the step, so kernels reading it never see it move
+		m_activeBodies.ResizeIfNecessary (m_activeBodiesCount + 1);
+		body->m_activeIndex = m_activeBodiesCount;
+		m_activeBodies[m_activeBodiesCount] = body;
+		m_activeBodiesCount ++;
+	}
+}
+
+void dgBroadPhase::DeactivateBody (dgBody* const body)
+{
+	dgThreadHiveScopeLock lock (m_world, &m_activeBodiesLock, false);
+	dgInt32 index = body->m_activeIndex;
+	if (index >= 0) {
+		dgAssert (m_activeBodies[index] == body);
+		// keep the sorted head and the pending tail apart
+		if (index < m_sortedActiveBodiesCount) {
+			m_sortedActiveBodiesCount --;
+			dgBody* const lastSorted = m_activeBodies[m_sortedActiveBodiesCount];
+			m_activeBodies[index] = lastSorted;
+			lastSorted->m_activeIndex = index;
+			index = m_sortedActiveBodiesCount;
+		}
+		m_activeBodiesCount --;
+		if (index < m_activeBodiesCount) {
+			dgBody* const last = m_activeBodies[m_activeBodiesCount];
+			m_activeBodies[index] = last;
+			last->m_activeIndex = index;
 		}
+		body->m_activeIndex = -1;
+	}
+}
 
-		for (dgInt32 i = 0; i < threadCount; i++) {
-			node = node ? node->GetPrev() : NULL;
+void dgBroadPhase::SortActiveBodies ()
+{
+	// bodies woken up from worker threads arrive in any order, sorting them makes the set order deterministic
+	const dgInt32 count = m_activeBodiesCount - m_sortedActiveBodiesCount;
+	if (count) {
+		dgBody** const tail = &m_activeBodies[m_sortedActiveBodiesCount];
+		dgSort (tail, count, CompareActiveBodies);
+		for (dgInt32 i = m_sortedActiveBodiesCount; i < m_activeBodiesCount; i ++) {
+			m_activeBodies[i]->m_activeIndex = i;
+		}
+		m_sortedActiveBodiesCount = m_activeBodiesCount;
+	}
+}
+
+void dgBroadPhase::BuildActiveBodyArray ()
+{
+	// the active set is maintained incrementally, bodies join it when they wake up and
+	// are dropped here when they no longer need update, sleeping bodies cost nothing
+	dgInt32 count = 0;
+	dgInt32 sortedCount = 0;
+	dgBody** const bodyArray = &m_activeBodies[0];
+	for (dgInt32 i = 0; i < m_activeBodiesCount; i ++) {
+		dgBody* const body = bodyArray[i];
+		if (DoNeedUpdate(body)) {
+			body->m_activeIndex = count;
+			bodyArray[count] = body;
+			count ++;
+			sortedCount += (i < m_sortedActiveBodiesCount) ? 1 : 0;
+		} else {
+			body->m_activeIndex = -1;
 		}
 	}
+	m_activeBodiesCount = count;
+	m_sortedActiveBodiesCount = sortedCount;
+	SortActiveBodies ();
+
+	const dgBodyMasterList* const masterList = m_world;
+	m_activeBodies.ResizeIfNecessary (masterList->GetCount() * 2);
 }
 
 
-void dgBroadPhase::SleepingState(dgBroadphaseSyncDescriptor* const descriptor, dgBodyMasterList::dgListNode* node, dgInt32 threadID)
+void dgBroadPhase::ApplyForceAndtorque(dgBroadphaseSyncDescriptor* const descriptor, dgInt32 threadID)
 {
-	dgFloat32 timestep = descriptor->m_timestep;
+	const dgFloat32 timestep = descriptor->m_timestep;
+	const dgInt32 count = m_sortedActiveBodiesCount;
+	dgBody** const bodyArray = &m_activeBodies[0];
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, DG_BROADPHASE_BODY_CHUNK); i < count; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, DG_BROADPHASE_BODY_CHUNK)) {
+		const dgInt32 chunkEnd = dgMin (i + DG_BROADPHASE_BODY_CHUNK, count);
+		for (dgInt32 j = i; j < chunkEnd; j ++) {
+			dgBody* const body = bodyArray[j];
+			if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
+				dgDynamicBody* const dynamicBody = (dgDynamicBody*)body;
+				dynamicBody->ApplyExtenalForces(timestep, threadID);
+			}
+		}
+	}
+}
 
-	const dgInt32 threadCount = descriptor->m_world->GetThreadCount();
-	while (node) {
-		if (DoNeedUpdate(node)) {
-			dgBody* const body = node->GetInfo().GetBody();
 
+void dgBroadPhase::SleepingState(dgBroadphaseSyncDescriptor* const descriptor, dgInt32 threadID)
+{
+	const dgFloat32 timestep = descriptor->m_timestep;
+	const dgInt32 count = m_sortedActiveBodiesCount;
+	dgBody** const bodyArray = &m_activeBodies[0];
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, DG_BROADPHASE_BODY_CHUNK); i < count; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, DG_BROADPHASE_BODY_CHUNK)) {
+		const dgInt32 chunkEnd = dgMin (i + DG_BROADPHASE_BODY_CHUNK, count);
+		for (dgInt32 j = i; j < chunkEnd; j ++) {
+			dgBody* const body = bodyArray[j];
 			if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
 				dgDynamicBody* const dynamicBody = (dgDynamicBody*)body;
 				if (!dynamicBody->IsInEquilibrium()) {
@@ -349,10 +756,6 @@ void dgBroadPhase::SleepingState(dgBroadphaseSyncDescriptor* const descriptor, d
 				body->UpdateCollisionMatrix(timestep, threadID);
 			}
 		}
-
-		for (dgInt32 i = 0; i < threadCount; i++) {
-			node = node ? node->GetPrev() : NULL;
-		}
 	}
 }
 
@@ -401,11 +804,6 @@ dgInt32 dgBroadPhase::ConvexCast(const dgBroadPhaseNode** stackPool, dgFloat32*
 {
 	dgVector boxP0;
 	dgVector boxP1;
-	dgTriplex points[DG_CONVEX_CAST_POOLSIZE];
-	dgTriplex normals[DG_CONVEX_CAST_POOLSIZE];
-	dgFloat32 penetration[DG_CONVEX_CAST_POOLSIZE];
-	dgInt64 attributeA[DG_CONVEX_CAST_POOLSIZE];
-	dgInt64 attributeB[DG_CONVEX_CAST_POOLSIZE];
 	dgInt32 totalCount = 0;
 
 	dgAssert(matrix.TestOrthogonal());
@@ -427,37 +825,9 @@ dgInt32 dgBroadPhase::ConvexCast(const dgBroadPhaseNode** stackPool, dgFloat32*
 
 			dgBody* const body = me->GetBody();
 			if (body) {
-				if (!PREFILTER_RAYCAST(prefilter, body, body->m_collision, userData)) {
-					dgInt32 count = m_world->CollideContinue(shape, matrix, velocA, velocB, body->m_collision, body->m_matrix, velocB, velocB, timeToImpact, points, normals, penetration, attributeA, attributeB, maxContacts, threadIndex);
-
-					if (timeToImpact < maxParam) {
-						if ((timeToImpact - maxParam) < dgFloat32(-1.0e-3f)) {
-							totalCount = 0;
-						}
-						maxParam = timeToImpact;
-						if (count >= (maxContacts - totalCount)) {
-							count = maxContacts - totalCount;
-						}
-
-						for (dgInt32 i = 0; i < count; i++) {
-							info[totalCount].m_point[0] = points[i].m_x;
-							info[totalCount].m_point[1] = points[i].m_y;
-							info[totalCount].m_point[2] = points[i].m_z;
-							info[totalCount].m_point[3] = dgFloat32(0.0f);
-							info[totalCount].m_normal[0] = normals[i].m_x;
-							info[totalCount].m_normal[1] = normals[i].m_y;
-							info[totalCount].m_normal[2] = normals[i].m_z;
-							info[totalCount].m_normal[3] = dgFloat32(0.0f);
-							info[totalCount].m_penetration = penetration[i];
-							info[totalCount].m_contaID = attributeB[i];
-
-							info[totalCount].m_hitBody = body;
-							totalCount++;
-						}
-					}
-					if (maxParam < 1.0e-8f) {
-						break;
-					}
+				totalCount = ConvexCastBody(body, shape, matrix, velocA, velocB, timeToImpact, maxParam, prefilter, userData, info, totalCount, maxContacts, threadIndex);
+				if (maxParam < 1.0e-8f) {
+					break;
 				}
 			} else if (me->IsAggregate()) {
 				dgBroadPhaseAggregate* const aggregate = (dgBroadPhaseAggregate*)me;
@@ -523,12 +893,6 @@ dgInt32 dgBroadPhase::ConvexCast(const dgBroadPhaseNode** stackPool, dgFloat32*
 
 dgInt32 dgBroadPhase::Collide(const dgBroadPhaseNode** stackPool, dgInt32* const ovelapStack, dgInt32 stack, const dgVector& boxP0, const dgVector& boxP1, dgCollisionInstance* const shape, const dgMatrix& matrix, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const
 {
-	dgTriplex points[DG_CONVEX_CAST_POOLSIZE];
-	dgTriplex normals[DG_CONVEX_CAST_POOLSIZE];
-	dgFloat32 penetration[DG_CONVEX_CAST_POOLSIZE];
-	dgInt64 attributeA[DG_CONVEX_CAST_POOLSIZE];
-	dgInt64 attributeB[DG_CONVEX_CAST_POOLSIZE];
-
 	dgInt32 totalCount = 0;
 	while (stack) {
 		stack--;
@@ -539,35 +903,10 @@ dgInt32 dgBroadPhase::Collide(const dgBroadPhaseNode** stackPool, dgInt32* const
 
 			dgBody* const body = me->GetBody();
 			if (body) {
-				if (!PREFILTER_RAYCAST(prefilter, body, body->m_collision, userData)) {
-					dgInt32 count = m_world->Collide(shape, matrix, body->m_collision, body->m_matrix, points, normals, penetration, attributeA, attributeB, DG_CONVEX_CAST_POOLSIZE, threadIndex);
-
-					if (count) {
-						bool teminate = false;
-						if (count >= (maxContacts - totalCount)) {
-							count = maxContacts - totalCount;
-							teminate = true;
-						}
-
-						for (dgInt32 i = 0; i < count; i++) {
-							info[totalCount].m_point[0] = points[i].m_x;
-							info[totalCount].m_point[1] = points[i].m_y;
-							info[totalCount].m_point[2] = points[i].m_z;
-							info[totalCount].m_point[3] = dgFloat32(0.0f);
-							info[totalCount].m_normal[0] = normals[i].m_x;
-							info[totalCount].m_normal[1] = normals[i].m_y;
-							info[totalCount].m_normal[2] = normals[i].m_z;
-							info[totalCount].m_normal[3] = dgFloat32(0.0f);
-							info[totalCount].m_penetration = penetration[i];
-							info[totalCount].m_contaID = attributeB[i];
-							info[totalCount].m_hitBody = body;
-							totalCount++;
-						}
-
-						if (teminate) {
-							break;
-						}
-					}
+				const dgInt32 count = CollideBody(body, shape, matrix, prefilter, userData, &info[totalCount], maxContacts - totalCount, threadIndex);
+				totalCount += count;
+				if (count && (totalCount >= maxContacts)) {
+					break;
 				}
 			} else if (me->IsAggregate()) {
 				dgBroadPhaseAggregate* const aggregate = (dgBroadPhaseAggregate*)me;
@@ -598,13 +937,12 @@ dgInt32 dgBroadPhase::Collide(const dgBroadPhaseNode** stackPool, dgInt32* const
 	return totalCount;
 }
 
-void dgBroadPhase::RayCast(const dgBroadPhaseNode** stackPool, dgFloat32* const distance, dgInt32 stack, const dgVector& l0, const dgVector& l1, dgFastRayTest& ray, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData) const
+dgFloat32 dgBroadPhase::RayCast(const dgBroadPhaseNode** stackPool, dgFloat32* const distance, dgInt32 stack, const dgVector& l0, const dgVector& l1, dgFastRayTest& ray, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData, dgFloat32 maxParam) const
 {
 	dgLineBox line;
 	line.m_l0 = l0;
 	line.m_l1 = l1;
 
-	dgFloat32 maxParam = dgFloat32 (1.2f);
 	dgVector test(line.m_l0 <= line.m_l1);
 	line.m_boxL0 = (line.m_l0 & test) | line.m_l1.AndNot(test);
 	line.m_boxL1 = (line.m_l1 & test) | line.m_l0.AndNot(test);
@@ -679,6 +1017,425 @@ void dgBroadPhase::RayCast(const dgBroadPhaseNode** stackPool, dgFloat32* const
 			}
 		}
 	}
+	return maxParam;
+}
+
+dgInt32 dgBroadPhase::ConvexCastBody(dgBody* const body, dgCollisionInstance* const shape, const dgMatrix& matrix, const dgVector& velocA, const dgVector& velocB, dgFloat32& timeToImpact, dgFloat32& maxParam,
+									 OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 totalCount, dgInt32 maxContacts, dgInt32 threadIndex) const
+{
+	if (!PREFILTER_RAYCAST(prefilter, body, body->m_collision, userData)) {
+		dgTriplex points[DG_CONVEX_CAST_POOLSIZE];
+		dgTriplex normals[DG_CONVEX_CAST_POOLSIZE];
+		dgFloat32 penetration[DG_CONVEX_CAST_POOLSIZE];
+		dgInt64 attributeA[DG_CONVEX_CAST_POOLSIZE];
+		dgInt64 attributeB[DG_CONVEX_CAST_POOLSIZE];
+		dgInt32 count = m_world->CollideContinue(shape, matrix, velocA, velocB, body->m_collision, body->m_matrix, velocB, velocB, timeToImpact, points, normals, penetration, attributeA, attributeB, maxContacts, threadIndex);
+
+		if (timeToImpact < maxParam) {
+			if ((timeToImpact - maxParam) < dgFloat32(-1.0e-3f)) {
+				totalCount = 0;
+			}
+			maxParam = timeToImpact;
+			if (count >= (maxContacts - totalCount)) {
+				count = maxContacts - totalCount;
+			}
+
+			for (dgInt32 i = 0; i < count; i++) {
+				info[totalCount].m_point[0] = points[i].m_x;
+				info[totalCount].m_point[1] = points[i].m_y;
+				info[totalCount].m_point[2] = points[i].m_z;
+				info[totalCount].m_point[3] = dgFloat32(0.0f);
+				info[totalCount].m_normal[0] = normals[i].m_x;
+				info[totalCount].m_normal[1] = normals[i].m_y;
+				info[totalCount].m_normal[2] = normals[i].m_z;
+				info[totalCount].m_normal[3] = dgFloat32(0.0f);
+				info[totalCount].m_penetration = penetration[i];
+				info[totalCount].m_contaID = attributeB[i];
+
+				info[totalCount].m_hitBody = body;
+				totalCount++;
+			}
+		}
+	}
+	return totalCount;
+}
+
+dgInt32 dgBroadPhase::CollideBody(dgBody* const body, dgCollisionInstance* const shape, const dgMatrix& matrix, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const
+{
+	dgInt32 count = 0;
+	if (!PREFILTER_RAYCAST(prefilter, body, body->m_collision, userData)) {
+		dgTriplex points[DG_CONVEX_CAST_POOLSIZE];
+		dgTriplex normals[DG_CONVEX_CAST_POOLSIZE];
+		dgFloat32 penetration[DG_CONVEX_CAST_POOLSIZE];
+		dgInt64 attributeA[DG_CONVEX_CAST_POOLSIZE];
+		dgInt64 attributeB[DG_CONVEX_CAST_POOLSIZE];
+		count = m_world->Collide(shape, matrix, body->m_collision, body->m_matrix, points, normals, penetration, attributeA, attributeB, DG_CONVEX_CAST_POOLSIZE, threadIndex);
+		count = dgMin (count, maxContacts);
+
+		for (dgInt32 i = 0; i < count; i++) {
+			info[i].m_point[0] = points[i].m_x;
+			info[i].m_point[1] = points[i].m_y;
+			info[i].m_point[2] = points[i].m_z;
+			info[i].m_point[3] = dgFloat32(0.0f);
+			info[i].m_normal[0] = normals[i].m_x;
+			info[i].m_normal[1] = normals[i].m_y;
+			info[i].m_normal[2] = normals[i].m_z;
+			info[i].m_normal[3] = dgFloat32(0.0f);
+			info[i].m_penetration = penetration[i];
+			info[i].m_contaID = attributeB[i];
+			info[i].m_hitBody = body;
+		}
+	}
+	return count;
+}
+
+void dgBroadPhase::ForEachBodyInQueryTree(const dgVector& minBox, const dgVector& maxBox, OnBodiesInAABB callback, void* const userData) const
+{
+	dgAssert(m_queryTree.IsValid());
+	const dgBroadPhaseQueryTree::dgNode* const nodes = m_queryTree.GetNodes();
+	const dgBroadPhaseQueryTree::dgLeaf* const leafs = m_queryTree.GetLeafs();
+	if (!nodes) {
+		return;
+	}
+
+	dgInt32 stackPool[DG_QUERY_TREE_STACK_DEPTH];
+	stackPool[0] = 0;
+	dgInt32 stack = 1;
+	while (stack) {
+		stack--;
+		const dgBroadPhaseQueryTree::dgNode& node = nodes[stackPool[stack]];
+		const dgInt32 overlap = dgBroadPhaseQueryTree::BoxOverlap(node, minBox, maxBox);
+		for (dgInt32 i = 0; i < 4; i++) {
+			const dgInt32 child = node.m_child[i];
+			if (child && (overlap & (1 << i))) {
+				if (child < 0) {
+					dgBody* const body = leafs[~child].m_body;
+					if (dgOverlapTest(body->m_minAABB, body->m_maxAABB, minBox, maxBox)) {
+						if (!callback(body, userData)) {
+							return;
+						}
+					}
+				} else {
+					stackPool[stack] = child;
+					stack++;
+					dgAssert(stack < DG_QUERY_TREE_STACK_DEPTH);
+				}
+			}
+		}
+	}
+}
+
+void dgBroadPhase::RayCastQueryTree(const dgVector& l0, const dgVector& l1, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData) const
+{
+	dgAssert(m_queryTree.IsValid());
+	const dgBroadPhaseQueryTree::dgNode* const nodes = m_queryTree.GetNodes();
+	const dgBroadPhaseQueryTree::dgLeaf* const leafs = m_queryTree.GetLeafs();
+	if (!nodes) {
+		return;
+	}
+
+	dgFastRayTest fastRay(l0, l1);
+	const dgBroadPhaseQueryTree::dgRay ray(fastRay, dgVector::m_zero, dgVector::m_zero);
+
+	dgLineBox line;
+	line.m_l0 = l0;
+	line.m_l1 = l1;
+	dgVector test(line.m_l0 <= line.m_l1);
+	line.m_boxL0 = (line.m_l0 & test) | line.m_l1.AndNot(test);
+	line.m_boxL1 = (line.m_l1 & test) | line.m_l0.AndNot(test);
+
+	// entries are sorted by distance with the closest at the top of the stack
+	dgInt32 stackPool[DG_QUERY_TREE_STACK_DEPTH];
+	dgFloat32 distance[DG_QUERY_TREE_STACK_DEPTH];
+	stackPool[0] = 0;
+	distance[0] = dgFloat32(0.0f);
+	dgInt32 stack = 1;
+
+	dgFloat32 maxParam = dgFloat32(1.2f);
+	while (stack) {
+		stack--;
+		if (distance[stack] > maxParam) {
+			break;
+		}
+		const dgInt32 index = stackPool[stack];
+		if (index < 0) {
+			dgBody* const body = leafs[~index].m_body;
+			dgFloat32 param = body->RayCast(line, filter, prefilter, userData, maxParam);
+			if (param < maxParam) {
+				maxParam = param;
+				if (maxParam < dgFloat32(1.0e-8f)) {
+					break;
+				}
+			}
+		} else {
+			const dgBroadPhaseQueryTree::dgNode& node = nodes[index];
+			const dgVector dist(ray.BoxIntersect(node));
+			for (dgInt32 i = 0; i < 4; i++) {
+				const dgInt32 child = node.m_child[i];
+				const dgFloat32 dist1 = dist[i];
+				if (child && (dist1 < maxParam)) {
+					dgInt32 j = stack;
+					for (; j && (dist1 > distance[j - 1]); j--) {
+						stackPool[j] = stackPool[j - 1];
+						distance[j] = distance[j - 1];
+					}
+					stackPool[j] = child;
+					distance[j] = dist1;
+					stack++;
+					dgAssert(stack < DG_QUERY_TREE_STACK_DEPTH);
+				}
+			}
+		}
+	}
+}
+
+dgInt32 dgBroadPhase::ConvexCastQueryTree(dgCollisionInstance* const shape, const dgMatrix& matrix, const dgVector& target, dgFloat32* const param, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const
+{
+	dgAssert(m_queryTree.IsValid());
+	*param = dgFloat32(1.0f);
+	const dgBroadPhaseQueryTree::dgNode* const nodes = m_queryTree.GetNodes();
+	const dgBroadPhaseQueryTree::dgLeaf* const leafs = m_queryTree.GetLeafs();
+	if (!nodes) {
+		return 0;
+	}
+
+	dgVector boxP0;
+	dgVector boxP1;
+	dgAssert(matrix.TestOrthogonal());
+	shape->CalcAABB(matrix, boxP0, boxP1);
+
+	dgVector velocA((target - matrix.m_posit) & dgVector::m_triplexMask);
+	dgVector velocB(dgFloat32(0.0f));
+	dgFastRayTest fastRay(dgVector(dgFloat32(0.0f)), velocA);
+	const dgBroadPhaseQueryTree::dgRay ray(fastRay, boxP0, boxP1);
+
+	maxContacts = dgMin (maxContacts, DG_CONVEX_CAST_POOLSIZE);
+	dgAssert (!maxContacts || (maxContacts && info));
+
+	dgInt32 stackPool[DG_QUERY_TREE_STACK_DEPTH];
+	dgFloat32 distance[DG_QUERY_TREE_STACK_DEPTH];
+	stackPool[0] = 0;
+	distance[0] = dgFloat32(0.0f);
+	dgInt32 stack = 1;
+
+	dgInt32 totalCount = 0;
+	dgFloat32 maxParam = *param;
+	dgFloat32 timeToImpact = *param;
+	while (stack) {
+		stack--;
+		if (distance[stack] > maxParam) {
+			break;
+		}
+		const dgInt32 index = stackPool[stack];
+		if (index < 0) {
+			dgBody* const body = leafs[~index].m_body;
+			totalCount = ConvexCastBody(body, shape, matrix, velocA, velocB, timeToImpact, maxParam, prefilter, userData, info, totalCount, maxContacts, threadIndex);
+			if (maxParam < 1.0e-8f) {
+				break;
+			}
+		} else {
+			const dgBroadPhaseQueryTree::dgNode& node = nodes[index];
+			const dgVector dist(ray.BoxIntersect(node));
+			for (dgInt32 i = 0; i < 4; i++) {
+				const dgInt32 child = node.m_child[i];
+				const dgFloat32 dist1 = dist[i];
+				if (child && (dist1 < maxParam)) {
+					dgInt32 j = stack;
+					for (; j && (dist1 > distance[j - 1]); j--) {
+						stackPool[j] = stackPool[j - 1];
+						distance[j] = distance[j - 1];
+					}
+					stackPool[j] = child;
+					distance[j] = dist1;
+					stack++;
+					dgAssert(stack < DG_QUERY_TREE_STACK_DEPTH);
+				}
+			}
+		}
+	}
+	*param = maxParam;
+	return totalCount;
+}
+
+dgInt32 dgBroadPhase::CollideQueryTree(dgCollisionInstance* const shape, const dgMatrix& matrix, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const
+{
+	dgAssert(m_queryTree.IsValid());
+	const dgBroadPhaseQueryTree::dgNode* const nodes = m_queryTree.GetNodes();
+	const dgBroadPhaseQueryTree::dgLeaf* const leafs = m_queryTree.GetLeafs();
+	if (!nodes) {
+		return 0;
+	}
+
+	dgVector boxP0;
+	dgVector boxP1;
+	dgAssert(matrix.TestOrthogonal());
+	shape->CalcAABB(matrix, boxP0, boxP1);
+
+	dgInt32 stackPool[DG_QUERY_TREE_STACK_DEPTH];
+	stackPool[0] = 0;
+	dgInt32 stack = 1;
+
+	dgInt32 totalCount = 0;
+	while (stack) {
+		stack--;
+		const dgBroadPhaseQueryTree::dgNode& node = nodes[stackPool[stack]];
+		const dgInt32 overlap = dgBroadPhaseQueryTree::BoxOverlap(node, boxP0, boxP1);
+		for (dgInt32 i = 0; i < 4; i++) {
+			const dgInt32 child = node.m_child[i];
+			if (child && (overlap & (1 << i))) {
+				if (child < 0) {
+					dgBody* const body = leafs[~child].m_body;
+					const dgInt32 count = CollideBody(body, shape, matrix, prefilter, userData, &info[totalCount], maxContacts - totalCount, threadIndex);
+					totalCount += count;
+					if (count && (totalCount >= maxContacts)) {
+						return totalCount;
+					}
+				} else {
+					stackPool[stack] = child;
+					stack++;
+					dgAssert(stack < DG_QUERY_TREE_STACK_DEPTH);
+				}
+			}
+		}
+	}
+	return totalCount;
+}
+
+// user data of the batch ray filters
+class dgRayCastBatchContext
+{
+	public:
+	dgRayCastBatchHit* m_hit;
+	OnRayPrecastAction m_prefilter;
+	void* m_userData;
+};
+
+static dgUnsigned32 dgApi dgRayCastBatchPrefilter(const dgBody* const body, const dgCollisionInstance* const collision, void* const userData)
+{
+	const dgRayCastBatchContext* const context = (dgRayCastBatchContext*)userData;
+	return context->m_prefilter(body, collision, context->m_userData);
+}
+
+static dgFloat32 dgApi dgRayCastBatchFilter(const dgBody* const body, const dgCollisionInstance* const collision, const dgVector& contact, const dgVector& normal, dgInt64 collisionID, void* const userData, dgFloat32 intersetParam)
+{
+	// keep the closest hit only
+	dgRayCastBatchHit* const hit = ((dgRayCastBatchContext*)userData)->m_hit;
+	if (intersetParam < hit->m_param) {
+		hit->m_point[0] = contact.m_x;
+		hit->m_point[1] = contact.m_y;
+		hit->m_point[2] = contact.m_z;
+		hit->m_point[3] = dgFloat32(0.0f);
+		hit->m_normal[0] = normal.m_x;
+		hit->m_normal[1] = normal.m_y;
+		hit->m_normal[2] = normal.m_z;
+		hit->m_normal[3] = dgFloat32(0.0f);
+		hit->m_contactID = collisionID;
+		hit->m_hitBody = body;
+		hit->m_param = intersetParam;
+	}
+	return hit->m_param;
+}
+
+void dgBroadPhase::RayCastBatchKernel(void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgQueryBatchDescriptor* const descriptor = (dgQueryBatchDescriptor*)context;
+	descriptor->m_broadPhase->RayCastBatch(descriptor, threadID);
+}
+
+void dgBroadPhase::ConvexCastBatchKernel(void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgQueryBatchDescriptor* const descriptor = (dgQueryBatchDescriptor*)context;
+	descriptor->m_broadPhase->ConvexCastBatch(descriptor, threadID);
+}
+
+void dgBroadPhase::RayCastBatch(const dgRayCastBatchQuery* const queries, dgRayCastBatchHit* const hits, dgInt32 count, OnRayPrecastAction prefilter, void* const userData) const
+{
+	dgQueryBatchDescriptor descriptor(this, count, prefilter, userData);
+	descriptor.m_rayQueries = queries;
+	descriptor.m_rayHits = hits;
+
+	const dgInt32 threadsCount = m_world->GetThreadCount();
+	if ((threadsCount > 1) && (count > DG_RAYCAST_BATCH_CHUNK)) {
+		for (dgInt32 i = 0; i < threadsCount; i++) {
+			m_world->QueueJob(RayCastBatchKernel, &descriptor, m_world);
+		}
+		m_world->SynchronizationBarrier();
+	} else {
+		RayCastBatch(&descriptor, 0);
+	}
+}
+
+void dgBroadPhase::ConvexCastBatch(const dgConvexCastBatchQuery* const queries, dgFloat32* const params, dgInt32* const contactCounts, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 count, OnRayPrecastAction prefilter, void* const userData) const
+{
+	dgAssert(!maxContacts || info);
+	dgQueryBatchDescriptor descriptor(this, count, prefilter, userData);
+	descriptor.m_convexQueries = queries;
+	descriptor.m_params = params;
+	descriptor.m_contactCounts = contactCounts;
+	descriptor.m_info = maxContacts ? info : NULL;
+	descriptor.m_maxContacts = maxContacts;
+
+	const dgInt32 threadsCount = m_world->GetThreadCount();
+	if ((threadsCount > 1) && (count > DG_CONVEX_CAST_BATCH_CHUNK)) {
+		for (dgInt32 i = 0; i < threadsCount; i++) {
+			m_world->QueueJob(ConvexCastBatchKernel, &descriptor, m_world);
+		}
+		m_world->SynchronizationBarrier();
+	} else {
+		ConvexCastBatch(&descriptor, 0);
+	}
+}
+
+void dgBroadPhase::RayCastBatch(dgQueryBatchDescriptor* const descriptor, dgInt32 threadID) const
+{
+	dgRayCastBatchContext context;
+	context.m_prefilter = descriptor->m_prefilter;
+	context.m_userData = descriptor->m_userData;
+	const OnRayPrecastAction prefilter = descriptor->m_prefilter ? dgRayCastBatchPrefilter : NULL;
+
+	const dgInt32 count = descriptor->m_count;
+	const dgRayCastBatchQuery* const queries = descriptor->m_rayQueries;
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, DG_RAYCAST_BATCH_CHUNK); i < count; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, DG_RAYCAST_BATCH_CHUNK)) {
+		const dgInt32 chunkEnd = dgMin(i + DG_RAYCAST_BATCH_CHUNK, count);
+		for (dgInt32 j = i; j < chunkEnd; j++) {
+			dgRayCastBatchHit* const hit = &descriptor->m_rayHits[j];
+			memset(hit, 0, sizeof (dgRayCastBatchHit));
+			hit->m_param = dgFloat32(1.0f);
+			context.m_hit = hit;
+
+			const dgVector p0(queries[j].m_p0[0], queries[j].m_p0[1], queries[j].m_p0[2], dgFloat32(0.0f));
+			const dgVector p1(queries[j].m_p1[0], queries[j].m_p1[1], queries[j].m_p1[2], dgFloat32(0.0f));
+			RayCast(p0, p1, dgRayCastBatchFilter, prefilter, &context);
+		}
+	}
+}
+
+void dgBroadPhase::ConvexCastBatch(dgQueryBatchDescriptor* const descriptor, dgInt32 threadID) const
+{
+	const dgInt32 count = descriptor->m_count;
+	const dgInt32 maxContacts = descriptor->m_maxContacts;
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, DG_CONVEX_CAST_BATCH_CHUNK); i < count; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, DG_CONVEX_CAST_BATCH_CHUNK)) {
+		const dgInt32 chunkEnd = dgMin(i + DG_CONVEX_CAST_BATCH_CHUNK, count);
+		for (dgInt32 j = i; j < chunkEnd; j++) {
+			const dgConvexCastBatchQuery& query = descriptor->m_convexQueries[j];
+			const dgMatrix matrix(query.m_matrix);
+			const dgVector target(query.m_target[0], query.m_target[1], query.m_target[2], dgFloat32(0.0f));
+			dgConvexCastReturnInfo* const info = descriptor->m_info ? &descriptor->m_info[j * maxContacts] : NULL;
+			descriptor->m_params[j] = dgFloat32(1.0f);
+			const dgInt32 contacts = ConvexCast(query.m_shape, matrix, target, &descriptor->m_params[j], descriptor->m_prefilter, descriptor->m_userData, info, maxContacts, threadID);
+			if (descriptor->m_contactCounts) {
+				descriptor->m_contactCounts[j] = contacts;
+			}
+		}
+	}
+}
+
+void dgBroadPhase::UpdateQueryStructure()
+{
+	if (!m_queryTree.IsValid()) {
+		DG_PROFILE_UPDATE_PHASE (m_world, m_fitness);
+		m_queryTree.Update(m_rootNode);
+	}
 }
 
 void dgBroadPhase::CollisionChange (dgBody* const body, dgCollisionInstance* const collision)
@@ -699,45 +1456,49 @@ void dgBroadPhase::CollisionChange (dgBody* const body, dgCollisionInstance* con
 void dgBroadPhase::UpdateBody(dgBody* const body, dgInt32 threadIndex)
 {
 	if (m_rootNode && !m_rootNode->IsLeafNode() && body->m_masterNode) {
-		dgBroadPhaseBodyNode* const node = body->GetBroadPhase();
-		dgBody* const body1 = node->GetBody();
-		dgAssert(body1 == body);
-
-		dgAssert(!node->GetLeft());
-		dgAssert(!node->GetRight());
-		dgAssert(!body1->GetCollision()->IsType(dgCollision::dgCollisionNull_RTTI));
-
 		const dgBroadPhaseNode* const root = (m_rootNode->GetLeft() && m_rootNode->GetRight()) ? NULL : m_rootNode;
+		UpdateBodyNode(body->GetBroadPhase(), root);
+	}
+}
 
-		dgThreadHiveScopeLock lock(m_world, &m_criticalSectionLock, true);
-		if (body1->GetBroadPhaseAggregate()) {
-			dgBroadPhaseAggregate* const aggregate = body1->GetBroadPhaseAggregate();
-			aggregate->m_isInEquilibrium = body1->m_equilibrium;
-			aggregate->SetAsDirty(m_lru + 1);
-		}
-
-		m_dirtyNodesCount += (node->m_nodeIsDirtyLru != (m_lru + 1)) ? 1 : 0;
-		node->SetAsDirty(m_lru + 1);
-		if (!dgBoxInclusionTest(body1->m_minAABB, body1->m_maxAABB, node->m_minBox, node->m_maxBox)) {
-			dgAssert(!node->IsAggregate());
-			node->SetAABB(body1->m_minAABB, body1->m_maxAABB);
-			for (dgBroadPhaseNode* parent = node->m_parent; parent != root; parent = parent->m_parent) {
-				if (!parent->IsAggregate()) {
-					dgVector minBox;
-					dgVector maxBox;
-					dgFloat32 area = CalculateSurfaceArea(parent->GetLeft(), parent->GetRight(), minBox, maxBox);
-					if (dgBoxInclusionTest(minBox, maxBox, parent->m_minBox, parent->m_maxBox)) {
-						break;
-					}
-					parent->m_minBox = minBox;
-					parent->m_maxBox = maxBox;
-					parent->m_surfaceArea = area;
-				} else {
-					dgBroadPhaseAggregate* const aggregate = (dgBroadPhaseAggregate*)parent;
-					aggregate->m_minBox = aggregate->m_root->m_minBox;
-					aggregate->m_maxBox = aggregate->m_root->m_maxBox;
-					aggregate->m_surfaceArea = aggregate->m_root->m_surfaceArea;
+void dgBroadPhase::UpdateBodyNode(dgBroadPhaseBodyNode* const node, const dgBroadPhaseNode* const root)
+{
+	dgBody* const body1 = node->GetBody();
+	dgAssert(body1);
+
+	dgAssert(!node->GetLeft());
+	dgAssert(!node->GetRight());
+	dgAssert(!body1->GetCollision()->IsType(dgCollision::dgCollisionNull_RTTI));
+
+	dgThreadHiveScopeLock lock(m_world, &m_criticalSectionLock, true);
+	if (body1->GetBroadPhaseAggregate()) {
+		dgBroadPhaseAggregate* const aggregate = body1->GetBroadPhaseAggregate();
+		aggregate->m_isInEquilibrium = body1->m_equilibrium;
+		aggregate->SetAsDirty(m_lru + 1);
+	}
+
+	m_dirtyNodesCount += (node->m_nodeIsDirtyLru != (m_lru + 1)) ? 1 : 0;
+	node->SetAsDirty(m_lru + 1);
+	if (!dgBoxInclusionTest(body1->m_minAABB, body1->m_maxAABB, node->m_minBox, node->m_maxBox)) {
+		dgAssert(!node->IsAggregate());
+		node->SetAABB(body1->m_minAABB, body1->m_maxAABB);
+		m_queryTree.Invalidate(false);
+		for (dgBroadPhaseNode* parent = node->m_parent; parent != root; parent = parent->m_parent) {
+			if (!parent->IsAggregate()) {
+				dgVector minBox;
+				dgVector maxBox;
+				dgFloat32 area = CalculateSurfaceArea(parent->GetLeft(), parent->GetRight(), minBox, maxBox);
+				if (dgBoxInclusionTest(minBox, maxBox, parent->m_minBox, parent->m_maxBox)) {
+					break;
 				}
+				parent->m_minBox = minBox;
+				parent->m_maxBox = maxBox;
+				parent->m_surfaceArea = area;
+			} else {
+				dgBroadPhaseAggregate* const aggregate = (dgBroadPhaseAggregate*)parent;
+				aggregate->m_minBox = aggregate->m_root->m_minBox;
+				aggregate->m_maxBox = aggregate->m_root->m_maxBox;
+				aggregate->m_surfaceArea = aggregate->m_root->m_surfaceArea;
 			}
 		}
 	}
@@ -840,8 +1601,8 @@ void dgBroadPhase::ImproveFitness(dgFitnessList& fitness, dgFloat64& oldEntropy,
 
 		if ((entropy > oldEntropy * dgFloat32(2.0f)) || (entropy < oldEntropy * dgFloat32(0.5f))) {
 			if (fitness.GetFirst()) {
-				m_world->m_solverJacobiansMemory.ResizeIfNecessary ((fitness.GetCount() * 2 + 16) * sizeof (dgBroadPhaseNode*));
-				dgBroadPhaseNode** const leafArray = (dgBroadPhaseNode**)&m_world->m_solverJacobiansMemory[0];
+				dgFrameArena::dgBuffer<dgBroadPhaseNode*> leafBuffer (m_world->m_frameArena, 0, fitness.GetCount() * 2 + 16);
+				dgBroadPhaseNode** const leafArray = leafBuffer.GetBuffer();
 
 				dgInt32 leafNodesCount = 0;
 				for (dgFitnessList::dgListNode* nodePtr = fitness.GetFirst(); nodePtr; nodePtr = nodePtr->GetNext()) {
@@ -872,6 +1633,7 @@ void dgBroadPhase::ImproveFitness(dgFitnessList& fitness, dgFloat64& oldEntropy,
 
 				dgSortIndirect(leafArray, leafNodesCount, CompareNodes);
 				*root = BuildTopDownBig(leafArray, 0, leafNodesCount - 1, &nodePtr);
+				m_queryTree.Invalidate(true);
 				dgAssert(!(*root)->m_parent);
 				entropy = CalculateEntropy(fitness, root);
 			}
@@ -923,6 +1685,7 @@ void dgBroadPhase::RotateLeft (dgBroadPhaseTreeNode* const node, dgBroadPhaseNod
 		parent->m_minBox = cost1P0;
 		parent->m_maxBox = cost1P1;
 		parent->m_surfaceArea = cost1;
+		m_queryTree.Invalidate(true);
 
 	} else if ((cost2 <= cost0) && (cost2 <= cost1)) {
 		//dgBroadPhaseNode* const parent = node->m_parent;
@@ -951,6 +1714,7 @@ void dgBroadPhase::RotateLeft (dgBroadPhaseTreeNode* const node, dgBroadPhaseNod
 		parent->m_minBox = cost2P0;
 		parent->m_maxBox = cost2P1;
 		parent->m_surfaceArea = cost2;
+		m_queryTree.Invalidate(true);
 	}
 }
 
@@ -996,6 +1760,7 @@ void dgBroadPhase::RotateRight (dgBroadPhaseTreeNode* const node, dgBroadPhaseNo
 		parent->m_minBox = cost1P0;
 		parent->m_maxBox = cost1P1;
 		parent->m_surfaceArea = cost1;
+		m_queryTree.Invalidate(true);
 
 	} else if ((cost2 <= cost0) && (cost2 <= cost1)) {
 		//dgBroadPhaseNode* const parent = node->m_parent;
@@ -1024,6 +1789,7 @@ void dgBroadPhase::RotateRight (dgBroadPhaseTreeNode* const node, dgBroadPhaseNo
 		parent->m_minBox = cost2P0;
 		parent->m_maxBox = cost2P1;
 		parent->m_surfaceArea = cost2;
+		m_queryTree.Invalidate(true);
 	}
 }
 
@@ -1065,7 +1831,11 @@ void dgBroadPhase::CalculatePairContacts (dgPair* const pair, dgInt32 threadID)
 	pair->m_cacheIsValid = false;
 	pair->m_contactBuffer = contacts;
 	m_world->CalculateContacts(pair, threadID, false, false);
+	ProcessPairContacts (pair, threadID);
+}
 
+void dgBroadPhase::ProcessPairContacts (dgPair* const pair, dgInt32 threadID)
+{
 	if (pair->m_contactCount) {
 //		if (pair->m_contact->m_body0->m_invMass.m_w != dgFloat32 (0.0f)) {
 //			pair->m_contact->m_body0->m_equilibrium = false;
@@ -1116,10 +1886,190 @@ void dgBroadPhase::AddPair (dgContact* const contact, dgFloat32 timestep, dgInt3
 			dgAssert (!body0->m_collision->IsType (dgCollision::dgCollisionNull_RTTI));
 			dgAssert (!body1->m_collision->IsType (dgCollision::dgCollisionNull_RTTI));
 
-			pair.m_contact = contact;
+			if (IsSplitContactPair (contact)) {
+				// heavy compound pairs are split over the thread pool once all the other pairs are done
+				dgThreadHiveScopeLock lock(m_world, &m_contacJointLock, true);
+				contact->m_maxDOF = 0;
+				m_pendingSplitContacts[m_pendingSplitContactsCount] = contact;
+				m_pendingSplitContactsCount ++;
+			} else {
+				pair.m_contact = contact;
+				pair.m_timestep = timestep;
+				CalculatePairContacts (&pair, threadIndex);
+			}
+		}
+	}
+}
+
+bool dgBroadPhase::IsSplitContactPair (const dgContact* const contact) const
+{
+	// the compound that drives the narrow phase decides, same order as dgWorld::CalculateContacts
+	const dgCollisionInstance* const instance0 = contact->m_body0->m_collision;
+	const dgCollisionInstance* const instance1 = contact->m_body1->m_collision;
+	if (instance0->IsType (dgCollision::dgCollisionCompound_RTTI)) {
+		const dgCollisionCompound* const compound = (dgCollisionCompound*)instance0->GetChildShape();
+		return compound->IsSplitContactPair (instance1);
+	} else if (instance1->IsType (dgCollision::dgCollisionCompound_RTTI)) {
+		const dgCollisionCompound* const compound = (dgCollisionCompound*)instance1->GetChildShape();
+		return compound->IsSplitContactPair (instance0);
+	}
+	return false;
+}
+
+class dgSplitPairContactDescriptor
+{
+	public:
+	dgContact* m_contact;
+	const dgCollisionCompound* m_compound;
+	dgCollisionCompound::dgNodeBase* m_subTrees[DG_COMPOUND_SPLIT_CONTACT_SUBTREES];
+	dgBroadPhase::dgPair m_pairs[DG_COMPOUND_SPLIT_CONTACT_SUBTREES];
+	dgThreadHive::dgThreadJobCounter m_counter;
+	dgFloat32 m_timestep;
+	dgInt32 m_count;
+	dgInt32 m_atomicIndex;
+};
+
+void dgBroadPhase::SplitPairContactKernel(void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgSplitPairContactDescriptor* const descriptor = (dgSplitPairContactDescriptor*)context;
+	DG_PROFILE_PHASE ((dgWorld*)worldContext, m_narrowPhase, threadID);
+
+	const dgInt32 count = descriptor->m_count;
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, 1); i < count; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, 1)) {
+		dgPair* const pair = &descriptor->m_pairs[i];
+		dgContact* const shadow = pair->m_contact;
+		dgCollisionParamProxy proxy(shadow, pair->m_contactBuffer, threadID, false, false);
+		proxy.m_timestep = pair->m_timestep;
+		proxy.m_maxContacts = DG_MAX_CONTATCS;
+		proxy.m_skinThickness = shadow->m_material->m_skinThickness;
+		descriptor->m_compound->CalculateSubTreeContacts (pair, proxy, descriptor->m_subTrees[i]);
+	}
+}
+
+void dgBroadPhase::MergeSplitPairContactKernel(void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgSplitPairContactDescriptor* const descriptor = (dgSplitPairContactDescriptor*)context;
+	dgWorld* const world = (dgWorld*)worldContext;
+	DG_PROFILE_PHASE (world, m_narrowPhase, threadID);
+	dgBroadPhase* const broadPhase = world->GetBroadPhase();
+	broadPhase->MergeSplitPairContacts(descriptor, threadID);
+}
+
+void dgBroadPhase::CalculateSplitPairContacts (dgFloat32 timestep)
+{
+	const dgInt32 pairsCount = m_pendingSplitContactsCount;
+	dgFrameArena::dgBuffer<dgSplitPairContactDescriptor> descriptorBuffer (m_world->m_frameArena, 0, pairsCount);
+	dgSplitPairContactDescriptor* const descriptors = descriptorBuffer.GetBuffer();
+
+	dgInt32 subTreesCount = 0;
+	for (dgInt32 i = 0; i < pairsCount; i ++) {
+		dgContact* const contact = m_pendingSplitContacts[i];
+		if (!contact->m_body0->m_collision->IsType (dgCollision::dgCollisionCompound_RTTI)) {
+			contact->SwapBodies();
+		}
+		dgSplitPairContactDescriptor& descriptor = descriptors[i];
+		const dgCollisionCompound* const compound = (dgCollisionCompound*)contact->m_body0->m_collision->GetChildShape();
+		descriptor.m_contact = contact;
+		descriptor.m_compound = compound;
+		descriptor.m_timestep = timestep;
+		descriptor.m_count = compound->GetContactSubTrees (descriptor.m_subTrees, DG_COMPOUND_SPLIT_CONTACT_SUBTREES);
+		descriptor.m_atomicIndex = 0;
+		subTreesCount += descriptor.m_count;
+	}
+
+	// each sub tree gets its own contact buffer and a shadow joint, the low level 
+	// contact functions write the separating state to the joint in the proxy.
+	// both pools are sized before any job runs, the jobs keep pointers into them
+	m_splitContactBuffer.ResizeIfNecessary (subTreesCount * DG_MAX_CONTATCS);
+	for (; m_splitContactShadowsCount < subTreesCount; m_splitContactShadowsCount ++) {
+		m_splitContactShadows[m_splitContactShadowsCount] = new (m_world->m_allocator) dgContact (m_world, m_pendingSplitContacts[0]->m_material);
+	}
+
+	dgInt32 subTreeIndex = 0;
+	for (dgInt32 i = 0; i < pairsCount; i ++) {
+		dgSplitPairContactDescriptor& descriptor = descriptors[i];
+		const dgContact* const contact = descriptor.m_contact;
+		for (dgInt32 j = 0; j < descriptor.m_count; j ++) {
+			dgContact* const shadow = m_splitContactShadows[subTreeIndex];
+			shadow->m_body0 = contact->m_body0;
+			shadow->m_body1 = contact->m_body1;
+			shadow->m_material = contact->m_material;
+			shadow->m_separtingVector = contact->m_separtingVector;
+			shadow->m_closestDistance = contact->m_closestDistance;
+			shadow->m_separationDistance = contact->m_separationDistance;
+			shadow->m_contactPruningTolereance = contact->m_contactPruningTolereance;
+			shadow->m_isNewContact = contact->m_isNewContact;
+			shadow->m_contactActive = 0;
+
+			dgPair& pair = descriptor.m_pairs[j];
+			pair.m_contact = shadow;
+			pair.m_contactBuffer = &m_splitContactBuffer[subTreeIndex * DG_MAX_CONTATCS];
 			pair.m_timestep = timestep;
-            CalculatePairContacts (&pair, threadIndex);
+			pair.m_contactCount = 0;
+			pair.m_cacheIsValid = false;
+			pair.m_flipContacts = false;
+			subTreeIndex ++;
+		}
+	}
+
+	// one job per sub tree, the job that completes a pair queues the merge of that pair,
+	// so all the split pairs share a single synchronization barrier
+	for (dgInt32 i = 0; i < pairsCount; i ++) {
+		dgSplitPairContactDescriptor& descriptor = descriptors[i];
+		descriptor.m_counter = dgThreadHive::dgThreadJobCounter (MergeSplitPairContactKernel, &descriptor, m_world);
+		for (dgInt32 j = 0; j < descriptor.m_count; j ++) {
+			m_world->QueueJob(SplitPairContactKernel, &descriptor, m_world, &descriptor.m_counter);
+		}
+		m_world->CloseJobGroup(&descriptor.m_counter);
+	}
+	m_world->SynchronizationBarrier();
+}
+
+void dgBroadPhase::MergeSplitPairContacts (dgSplitPairContactDescriptor* const descriptor, dgInt32 threadID)
+{
+	// merge in sub tree order so the result does not depend on the thread count
+	dgContact* const contact = descriptor->m_contact;
+	dgContactPoint contacts[DG_MAX_CONTATCS];
+	dgInt32 contactCount = 0;
+	dgFloat32 closestDist = dgFloat32 (1.0e10f);
+	const dgFloat32 tolerance = contact->GetPruningTolerance();
+	for (dgInt32 i = 0; i < descriptor->m_count; i ++) {
+		const dgPair& subPair = descriptor->m_pairs[i];
+		const dgContact* const shadow = subPair.m_contact;
+		if (shadow->m_closestDistance < closestDist) {
+			closestDist = shadow->m_closestDistance;
+			contact->m_separtingVector = shadow->m_separtingVector;
+		}
+		contact->m_isNewContact = contact->m_isNewContact & shadow->m_isNewContact;
+		contact->m_contactActive = contact->m_contactActive | shadow->m_contactActive;
+
+		for (dgInt32 j = 0; j < subPair.m_contactCount; j ++) {
+			if (contactCount == DG_MAX_CONTATCS) {
+				contactCount = m_world->ReduceContacts (contactCount, contacts, DG_CONSTRAINT_MAX_ROWS / 3, tolerance);
+			}
+			contacts[contactCount] = subPair.m_contactBuffer[j];
+			contactCount ++;
 		}
+		if (contactCount > (DG_MAX_CONTATCS - 2 * (DG_CONSTRAINT_MAX_ROWS / 3))) {
+			contactCount = m_world->ReduceContacts (contactCount, contacts, DG_CONSTRAINT_MAX_ROWS / 3, tolerance);
+		}
+	}
+	if (contactCount) {
+		contactCount = m_world->PruneContacts (contactCount, contacts, tolerance);
+	}
+	contact->m_closestDistance = closestDist;
+	contact->m_separationDistance = dgFloat32 (0.0f);
+
+	dgPair pair;
+	pair.m_contact = contact;
+	pair.m_contactBuffer = contacts;
+	pair.m_timestep = descriptor->m_timestep;
+	pair.m_contactCount = contactCount;
+	pair.m_cacheIsValid = false;
+	pair.m_flipContacts = false;
+	ProcessPairContacts (&pair, threadID);
+	if (contact->m_maxDOF) {
+		contact->m_timeOfImpact = dgFloat32(1.0e10f);
 	}
 }
 
@@ -1136,16 +2086,9 @@ void dgBroadPhase::AddPair (dgBody* const body0, dgBody* const body1, const dgFl
 			const bool isCollidable = bilateral ? bilateral->IsCollidable() : true;
 
 			if (isCollidable) {
-				dgUnsigned32 group0_ID = dgUnsigned32 (body0->m_bodyGroupId);
-				dgUnsigned32 group1_ID = dgUnsigned32 (body1->m_bodyGroupId);
-				if (group1_ID < group0_ID) {
-					dgSwap (group0_ID, group1_ID);
-				}
-
-				dgUnsigned32 key = (group1_ID << 16) + group0_ID;
 				const dgBodyMaterialList* const materialList = m_world;  
-				dgAssert (materialList->Find (key));
-				const dgContactMaterial* const material = &materialList->Find (key)->GetInfo();
+				const dgContactMaterial* const material = materialList->FindMaterial (dgUnsigned32 (body0->m_bodyGroupId), dgUnsigned32 (body1->m_bodyGroupId));
+				dgAssert (material);
 
 				if (material->m_flags & dgContactMaterial::m_collisionEnable) {
 					const dgInt32 kinematicBodyEquilibrium = (((body0->IsRTTIType(dgBody::m_kinematicBodyRTTI) ? true : false) & body0->IsCollidable()) | ((body1->IsRTTIType(dgBody::m_kinematicBodyRTTI) ? true : false) & body1->IsCollidable())) ? 0 : 1;
@@ -1297,7 +2240,7 @@ void dgBroadPhase::ImproveNodeFitness(dgBroadPhaseTreeNode* const node, dgBroadP
 			RotateLeft(node, root);
 		}
 	}
-	dgAssert(!m_rootNode->m_parent);
+	dgAssert(!m_rootNode || !m_rootNode->m_parent);
 }
 
 dgFloat64 dgBroadPhase::CalculateEntropy (dgFitnessList& fitness, dgBroadPhaseNode** const root)
@@ -1327,9 +2270,12 @@ void dgBroadPhase::KinematicBodyActivation (dgContact* const contatJoint) const
 					dgVector relOmega (body0->m_omega - body1->m_omega);
 					dgVector mask2 ((relVeloc.DotProduct4(relVeloc) < dgDynamicBody::m_equilibriumError2) & (relOmega.DotProduct4(relOmega) < dgDynamicBody::m_equilibriumError2));
 
-					dgThreadHiveScopeLock lock (m_world, &body1->m_criticalSectionLock, false);
-					body1->m_sleeping = false;
-					body1->m_equilibrium = mask2.GetSignMask() ? true : false;
+					{
+						dgThreadHiveScopeLock lock (m_world, &body1->m_criticalSectionLock, false);
+						body1->m_sleeping = false;
+						body1->m_equilibrium = mask2.GetSignMask() ? true : false;
+					}
+					body1->Activate();
 				}
 			}
 		} else if (body1->IsRTTIType(dgBody::m_kinematicBodyRTTI)) {
@@ -1339,9 +2285,12 @@ void dgBroadPhase::KinematicBodyActivation (dgContact* const contatJoint) const
 					dgVector relOmega (body0->m_omega - body1->m_omega);
 					dgVector mask2 ((relVeloc.DotProduct4(relVeloc) < dgDynamicBody::m_equilibriumError2) & (relOmega.DotProduct4(relOmega) < dgDynamicBody::m_equilibriumError2));
 
-					dgThreadHiveScopeLock lock (m_world, &body0->m_criticalSectionLock, false);
-					body0->m_sleeping = false;
-					body0->m_equilibrium = mask2.GetSignMask() ? true : false;
+					{
+						dgThreadHiveScopeLock lock (m_world, &body0->m_criticalSectionLock, false);
+						body0->m_sleeping = false;
+						body0->m_equilibrium = mask2.GetSignMask() ? true : false;
+					}
+					body0->Activate();
 				}
 			}
 		}
@@ -1353,6 +2302,7 @@ void dgBroadPhase::CollidingPairsKernel(void* const context, void* const node, d
 {
 	dgBroadphaseSyncDescriptor* const descriptor = (dgBroadphaseSyncDescriptor*)context;
 	dgWorld* const world = descriptor->m_world;
+	DG_PROFILE_PHASE (world, m_pairScan, threadID);
 	dgBroadPhase* const broadPhase = world->GetBroadPhase();
 	if (broadPhase->m_scanTwoWays) {
 		broadPhase->FindCollidingPairsForwardAndBackward(descriptor, (dgList<dgBroadPhaseNode*>::dgListNode*) node, threadID);
@@ -1373,8 +2323,11 @@ void dgBroadPhase::AddGeneratedBodiesContactsKernel (void* const context, void*
 
 void dgBroadPhase::ScanForContactJoints(dgBroadphaseSyncDescriptor& syncPoints)
 {
+	DG_PROFILE_UPDATE_PHASE (m_world, m_pairScan);
+	DG_PROFILE_UPDATE_ITEMS (m_world, m_pairScan, m_updateList.GetCount());
 	dgInt32 threadsCount = m_world->GetThreadCount();
 	dgList<dgBroadPhaseNode*>::dgListNode* node = m_updateList.GetFirst();
+	syncPoints.m_atomicIndex = 0;
 	for (dgInt32 i = 0; i < threadsCount; i++) {
 		m_world->QueueJob(CollidingPairsKernel, &syncPoints, node);
 		node = node ? node->GetNext() : NULL;
@@ -1420,16 +2373,18 @@ void dgBroadPhase::UpdateSoftBodyContactKernel(void* const context, void* const
 {
 	dgBroadphaseSyncDescriptor* const descriptor = (dgBroadphaseSyncDescriptor*)context;
 	dgWorld* const world = descriptor->m_world;
+	DG_PROFILE_PHASE (world, m_narrowPhase, threadID);
 	dgBroadPhase* const broadPhase = world->GetBroadPhase();
 	broadPhase->UpdateSoftBodyContacts(descriptor, descriptor->m_timestep, threadID);
 }
 
-void dgBroadPhase::UpdateRigidBodyContactKernel(void* const context, void* const node, dgInt32 threadID)
+void dgBroadPhase::UpdateRigidBodyContactKernel(void* const context, void* const worldContext, dgInt32 threadID)
 {
 	dgBroadphaseSyncDescriptor* const descriptor = (dgBroadphaseSyncDescriptor*)context;
 	dgWorld* const world = descriptor->m_world;
+	DG_PROFILE_PHASE (world, m_narrowPhase, threadID);
 	dgBroadPhase* const broadPhase = world->GetBroadPhase();
-	broadPhase->UpdateRigidBodyContacts(descriptor, (dgActiveContacts::dgListNode*) node, descriptor->m_timestep, threadID);
+	broadPhase->UpdateRigidBodyContacts(descriptor, descriptor->m_timestep, threadID);
 }
 
 void dgBroadPhase::UpdateSoftBodyContacts(dgBroadphaseSyncDescriptor* const descriptor, dgFloat32 timeStep, dgInt32 threadID)
@@ -1451,17 +2406,45 @@ void dgBroadPhase::UpdateSoftBodyContacts(dgBroadphaseSyncDescriptor* const desc
 	}
 }
 
-void dgBroadPhase::UpdateRigidBodyContacts(dgBroadphaseSyncDescriptor* const descriptor, dgActiveContacts::dgListNode* const nodePtr, dgFloat32 timeStep, dgInt32 threadID)
+void dgBroadPhase::BuildActiveContactArray ()
 {
-	dgActiveContacts::dgListNode* node = nodePtr;
-	const dgFloat32 timestep = descriptor->m_timestep;
-	const dgInt32 threadCount = descriptor->m_world->GetThreadCount();
-	while (node) {
-		dgContact* const contact = node->GetInfo();
+	// contacts between two bodies in equilibrium do not need update, a body out of equilibrium is always 
+	// in the active set, so only the contacts rows of the active bodies are visited
+	dgInt32 count = 0;
+	const dgInt32 bodyCount = m_sortedActiveBodiesCount;
+	dgBody** const bodyArray = &m_activeBodies[0];
+	for (dgInt32 i = 0; i < bodyCount; i ++) {
+		const dgBody* const body = bodyArray[i];
+		const dgBodyMasterListRow& row = body->m_masterNode->GetInfo();
+		for (dgBodyMasterListRow::dgListNode* node = row.GetFirst(); node && (node->GetInfo().m_joint->GetId() == dgConstraint::m_contactConstraint); node = node->GetNext()) {
+			dgContact* const contact = (dgContact*) node->GetInfo().m_joint;
+			const dgBody* const body0 = contact->GetBody0();
+			const dgBody* const body1 = contact->GetBody1();
+			if (!(body0->m_equilibrium & body1->m_equilibrium)) {
+				// a contact between two active bodies is seen twice, it is added by its first body
+				const dgBody* const otherBody = node->GetInfo().m_bodyNode;
+				if ((otherBody->m_activeIndex < 0) || (body == body0)) {
+					m_activeContacts[count] = contact;
+					count ++;
+				}
+			}
+		}
+	}
+	m_activeContactsCount = count;
+}
 
-		const dgBody* const body0 = contact->GetBody0();
-		const dgBody* const body1 = contact->GetBody1();
-		if (!(body0->m_equilibrium & body1->m_equilibrium)) {
+
+void dgBroadPhase::UpdateRigidBodyContacts(dgBroadphaseSyncDescriptor* const descriptor, dgFloat32 timeStep, dgInt32 threadID)
+{
+	const dgFloat32 timestep = descriptor->m_timestep;
+	const dgInt32 count = m_activeContactsCount;
+	dgContact** const contactArray = &m_activeContacts[0];
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, DG_BROADPHASE_CONTACT_CHUNK); i < count; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, DG_BROADPHASE_CONTACT_CHUNK)) {
+		const dgInt32 chunkEnd = dgMin (i + DG_BROADPHASE_CONTACT_CHUNK, count);
+		for (dgInt32 j = i; j < chunkEnd; j ++) {
+			dgContact* const contact = contactArray[j];
+			const dgBody* const body0 = contact->GetBody0();
+			const dgBody* const body1 = contact->GetBody1();
 			if (ValidateContactCache(contact, timestep)) {
 				contact->m_timeOfImpact = dgFloat32(1.0e10f);
 			} else {
@@ -1495,10 +2478,6 @@ void dgBroadPhase::UpdateRigidBodyContacts(dgBroadphaseSyncDescriptor* const des
 				}
 			}
 		}
-
-		for (dgInt32 i = 0; i < threadCount; i++) {
-			node = node ? node->GetNext() : NULL;
-		}
 	}
 }
 
@@ -1510,41 +2489,54 @@ void dgBroadPhase::UpdateContacts(dgFloat32 timestep)
     m_lru = m_lru + 1;
 	m_dirtyNodesCount = 0;
 	m_pendingSoftBodyPairsCount = 0;
+	m_pendingSplitContactsCount = 0;
 
 	m_recursiveChunks = true;
 	const dgInt32 threadsCount = m_world->GetThreadCount();
 
-	const dgBodyMasterList* const masterList = m_world;
 	dgBroadphaseSyncDescriptor syncPoints(timestep, m_world);
 
-	dgBodyMasterList::dgListNode* node = masterList->GetLast();
-	for (dgInt32 i = 0; i < threadsCount; i++) {
-		m_world->QueueJob(ForceAndToqueKernel, &syncPoints, node);
-		node = node ? node->GetPrev() : NULL;
-	}
-	m_world->SynchronizationBarrier();
+	BuildActiveBodyArray();
 
-	// update pre-listeners after the force and true are applied
-	if (m_world->m_listeners.GetCount()) {
+	{
+		// the update track times the chained phases under the force callbacks
+		DG_PROFILE_UPDATE_PHASE (m_world, m_forceCallbacks);
+		DG_PROFILE_UPDATE_ITEMS (m_world, m_forceCallbacks, m_activeBodiesCount);
+		DG_PROFILE_UPDATE_ITEMS (m_world, m_aggregateEntropy, m_aggregateList.GetCount());
+
+		// pre update listeners are user code that runs on this thread after the force callbacks,
+		// without them the forces join the sleeping state and aggregate entropy phases in a single job
+		bool hasPreUpdateListeners = false;
 		for (dgWorld::dgListenerList::dgListNode* node1 = m_world->m_listeners.GetFirst(); node1; node1 = node1->GetNext()) {
-			dgWorld::dgListener& listener = node1->GetInfo();
-			if (listener.m_onPreUpdate) {
-				listener.m_onPreUpdate(m_world, listener.m_userData, timestep);
+			hasPreUpdateListeners = hasPreUpdateListeners || (node1->GetInfo().m_onPreUpdate != NULL);
+		}
+
+		if (hasPreUpdateListeners) {
+			syncPoints.m_atomicIndex = 0;
+			for (dgInt32 i = 0; i < threadsCount; i++) {
+				m_world->QueueJob(ForceAndToqueKernel, &syncPoints, m_world);
+			}
+			m_world->SynchronizationBarrier();
+
+			// update pre-listeners after the force and true are applied
+			for (dgWorld::dgListenerList::dgListNode* node1 = m_world->m_listeners.GetFirst(); node1; node1 = node1->GetNext()) {
+				dgWorld::dgListener& listener = node1->GetInfo();
+				if (listener.m_onPreUpdate) {
+					listener.m_onPreUpdate(m_world, listener.m_userData, timestep);
+				}
 			}
 		}
-	}
 
-	node = masterList->GetLast();
-	for (dgInt32 i = 0; i < threadsCount; i++) {
-		m_world->QueueJob(SleepingStateKernel, &syncPoints, node);
-		node = node ? node->GetPrev() : NULL;
+		syncPoints.m_applyForces = !hasPreUpdateListeners;
+		m_world->QueueJob(UpdateBodyPhasesKernel, &syncPoints, m_world);
+		m_world->SynchronizationBarrier();
 	}
-	m_world->SynchronizationBarrier();
 
 
 #if 0
 	static dgInt32 xxx;
 	xxx ++;
+	const dgBodyMasterList* const masterList = m_world;
 	for (dgBodyMasterList::dgListNode* node = masterList->GetLast(); node; node = node->GetPrev()) {
 		dgDynamicBody* const body = (dgDynamicBody*)node->GetInfo().GetBody();
 		if ((body->GetType() == dgBody::m_dynamicBody) && (body->GetInvMass().m_w > dgFloat32 (0.0f))) {
@@ -1582,30 +2574,36 @@ void dgBroadPhase::UpdateContacts(dgFloat32 timestep)
 #endif
 
 
-	dgList<dgBroadPhaseAggregate*>::dgListNode* aggregateNode = m_aggregateList.GetFirst();
-	for (dgInt32 i = 0; i < threadsCount; i++) {
-		m_world->QueueJob (UpdateAggregateEntropyKernel, &syncPoints, aggregateNode);
-		aggregateNode = aggregateNode ? aggregateNode->GetNext() : NULL;
+	{
+		DG_PROFILE_UPDATE_PHASE (m_world, m_fitness);
+		UpdateFitness();
 	}
-	m_world->SynchronizationBarrier();
-	UpdateFitness();
 
 	m_scanTwoWays = (lastDirtyCount * 100) < (40 * m_updateList.GetCount());
 	ScanForContactJoints (syncPoints);
 
-	dgActiveContacts* const contactList = m_world;
-	dgActiveContacts::dgListNode* contactListNode = contactList->GetFirst();
-	for (dgInt32 i = 0; i < threadsCount; i++) {
-		m_world->QueueJob(UpdateRigidBodyContactKernel, &syncPoints, contactListNode);
-		contactListNode = contactListNode ? contactListNode->GetNext() : NULL;
-	}
-	m_world->SynchronizationBarrier();
+	SortActiveBodies();
+	BuildActiveContactArray();
 
-	if (m_pendingSoftBodyPairsCount) {
+	{
+		DG_PROFILE_UPDATE_PHASE (m_world, m_narrowPhase);
+		DG_PROFILE_UPDATE_ITEMS (m_world, m_narrowPhase, m_activeContactsCount);
+		syncPoints.m_atomicIndex = 0;
 		for (dgInt32 i = 0; i < threadsCount; i++) {
-			m_world->QueueJob(UpdateSoftBodyContactKernel, &syncPoints, contactListNode);
+			m_world->QueueJob(UpdateRigidBodyContactKernel, &syncPoints, m_world);
 		}
 		m_world->SynchronizationBarrier();
+
+		if (m_pendingSplitContactsCount) {
+			CalculateSplitPairContacts (timestep);
+		}
+
+		if (m_pendingSoftBodyPairsCount) {
+			for (dgInt32 i = 0; i < threadsCount; i++) {
+				m_world->QueueJob(UpdateSoftBodyContactKernel, &syncPoints, m_world);
+			}
+			m_world->SynchronizationBarrier();
+		}
 	}
 
 
@@ -32,11 +32,21 @@ class dgContact;
 class dgCollision;
 class dgDynamicBody;
 class dgCollisionInstance;
+class dgWorldStateStream;
+class dgWorldStatePointerSet;
+class dgSplitPairContactDescriptor;
 class dgBroadPhaseAggregate;
 
 
 #define DG_CACHE_DIST_TOL				dgFloat32 (1.0e-3f)
 #define DG_BROADPHASE_MAX_STACK_DEPTH	256
+#define DG_BROADPHASE_BODY_CHUNK		16
+#define DG_BROADPHASE_CONTACT_CHUNK		4
+#define DG_CONVEX_CAST_POOLSIZE			32
+#define DG_RAYCAST_BATCH_CHUNK			16
+#define DG_CONVEX_CAST_BATCH_CHUNK		4
+
+#include "dgBroadPhaseQueryTree.h"
 
 class dgConvexCastReturnInfo
 {
@@ -50,6 +60,31 @@ class dgConvexCastReturnInfo
 	dgFloat32 m_penetration;                // contact penetration at collision point
 };
 
+class dgRayCastBatchQuery
+{
+	public:
+	dgFloat32 m_p0[4];						// ray origin in global space
+	dgFloat32 m_p1[4];						// ray end in global space
+};
+
+class dgRayCastBatchHit
+{
+	public:
+	dgFloat32 m_point[4];					// closest hit point in global space
+	dgFloat32 m_normal[4];					// surface normal at the hit point in global space
+	dgInt64 m_contactID;					// collision ID at the hit point
+	const dgBody* m_hitBody;				// NULL when the ray did not hit anything
+	dgFloat32 m_param;						// intersection parameter along the ray, one when the ray did not hit anything
+};
+
+class dgConvexCastBatchQuery
+{
+	public:
+	dgFloat32 m_matrix[16];					// start matrix of the shape in global space
+	dgFloat32 m_target[4];					// end position of the shape in global space
+	dgCollisionInstance* m_shape;
+};
+
 
 DG_MSC_VECTOR_ALIGMENT
 class dgBroadPhaseNode
@@ -242,6 +277,8 @@ class dgBroadPhase
 			,m_newBodiesNodes(NULL)
 			,m_timestep(timestep)
 			,m_pairsAtomicCounter(0)
+			,m_atomicIndex(0)
+			,m_applyForces(true)
 		{
 		}
 
@@ -249,6 +286,8 @@ class dgBroadPhase
 		dgList<dgBody*>::dgListNode* m_newBodiesNodes;
 		dgFloat32 m_timestep;
 		dgInt32 m_pairsAtomicCounter;
+		dgInt32 m_atomicIndex;
+		bool m_applyForces;
 	};
 	
 	class dgFitnessList: public dgList <dgBroadPhaseTreeNode*>
@@ -328,7 +367,11 @@ class dgBroadPhase
 
 	void ScanForContactJoints(dgBroadphaseSyncDescriptor& syncPoints);
 
-	void UpdateBody(dgBody* const body, dgInt32 threadIndex);
+	virtual void UpdateBody(dgBody* const body, dgInt32 threadIndex);
+
+	// called once the bodies are integrated, before the post update listeners
+	virtual void UpdateQueryStructure();
+
 	void AddInternallyGeneratedBody(dgBody* const body)
 	{
 		m_generatedBodies.Append(body);
@@ -339,11 +382,56 @@ class dgBroadPhase
 
 	void MoveNodes (dgBroadPhase* const dest);
 
+	// run a batch of independent queries distributed over the worker threads, can not be called from inside the world update
+	void RayCastBatch (const dgRayCastBatchQuery* const queries, dgRayCastBatchHit* const hits, dgInt32 count, OnRayPrecastAction prefilter, void* const userData) const;
+	void ConvexCastBatch (const dgConvexCastBatchQuery* const queries, dgFloat32* const params, dgInt32* const contactCounts, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 count, OnRayPrecastAction prefilter, void* const userData) const;
+
+	// copy of the mutable state of the nodes, the aggregates and the active set. nodes are saved by address,
+	// so the state can only be restored while the same bodies and aggregates are in the broad phase
+	dgInt32 GetStateNodeCount() const;
+	virtual void SaveState (dgWorldStateStream& stream) const;
+	virtual bool ValidateState (dgWorldStateStream& stream, const dgWorldStatePointerSet& bodies) const;
+	virtual void RestoreState (dgWorldStateStream& stream);
+
 	protected:
+	class dgQueryBatchDescriptor
+	{
+		public:
+		dgQueryBatchDescriptor(const dgBroadPhase* const broadPhase, dgInt32 count, OnRayPrecastAction prefilter, void* const userData)
+			:m_broadPhase(broadPhase)
+			,m_rayQueries(NULL)
+			,m_rayHits(NULL)
+			,m_convexQueries(NULL)
+			,m_params(NULL)
+			,m_contactCounts(NULL)
+			,m_info(NULL)
+			,m_prefilter(prefilter)
+			,m_userData(userData)
+			,m_maxContacts(0)
+			,m_count(count)
+			,m_atomicIndex(0)
+		{
+		}
+
+		const dgBroadPhase* m_broadPhase;
+		const dgRayCastBatchQuery* m_rayQueries;
+		dgRayCastBatchHit* m_rayHits;
+		const dgConvexCastBatchQuery* m_convexQueries;
+		dgFloat32* m_params;
+		dgInt32* m_contactCounts;
+		dgConvexCastReturnInfo* m_info;
+		OnRayPrecastAction m_prefilter;
+		void* m_userData;
+		dgInt32 m_maxContacts;
+		dgInt32 m_count;
+		dgInt32 m_atomicIndex;
+	};
+
 	virtual void LinkAggregate (dgBroadPhaseAggregate* const aggregate) = 0; 
 	virtual void UnlinkAggregate (dgBroadPhaseAggregate* const aggregate) = 0; 
 
-	bool DoNeedUpdate(dgBodyMasterList::dgListNode* const node) const;
+	bool DoNeedUpdate(const dgBody* const body) const;
+	void UpdateBodyNode(dgBroadPhaseBodyNode* const node, const dgBroadPhaseNode* const root);
 	dgFloat64 CalculateEntropy (dgFitnessList& fitness, dgBroadPhaseNode** const root);
 	dgBroadPhaseTreeNode* InsertNode (dgBroadPhaseNode* const root, dgBroadPhaseNode* const node);
 
@@ -353,12 +441,16 @@ class dgBroadPhase
 	void ImproveFitness(dgFitnessList& fitness, dgFloat64& oldEntropy, dgBroadPhaseNode** const root);
 
 	void CalculatePairContacts (dgPair* const pair, dgInt32 threadID);
+	void ProcessPairContacts (dgPair* const pair, dgInt32 threadID);
+	bool IsSplitContactPair (const dgContact* const contact) const;
+	void CalculateSplitPairContacts (dgFloat32 timestep);
+	void MergeSplitPairContacts (dgSplitPairContactDescriptor* const descriptor, dgInt32 threadID);
 	bool ValidateContactCache(dgContact* const contact, dgFloat32 timestep) const;
     void AddPair (dgContact* const contact, dgFloat32 timestep, dgInt32 threadIndex);
 	void AddPair (dgBody* const body0, dgBody* const body1, dgFloat32 timestep, dgInt32 threadID);	
 
 	void ForEachBodyInAABB (const dgBroadPhaseNode** stackPool, dgInt32 stack, const dgVector& minBox, const dgVector& maxBox, OnBodiesInAABB callback, void* const userData) const;
-	void RayCast (const dgBroadPhaseNode** stackPool, dgFloat32* const distance, dgInt32 stack, const dgVector& l0, const dgVector& l1, dgFastRayTest& ray, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData) const;
+	dgFloat32 RayCast (const dgBroadPhaseNode** stackPool, dgFloat32* const distance, dgInt32 stack, const dgVector& l0, const dgVector& l1, dgFastRayTest& ray, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData, dgFloat32 maxParam) const;
 
 	dgInt32 ConvexCast (const dgBroadPhaseNode** stackPool, dgFloat32* const distance, dgInt32 stack, const dgVector& velocA, const dgVector& velocB, dgFastRayTest& ray,  
 						dgCollisionInstance* const shape, const dgMatrix& matrix, const dgVector& target, dgFloat32* const param, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const;
@@ -366,29 +458,61 @@ class dgBroadPhase
 	dgInt32 Collide(const dgBroadPhaseNode** stackPool, dgInt32* const overlap, dgInt32 stack, const dgVector& p0, const dgVector& p1, 
 		            dgCollisionInstance* const shape, const dgMatrix& matrix, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const;
 
-	void SleepingState (dgBroadphaseSyncDescriptor* const descriptor, dgBodyMasterList::dgListNode* node, dgInt32 threadID);
-	void ApplyForceAndtorque (dgBroadphaseSyncDescriptor* const descriptor, dgBodyMasterList::dgListNode* node, dgInt32 threadID);
+	dgInt32 ConvexCastBody (dgBody* const body, dgCollisionInstance* const shape, const dgMatrix& matrix, const dgVector& velocA, const dgVector& velocB, dgFloat32& timeToImpact, dgFloat32& maxParam,
+							OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 totalCount, dgInt32 maxContacts, dgInt32 threadIndex) const;
+	dgInt32 CollideBody (dgBody* const body, dgCollisionInstance* const shape, const dgMatrix& matrix, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const;
+
+	// the same queries over the query tree, only valid while m_queryTree.IsValid()
+	void ForEachBodyInQueryTree (const dgVector& minBox, const dgVector& maxBox, OnBodiesInAABB callback, void* const userData) const;
+	void RayCastQueryTree (const dgVector& l0, const dgVector& l1, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData) const;
+	dgInt32 ConvexCastQueryTree (dgCollisionInstance* const shape, const dgMatrix& matrix, const dgVector& target, dgFloat32* const param, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const;
+	dgInt32 CollideQueryTree (dgCollisionInstance* const shape, const dgMatrix& matrix, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const;
+
+	void RayCastBatch (dgQueryBatchDescriptor* const descriptor, dgInt32 threadID) const;
+	void ConvexCastBatch (dgQueryBatchDescriptor* const descriptor, dgInt32 threadID) const;
+
+	void SleepingState (dgBroadphaseSyncDescriptor* const descriptor, dgInt32 threadID);
+	void ApplyForceAndtorque (dgBroadphaseSyncDescriptor* const descriptor, dgInt32 threadID);
 	
 	void UpdateAggregateEntropy (dgBroadphaseSyncDescriptor* const descriptor, dgList<dgBroadPhaseAggregate*>::dgListNode* node, dgInt32 threadID);
+	void UpdateBodyPhases (dgBroadphaseSyncDescriptor* const descriptor, dgInt32 threadID);
+	void RunBodyPhase (dgBroadphaseSyncDescriptor* const descriptor, dgWorkerThreadTaskCallback kernel, dgInt32 threadID);
 
 	dgBroadPhaseNode* BuildTopDown(dgBroadPhaseNode** const leafArray, dgInt32 firstBox, dgInt32 lastBox, dgFitnessList::dgListNode** const nextNode);
 	dgBroadPhaseNode* BuildTopDownBig(dgBroadPhaseNode** const leafArray, dgInt32 firstBox, dgInt32 lastBox, dgFitnessList::dgListNode** const nextNode);
 
+	dgInt32 SaveStateNodes (dgWorldStateStream* const stream, dgWorldStatePointerSet* const nodes) const;
+	dgInt32 SaveStateNodes (dgBroadPhaseNode* const root, dgWorldStateStream* const stream, dgWorldStatePointerSet* const nodes) const;
+	void SaveFitnessState (dgWorldStateStream& stream, const dgList<dgBroadPhaseTreeNode*>& fitness) const;
+	bool ValidateFitnessState (dgWorldStateStream& stream, const dgList<dgBroadPhaseTreeNode*>& fitness) const;
+	void RestoreFitnessState (dgWorldStateStream& stream, dgList<dgBroadPhaseTreeNode*>& fitness);
+
 	void KinematicBodyActivation (dgContact* const contatJoint) const;
 	
 	void FindGeneratedBodiesCollidingPairs (dgBroadphaseSyncDescriptor* const descriptor, dgInt32 threadID);
 	void UpdateSoftBodyContacts(dgBroadphaseSyncDescriptor* const descriptor, dgFloat32 timeStep, dgInt32 threadID);
-	void UpdateRigidBodyContacts (dgBroadphaseSyncDescriptor* const descriptor, dgActiveContacts::dgListNode* const node, dgFloat32 timeStep, dgInt32 threadID);
+	void UpdateRigidBodyContacts (dgBroadphaseSyncDescriptor* const descriptor, dgFloat32 timeStep, dgInt32 threadID);
+	void ActivateBody (dgBody* const body);
+	void DeactivateBody (dgBody* const body);
+	void SortActiveBodies ();
+	void BuildActiveBodyArray ();
+	void BuildActiveContactArray ();
 	void SubmitPairs (dgBroadPhaseNode* const body, dgBroadPhaseNode* const node, dgFloat32 timestep, dgInt32 threaCount, dgInt32 threadID);
 		
 	static void SleepingStateKernel(void* const descriptor, void* const worldContext, dgInt32 threadID);
 	static void ForceAndToqueKernel(void* const descriptor, void* const worldContext, dgInt32 threadID);
 	static void CollidingPairsKernel(void* const descriptor, void* const worldContext, dgInt32 threadID);
 	static void UpdateAggregateEntropyKernel(void* const descriptor, void* const worldContext, dgInt32 threadID);
+	static void UpdateBodyPhasesKernel(void* const descriptor, void* const worldContext, dgInt32 threadID);
 	static void AddGeneratedBodiesContactsKernel(void* const descriptor, void* const worldContext, dgInt32 threadID);
 	static void UpdateRigidBodyContactKernel(void* const descriptor, void* const worldContext, dgInt32 threadID);
 	static void UpdateSoftBodyContactKernel(void* const descriptor, void* const worldContext, dgInt32 threadID);
+	static void SplitPairContactKernel(void* const descriptor, void* const worldContext, dgInt32 threadID);
+	static void MergeSplitPairContactKernel(void* const descriptor, void* const worldContext, dgInt32 threadID);
+	static void RayCastBatchKernel(void* const descriptor, void* const worldContext, dgInt32 threadID);
+	static void ConvexCastBatchKernel(void* const descriptor, void* const worldContext, dgInt32 threadID);
 	static dgInt32 CompareNodes(const dgBroadPhaseNode* const nodeA, const dgBroadPhaseNode* const nodeB, void* const notUsed);
+	static dgInt32 CompareActiveBodies(dgBody* const* const bodyA, dgBody* const* const bodyB, void* const notUsed);
 
 	class dgPendingCollisionSofBodies
 	{
@@ -405,8 +529,20 @@ class dgBroadPhase
 	dgUnsigned32 m_lru;
 	dgThread::dgCriticalSection m_contacJointLock;
 	dgThread::dgCriticalSection m_criticalSectionLock;
+	dgThread::dgCriticalSection m_activeBodiesLock;
 	dgArray<dgPendingCollisionSofBodies> m_pendingSoftBodyCollisions;
+	dgArray<dgBody*> m_activeBodies;
+	dgArray<dgContact*> m_activeContacts;
+	dgArray<dgContact*> m_pendingSplitContacts;
+	dgArray<dgContact*> m_splitContactShadows;
+	dgArray<dgContactPoint> m_splitContactBuffer;
+	dgBroadPhaseQueryTree m_queryTree;
 	dgInt32 m_pendingSoftBodyPairsCount;
+	dgInt32 m_pendingSplitContactsCount;
+	dgInt32 m_splitContactShadowsCount;
+	dgInt32 m_activeBodiesCount;
+	dgInt32 m_sortedActiveBodiesCount;
+	dgInt32 m_activeContactsCount;
 	dgInt32 m_dirtyNodesCount;
 	bool m_scanTwoWays;
 	bool m_recursiveChunks;
@@ -423,6 +559,7 @@ class dgBroadPhase
 
 	friend class dgBody;
 	friend class dgWorld;
+	friend class dgBodyMasterList;
 	friend class dgWorldDynamicUpdate;
 	friend class dgBroadPhaseAggregate;
 	friend class dgCollisionCompoundFractured;
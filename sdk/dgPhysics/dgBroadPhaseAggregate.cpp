@@ -87,6 +87,7 @@ void dgBroadPhaseAggregate::AddBody(dgBody* const body)
 	if (!m_root) {
 		m_root = newNode;
 		newNode->m_parent = this;
+		m_broadPhase->m_queryTree.Invalidate(true);
 	} else {
 		dgBroadPhaseTreeNode* const tmp = m_broadPhase->InsertNode(m_root, newNode);
 		dgList<dgBroadPhaseTreeNode*>::dgListNode* const link = m_fitnessList.Append(tmp);
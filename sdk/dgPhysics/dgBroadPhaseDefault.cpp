@@ -63,9 +63,35 @@ void dgBroadPhaseDefault::InvalidateCache()
 	ImproveFitness(m_fitness, m_treeEntropy, &m_rootNode);
 }
 
+void dgBroadPhaseDefault::SaveState (dgWorldStateStream& stream) const
+{
+	dgBroadPhase::SaveState (stream);
+	stream.Write (m_treeEntropy);
+	SaveFitnessState (stream, m_fitness);
+}
+
+bool dgBroadPhaseDefault::ValidateState (dgWorldStateStream& stream, const dgWorldStatePointerSet& bodies) const
+{
+	dgFloat64 treeEntropy;
+	if (!dgBroadPhase::ValidateState (stream, bodies)) {
+		return false;
+	}
+	stream.Read (treeEntropy);
+	return ValidateFitnessState (stream, m_fitness);
+}
+
+void dgBroadPhaseDefault::RestoreState (dgWorldStateStream& stream)
+{
+	dgBroadPhase::RestoreState (stream);
+	stream.Read (m_treeEntropy);
+	RestoreFitnessState (stream, m_fitness);
+}
+
 void dgBroadPhaseDefault::ForEachBodyInAABB(const dgVector& minBox, const dgVector& maxBox, OnBodiesInAABB callback, void* const userData) const
 {
-	if (m_rootNode) {
+	if (m_queryTree.IsValid()) {
+		ForEachBodyInQueryTree(minBox, maxBox, callback, userData);
+	} else if (m_rootNode) {
 		const dgBroadPhaseNode* stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];
 		stackPool[0] = m_rootNode;
 		dgBroadPhase::ForEachBodyInAABB(stackPool, 1, minBox, maxBox, callback, userData);
@@ -79,6 +105,10 @@ void dgBroadPhaseDefault::RayCast(const dgVector& l0, const dgVector& l1, OnRayC
 		dgVector segment(l1 - l0);
 		dgFloat32 dist2 = segment.DotProduct3(segment);
 		if (dist2 > dgFloat32(1.0e-8f)) {
+			if (m_queryTree.IsValid()) {
+				RayCastQueryTree(l0, l1, filter, prefilter, userData);
+				return;
+			}
 
 			dgFloat32 distance[DG_BROADPHASE_MAX_STACK_DEPTH];
 			const dgBroadPhaseNode* stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];
@@ -87,7 +117,7 @@ void dgBroadPhaseDefault::RayCast(const dgVector& l0, const dgVector& l1, OnRayC
 
 			stackPool[0] = m_rootNode;
 			distance[0] = ray.BoxIntersect(m_rootNode->m_minBox, m_rootNode->m_maxBox);
-			dgBroadPhase::RayCast(stackPool, distance, 1, l0, l1, ray, filter, prefilter, userData);
+			dgBroadPhase::RayCast(stackPool, distance, 1, l0, l1, ray, filter, prefilter, userData, dgFloat32 (1.2f));
 		}
 	}
 }
@@ -96,7 +126,9 @@ void dgBroadPhaseDefault::RayCast(const dgVector& l0, const dgVector& l1, OnRayC
 dgInt32 dgBroadPhaseDefault::ConvexCast(dgCollisionInstance* const shape, const dgMatrix& matrix, const dgVector& target, dgFloat32* const param, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const
 {
 	dgInt32 totalCount = 0;
-	if (m_rootNode) {
+	if (m_rootNode && m_queryTree.IsValid()) {
+		totalCount = ConvexCastQueryTree(shape, matrix, target, param, prefilter, userData, info, maxContacts, threadIndex);
+	} else if (m_rootNode) {
 		dgVector boxP0;
 		dgVector boxP1;
 		dgAssert(matrix.TestOrthogonal());
@@ -124,7 +156,9 @@ dgInt32 dgBroadPhaseDefault::ConvexCast(dgCollisionInstance* const shape, const
 dgInt32 dgBroadPhaseDefault::Collide(dgCollisionInstance* const shape, const dgMatrix& matrix, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const
 {
 	dgInt32 totalCount = 0;
-	if (m_rootNode) {
+	if (m_queryTree.IsValid()) {
+		totalCount = CollideQueryTree(shape, matrix, prefilter, userData, info, maxContacts, threadIndex);
+	} else if (m_rootNode) {
 		dgVector boxP0;
 		dgVector boxP1;
 		dgAssert(matrix.TestOrthogonal());
@@ -144,6 +178,7 @@ dgInt32 dgBroadPhaseDefault::Collide(dgCollisionInstance* const shape, const dgM
 
 void dgBroadPhaseDefault::AddNode(dgBroadPhaseNode* const newNode)
 {
+	m_queryTree.Invalidate(true);
 	if (!m_rootNode) {
 		m_rootNode = newNode;
 	} else {
@@ -181,6 +216,7 @@ void dgBroadPhaseDefault::LinkAggregate(dgBroadPhaseAggregate* const aggregate)
 
 void dgBroadPhaseDefault::RemoveNode(dgBroadPhaseNode* const node)
 {
+	m_queryTree.Invalidate(true);
 	if (node->m_parent) {
 		if (!node->m_parent->IsAggregate()) {
 			dgBroadPhaseTreeNode* const parent = (dgBroadPhaseTreeNode*)node->m_parent;
@@ -269,6 +305,7 @@ void dgBroadPhaseDefault::RemoveNode(dgBroadPhaseNode* const node)
 
 void dgBroadPhaseDefault::UnlinkAggregate(dgBroadPhaseAggregate* const aggregate)
 {
+	m_queryTree.Invalidate(true);
 	dgAssert (m_rootNode);
 	if (m_rootNode == aggregate) {
 		m_rootNode = NULL;
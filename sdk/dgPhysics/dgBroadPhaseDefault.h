@@ -40,6 +40,9 @@ class dgBroadPhaseDefault: public dgBroadPhase
 	virtual void Remove(dgBody* const body);
 	virtual void UpdateFitness();
 	virtual void InvalidateCache();
+	virtual void SaveState (dgWorldStateStream& stream) const;
+	virtual bool ValidateState (dgWorldStateStream& stream, const dgWorldStatePointerSet& bodies) const;
+	virtual void RestoreState (dgWorldStateStream& stream);
 	virtual dgBroadPhaseAggregate* CreateAggregate();
 	virtual void DestroyAggregate(dgBroadPhaseAggregate* const aggregate);
 
@@ -91,6 +91,7 @@ void dgBroadPhasePersistent::CheckStaticDynamic(dgBody* const body, dgFloat32 ma
 
 void dgBroadPhasePersistent::Add(dgBody* const body)
 {
+	m_queryTree.Invalidate(true);
 	dgAssert (!body->GetCollision()->IsType (dgCollision::dgCollisionNull_RTTI));
 	dgBroadPhasePesistanceRootNode* const root = (dgBroadPhasePesistanceRootNode*)m_rootNode;
 	dgAssert (m_rootNode->IsPersistentRoot());
@@ -126,6 +127,7 @@ dgBroadPhaseAggregate* dgBroadPhasePersistent::CreateAggregate()
 
 void dgBroadPhasePersistent::LinkAggregate(dgBroadPhaseAggregate* const aggregate)
 {
+	m_queryTree.Invalidate(true);
 	dgAssert(m_rootNode->IsPersistentRoot());
 	dgBroadPhasePesistanceRootNode* const root = (dgBroadPhasePesistanceRootNode*)m_rootNode;
 
@@ -150,6 +152,7 @@ void dgBroadPhasePersistent::DestroyAggregate(dgBroadPhaseAggregate* const aggre
 
 void dgBroadPhasePersistent::RemoveNode(dgBroadPhaseNode* const node)
 {
+	m_queryTree.Invalidate(true);
 	dgAssert (node->m_parent);
 
 	if (node->m_parent->IsPersistentRoot()) {
@@ -289,6 +292,7 @@ void dgBroadPhasePersistent::RemoveNode(dgBroadPhaseNode* const node)
 
 void dgBroadPhasePersistent::UnlinkAggregate (dgBroadPhaseAggregate* const aggregate)
 {
+	m_queryTree.Invalidate(true);
 	dgBroadPhasePesistanceRootNode* const root = (dgBroadPhasePesistanceRootNode*)m_rootNode;
 	dgAssert (root && root->m_left);
 	if (aggregate->m_parent == root) {
@@ -365,8 +369,47 @@ void dgBroadPhasePersistent::UpdateFitness()
 	root->SetBox ();
 }
 
+void dgBroadPhasePersistent::SaveState (dgWorldStateStream& stream) const
+{
+	dgBroadPhase::SaveState (stream);
+	stream.Write (m_staticEntropy);
+	stream.Write (m_dynamicsEntropy);
+	stream.Write (m_staticNeedsUpdate);
+	SaveFitnessState (stream, m_staticFitness);
+	SaveFitnessState (stream, m_dynamicsFitness);
+}
+
+bool dgBroadPhasePersistent::ValidateState (dgWorldStateStream& stream, const dgWorldStatePointerSet& bodies) const
+{
+	dgFloat64 staticEntropy;
+	dgFloat64 dynamicsEntropy;
+	bool staticNeedsUpdate;
+	if (!dgBroadPhase::ValidateState (stream, bodies)) {
+		return false;
+	}
+	stream.Read (staticEntropy);
+	stream.Read (dynamicsEntropy);
+	stream.Read (staticNeedsUpdate);
+	return ValidateFitnessState (stream, m_staticFitness) && ValidateFitnessState (stream, m_dynamicsFitness);
+}
+
+void dgBroadPhasePersistent::RestoreState (dgWorldStateStream& stream)
+{
+	dgBroadPhase::RestoreState (stream);
+	stream.Read (m_staticEntropy);
+	stream.Read (m_dynamicsEntropy);
+	stream.Read (m_staticNeedsUpdate);
+	RestoreFitnessState (stream, m_staticFitness);
+	RestoreFitnessState (stream, m_dynamicsFitness);
+}
+
 void dgBroadPhasePersistent::ForEachBodyInAABB(const dgVector& minBox, const dgVector& maxBox, OnBodiesInAABB callback, void* const userData) const
 {
+	if (m_queryTree.IsValid()) {
+		ForEachBodyInQueryTree(minBox, maxBox, callback, userData);
+		return;
+	}
+
 	dgBroadPhasePesistanceRootNode* const root = (dgBroadPhasePesistanceRootNode*)m_rootNode;
 	const dgBroadPhaseNode* stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];
 
@@ -390,6 +433,10 @@ void dgBroadPhasePersistent::RayCast(const dgVector& l0, const dgVector& l1, OnR
 		dgVector segment(l1 - l0);
 		dgFloat32 dist2 = segment.DotProduct3(segment);
 		if (dist2 > dgFloat32(1.0e-8f)) {
+			if (m_queryTree.IsValid()) {
+				RayCastQueryTree(l0, l1, filter, prefilter, userData);
+				return;
+			}
 
 			dgFloat32 distance[DG_BROADPHASE_MAX_STACK_DEPTH];
 			const dgBroadPhaseNode* stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];
@@ -414,7 +461,7 @@ void dgBroadPhasePersistent::RayCast(const dgVector& l0, const dgVector& l1, OnR
 				}
 			}
 
-			dgBroadPhase::RayCast(stackPool, distance, stack, l0, l1, ray, filter, prefilter, userData);
+			dgBroadPhase::RayCast(stackPool, distance, stack, l0, l1, ray, filter, prefilter, userData, dgFloat32 (1.2f));
 		}
 	}
 }
@@ -422,7 +469,9 @@ void dgBroadPhasePersistent::RayCast(const dgVector& l0, const dgVector& l1, OnR
 dgInt32 dgBroadPhasePersistent::ConvexCast(dgCollisionInstance* const shape, const dgMatrix& matrix, const dgVector& target, dgFloat32* const param, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const
 {
 	dgInt32 totalCount = 0;
-	if (m_rootNode) {
+	if (m_queryTree.IsValid()) {
+		totalCount = ConvexCastQueryTree(shape, matrix, target, param, prefilter, userData, info, maxContacts, threadIndex);
+	} else if (m_rootNode) {
 		dgVector boxP0;
 		dgVector boxP1;
 		dgAssert(matrix.TestOrthogonal());
@@ -468,7 +517,9 @@ dgInt32 dgBroadPhasePersistent::ConvexCast(dgCollisionInstance* const shape, con
 dgInt32 dgBroadPhasePersistent::Collide(dgCollisionInstance* const shape, const dgMatrix& matrix, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const
 {
 	dgInt32 totalCount = 0;
-	if (m_rootNode) {
+	if (m_queryTree.IsValid()) {
+		totalCount = CollideQueryTree(shape, matrix, prefilter, userData, info, maxContacts, threadIndex);
+	} else if (m_rootNode) {
 		dgVector boxP0;
 		dgVector boxP1;
 		dgAssert(matrix.TestOrthogonal());
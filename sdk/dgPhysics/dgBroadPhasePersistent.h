@@ -39,6 +39,9 @@ class dgBroadPhasePersistent: public dgBroadPhase
 	virtual void Add(dgBody* const body);
 	virtual void Remove(dgBody* const body);
 	virtual void InvalidateCache();
+	virtual void SaveState (dgWorldStateStream& stream) const;
+	virtual bool ValidateState (dgWorldStateStream& stream, const dgWorldStatePointerSet& bodies) const;
+	virtual void RestoreState (dgWorldStateStream& stream);
 	virtual dgBroadPhaseAggregate* CreateAggregate();
 	virtual void DestroyAggregate(dgBroadPhaseAggregate* const aggregate);
 
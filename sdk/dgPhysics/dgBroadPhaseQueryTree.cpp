@@ -0,0 +1,224 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dgPhysicsStdafx.h"
+#include "dgBody.h"
+#include "dgBroadPhase.h"
+#include "dgBroadPhaseAggregate.h"
+#include "dgBroadPhaseQueryTree.h"
+
+
+dgBroadPhaseQueryTree::dgRay::dgRay (const dgFastRayTest& ray, const dgVector& boxP0, const dgVector& boxP1)
+{
+	m_p0[0] = ray.m_p0.BroadcastX();
+	m_p0[1] = ray.m_p0.BroadcastY();
+	m_p0[2] = ray.m_p0.BroadcastZ();
+	m_dpInv[0] = ray.m_dpInv.BroadcastX();
+	m_dpInv[1] = ray.m_dpInv.BroadcastY();
+	m_dpInv[2] = ray.m_dpInv.BroadcastZ();
+	m_isParallel[0] = ray.m_isParallel.BroadcastX();
+	m_isParallel[1] = ray.m_isParallel.BroadcastY();
+	m_isParallel[2] = ray.m_isParallel.BroadcastZ();
+	m_boxP0[0] = boxP0.BroadcastX();
+	m_boxP0[1] = boxP0.BroadcastY();
+	m_boxP0[2] = boxP0.BroadcastZ();
+	m_boxP1[0] = boxP1.BroadcastX();
+	m_boxP1[1] = boxP1.BroadcastY();
+	m_boxP1[2] = boxP1.BroadcastZ();
+}
+
+dgBroadPhaseQueryTree::dgBroadPhaseQueryTree (dgMemoryAllocator* const allocator)
+	:m_nodes(allocator)
+	,m_leafs(allocator)
+	,m_buildStack(allocator)
+	,m_nodeCount(0)
+	,m_leafCount(0)
+	,m_isValid(0)
+	,m_topologyChanged(1)
+{
+}
+
+void dgBroadPhaseQueryTree::Invalidate (bool topologyChanged)
+{
+	m_isValid = 0;
+	if (topologyChanged) {
+		m_topologyChanged = 1;
+	}
+}
+
+void dgBroadPhaseQueryTree::Update (const dgBroadPhaseNode* const root)
+{
+	if (!m_isValid) {
+		if (m_topologyChanged) {
+			Build (root);
+		}
+		Refit ();
+		m_isValid = 1;
+		m_topologyChanged = 0;
+	}
+}
+
+const dgBroadPhaseNode* dgBroadPhaseQueryTree::GetTreeNode (const dgBroadPhaseNode* const node)
+{
+	// aggregates are not separate levels of the query tree, they are replaced by their own tree
+	const dgBroadPhaseNode* ptr = node;
+	while (ptr && ptr->IsAggregate()) {
+		ptr = ((dgBroadPhaseAggregate*)ptr)->m_root;
+	}
+	return ptr;
+}
+
+dgInt32 dgBroadPhaseQueryTree::GetChildren (const dgBroadPhaseNode* const node, const dgBroadPhaseNode** const children) const
+{
+	dgInt32 count = 0;
+	if (node->GetBody()) {
+		children[0] = node;
+		return 1;
+	}
+
+	const dgBroadPhaseNode* const left = GetTreeNode (node->GetLeft());
+	if (left) {
+		children[count] = left;
+		count ++;
+	}
+	const dgBroadPhaseNode* const right = GetTreeNode (node->GetRight());
+	if (right) {
+		children[count] = right;
+		count ++;
+	}
+
+	// pull up the grand children of the largest inner children until the node is full
+	while (count < 4) {
+		dgInt32 index = -1;
+		dgFloat32 maxArea = dgFloat32 (-1.0f);
+		for (dgInt32 i = 0; i < count; i ++) {
+			if (!children[i]->GetBody() && (children[i]->m_surfaceArea > maxArea)) {
+				index = i;
+				maxArea = children[i]->m_surfaceArea;
+			}
+		}
+		if (index < 0) {
+			break;
+		}
+
+		const dgBroadPhaseNode* const parent = children[index];
+		count --;
+		children[index] = children[count];
+		const dgBroadPhaseNode* const parentLeft = GetTreeNode (parent->GetLeft());
+		if (parentLeft) {
+			children[count] = parentLeft;
+			count ++;
+		}
+		const dgBroadPhaseNode* const parentRight = GetTreeNode (parent->GetRight());
+		if (parentRight) {
+			children[count] = parentRight;
+			count ++;
+		}
+	}
+	return count;
+}
+
+void dgBroadPhaseQueryTree::Build (const dgBroadPhaseNode* const root)
+{
+	m_nodeCount = 0;
+	m_leafCount = 0;
+
+	const dgBroadPhaseNode* const rootNode = GetTreeNode (root);
+	if (!rootNode) {
+		return;
+	}
+
+	dgInt32 stack = 1;
+	m_buildStack[0].m_node = rootNode;
+	m_buildStack[0].m_parent = -1;
+	m_buildStack[0].m_lane = 0;
+	while (stack) {
+		stack --;
+		const dgBuildEntry entry (m_buildStack[stack]);
+
+		const dgInt32 index = m_nodeCount;
+		m_nodeCount ++;
+		if (entry.m_parent >= 0) {
+			m_nodes[entry.m_parent].m_child[entry.m_lane] = index;
+		}
+
+		const dgBroadPhaseNode* children[4];
+		const dgInt32 count = GetChildren (entry.m_node, children);
+
+		dgNode& node = m_nodes[index];
+		for (dgInt32 i = 0; i < 4; i ++) {
+			node.m_child[i] = 0;
+		}
+		for (dgInt32 i = 0; i < count; i ++) {
+			dgBody* const body = children[i]->GetBody();
+			if (body) {
+				m_leafs[m_leafCount].m_body = body;
+				m_leafs[m_leafCount].m_node = children[i];
+				node.m_child[i] = ~m_leafCount;
+				m_leafCount ++;
+			}
+		}
+
+		// push in reverse so that the first child is the next node in the array
+		for (dgInt32 i = count - 1; i >= 0; i --) {
+			if (!children[i]->GetBody()) {
+				m_buildStack[stack].m_node = children[i];
+				m_buildStack[stack].m_parent = index;
+				m_buildStack[stack].m_lane = i;
+				stack ++;
+			}
+		}
+	}
+}
+
+void dgBroadPhaseQueryTree::Refit ()
+{
+	// the children are always after their parent, so one backward pass updates the boxes bottom up
+	const dgVector emptyMinBox (dgFloat32 (1.0e15f));
+	const dgVector emptyMaxBox (dgFloat32 (-1.0e15f));
+	dgNode* const nodes = m_nodeCount ? &m_nodes[0] : NULL;
+	const dgLeaf* const leafs = m_leafCount ? &m_leafs[0] : NULL;
+	for (dgInt32 i = m_nodeCount - 1; i >= 0; i --) {
+		dgNode& node = nodes[i];
+		for (dgInt32 j = 0; j < 3; j ++) {
+			node.m_minBox[j] = emptyMinBox;
+			node.m_maxBox[j] = emptyMaxBox;
+		}
+		for (dgInt32 j = 0; j < 4; j ++) {
+			const dgInt32 child = node.m_child[j];
+			if (child < 0) {
+				const dgBroadPhaseNode* const leafNode = leafs[~child].m_node;
+				for (dgInt32 k = 0; k < 3; k ++) {
+					node.m_minBox[k][j] = leafNode->m_minBox[k];
+					node.m_maxBox[k][j] = leafNode->m_maxBox[k];
+				}
+			} else if (child > 0) {
+				const dgNode& childNode = nodes[child];
+				for (dgInt32 k = 0; k < 3; k ++) {
+					const dgVector& minBox = childNode.m_minBox[k];
+					const dgVector& maxBox = childNode.m_maxBox[k];
+					node.m_minBox[k][j] = dgMin (dgMin (minBox.m_x, minBox.m_y), dgMin (minBox.m_z, minBox.m_w));
+					node.m_maxBox[k][j] = dgMax (dgMax (maxBox.m_x, maxBox.m_y), dgMax (maxBox.m_z, maxBox.m_w));
+				}
+			}
+		}
+	}
+}
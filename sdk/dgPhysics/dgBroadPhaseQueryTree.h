@@ -0,0 +1,156 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __AFX_BROADPHASE_QUERY_TREE_H_
+#define __AFX_BROADPHASE_QUERY_TREE_H_
+
+#include "dgPhysicsStdafx.h"
+
+class dgBody;
+class dgBroadPhaseNode;
+
+// the four wide tree is about half as deep as the binary tree, but each visited node can push three more entries
+#define DG_QUERY_TREE_STACK_DEPTH	(DG_BROADPHASE_MAX_STACK_DEPTH * 2)
+
+
+// read only copy of the broad phase tree for the scene queries.
+// every node holds the boxes of up to four children in structure of arrays form, so a query tests all of
+// them at once, and the nodes are stored in depth first order in one array. aggregates are flattened into
+// the tree. The copy is rebuilt when the tree topology changed, and refitted when only boxes moved.
+// while it is stale the queries walk the broad phase tree.
+class dgBroadPhaseQueryTree
+{
+	public:
+	// a positive child is a node index, a negative child is the complement of a leaf index.
+	// the root is never a child, so zero marks the empty lanes
+	DG_MSC_VECTOR_ALIGMENT
+	class dgNode
+	{
+		public:
+		dgVector m_minBox[3];
+		dgVector m_maxBox[3];
+		dgInt32 m_child[4];
+	} DG_GCC_VECTOR_ALIGMENT;
+
+	class dgLeaf
+	{
+		public:
+		dgBody* m_body;
+		const dgBroadPhaseNode* m_node;
+	};
+
+	// a ray or the sweep of a box with every component broadcast to the four lanes
+	DG_MSC_VECTOR_ALIGMENT
+	class dgRay
+	{
+		public:
+		dgRay (const dgFastRayTest& ray, const dgVector& boxP0, const dgVector& boxP1);
+
+		// distance along the ray to the four child boxes grown by the swept box, dgFloat32 (1.2f) for the boxes it misses
+		DG_INLINE dgVector BoxIntersect (const dgNode& node) const;
+
+		dgVector m_p0[3];
+		dgVector m_dpInv[3];
+		dgVector m_isParallel[3];
+		dgVector m_boxP0[3];
+		dgVector m_boxP1[3];
+	} DG_GCC_VECTOR_ALIGMENT;
+
+	dgBroadPhaseQueryTree (dgMemoryAllocator* const allocator);
+
+	void Invalidate (bool topologyChanged);
+	void Update (const dgBroadPhaseNode* const root);
+
+	DG_INLINE bool IsValid() const
+	{
+		return m_isValid ? true : false;
+	}
+
+	DG_INLINE dgInt32 GetNodeCount() const
+	{
+		return m_nodeCount;
+	}
+
+	DG_INLINE const dgNode* GetNodes() const
+	{
+		return m_nodeCount ? &m_nodes[0] : NULL;
+	}
+
+	DG_INLINE const dgLeaf* GetLeafs() const
+	{
+		return m_leafCount ? &m_leafs[0] : NULL;
+	}
+
+	// the four overlap flags of the child boxes in the sign mask
+	DG_INLINE static dgInt32 BoxOverlap (const dgNode& node, const dgVector& boxP0, const dgVector& boxP1);
+
+	private:
+	class dgBuildEntry
+	{
+		public:
+		const dgBroadPhaseNode* m_node;
+		dgInt32 m_parent;
+		dgInt32 m_lane;
+	};
+
+	void Build (const dgBroadPhaseNode* const root);
+	void Refit ();
+	dgInt32 GetChildren (const dgBroadPhaseNode* const node, const dgBroadPhaseNode** const children) const;
+
+	static const dgBroadPhaseNode* GetTreeNode (const dgBroadPhaseNode* const node);
+
+	dgArray<dgNode> m_nodes;
+	dgArray<dgLeaf> m_leafs;
+	dgArray<dgBuildEntry> m_buildStack;
+	dgInt32 m_nodeCount;
+	dgInt32 m_leafCount;
+	dgInt32 m_isValid;
+	dgInt32 m_topologyChanged;
+};
+
+
+DG_INLINE dgVector dgBroadPhaseQueryTree::dgRay::BoxIntersect (const dgNode& node) const
+{
+	dgVector t0 (dgVector::m_zero);
+	dgVector t1 (dgVector::m_one);
+	dgVector reject (dgVector::m_zero);
+	for (dgInt32 i = 0; i < 3; i ++) {
+		const dgVector minBox (node.m_minBox[i] - m_boxP1[i]);
+		const dgVector maxBox (node.m_maxBox[i] - m_boxP0[i]);
+		reject = reject | (((m_p0[i] <= minBox) | (m_p0[i] >= maxBox)) & m_isParallel[i]);
+		const dgVector tt0 (m_dpInv[i] * (minBox - m_p0[i]));
+		const dgVector tt1 (m_dpInv[i] * (maxBox - m_p0[i]));
+		t0 = t0.GetMax (tt0.GetMin (tt1));
+		t1 = t1.GetMin (tt0.GetMax (tt1));
+	}
+	const dgVector hit ((t0 < t1).AndNot (reject));
+	return (t0 & hit) | dgVector (dgFloat32 (1.2f)).AndNot (hit);
+}
+
+DG_INLINE dgInt32 dgBroadPhaseQueryTree::BoxOverlap (const dgNode& node, const dgVector& boxP0, const dgVector& boxP1)
+{
+	const dgVector x ((node.m_minBox[0] < boxP1.BroadcastX()) & (node.m_maxBox[0] > boxP0.BroadcastX()));
+	const dgVector y ((node.m_minBox[1] < boxP1.BroadcastY()) & (node.m_maxBox[1] > boxP0.BroadcastY()));
+	const dgVector z ((node.m_minBox[2] < boxP1.BroadcastZ()) & (node.m_maxBox[2] > boxP0.BroadcastZ()));
+	return (x & y & z).GetSignMask();
+}
+
+#endif
@@ -0,0 +1,876 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dgPhysicsStdafx.h"
+#include "dgBody.h"
+#include "dgWorld.h"
+#include "dgCollisionInstance.h"
+#include "dgBroadPhaseSAP.h"
+#include "dgBroadPhaseAggregate.h"
+
+// padding lanes never overlap anything
+#define DG_SAP_EMPTY_LANE	dgFloat32 (1.0e30f)
+
+
+class dgSweepForEachBodyContext
+{
+	public:
+	dgVector m_minBox;
+	dgVector m_maxBox;
+	OnBodiesInAABB m_callback;
+	void* m_userData;
+};
+
+// a node found by a cast, with the distance along the cast at which the cast enters the node box
+class dgSweepCastCandidate
+{
+	public:
+	const dgBroadPhaseNode* m_node;
+	dgFloat32 m_distance;
+};
+
+// the sweep finds the nodes in slab order, so casts collect them first and then visit them nearest first, 
+// like the tree traversal does. Otherwise a far body is tested with a ray that ends inside of it.
+class dgSweepCastCandidateList
+{
+	public:
+	dgSweepCastCandidateList()
+		:m_candidates(m_localPool)
+		,m_count(0)
+		,m_capacity(DG_BROADPHASE_MAX_STACK_DEPTH)
+	{
+	}
+
+	~dgSweepCastCandidateList()
+	{
+		if (m_candidates != m_localPool) {
+			dgFreeStack (m_candidates);
+		}
+	}
+
+	DG_INLINE void Add (const dgBroadPhaseNode* const node, dgFloat32 distance)
+	{
+		if (m_count == m_capacity) {
+			Grow();
+		}
+		m_candidates[m_count].m_node = node;
+		m_candidates[m_count].m_distance = distance;
+		m_count ++;
+	}
+
+	void Sort ()
+	{
+		dgSort (m_candidates, m_count, Compare);
+	}
+
+	DG_INLINE dgInt32 GetCount() const
+	{
+		return m_count;
+	}
+
+	DG_INLINE const dgSweepCastCandidate& operator[] (dgInt32 i) const
+	{
+		dgAssert (i < m_count);
+		return m_candidates[i];
+	}
+
+	private:
+	void Grow ()
+	{
+		dgSweepCastCandidate* const candidates = (dgSweepCastCandidate*) dgMallocStack (2 * m_capacity * sizeof (dgSweepCastCandidate));
+		memcpy (candidates, m_candidates, m_count * sizeof (dgSweepCastCandidate));
+		if (m_candidates != m_localPool) {
+			dgFreeStack (m_candidates);
+		}
+		m_candidates = candidates;
+		m_capacity *= 2;
+	}
+
+	static dgInt32 Compare (const dgSweepCastCandidate* const candidateA, const dgSweepCastCandidate* const candidateB, void* const context)
+	{
+		if (candidateA->m_distance < candidateB->m_distance) {
+			return -1;
+		} else if (candidateA->m_distance > candidateB->m_distance) {
+			return 1;
+		}
+		return 0;
+	}
+
+	dgSweepCastCandidate* m_candidates;
+	dgInt32 m_count;
+	dgInt32 m_capacity;
+	dgSweepCastCandidate m_localPool[DG_BROADPHASE_MAX_STACK_DEPTH];
+};
+
+class dgSweepRayCastContext
+{
+	public:
+	dgVector m_l0;
+	dgVector m_l1;
+	dgFastRayTest* m_ray;
+	OnRayCastAction m_filter;
+	OnRayPrecastAction m_prefilter;
+	void* m_userData;
+	dgSweepCastCandidateList* m_candidates;
+	dgFloat32 m_maxParam;
+};
+
+class dgSweepCastContext
+{
+	public:
+	dgVector m_boxP0;
+	dgVector m_boxP1;
+	dgVector m_velocA;
+	dgVector m_velocB;
+	dgMatrix m_matrix;
+	dgVector m_target;
+	dgFastRayTest* m_ray;
+	dgCollisionInstance* m_shape;
+	OnRayPrecastAction m_prefilter;
+	void* m_userData;
+	dgConvexCastReturnInfo* m_info;
+	dgSweepCastCandidateList* m_candidates;
+	dgFloat32 m_param;
+	dgInt32 m_maxContacts;
+	dgInt32 m_totalCount;
+	dgInt32 m_threadIndex;
+};
+
+
+dgBroadPhaseSAP::dgBroadPhaseSAP(dgWorld* const world)
+	:dgBroadPhase(world)
+	,m_blocks(world->GetAllocator())
+	,m_keys(world->GetAllocator())
+	,m_tmpKeys(world->GetAllocator())
+	,m_slabOrigin(dgFloat32 (0.0f))
+	,m_slabInvSize(dgFloat32 (0.0f))
+	,m_slabCount(0)
+	,m_blockCount(0)
+	,m_sweepIsValid(0)
+{
+	m_axis[0] = 0;
+	m_axis[1] = 1;
+	m_axis[2] = 2;
+}
+
+dgBroadPhaseSAP::~dgBroadPhaseSAP()
+{
+	while (m_aggregateList.GetFirst()) {
+		DestroyAggregate(m_aggregateList.GetFirst()->GetInfo());
+	}
+	while (m_updateList.GetFirst()) {
+		dgBroadPhaseNode* const node = m_updateList.GetFirst()->GetInfo();
+		m_updateList.Remove(m_updateList.GetFirst());
+		delete node;
+	}
+}
+
+dgInt32 dgBroadPhaseSAP::GetType() const
+{
+	return dgWorld::m_sapBroadphase;
+}
+
+void dgBroadPhaseSAP::InvalidateSweep()
+{
+	m_sweepIsValid = 0;
+}
+
+void dgBroadPhaseSAP::ResetEntropy()
+{
+	InvalidateSweep();
+}
+
+void dgBroadPhaseSAP::UpdateFitness()
+{
+	if (!m_sweepIsValid) {
+		BuildSweep();
+	}
+}
+
+void dgBroadPhaseSAP::InvalidateCache()
+{
+	BuildSweep();
+}
+
+void dgBroadPhaseSAP::RestoreState (dgWorldStateStream& stream)
+{
+	// the sweep is sorted again from the restored boxes on the next update
+	dgBroadPhase::RestoreState (stream);
+	InvalidateSweep();
+}
+
+void dgBroadPhaseSAP::UpdateQueryStructure()
+{
+	// bodies moved during the update, sort them now so that queries do not have to wait for the next update
+	if (!m_sweepIsValid) {
+		DG_PROFILE_UPDATE_PHASE (m_world, m_fitness);
+		BuildSweep();
+	}
+}
+
+void dgBroadPhaseSAP::UpdateBody(dgBody* const body, dgInt32 threadIndex)
+{
+	if (body->m_masterNode && body->GetBroadPhase()) {
+		UpdateBodyNode(body->GetBroadPhase(), NULL);
+		if (m_sweepIsValid) {
+			dgInterlockedExchange(&m_sweepIsValid, 0);
+		}
+	}
+}
+
+void dgBroadPhaseSAP::Add(dgBody* const body)
+{
+	dgAssert (!body->GetCollision()->IsType (dgCollision::dgCollisionNull_RTTI));
+	dgBroadPhaseBodyNode* const newNode = new (m_world->GetAllocator()) dgBroadPhaseBodyNode(body);
+	newNode->m_updateNode = m_updateList.Append(newNode);
+	InvalidateSweep();
+}
+
+void dgBroadPhaseSAP::Remove(dgBody* const body)
+{
+	if (body->GetBroadPhase()) {
+		dgBroadPhaseBodyNode* const node = (dgBroadPhaseBodyNode*)body->GetBroadPhase();
+		if (node->m_updateNode) {
+			m_updateList.Remove(node->m_updateNode);
+		}
+		RemoveNode(node);
+		InvalidateSweep();
+	}
+}
+
+dgBroadPhaseAggregate* dgBroadPhaseSAP::CreateAggregate()
+{
+	dgBroadPhaseAggregate* const aggregate = new (m_world->GetAllocator()) dgBroadPhaseAggregate(m_world->GetBroadPhase());
+	LinkAggregate (aggregate);
+	return aggregate;
+}
+
+void dgBroadPhaseSAP::LinkAggregate(dgBroadPhaseAggregate* const aggregate)
+{
+	dgAssert (!aggregate->m_parent);
+	aggregate->m_broadPhase = this;
+	aggregate->m_updateNode = m_updateList.Append(aggregate);
+	aggregate->m_myAggregateNode = m_aggregateList.Append(aggregate);
+	InvalidateSweep();
+}
+
+void dgBroadPhaseSAP::UnlinkAggregate(dgBroadPhaseAggregate* const aggregate)
+{
+	dgAssert (!aggregate->m_parent);
+	InvalidateSweep();
+}
+
+void dgBroadPhaseSAP::DestroyAggregate(dgBroadPhaseAggregate* const aggregate)
+{
+	m_updateList.Remove(aggregate->m_updateNode);
+	m_aggregateList.Remove(aggregate->m_myAggregateNode);
+	RemoveNode(aggregate);
+	InvalidateSweep();
+}
+
+void dgBroadPhaseSAP::RemoveNode(dgBroadPhaseNode* const node)
+{
+	// only the nodes of aggregates have parents
+	if (node->m_parent) {
+		if (!node->m_parent->IsAggregate()) {
+			dgBroadPhaseTreeNode* const parent = (dgBroadPhaseTreeNode*)node->m_parent;
+			dgAssert (parent->m_parent);
+			if (parent->m_parent->IsAggregate()) {
+				dgBroadPhaseAggregate* const aggregate = (dgBroadPhaseAggregate*)parent->m_parent;
+				if (parent->m_left == node) {
+					dgAssert(parent->m_right);
+					aggregate->m_root = parent->m_right;
+					parent->m_right->m_parent = aggregate;
+					parent->m_right = NULL;
+				} else {
+					dgAssert(parent->m_right == node);
+					aggregate->m_root = parent->m_left;
+					parent->m_left->m_parent = aggregate;
+					parent->m_left = NULL;
+				}
+				parent->m_parent = NULL;
+			} else {
+				dgBroadPhaseTreeNode* const grandParent = (dgBroadPhaseTreeNode*)parent->m_parent;
+				if (grandParent->m_left == parent) {
+					if (parent->m_right == node) {
+						grandParent->m_left = parent->m_left;
+						parent->m_left->m_parent = grandParent;
+						parent->m_left = NULL;
+					} else {
+						grandParent->m_left = parent->m_right;
+						parent->m_right->m_parent = grandParent;
+						parent->m_right = NULL;
+					}
+				} else {
+					if (parent->m_right == node) {
+						grandParent->m_right = parent->m_left;
+						parent->m_left->m_parent = grandParent;
+						parent->m_left = NULL;
+					} else {
+						grandParent->m_right = parent->m_right;
+						parent->m_right->m_parent = grandParent;
+						parent->m_right = NULL;
+					}
+				}
+				parent->m_parent = NULL;
+			}
+
+			dgBody* const body = node->GetBody();
+			dgAssert (body && body->GetBroadPhaseAggregate());
+			if (parent->m_fitnessNode) {
+				body->GetBroadPhaseAggregate()->m_fitnessList.Remove(parent->m_fitnessNode);
+			}
+			body->SetBroadPhaseAggregate(NULL);
+			delete parent;
+		} else {
+			dgBroadPhaseAggregate* const aggregate = (dgBroadPhaseAggregate*)node->m_parent;
+			dgBody* const body = node->GetBody();
+			dgAssert (body);
+			dgAssert(body->GetBroadPhaseAggregate() == aggregate);
+			body->SetBroadPhaseAggregate(NULL);
+			aggregate->m_root = NULL;
+			node->m_parent = NULL;
+			delete node;
+		}
+	} else {
+		delete node;
+	}
+}
+
+void dgBroadPhaseSAP::GetNodeBox (const dgBroadPhaseNode* const node, dgVector& minBox, dgVector& maxBox)
+{
+	const dgBody* const body = node->GetBody();
+	if (body) {
+		minBox = body->m_minAABB;
+		maxBox = body->m_maxAABB;
+	} else {
+		minBox = node->m_minBox;
+		maxBox = node->m_maxBox;
+	}
+}
+
+dgInt32 dgBroadPhaseSAP::GetSortKey (const dgSweepKey* const key, void* const context)
+{
+	return key->m_key;
+}
+
+void dgBroadPhaseSAP::BuildSweep()
+{
+	m_slabCount = 0;
+	m_blockCount = 0;
+
+	dgInt32 count = 0;
+	dgVector sum (dgFloat32 (0.0f));
+	dgVector sum2 (dgFloat32 (0.0f));
+	dgVector minCenter (dgFloat32 (1.0e15f));
+	dgVector maxCenter (dgFloat32 (-1.0e15f));
+	m_keys.ResizeIfNecessary(m_updateList.GetCount());
+	dgSweepKey* const keys = &m_keys[0];
+	for (dgList<dgBroadPhaseNode*>::dgListNode* ptr = m_updateList.GetFirst(); ptr; ptr = ptr->GetNext()) {
+		dgBroadPhaseNode* const node = ptr->GetInfo();
+		if (node->IsAggregate() && !((dgBroadPhaseAggregate*)node)->m_root) {
+			continue;
+		}
+		dgVector minBox;
+		dgVector maxBox;
+		GetNodeBox (node, minBox, maxBox);
+		const dgVector center ((minBox + maxBox) * dgVector::m_half);
+		sum += center;
+		sum2 += center * center;
+		minCenter = minCenter.GetMin(center);
+		maxCenter = maxCenter.GetMax(center);
+		keys[count].m_node = node;
+		count ++;
+	}
+
+	if (count) {
+		// sweep along the axis of largest variance, and cut slabs along the second one
+		const dgVector invCount (dgFloat32 (1.0f) / count);
+		const dgVector mean (sum * invCount);
+		const dgVector variance (sum2 * invCount - mean * mean);
+		m_axis[0] = 0;
+		m_axis[1] = 1;
+		m_axis[2] = 2;
+		for (dgInt32 i = 0; i < 2; i ++) {
+			for (dgInt32 j = i + 1; j < 3; j ++) {
+				if (variance[m_axis[j]] > variance[m_axis[i]]) {
+					dgSwap (m_axis[i], m_axis[j]);
+				}
+			}
+		}
+		const dgInt32 axisA = m_axis[0];
+		const dgInt32 axisB = m_axis[1];
+		const dgInt32 axisC = m_axis[2];
+
+		for (dgInt32 i = 0; i < count; i ++) {
+			union {
+				float m_float;
+				dgUnsigned32 m_int;
+			} value;
+			dgVector minBox;
+			dgVector maxBox;
+			GetNodeBox (keys[i].m_node, minBox, maxBox);
+			value.m_float = float (minBox[axisA]);
+			keys[i].m_key = dgInt32 ((value.m_int & 0x80000000) ? ~value.m_int : (value.m_int | 0x80000000));
+		}
+		m_tmpKeys.ResizeIfNecessary(count);
+		dgRadixSort (keys, &m_tmpKeys[0], count, 4, GetSortKey);
+
+		const dgFloat32 slabSpan = maxCenter[axisB] - minCenter[axisB];
+		m_slabCount = dgClamp (count / DG_SAP_SLAB_SIZE, 1, DG_SAP_MAX_SLABS);
+		if (slabSpan < dgFloat32 (1.0e-3f)) {
+			m_slabCount = 1;
+		}
+		m_slabOrigin = minCenter[axisB];
+		m_slabInvSize = (m_slabCount > 1) ? m_slabCount / slabSpan : dgFloat32 (0.0f);
+
+		for (dgInt32 i = 0; i < m_slabCount; i ++) {
+			m_slabs[i].m_maxExtent = dgFloat32 (0.0f);
+			m_slabs[i].m_count = 0;
+		}
+		for (dgInt32 i = 0; i < count; i ++) {
+			dgVector minBox;
+			dgVector maxBox;
+			GetNodeBox (keys[i].m_node, minBox, maxBox);
+			const dgInt32 slab1 = GetSlab(maxBox[axisB]);
+			for (dgInt32 j = GetSlab(minBox[axisB]); j <= slab1; j ++) {
+				m_slabs[j].m_count ++;
+			}
+		}
+		for (dgInt32 i = 0; i < m_slabCount; i ++) {
+			m_slabs[i].m_firstBlock = m_blockCount;
+			m_slabs[i].m_blockCount = (m_slabs[i].m_count + 3) >> 2;
+			m_blockCount += m_slabs[i].m_blockCount;
+		}
+
+		m_blocks.ResizeIfNecessary(m_blockCount);
+		dgSweepBlock* const blocks = &m_blocks[0];
+		const dgVector emptyLane (DG_SAP_EMPTY_LANE);
+		for (dgInt32 i = 0; i < m_slabCount; i ++) {
+			const dgSweepSlab& slab = m_slabs[i];
+			for (dgInt32 j = 0; j < slab.m_blockCount; j ++) {
+				dgSweepBlock& block = blocks[slab.m_firstBlock + j];
+				block.m_minA = emptyLane;
+				block.m_maxA = emptyLane * dgVector::m_negOne;
+				block.m_minB = emptyLane;
+				block.m_maxB = emptyLane * dgVector::m_negOne;
+				block.m_minC = emptyLane;
+				block.m_maxC = emptyLane * dgVector::m_negOne;
+				block.m_nodes[0] = NULL;
+				block.m_nodes[1] = NULL;
+				block.m_nodes[2] = NULL;
+				block.m_nodes[3] = NULL;
+				block.m_slab = i;
+				block.m_count = dgMin (slab.m_count - j * 4, 4);
+			}
+		}
+
+		// the sorted boxes go to their slabs in order, so each slab stays sorted
+		dgInt32 slabFill[DG_SAP_MAX_SLABS];
+		memset (slabFill, 0, m_slabCount * sizeof (dgInt32));
+		for (dgInt32 i = 0; i < count; i ++) {
+			dgVector minBox;
+			dgVector maxBox;
+			dgBroadPhaseNode* const node = keys[i].m_node;
+			GetNodeBox (node, minBox, maxBox);
+			const dgFloat32 extent = maxBox[axisA] - minBox[axisA];
+			const dgInt32 slab1 = GetSlab(maxBox[axisB]);
+			for (dgInt32 j = GetSlab(minBox[axisB]); j <= slab1; j ++) {
+				dgSweepSlab& slab = m_slabs[j];
+				const dgInt32 index = slabFill[j];
+				slabFill[j] = index + 1;
+				slab.m_maxExtent = dgMax (slab.m_maxExtent, extent);
+
+				dgSweepBlock& block = blocks[slab.m_firstBlock + (index >> 2)];
+				const dgInt32 lane = index & 3;
+				block.m_minA[lane] = minBox[axisA];
+				block.m_maxA[lane] = maxBox[axisA];
+				block.m_minB[lane] = minBox[axisB];
+				block.m_maxB[lane] = maxBox[axisB];
+				block.m_minC[lane] = minBox[axisC];
+				block.m_maxC[lane] = maxBox[axisC];
+				block.m_nodes[lane] = node;
+			}
+		}
+	}
+	m_sweepIsValid = 1;
+}
+
+void dgBroadPhaseSAP::SubmitPair (dgBroadPhaseNode* const node0, dgBroadPhaseNode* const node1, dgFloat32 timestep, dgInt32 threadID)
+{
+	dgBody* const body0 = node0->GetBody();
+	dgBody* const body1 = node1->GetBody();
+	if (body0 && body1) {
+		if ((body0->GetInvMass().m_w != dgFloat32(0.0f)) || (body1->GetInvMass().m_w != dgFloat32(0.0f))) {
+			AddPair(body0, body1, timestep, threadID);
+		}
+	} else if (body0) {
+		dgAssert (node1->IsAggregate());
+		((dgBroadPhaseAggregate*)node1)->SummitPairs(body0, timestep, threadID);
+	} else if (body1) {
+		dgAssert (node0->IsAggregate());
+		((dgBroadPhaseAggregate*)node0)->SummitPairs(body1, timestep, threadID);
+	} else {
+		dgAssert (node0->IsAggregate());
+		dgAssert (node1->IsAggregate());
+		((dgBroadPhaseAggregate*)node0)->SummitPairs((dgBroadPhaseAggregate*)node1, timestep, threadID);
+	}
+}
+
+void dgBroadPhaseSAP::SweepBlock (dgInt32 blockIndex, dgFloat32 timestep, bool twoWays, dgInt32 threadID)
+{
+	const dgUnsigned32 lru = m_lru + 1;
+	const dgSweepBlock* const blocks = &m_blocks[0];
+	const dgSweepBlock& block = blocks[blockIndex];
+	const dgSweepSlab& slab = m_slabs[block.m_slab];
+	const dgInt32 lastBlock = slab.m_firstBlock + slab.m_blockCount;
+
+	for (dgInt32 lane = 0; lane < block.m_count; lane ++) {
+		dgBroadPhaseNode* const node0 = block.m_nodes[lane];
+		const bool dirty0 = (node0->GetDirtyLru() == lru);
+		const dgFloat32 minB0 = block.m_minB[lane];
+		if (node0->IsAggregate() && (dirty0 || !twoWays) && (GetSlab(minB0) == block.m_slab)) {
+			((dgBroadPhaseAggregate*)node0)->SubmitSeltPairs(timestep, threadID);
+		}
+
+		const dgVector minA (block.m_minA[lane]);
+		const dgVector maxA (block.m_maxA[lane]);
+		const dgVector minB (minB0);
+		const dgVector maxB (block.m_maxB[lane]);
+		const dgVector minC (block.m_minC[lane]);
+		const dgVector maxC (block.m_maxC[lane]);
+
+		// only the boxes after this one in the sorted order
+		dgInt32 laneMask = (0x0f << (lane + 1)) & 0x0f;
+		for (dgInt32 i = blockIndex; i < lastBlock; i ++) {
+			const dgSweepBlock& block1 = blocks[i];
+			if (block1.m_minA.m_x >= maxA.m_x) {
+				break;
+			}
+			const dgVector test ((block1.m_minA < maxA) & (block1.m_maxA > minA) & (block1.m_minB < maxB) & (block1.m_maxB > minB) & (block1.m_minC < maxC) & (block1.m_maxC > minC));
+			const dgInt32 mask = test.GetSignMask() & laneMask;
+			laneMask = 0x0f;
+			if (mask) {
+				for (dgInt32 j = 0; j < 4; j ++) {
+					if (mask & (1 << j)) {
+						dgBroadPhaseNode* const node1 = block1.m_nodes[j];
+						if (twoWays && !dirty0 && (node1->GetDirtyLru() != lru)) {
+							continue;
+						}
+						if ((m_slabCount > 1) && (GetSlab(dgMax(minB0, block1.m_minB[j])) != block.m_slab)) {
+							continue;
+						}
+						SubmitPair(node0, node1, timestep, threadID);
+					}
+				}
+			}
+		}
+	}
+}
+
+void dgBroadPhaseSAP::FindCollidingPairs (dgBroadphaseSyncDescriptor* const descriptor, bool twoWays, dgInt32 threadID)
+{
+	dgAssert (m_sweepIsValid);
+	const dgFloat32 timestep = descriptor->m_timestep;
+	const dgInt32 blockCount = m_blockCount;
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, DG_SAP_PAIR_BLOCK_CHUNK); i < blockCount; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, DG_SAP_PAIR_BLOCK_CHUNK)) {
+		const dgInt32 chunkEnd = dgMin (i + DG_SAP_PAIR_BLOCK_CHUNK, blockCount);
+		for (dgInt32 j = i; j < chunkEnd; j ++) {
+			SweepBlock (j, timestep, twoWays, threadID);
+		}
+	}
+}
+
+void dgBroadPhaseSAP::FindCollidingPairsForward(dgBroadphaseSyncDescriptor* const descriptor, dgList<dgBroadPhaseNode*>::dgListNode* const node, dgInt32 threadID)
+{
+	FindCollidingPairs (descriptor, false, threadID);
+}
+
+void dgBroadPhaseSAP::FindCollidingPairsForwardAndBackward(dgBroadphaseSyncDescriptor* const descriptor, dgList<dgBroadPhaseNode*>::dgListNode* const node, dgInt32 threadID)
+{
+	FindCollidingPairs (descriptor, true, threadID);
+}
+
+void dgBroadPhaseSAP::ForEachCandidate (const dgVector& minBox, const dgVector& maxBox, OnSweepCandidate callback, void* const context) const
+{
+	if (!m_sweepIsValid) {
+		// bodies were added, removed or moved since the last sort, test them all
+		for (dgList<dgBroadPhaseNode*>::dgListNode* ptr = m_updateList.GetFirst(); ptr; ptr = ptr->GetNext()) {
+			const dgBroadPhaseNode* const node = ptr->GetInfo();
+			if (node->IsAggregate() && !((dgBroadPhaseAggregate*)node)->m_root) {
+				continue;
+			}
+			dgVector p0;
+			dgVector p1;
+			GetNodeBox (node, p0, p1);
+			if (dgOverlapTest(p0, p1, minBox, maxBox)) {
+				if (!callback(this, node, context)) {
+					break;
+				}
+			}
+		}
+		return;
+	}
+
+	if (!m_slabCount) {
+		return;
+	}
+
+	const dgVector minA (minBox[m_axis[0]]);
+	const dgVector maxA (maxBox[m_axis[0]]);
+	const dgVector minB (minBox[m_axis[1]]);
+	const dgVector maxB (maxBox[m_axis[1]]);
+	const dgVector minC (minBox[m_axis[2]]);
+	const dgVector maxC (maxBox[m_axis[2]]);
+
+	const dgSweepBlock* const blocks = &m_blocks[0];
+	const dgInt32 slab0 = GetSlab(minB.m_x);
+	const dgInt32 slab1 = GetSlab(maxB.m_x);
+	for (dgInt32 i = slab0; i <= slab1; i ++) {
+		const dgSweepSlab& slab = m_slabs[i];
+		if (!slab.m_count) {
+			continue;
+		}
+
+		// skip the blocks that start too far back to reach the query box
+		const dgFloat32 start = minA.m_x - slab.m_maxExtent;
+		dgInt32 first = slab.m_firstBlock;
+		dgInt32 last = slab.m_firstBlock + slab.m_blockCount - 1;
+		while (first < last) {
+			const dgInt32 middle = (first + last + 1) >> 1;
+			if (blocks[middle].m_minA.m_x <= start) {
+				first = middle;
+			} else {
+				last = middle - 1;
+			}
+		}
+
+		const dgInt32 lastBlock = slab.m_firstBlock + slab.m_blockCount;
+		for (dgInt32 j = first; j < lastBlock; j ++) {
+			const dgSweepBlock& block = blocks[j];
+			if (block.m_minA.m_x >= maxA.m_x) {
+				break;
+			}
+			const dgVector test ((block.m_minA < maxA) & (block.m_maxA > minA) & (block.m_minB < maxB) & (block.m_maxB > minB) & (block.m_minC < maxC) & (block.m_maxC > minC));
+			const dgInt32 mask = test.GetSignMask();
+			if (mask) {
+				for (dgInt32 k = 0; k < 4; k ++) {
+					if (mask & (1 << k)) {
+						if ((slab0 != slab1) && (GetSlab(dgMax(minB.m_x, block.m_minB[k])) != i)) {
+							continue;
+						}
+						if (!callback(this, block.m_nodes[k], context)) {
+							return;
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+bool dgBroadPhaseSAP::ForEachBodyCandidate (const dgBroadPhaseSAP* const me, const dgBroadPhaseNode* const node, void* const context)
+{
+	dgSweepForEachBodyContext* const data = (dgSweepForEachBodyContext*)context;
+	dgBody* const body = node->GetBody();
+	if (body) {
+		return data->m_callback(body, data->m_userData) ? true : false;
+	}
+	const dgBroadPhaseNode* stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];
+	stackPool[0] = node;
+	me->dgBroadPhase::ForEachBodyInAABB(stackPool, 1, data->m_minBox, data->m_maxBox, data->m_callback, data->m_userData);
+	return true;
+}
+
+void dgBroadPhaseSAP::ForEachBodyInAABB(const dgVector& minBox, const dgVector& maxBox, OnBodiesInAABB callback, void* const userData) const
+{
+	dgSweepForEachBodyContext context;
+	context.m_minBox = minBox;
+	context.m_maxBox = maxBox;
+	context.m_callback = callback;
+	context.m_userData = userData;
+	ForEachCandidate (minBox, maxBox, ForEachBodyCandidate, &context);
+}
+
+bool dgBroadPhaseSAP::RayCastCandidate (const dgBroadPhaseSAP* const me, const dgBroadPhaseNode* const node, void* const context)
+{
+	dgSweepRayCastContext* const data = (dgSweepRayCastContext*)context;
+
+	dgVector minBox;
+	dgVector maxBox;
+	GetNodeBox (node, minBox, maxBox);
+	const dgFloat32 distance = data->m_ray->BoxIntersect(minBox, maxBox);
+	if (distance < data->m_maxParam) {
+		data->m_candidates->Add (node, distance);
+	}
+	return true;
+}
+
+void dgBroadPhaseSAP::RayCast(const dgVector& l0, const dgVector& l1, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData) const
+{
+	if (filter) {
+		dgVector segment(l1 - l0);
+		dgFloat32 dist2 = segment.DotProduct3(segment);
+		if (dist2 > dgFloat32(1.0e-8f)) {
+			dgFastRayTest ray(l0, l1);
+			dgSweepCastCandidateList candidates;
+
+			dgSweepRayCastContext context;
+			context.m_l0 = l0;
+			context.m_l1 = l1;
+			context.m_ray = &ray;
+			context.m_filter = filter;
+			context.m_prefilter = prefilter;
+			context.m_userData = userData;
+			context.m_candidates = &candidates;
+			context.m_maxParam = dgFloat32 (1.2f);
+			ForEachCandidate (l0.GetMin(l1), l0.GetMax(l1), RayCastCandidate, &context);
+
+			candidates.Sort();
+			dgFloat32 maxParam = context.m_maxParam;
+			const dgInt32 count = candidates.GetCount();
+			for (dgInt32 i = 0; (i < count) && (candidates[i].m_distance <= maxParam); i ++) {
+				dgFloat32 distance[DG_BROADPHASE_MAX_STACK_DEPTH];
+				const dgBroadPhaseNode* stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];
+				stackPool[0] = candidates[i].m_node;
+				distance[0] = candidates[i].m_distance;
+				maxParam = dgBroadPhase::RayCast(stackPool, distance, 1, l0, l1, ray, filter, prefilter, userData, maxParam);
+				if (maxParam < dgFloat32(1.0e-8f)) {
+					break;
+				}
+			}
+		}
+	}
+}
+
+bool dgBroadPhaseSAP::ConvexCastCandidate (const dgBroadPhaseSAP* const me, const dgBroadPhaseNode* const node, void* const context)
+{
+	dgSweepCastContext* const data = (dgSweepCastContext*)context;
+
+	dgVector minBox;
+	dgVector maxBox;
+	GetNodeBox (node, minBox, maxBox);
+	const dgFloat32 distance = data->m_ray->BoxIntersect(minBox - data->m_boxP1, maxBox - data->m_boxP0);
+	if (distance < data->m_param) {
+		data->m_candidates->Add (node, distance);
+	}
+	return true;
+}
+
+dgInt32 dgBroadPhaseSAP::ConvexCast(dgCollisionInstance* const shape, const dgMatrix& matrix, const dgVector& target, dgFloat32* const param, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const
+{
+	dgVector boxP0;
+	dgVector boxP1;
+	dgAssert(matrix.TestOrthogonal());
+	shape->CalcAABB(matrix, boxP0, boxP1);
+
+	dgSweepCastCandidateList candidates;
+	dgSweepCastContext context;
+	context.m_boxP0 = boxP0;
+	context.m_boxP1 = boxP1;
+	context.m_velocA = (target - matrix.m_posit) & dgVector::m_triplexMask;
+	context.m_velocB = dgVector(dgFloat32(0.0f));
+	context.m_matrix = matrix;
+	context.m_target = target;
+	context.m_shape = shape;
+	context.m_prefilter = prefilter;
+	context.m_userData = userData;
+	context.m_info = info;
+	context.m_candidates = &candidates;
+	context.m_param = dgFloat32 (1.0f);
+	context.m_maxContacts = dgMin (maxContacts, DG_CONVEX_CAST_POOLSIZE);
+	context.m_totalCount = 0;
+	context.m_threadIndex = threadIndex;
+
+	dgFastRayTest ray(dgVector(dgFloat32(0.0f)), context.m_velocA);
+	context.m_ray = &ray;
+
+	const dgVector minBox (boxP0.GetMin(boxP0 + context.m_velocA));
+	const dgVector maxBox (boxP1.GetMax(boxP1 + context.m_velocA));
+	ForEachCandidate (minBox, maxBox, ConvexCastCandidate, &context);
+
+	candidates.Sort();
+	const dgInt32 count = candidates.GetCount();
+	for (dgInt32 i = 0; (i < count) && (candidates[i].m_distance <= context.m_param); i ++) {
+		dgConvexCastReturnInfo castInfo[DG_CONVEX_CAST_POOLSIZE];
+		dgFloat32 distance[DG_BROADPHASE_MAX_STACK_DEPTH];
+		const dgBroadPhaseNode* stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];
+		stackPool[0] = candidates[i].m_node;
+		distance[0] = candidates[i].m_distance;
+
+		dgFloat32 castParam = context.m_param;
+		dgInt32 castCount = dgBroadPhase::ConvexCast(stackPool, distance, 1, context.m_velocA, context.m_velocB, ray, shape, matrix, target, &castParam, prefilter, userData, castInfo, context.m_maxContacts, threadIndex);
+		if (castParam < context.m_param) {
+			// same rule as the tree traversal, a closer hit replaces the contacts found so far
+			if ((castParam - context.m_param) < dgFloat32(-1.0e-3f)) {
+				context.m_totalCount = 0;
+			}
+			context.m_param = castParam;
+			castCount = dgMin (castCount, context.m_maxContacts - context.m_totalCount);
+			for (dgInt32 j = 0; j < castCount; j ++) {
+				info[context.m_totalCount] = castInfo[j];
+				context.m_totalCount ++;
+			}
+		}
+		if (context.m_param < dgFloat32(1.0e-8f)) {
+			break;
+		}
+	}
+
+	*param = context.m_param;
+	return context.m_totalCount;
+}
+
+bool dgBroadPhaseSAP::CollideCandidate (const dgBroadPhaseSAP* const me, const dgBroadPhaseNode* const node, void* const context)
+{
+	dgSweepCastContext* const data = (dgSweepCastContext*)context;
+
+	dgInt32 overlaped[DG_BROADPHASE_MAX_STACK_DEPTH];
+	const dgBroadPhaseNode* stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];
+	stackPool[0] = node;
+	overlaped[0] = 1;
+	data->m_totalCount += me->dgBroadPhase::Collide(stackPool, overlaped, 1, data->m_boxP0, data->m_boxP1, data->m_shape, data->m_matrix, data->m_prefilter, data->m_userData, &data->m_info[data->m_totalCount], data->m_maxContacts - data->m_totalCount, data->m_threadIndex);
+	return data->m_totalCount < data->m_maxContacts;
+}
+
+dgInt32 dgBroadPhaseSAP::Collide(dgCollisionInstance* const shape, const dgMatrix& matrix, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const
+{
+	dgVector boxP0;
+	dgVector boxP1;
+	dgAssert(matrix.TestOrthogonal());
+	shape->CalcAABB(matrix, boxP0, boxP1);
+
+	dgSweepCastContext context;
+	context.m_boxP0 = boxP0;
+	context.m_boxP1 = boxP1;
+	context.m_matrix = matrix;
+	context.m_shape = shape;
+	context.m_prefilter = prefilter;
+	context.m_userData = userData;
+	context.m_info = info;
+	context.m_maxContacts = maxContacts;
+	context.m_totalCount = 0;
+	context.m_threadIndex = threadIndex;
+	if (maxContacts > 0) {
+		ForEachCandidate (boxP0, boxP1, CollideCandidate, &context);
+	}
+	return context.m_totalCount;
+}
@@ -0,0 +1,141 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __AFX_BROADPHASE_SAP_H_
+#define __AFX_BROADPHASE_SAP_H_
+
+#include "dgPhysicsStdafx.h"
+#include "dgBroadPhase.h"
+
+// average number of boxes per slab, and most slabs the sweep is split in
+#define DG_SAP_SLAB_SIZE			256
+#define DG_SAP_MAX_SLABS			64
+
+// sweep blocks each thread takes at the time during the pair scan
+#define DG_SAP_PAIR_BLOCK_CHUNK		8
+
+
+// sweep and prune broad phase.
+// the top level boxes are sorted along the axis of largest spread, and the sorted list is cut in slabs
+// across the second largest axis, a box goes to every slab it touches. Each slab is stored four boxes
+// to a block in structure of arrays form, so the sweep tests four boxes at the time.
+// a pair is only reported by the slab that contains the largest of the two box minimum along the slab axis.
+// aggregates are swept as a single box, and keep their own tree.
+class dgBroadPhaseSAP: public dgBroadPhase
+{
+	public:
+	DG_CLASS_ALLOCATOR(allocator);
+
+	dgBroadPhaseSAP(dgWorld* const world);
+	virtual ~dgBroadPhaseSAP();
+
+	protected:
+	typedef bool (*OnSweepCandidate) (const dgBroadPhaseSAP* const me, const dgBroadPhaseNode* const node, void* const context);
+
+	DG_MSC_VECTOR_ALIGMENT
+	class dgSweepBlock
+	{
+		public:
+		dgVector m_minA;
+		dgVector m_maxA;
+		dgVector m_minB;
+		dgVector m_maxB;
+		dgVector m_minC;
+		dgVector m_maxC;
+		dgBroadPhaseNode* m_nodes[4];
+		dgInt32 m_slab;
+		dgInt32 m_count;
+	} DG_GCC_VECTOR_ALIGMENT;
+
+	class dgSweepSlab
+	{
+		public:
+		dgFloat32 m_maxExtent;
+		dgInt32 m_firstBlock;
+		dgInt32 m_blockCount;
+		dgInt32 m_count;
+	};
+
+	class dgSweepKey
+	{
+		public:
+		dgBroadPhaseNode* m_node;
+		dgInt32 m_key;
+	};
+
+	virtual dgInt32 GetType() const;
+	virtual void Add(dgBody* const body);
+	virtual void Remove(dgBody* const body);
+	virtual void UpdateBody(dgBody* const body, dgInt32 threadIndex);
+	virtual void UpdateQueryStructure();
+	virtual void ResetEntropy();
+	virtual void UpdateFitness();
+	virtual void InvalidateCache();
+	virtual void RestoreState (dgWorldStateStream& stream);
+	virtual dgBroadPhaseAggregate* CreateAggregate();
+	virtual void DestroyAggregate(dgBroadPhaseAggregate* const aggregate);
+
+	virtual void LinkAggregate (dgBroadPhaseAggregate* const aggregate); 
+	virtual void UnlinkAggregate (dgBroadPhaseAggregate* const aggregate); 
+	virtual void CheckStaticDynamic(dgBody* const body, dgFloat32 mass) {}
+	virtual void FindCollidingPairsForward (dgBroadphaseSyncDescriptor* const descriptor, dgList<dgBroadPhaseNode*>::dgListNode* const node, dgInt32 threadID);
+	virtual void FindCollidingPairsForwardAndBackward (dgBroadphaseSyncDescriptor* const descriptor, dgList<dgBroadPhaseNode*>::dgListNode* const node, dgInt32 threadID);
+
+	virtual void ForEachBodyInAABB (const dgVector& q0, const dgVector& q1, OnBodiesInAABB callback, void* const userData) const;
+	virtual void RayCast (const dgVector& p0, const dgVector& p1, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData) const;
+	virtual dgInt32 Collide(dgCollisionInstance* const shape, const dgMatrix& matrix, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const;
+	virtual dgInt32 ConvexCast (dgCollisionInstance* const shape, const dgMatrix& matrix, const dgVector& target, dgFloat32* const param, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const;
+
+	void RemoveNode(dgBroadPhaseNode* const node);
+	void InvalidateSweep();
+	void BuildSweep();
+	void FindCollidingPairs (dgBroadphaseSyncDescriptor* const descriptor, bool twoWays, dgInt32 threadID);
+	void SweepBlock (dgInt32 blockIndex, dgFloat32 timestep, bool twoWays, dgInt32 threadID);
+	void SubmitPair (dgBroadPhaseNode* const node0, dgBroadPhaseNode* const node1, dgFloat32 timestep, dgInt32 threadID);
+	void ForEachCandidate (const dgVector& minBox, const dgVector& maxBox, OnSweepCandidate callback, void* const context) const;
+
+	DG_INLINE dgInt32 GetSlab (dgFloat32 value) const
+	{
+		const dgFloat32 slab = dgClamp ((value - m_slabOrigin) * m_slabInvSize, dgFloat32 (0.0f), dgFloat32 (m_slabCount - 1));
+		return dgInt32 (slab);
+	}
+
+	static void GetNodeBox (const dgBroadPhaseNode* const node, dgVector& minBox, dgVector& maxBox);
+	static dgInt32 GetSortKey (const dgSweepKey* const key, void* const context);
+	static bool ForEachBodyCandidate (const dgBroadPhaseSAP* const me, const dgBroadPhaseNode* const node, void* const context);
+	static bool RayCastCandidate (const dgBroadPhaseSAP* const me, const dgBroadPhaseNode* const node, void* const context);
+	static bool ConvexCastCandidate (const dgBroadPhaseSAP* const me, const dgBroadPhaseNode* const node, void* const context);
+	static bool CollideCandidate (const dgBroadPhaseSAP* const me, const dgBroadPhaseNode* const node, void* const context);
+
+	dgArray<dgSweepBlock> m_blocks;
+	dgArray<dgSweepKey> m_keys;
+	dgArray<dgSweepKey> m_tmpKeys;
+	dgSweepSlab m_slabs[DG_SAP_MAX_SLABS];
+	dgInt32 m_axis[3];
+	dgFloat32 m_slabOrigin;
+	dgFloat32 m_slabInvSize;
+	dgInt32 m_slabCount;
+	dgInt32 m_blockCount;
+	dgInt32 m_sweepIsValid;
+};
+
+
+#endif
@@ -28,8 +28,11 @@
 dgCollisionBVH::dgCollisionBVH(dgWorld* const world)
 	:dgCollisionMesh (world, m_boundingBoxHierachy), dgAABBPolygonSoup()
 	,m_trianglesCount(0)
+	,m_compressedBuild(false)
+	,m_parallelBuild(false)
 {
 	m_rtti |= dgCollisionBVH_RTTI;
+	m_world = world;
 	m_builder = NULL;
 	m_userRayCastCallback = NULL;
 }
@@ -38,9 +41,12 @@ dgCollisionBVH::dgCollisionBVH (dgWorld* const world, dgDeserialize deserializat
 	:dgCollisionMesh (world, deserialization, userData, revisionNumber)
 	,dgAABBPolygonSoup()
 	,m_trianglesCount(0)
+	,m_compressedBuild(false)
+	,m_parallelBuild(false)
 {
 	dgAssert (m_rtti | dgCollisionBVH_RTTI);
-	m_builder = NULL;;
+	m_world = world;
+	m_builder = NULL;
 	m_userRayCastCallback = NULL;
 
 	dgAABBPolygonSoup::Deserialize (deserialization, userData, revisionNumber);
@@ -83,6 +89,16 @@ void dgCollisionBVH::AddFace(dgInt32 vertexCount, const dgFloat32* const vertexP
 	m_builder->AddMesh (vertexPtr, vertexCount, strideInBytes, 1, &faceArray, indexList, &faceAttribute, dgGetIdentityMatrix());
 }
 
+void dgCollisionBVH::SetCompressedBuild (bool state)
+{
+	m_compressedBuild = state;
+}
+
+void dgCollisionBVH::SetParallelBuild (bool state)
+{
+	m_parallelBuild = state;
+}
+
 void dgCollisionBVH::SetCollisionRayCastCallback (dgCollisionBVHUserRayCastCallback rayCastCallback)
 {
 	m_userRayCastCallback = rayCastCallback;
@@ -96,9 +112,15 @@ void dgCollisionBVH::EndBuild(dgInt32 optimize)
 
 	bool state = optimize ? true : false;
 
+	// the caller guarantees the world worker threads are idle, see NewtonTreeCollisionSetParallelBuild
+	dgThreadHive* const threadPool = m_parallelBuild ? m_world : NULL;
+
 	m_builder->End(state);
-	Create (*m_builder, state);
-	CalculateAdjacendy();
+	Create (*m_builder, state, threadPool);
+	CalculateAdjacendy(threadPool);
+	if (m_compressedBuild) {
+		Compress();
+	}
 	
 	GetAABB (p0, p1);
 	SetCollisionBBox (p0, p1);
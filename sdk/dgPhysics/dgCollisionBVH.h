@@ -56,6 +56,8 @@ class dgCollisionBVH: public dgCollisionMesh, public dgAABBPolygonSoup
 	void BeginBuild();
 	void AddFace (dgInt32 vertexCount, const dgFloat32* const vertexPtr, dgInt32 strideInBytes, dgInt32 faceAttribute);
 	void EndBuild(dgInt32 optimize);
+	void SetCompressedBuild (bool state);
+	void SetParallelBuild (bool state);
 
 	void SetCollisionRayCastCallback (dgCollisionBVHUserRayCastCallback rayCastCallback);
 	dgCollisionBVHUserRayCastCallback GetDebugRayCastCallback() const { return m_userRayCastCallback;} 
@@ -85,10 +87,13 @@ class dgCollisionBVH: public dgCollisionMesh, public dgAABBPolygonSoup
 	virtual dgVector SupportVertexSpecial (const dgVector& dir, dgInt32* const vertexIndex) const;
 	virtual dgVector SupportVertexSpecialProjectPoint (const dgVector& point, const dgVector& dir) const {return point;}
 
+	dgWorld* m_world;
 	dgPolygonSoupDatabaseBuilder* m_builder;
 	dgCollisionBVHUserRayCastCallback m_userRayCastCallback;
 
 	dgInt32 m_trianglesCount;
+	bool m_compressedBuild;
+	bool m_parallelBuild;
 	friend class dgCollisionCompound;
 	friend class dgCollisionDeformableMesh;
 };
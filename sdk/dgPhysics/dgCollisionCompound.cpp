@@ -1552,9 +1552,9 @@ dgInt32 dgCollisionCompound::CalculateContacts (dgBroadPhase::dgPair* const pair
 			if (body1->m_collision->IsType (dgCollision::dgCollisionConvexShape_RTTI)) {
 				contactCount = CalculateContactsToSingle (pair, proxy);
 			} else if (body1->m_collision->IsType (dgCollision::dgCollisionCompound_RTTI)) {
-				contactCount = CalculateContactsToCompound (pair, proxy);
+				contactCount = CalculateContactsToCompound (pair, proxy, m_root);
 			} else if (body1->m_collision->IsType (dgCollision::dgCollisionBVH_RTTI)) {
-				contactCount = CalculateContactsToCollisionTree (pair, proxy);
+				contactCount = CalculateContactsToCollisionTree (pair, proxy, m_root);
 			} else if (body1->m_collision->IsType (dgCollision::dgCollisionHeightField_RTTI)) {
 				contactCount = CalculateContactsToHeightField (pair, proxy);
 			} else {
@@ -1567,6 +1567,65 @@ dgInt32 dgCollisionCompound::CalculateContacts (dgBroadPhase::dgPair* const pair
 	return contactCount;
 }
 
+bool dgCollisionCompound::IsSplitContactPair (const dgCollisionInstance* const otherInstance) const
+{
+	// only plain compounds colliding with meshes or other compounds are worth splitting
+	if (!m_root || (m_array.GetCount() < DG_COMPOUND_SPLIT_CONTACT_LEAFS)) {
+		return false;
+	}
+	if (IsType (dgCollision::dgCollisionCompoundBreakable_RTTI) || IsType (dgCollision::dgCollisionScene_RTTI)) {
+		return false;
+	}
+	if (otherInstance->IsType (dgCollision::dgCollisionBVH_RTTI)) {
+		return true;
+	}
+	return otherInstance->IsType (dgCollision::dgCollisionCompound_RTTI) && !otherInstance->IsType (dgCollision::dgCollisionCompoundBreakable_RTTI) && !otherInstance->IsType (dgCollision::dgCollisionScene_RTTI);
+}
+
+dgInt32 dgCollisionCompound::GetContactSubTrees (dgNodeBase** const subTrees, dgInt32 maxCount) const
+{
+	// open the largest node until there are enough sub trees, the split only depends on the tree 
+	// so the contacts come out the same regardless of how many threads process them
+	dgInt32 count = 0;
+	if (m_root) {
+		subTrees[0] = m_root;
+		count = 1;
+		while (count < maxCount) {
+			dgInt32 index = -1;
+			dgFloat32 maxArea = dgFloat32 (-1.0f);
+			for (dgInt32 i = 0; i < count; i ++) {
+				if ((subTrees[i]->m_type == m_node) && (subTrees[i]->m_area > maxArea)) {
+					index = i;
+					maxArea = subTrees[i]->m_area;
+				}
+			}
+			if (index == -1) {
+				break;
+			}
+			dgNodeBase* const node = subTrees[index];
+			subTrees[index] = node->m_left;
+			subTrees[count] = node->m_right;
+			count ++;
+		}
+	}
+	return count;
+}
+
+dgInt32 dgCollisionCompound::CalculateSubTreeContacts (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy, dgNodeBase* const subTree) const
+{
+	dgInt32 contactCount = 0;
+	dgAssert (!proxy.m_continueCollision);
+	dgBody* const body1 = pair->m_contact->GetBody1();
+	if (body1->m_collision->IsType (dgCollision::dgCollisionCompound_RTTI)) {
+		contactCount = CalculateContactsToCompound (pair, proxy, subTree);
+	} else {
+		dgAssert (body1->m_collision->IsType (dgCollision::dgCollisionBVH_RTTI));
+		contactCount = CalculateContactsToCollisionTree (pair, proxy, subTree);
+	}
+	pair->m_contactCount = contactCount;
+	return contactCount;
+}
+
 
 dgInt32 dgCollisionCompound::ClosestDistance (dgCollisionParamProxy& proxy) const
 {
@@ -1756,7 +1815,7 @@ dgInt32 dgCollisionCompound::ClosestDistanceToCompound (dgCollisionParamProxy& p
 
 
 
-dgInt32 dgCollisionCompound::CalculateContactsToCompound (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy) const
+dgInt32 dgCollisionCompound::CalculateContactsToCompound (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy, dgNodeBase* const subTree) const
 {
 	dgContactPoint* const contacts = proxy.m_contacts;
 	const dgNodeBase* stackPool[4 * DG_COMPOUND_STACK_DEPTH][2];
@@ -1781,7 +1840,7 @@ dgInt32 dgCollisionCompound::CalculateContactsToCompound (dgBroadPhase::dgPair*
 	dgOOBBTestData data (otherMatrix * myMatrix.Inverse());
 
 	dgInt32 stack = 1;
-	stackPool[0][0] = m_root;
+	stackPool[0][0] = subTree;
 	stackPool[0][1] = otherCompound->m_root;
 	const dgContactMaterial* const material = constraint->GetMaterial();
 
@@ -2226,7 +2285,7 @@ dgInt32 dgCollisionCompound::CalculateContactsToSingle (dgBroadPhase::dgPair* co
 }
 
 
-dgInt32 dgCollisionCompound::CalculateContactsToCollisionTree (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy) const
+dgInt32 dgCollisionCompound::CalculateContactsToCollisionTree (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy, dgNodeBase* const subTree) const
 {
 	dgContactPoint* const contacts = proxy.m_contacts;
 
@@ -2254,9 +2313,11 @@ dgInt32 dgCollisionCompound::CalculateContactsToCollisionTree (dgBroadPhase::dgP
 	dgOOBBTestData data (treeCollisionInstance->GetGlobalMatrix() * myMatrix.Inverse());
 
 	dgInt32 stack = 1;
-	stackPool[0].m_myNode = m_root;
+	stackPool[0].m_myNode = subTree;
 	stackPool[0].m_treeNode = treeCollision->GetRootNode();
 	stackPool[0].m_treeNodeIsLeaf = 0;
+	stackPool[0].m_treeParentP0 = dgVector (dgFloat32 (0.0f));
+	stackPool[0].m_treeParentP1 = dgVector (dgFloat32 (0.0f));
 
 	dgNodeBase nodeProxi;
 	nodeProxi.m_left = NULL;
@@ -2275,14 +2336,19 @@ dgInt32 dgCollisionCompound::CalculateContactsToCollisionTree (dgBroadPhase::dgP
 		dgNodeBase* const me = stackEntry->m_myNode;
 		const void* const other = stackEntry->m_treeNode;
 		dgInt32 treeNodeIsLeaf = stackEntry->m_treeNodeIsLeaf;
+		const dgVector treeParentP0 (stackEntry->m_treeParentP0);
+		const dgVector treeParentP1 (stackEntry->m_treeParentP1);
+		const dgInt32 stackStart = stack;
 
 		dgAssert (me && other);
 		dgVector p0;
 		dgVector p1;
 
-		treeCollision->GetNodeAABB(other, p0, p1);
-		nodeProxi.m_p0 = p0 * treeScale;
-		nodeProxi.m_p1 = p1 * treeScale;
+		dgVector treeP0;
+		dgVector treeP1;
+		treeCollision->GetNodeAABB(other, treeParentP0, treeParentP1, treeP0, treeP1);
+		nodeProxi.m_p0 = treeP0 * treeScale;
+		nodeProxi.m_p1 = treeP1 * treeScale;
 
 		p0 = nodeProxi.m_p0 * dgVector::m_half;
 		p1 = nodeProxi.m_p1 * dgVector::m_half;
@@ -2453,6 +2519,13 @@ dgInt32 dgCollisionCompound::CalculateContactsToCollisionTree (dgBroadPhase::dgP
 				stack++;
 			}
 		}
+
+		// the tree nodes pushed above are either children of the visited tree node or the node itself
+		for (dgInt32 i = stackStart; i < stack; i ++) {
+			const bool isChild = (stackPool[i].m_treeNode != other);
+			stackPool[i].m_treeParentP0 = isChild ? treeP0 : treeParentP0;
+			stackPool[i].m_treeParentP1 = isChild ? treeP1 : treeParentP1;
+		}
 	}
 
 	constraint->m_closestDistance = closestDist;
@@ -2836,6 +2909,8 @@ dgInt32 dgCollisionCompound::CalculateContactsToCollisionTreeContinue (dgBroadPh
 	stackPool[0].m_myNode = m_root;
 	stackPool[0].m_treeNode = treeCollision->GetRootNode();
 	stackPool[0].m_treeNodeIsLeaf = 0;
+	stackPool[0].m_treeParentP0 = dgVector (dgFloat32 (0.0f));
+	stackPool[0].m_treeParentP1 = dgVector (dgFloat32 (0.0f));
 
 	dgNodeBase nodeProxi;
 	nodeProxi.m_left = NULL;
@@ -2861,15 +2936,20 @@ dgInt32 dgCollisionCompound::CalculateContactsToCollisionTreeContinue (dgBroadPh
 		dgNodeBase* const me = stackEntry->m_myNode;
 		const void* const other = stackEntry->m_treeNode;
 		dgInt32 treeNodeIsLeaf = stackEntry->m_treeNodeIsLeaf;
+		const dgVector treeParentP0 (stackEntry->m_treeParentP0);
+		const dgVector treeParentP1 (stackEntry->m_treeParentP1);
+		const dgInt32 stackStart = stack;
 
 		dgAssert (me && other);
 
 		dgVector p0;
 		dgVector p1;
 
-		treeCollision->GetNodeAABB(other, p0, p1);
-		nodeProxi.m_p0 = p0 * treeScale;
-		nodeProxi.m_p1 = p1 * treeScale;
+		dgVector treeP0;
+		dgVector treeP1;
+		treeCollision->GetNodeAABB(other, treeParentP0, treeParentP1, treeP0, treeP1);
+		nodeProxi.m_p0 = treeP0 * treeScale;
+		nodeProxi.m_p1 = treeP1 * treeScale;
 
 		p0 = nodeProxi.m_p0 * dgVector::m_half;
 		p1 = nodeProxi.m_p1 * dgVector::m_half;
@@ -3067,6 +3147,13 @@ dgInt32 dgCollisionCompound::CalculateContactsToCollisionTreeContinue (dgBroadPh
 				stack++;
 			}
 		}
+
+		// the tree nodes pushed above are either children of the visited tree node or the node itself
+		for (dgInt32 i = stackStart; i < stack; i ++) {
+			const bool isChild = (stackPool[i].m_treeNode != other);
+			stackPool[i].m_treeParentP0 = isChild ? treeP0 : treeParentP0;
+			stackPool[i].m_treeParentP1 = isChild ? treeP1 : treeParentP1;
+		}
 	}
 
 	proxy.m_normal = n;
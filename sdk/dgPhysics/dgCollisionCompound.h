@@ -32,6 +32,10 @@ class dgCollisionInstance;
 
 #define DG_COMPOUND_STACK_DEPTH	256
 
+// compounds with at least this many children get their contacts split over the thread pool
+#define DG_COMPOUND_SPLIT_CONTACT_LEAFS		32
+#define DG_COMPOUND_SPLIT_CONTACT_SUBTREES	16
+
 class dgCollisionCompound: public dgCollision
 {
 	protected:
@@ -125,6 +129,8 @@ class dgCollisionCompound: public dgCollision
 	class dgNodePairs
 	{
 		public:
+		dgVector m_treeParentP0;
+		dgVector m_treeParentP1;
 		const void* m_treeNode;
 		dgNodeBase* m_myNode;
 		dgInt32 m_treeNodeIsLeaf;
@@ -157,6 +163,10 @@ class dgCollisionCompound: public dgCollision
 	dgTreeArray::dgTreeNode* GetNextNode (dgTreeArray::dgTreeNode* const node) const;
 	dgCollisionInstance* GetCollisionFromNode (dgTreeArray::dgTreeNode* const node) const;
 
+	bool IsSplitContactPair (const dgCollisionInstance* const otherInstance) const;
+	dgInt32 GetContactSubTrees (dgNodeBase** const subTrees, dgInt32 maxCount) const;
+	dgInt32 CalculateSubTreeContacts (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy, dgNodeBase* const subTree) const;
+
 	protected:
 	void RemoveCollision (dgNodeBase* const node);
 	virtual dgFloat32 GetVolume () const;
@@ -187,9 +197,9 @@ class dgCollisionCompound: public dgCollision
 
 	dgInt32 CalculateContactsToSingle (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy) const;
 	dgInt32 CalculateContactsToSingleContinue (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy) const;
-	dgInt32 CalculateContactsToCompound (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy) const;
+	dgInt32 CalculateContactsToCompound (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy, dgNodeBase* const subTree) const;
 	dgInt32 CalculateContactsToCompoundContinue (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy) const;
-	dgInt32 CalculateContactsToCollisionTree (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy) const;
+	dgInt32 CalculateContactsToCollisionTree (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy, dgNodeBase* const subTree) const;
 	dgInt32 CalculateContactsToCollisionTreeContinue (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy) const;
 	dgInt32 CalculateContactsToHeightField (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy) const;
 	dgInt32 CalculateContactsUserDefinedCollision (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy) const;
@@ -101,26 +101,27 @@ dgCollisionConvexHull::dgCollisionConvexHull(dgWorld* const world, dgDeserialize
 	}
 	deserialization (userData, m_vertex, m_vertexCount * sizeof (dgVector));
 
-	for (dgInt32 i = 0; i < m_edgeCount; i ++) {
-		dgInt32 serialization[4];
-		deserialization (userData, serialization, sizeof (serialization));
+	// the edge, face and vertex tables are contiguous in the stream, read them in one go and fix up the pointers
+	dgStack<dgInt32> offsets (m_edgeCount * 4 + m_faceCount + m_vertexCount);
+	deserialization (userData, &offsets[0], (m_edgeCount * 4 + m_faceCount + m_vertexCount) * sizeof (dgInt32));
 
+	const dgInt32* const edgeOffsets = &offsets[0];
+	for (dgInt32 i = 0; i < m_edgeCount; i ++) {
+		const dgInt32* const serialization = &edgeOffsets[i * 4];
 		m_simplex[i].m_vertex = serialization[0];
 		m_simplex[i].m_twin = m_simplex + serialization[1];
 		m_simplex[i].m_next = m_simplex + serialization[2];
 		m_simplex[i].m_prev = m_simplex + serialization[3];
 	}
 
+	const dgInt32* const faceOffsets = &offsets[m_edgeCount * 4];
 	for (dgInt32 i = 0; i < m_faceCount; i ++) {
-		dgInt32 faceOffset;
-		deserialization (userData, &faceOffset, sizeof (dgInt32));
-		m_faceArray[i] = m_simplex + faceOffset; 
+		m_faceArray[i] = m_simplex + faceOffsets[i]; 
 	}
 
+	const dgInt32* const vertexOffsets = &faceOffsets[m_faceCount];
 	for (dgInt32 i = 0; i < m_vertexCount; i ++) {
-		dgInt32 faceOffset;
-		deserialization (userData, &faceOffset, sizeof (dgInt32));
-		m_vertexToEdgeMapping[i] = m_simplex + faceOffset; 
+		m_vertexToEdgeMapping[i] = m_simplex + vertexOffsets[i]; 
 	}
 
 	SetVolumeAndCG ();
@@ -54,6 +54,226 @@ dgInt32 dgCollisionHeightField::m_horizontalEdgeMap[][7] =
 };
 
 
+dgCollisionHeightField::dgPerIntanceData::dgPerIntanceData (dgWorld* const world)
+	:m_world(world)
+	,m_refCount(0)
+	,m_threadCount(world->GetMaxThreadCount())
+{
+	// sized for the maximum number of threads so that the world thread count can change at any time
+	dgMemoryAllocator* const allocator = world->GetAllocator();
+	m_vertexCount = (dgInt32*) allocator->MallocLow(m_threadCount * sizeof (dgInt32));
+	m_vertex = new (allocator) dgArray<dgVector>[dgUnsigned32 (m_threadCount)];
+	m_cells = new (allocator) dgArray<dgInt8>[dgUnsigned32 (m_threadCount)];
+	for (dgInt32 i = 0; i < m_threadCount; i ++) {
+		m_vertexCount[i] = 0;
+		m_vertex[i].SetAllocator(allocator);
+		m_cells[i].SetAllocator(allocator);
+	}
+}
+
+dgCollisionHeightField::dgPerIntanceData::~dgPerIntanceData ()
+{
+	delete[] m_vertex;
+	delete[] m_cells;
+	m_world->GetAllocator()->FreeLow(m_vertexCount);
+}
+
+dgCollisionHeightField::dgTileCache::dgTileCache (dgCollisionHeightField* const owner, dgInt32 tileSize, dgInt32 maxResidentTiles, dgFloat32 minElevation, dgFloat32 maxElevation, dgCollisionHeightFieldTileCallback callback, void* const userData)
+	:dgThread("heightFieldTiles", 0)
+	,m_owner(owner)
+	,m_callback(callback)
+	,m_userData(userData)
+	,m_tiles(NULL)
+	,m_queue(NULL)
+	,m_lru(owner->GetAllocator())
+	,m_lock()
+	,m_semaphore()
+	,m_prefetchDistance(dgFloat32 (0.0f))
+	// even sizes, so that the tiles start at the same diagonal pattern as the whole map
+	,m_tileSize(dgMax ((tileSize + 1) & -2, 2))
+	,m_tilesX((owner->m_width + m_tileSize - 2) / m_tileSize)
+	,m_tilesZ((owner->m_height + m_tileSize - 2) / m_tileSize)
+	,m_maxResidentTiles(dgMax (maxResidentTiles, 1))
+	,m_queueHead(0)
+	,m_queueTail(0)
+	,m_loaderStarted(0)
+{
+	const dgInt32 count = m_tilesX * m_tilesZ;
+	m_tiles = (dgTile*) dgMallocStack(count * sizeof (dgTile));
+	m_queue = (dgInt32*) dgMallocStack((count + 1) * sizeof (dgInt32));
+	for (dgInt32 i = 0; i < count; i ++) {
+		m_tiles[i].m_field = NULL;
+		m_tiles[i].m_lruNode = NULL;
+		m_tiles[i].m_minHeight = minElevation;
+		m_tiles[i].m_maxHeight = maxElevation;
+		m_tiles[i].m_state = m_unloaded;
+		m_tiles[i].m_inQueue = 0;
+	}
+}
+
+dgCollisionHeightField::dgTileCache::~dgTileCache ()
+{
+	if (m_loaderStarted) {
+		dgInterlockedExchange(&m_terminate, 1);
+		m_semaphore.Release();
+		Close();
+	}
+
+	for (dgInt32 i = 0; i < m_tilesX * m_tilesZ; i ++) {
+		if (m_tiles[i].m_field) {
+			m_tiles[i].m_field->Release();
+		}
+	}
+	m_lru.RemoveAll();
+	dgFreeStack(m_tiles);
+	dgFreeStack(m_queue);
+}
+
+void dgCollisionHeightField::dgTileCache::Execute (dgInt32 threadID)
+{
+	const dgInt32 queueSize = m_tilesX * m_tilesZ + 1;
+	while (!m_terminate) {
+		SuspendExecution(m_semaphore);
+		while (!m_terminate) {
+			dgInt32 index = -1;
+			m_lock.Lock(true);
+			while ((index < 0) && (m_queueHead != m_queueTail)) {
+				dgTile& tile = m_tiles[m_queue[m_queueHead]];
+				tile.m_inQueue = 0;
+				if (tile.m_state == m_queued) {
+					// a physics thread may have read it already
+					tile.m_state = m_loading;
+					index = m_queue[m_queueHead];
+				}
+				m_queueHead = (m_queueHead + 1) % queueSize;
+			}
+			m_lock.Unlock();
+			if (index < 0) {
+				break;
+			}
+			LoadTile (index);
+		}
+	}
+}
+
+void dgCollisionHeightField::dgTileCache::LoadTile (dgInt32 index)
+{
+	dgAssert (m_tiles[index].m_state == m_loading);
+	const dgInt32 x0 = (index % m_tilesX) * m_tileSize;
+	const dgInt32 z0 = (index / m_tilesX) * m_tileSize;
+	const dgInt32 width = dgMin (m_tileSize, m_owner->m_width - 1 - x0) + 1;
+	const dgInt32 height = dgMin (m_tileSize, m_owner->m_height - 1 - z0) + 1;
+	const dgInt32 elementSize = (m_owner->m_elevationDataType == m_float32Bit) ? sizeof (dgFloat32) : sizeof (dgUnsigned16);
+
+	// the user reads the tile without holding the lock
+	void* const elevation = dgMallocStack(width * height * elementSize);
+	dgInt8* const atributes = (dgInt8*) dgMallocStack(width * height * sizeof (dgInt8));
+	m_callback (x0, z0, width, height, elevation, atributes, m_userData);
+
+	m_lock.Lock(true);
+	dgCollisionHeightField* const field = new (m_owner->GetAllocator()) dgCollisionHeightField (m_owner->m_instanceData->m_world, width, height, m_owner->m_diagonalMode, elevation, m_owner->m_elevationDataType, 
+																							   m_owner->m_verticalScale, atributes, m_owner->m_horizontalScale_x, m_owner->m_horizontalScale_z);
+	InsertTile (index, field);
+	m_lock.Unlock();
+
+	dgFreeStack(elevation);
+	dgFreeStack(atributes);
+}
+
+void dgCollisionHeightField::dgTileCache::InsertTile (dgInt32 index, dgCollisionHeightField* const field)
+{
+	while (m_lru.GetCount() >= m_maxResidentTiles) {
+		dgList<dgInt32>::dgListNode* const node = m_lru.GetLast();
+		dgTile& lastTile = m_tiles[node->GetInfo()];
+		lastTile.m_field->Release();
+		lastTile.m_field = NULL;
+		lastTile.m_lruNode = NULL;
+		lastTile.m_state = m_unloaded;
+		m_lru.Remove (node);
+	}
+
+	dgTile& tile = m_tiles[index];
+	const dgElevationRange& range = field->m_elevationPyramid[field->m_pyramidOffset[field->m_pyramidLevels - 1]];
+	tile.m_field = field;
+	tile.m_lruNode = m_lru.Addtop(index);
+	tile.m_minHeight = range.m_minHeight;
+	tile.m_maxHeight = range.m_maxHeight;
+	tile.m_state = m_resident;
+}
+
+dgCollisionHeightField* dgCollisionHeightField::dgTileCache::GetTile (dgInt32 tileX, dgInt32 tileZ)
+{
+	dgAssert ((tileX >= 0) && (tileX < m_tilesX));
+	dgAssert ((tileZ >= 0) && (tileZ < m_tilesZ));
+	const dgInt32 index = tileZ * m_tilesX + tileX;
+	dgTile& tile = m_tiles[index];
+
+	m_lock.Lock(true);
+	while (tile.m_state != m_resident) {
+		if (tile.m_state == m_loading) {
+			// some other thread is reading it
+			m_lock.Unlock();
+			dgThreadYield();
+		} else {
+			tile.m_state = m_loading;
+			m_lock.Unlock();
+			LoadTile (index);
+		}
+		m_lock.Lock(true);
+	}
+	m_lru.RotateToBegin (tile.m_lruNode);
+	dgCollisionHeightField* const field = tile.m_field;
+	field->AddRef();
+	m_lock.Unlock();
+	return field;
+}
+
+void dgCollisionHeightField::dgTileCache::ReleaseTile (dgCollisionHeightField* const tile)
+{
+	m_lock.Lock(true);
+	tile->Release();
+	m_lock.Unlock();
+}
+
+void dgCollisionHeightField::dgTileCache::Prefetch (dgInt32 tileX0, dgInt32 tileX1, dgInt32 tileZ0, dgInt32 tileZ1)
+{
+	#ifndef DG_USE_THREAD_EMULATION
+	const dgInt32 queueSize = m_tilesX * m_tilesZ + 1;
+	bool wakeUp = false;
+	bool startLoader = false;
+	m_lock.Lock(true);
+	for (dgInt32 z = dgMax (tileZ0, 0); z <= dgMin (tileZ1, m_tilesZ - 1); z ++) {
+		for (dgInt32 x = dgMax (tileX0, 0); x <= dgMin (tileX1, m_tilesX - 1); x ++) {
+			const dgInt32 index = z * m_tilesX + x;
+			dgTile& tile = m_tiles[index];
+			if (tile.m_state == m_resident) {
+				m_lru.RotateToBegin (tile.m_lruNode);
+			} else if (tile.m_state == m_unloaded) {
+				tile.m_state = m_queued;
+				if (!tile.m_inQueue) {
+					tile.m_inQueue = 1;
+					m_queue[m_queueTail] = index;
+					m_queueTail = (m_queueTail + 1) % queueSize;
+					dgAssert (m_queueTail != m_queueHead);
+				}
+				wakeUp = true;
+			}
+		}
+	}
+	if (wakeUp && !m_loaderStarted) {
+		m_loaderStarted = 1;
+		startLoader = true;
+	}
+	m_lock.Unlock();
+	if (startLoader) {
+		Init ();
+	}
+	if (wakeUp) {
+		m_semaphore.Release();
+	}
+	#endif
+}
+
 dgCollisionHeightField::dgCollisionHeightField(
 	dgWorld* const world, dgInt32 width, dgInt32 height, dgInt32 contructionMode, 
 	const void* const elevationMap, dgElevationType elevationDataType, dgFloat32 verticalScale, 
@@ -72,6 +292,8 @@ dgCollisionHeightField::dgCollisionHeightField(
 	,m_horizontalDisplacementScale_z(dgFloat32(1.0f))
 	,m_userRayCastCallback(NULL)
 	,m_elevationDataType(elevationDataType)
+	,m_tileCache(NULL)
+	,m_inPlace(false)
 {
 	m_rtti |= dgCollisionHeightField_RTTI;
 
@@ -232,25 +454,69 @@ dgCollisionHeightField::dgCollisionHeightField(
 
 	dgTree<void*, unsigned>::dgTreeNode* nodeData = world->m_perInstanceData.Find(DG_HIGHTFIELD_DATA_ID);
 	if (!nodeData) {
-		m_instanceData = (dgPerIntanceData*) new dgPerIntanceData();
-		m_instanceData->m_refCount = 0;
-		m_instanceData->m_world = world;
-		for (dgInt32 i = 0 ; i < DG_MAX_THREADS_HIVE_COUNT; i ++) {
-			m_instanceData->m_vertex[i] = NULL;
-			m_instanceData->m_vertexCount[i] = 0;
-			m_instanceData->m_vertex[i].SetAllocator(world->GetAllocator());
+		m_instanceData = (dgPerIntanceData*) new dgPerIntanceData(world);
+		for (dgInt32 i = 0; i < m_instanceData->m_threadCount; i ++) {
 			AllocateVertex(world, i);
 		}
 		nodeData = world->m_perInstanceData.Insert (m_instanceData, DG_HIGHTFIELD_DATA_ID);
 	}
 	m_instanceData = (dgPerIntanceData*) nodeData->GetInfo();
 
-	m_instanceData->m_refCount ++;
+	// the tile loader thread creates height fields too
+	dgAtomicExchangeAndAdd (&m_instanceData->m_refCount, 1);
 
+	BuildElevationPyramid();
 	CalculateAABB();
 	SetCollisionBBox(m_minBox, m_maxBox);
 }
 
+dgCollisionHeightField::dgCollisionHeightField(
+	dgWorld* const world, dgInt32 width, dgInt32 height, dgInt32 tileSize, dgInt32 maxResidentTiles, dgInt32 contructionMode, 
+	dgElevationType elevationDataType, dgFloat32 minElevation, dgFloat32 maxElevation, dgFloat32 verticalScale, 
+	dgFloat32 horizontalScale_x, dgFloat32 horizontalScale_z, dgCollisionHeightFieldTileCallback tileCallback, void* const tileUserData)
+	:dgCollisionMesh (world, m_heightField)
+	,m_width(width)
+	,m_height(height)
+	,m_diagonalMode (dgCollisionHeightFieldGridConstruction  (dgClamp (contructionMode, dgInt32 (m_normalDiagonals), dgInt32 (m_starInvertexDiagonals))))
+	,m_atributeMap(NULL)
+	,m_diagonals(NULL)
+	,m_elevationMap(NULL)
+	,m_horizontalDisplacement(NULL)
+	,m_verticalScale(verticalScale)
+	,m_horizontalScale_x(horizontalScale_x)
+	,m_horizontalScaleInv_x (dgFloat32 (1.0f) / m_horizontalScale_x)
+	,m_horizontalDisplacementScale_x(dgFloat32 (1.0f))
+	,m_horizontalScale_z(horizontalScale_z)
+	,m_horizontalScaleInv_z(dgFloat32(1.0f) / m_horizontalScale_z)
+	,m_horizontalDisplacementScale_z(dgFloat32(1.0f))
+	,m_userRayCastCallback(NULL)
+	,m_elevationDataType(elevationDataType)
+	,m_elevationPyramid(NULL)
+	,m_pyramidLevels(0)
+	,m_tileCache(NULL)
+	,m_inPlace(false)
+{
+	m_rtti |= dgCollisionHeightField_RTTI;
+
+	dgTree<void*, unsigned>::dgTreeNode* nodeData = world->m_perInstanceData.Find(DG_HIGHTFIELD_DATA_ID);
+	if (!nodeData) {
+		m_instanceData = (dgPerIntanceData*) new dgPerIntanceData(world);
+		for (dgInt32 i = 0; i < m_instanceData->m_threadCount; i ++) {
+			AllocateVertex(world, i);
+		}
+		nodeData = world->m_perInstanceData.Insert (m_instanceData, DG_HIGHTFIELD_DATA_ID);
+	}
+	m_instanceData = (dgPerIntanceData*) nodeData->GetInfo();
+
+	dgAtomicExchangeAndAdd (&m_instanceData->m_refCount, 1);
+
+	m_tileCache = new (world->GetAllocator()) dgTileCache (this, tileSize, maxResidentTiles, minElevation, maxElevation, tileCallback, tileUserData);
+
+	m_minBox = dgVector (dgFloat32 (dgFloat32 (0.0f)),                  minElevation * m_verticalScale, dgFloat32 (dgFloat32 (0.0f)),               dgFloat32 (0.0f)); 
+	m_maxBox = dgVector (dgFloat32 (m_width - 1) * m_horizontalScale_x, maxElevation * m_verticalScale, dgFloat32 (m_height-1) * m_horizontalScale_z, dgFloat32 (0.0f)); 
+	SetCollisionBBox(m_minBox, m_maxBox);
+}
+
 dgCollisionHeightField::dgCollisionHeightField (dgWorld* const world, dgDeserialize deserialization, void* const userData, dgInt32 revisionNumber)
 	:dgCollisionMesh (world, deserialization, userData, revisionNumber)
 {
@@ -260,6 +526,8 @@ dgCollisionHeightField::dgCollisionHeightField (dgWorld* const world, dgDeserial
 
 	m_userRayCastCallback = NULL;
 	m_horizontalDisplacement = NULL;
+	m_tileCache = NULL;
+	m_inPlace = false;
 	deserialization (userData, &m_width, sizeof (dgInt32));
 	deserialization (userData, &m_height, sizeof (dgInt32));
 	deserialization (userData, &m_diagonalMode, sizeof (dgInt32));
@@ -275,27 +543,22 @@ dgCollisionHeightField::dgCollisionHeightField (dgWorld* const world, dgDeserial
 	m_elevationDataType = dgElevationType (elevationDataType);
 
 	dgInt32 attibutePaddedMapSize = (m_width * m_height + 4) & -4; 
-	m_atributeMap = (dgInt8 *)dgMallocStack(attibutePaddedMapSize * sizeof (dgInt8));
-	m_diagonals = (dgInt8 *)dgMallocStack(attibutePaddedMapSize * sizeof (dgInt8));
-
 	switch (m_elevationDataType) 
 	{
 		case m_float32Bit:
 		{
-			m_elevationMap = dgMallocStack(m_width * m_height * sizeof (dgFloat32));
-			deserialization (userData, m_elevationMap, m_width * m_height * sizeof (dgFloat32));
+			m_elevationMap = dgDeserializeArray (deserialization, userData, m_width * m_height * sizeof (dgFloat32), m_inPlace);
 			break;
 		}
 
 		case m_unsigned16Bit:
 		{
-			m_elevationMap = dgMallocStack(m_width * m_height * sizeof (dgUnsigned16));
-			deserialization (userData, m_elevationMap, m_width * m_height * sizeof (dgUnsigned16));
+			m_elevationMap = dgDeserializeArray (deserialization, userData, m_width * m_height * sizeof (dgUnsigned16), m_inPlace);
 			break;
 		}
 	}
-	deserialization (userData, m_atributeMap, attibutePaddedMapSize * sizeof (dgInt8));
-	deserialization (userData, m_diagonals, attibutePaddedMapSize * sizeof (dgInt8));
+	m_atributeMap = (dgInt8*) dgDeserializeArray (deserialization, userData, attibutePaddedMapSize * sizeof (dgInt8), m_inPlace);
+	m_diagonals = (dgInt8*) dgDeserializeArray (deserialization, userData, attibutePaddedMapSize * sizeof (dgInt8), m_inPlace);
 
 	dgInt32 hasDisplacement = m_horizontalDisplacement ? 1 : 0;
 	deserialization (userData, &hasDisplacement, sizeof (hasDisplacement));
@@ -307,36 +570,42 @@ dgCollisionHeightField::dgCollisionHeightField (dgWorld* const world, dgDeserial
 	m_horizontalScaleInv_x = dgFloat32 (1.0f) / m_horizontalScale_x;
 	m_horizontalScaleInv_z = dgFloat32 (1.0f) / m_horizontalScale_z;
 
+	BuildElevationPyramid();
+
 	dgTree<void*, unsigned>::dgTreeNode* nodeData = world->m_perInstanceData.Find(DG_HIGHTFIELD_DATA_ID);
 	if (!nodeData) {
-		m_instanceData = (dgPerIntanceData*) new dgPerIntanceData();
-		m_instanceData->m_refCount = 0;
-		m_instanceData->m_world = world;
-		for (dgInt32 i = 0; i < DG_MAX_THREADS_HIVE_COUNT; i++) {
-			m_instanceData->m_vertex[i] = NULL;
-			m_instanceData->m_vertexCount[i] = 0;
-			m_instanceData->m_vertex[i].SetAllocator(world->GetAllocator());
+		m_instanceData = (dgPerIntanceData*) new dgPerIntanceData(world);
+		for (dgInt32 i = 0; i < m_instanceData->m_threadCount; i ++) {
 			AllocateVertex(world, i);
 		}
 		nodeData = world->m_perInstanceData.Insert(m_instanceData, DG_HIGHTFIELD_DATA_ID);
 	}
 	m_instanceData = (dgPerIntanceData*)nodeData->GetInfo();
 
-	m_instanceData->m_refCount ++;
+	dgAtomicExchangeAndAdd (&m_instanceData->m_refCount, 1);
 	SetCollisionBBox(m_minBox, m_maxBox);
 }
 
 dgCollisionHeightField::~dgCollisionHeightField(void)
 {
-	m_instanceData->m_refCount --;
-	if (!m_instanceData->m_refCount) {
+	if (m_tileCache) {
+		// the tiles share the per instance data, they go first
+		delete m_tileCache;
+	} else {
+		dgFreeStack(m_elevationPyramid);
+		// the maps of a height field loaded from an image belong to the image
+		if (!m_inPlace) {
+			dgFreeStack(m_elevationMap);
+			dgFreeStack(m_atributeMap);
+			dgFreeStack(m_diagonals);
+		}
+	}
+
+	if (dgAtomicExchangeAndAdd (&m_instanceData->m_refCount, -1) == 1) {
 		dgWorld* const world = m_instanceData->m_world;
 		delete m_instanceData;
 		world->m_perInstanceData.Remove(DG_HIGHTFIELD_DATA_ID);
 	}
-	dgFreeStack(m_elevationMap);
-	dgFreeStack(m_atributeMap);
-	dgFreeStack(m_diagonals);
 
 	if (m_horizontalDisplacement) {
 		dgFreeStack(m_horizontalDisplacement);
@@ -361,23 +630,57 @@ void dgCollisionHeightField::Serialize(dgSerialize callback, void* const userDat
 	callback (userData, &m_minBox.m_x, sizeof (dgVector)); 
 	callback (userData, &m_maxBox.m_x, sizeof (dgVector)); 
 
-	switch (m_elevationDataType) 
-	{
-		case m_float32Bit:
-		{
-			callback (userData, m_elevationMap, m_width * m_height * sizeof (dgFloat32));
-			break;
+	dgInt32 attibutePaddedMapSize = (m_width * m_height + 4) & -4; 
+	if (m_tileCache) {
+		// streaming height fields are saved as one resident height field, the maps are written one tile row at the time
+		const dgInt32 elementSize = (m_elevationDataType == m_float32Bit) ? sizeof (dgFloat32) : sizeof (dgUnsigned16);
+		const dgInt32 tileSize = m_tileCache->m_tileSize;
+		for (dgInt32 map = 0; map < 3; map ++) {
+			dgSerializeAlign (callback, userData);
+			for (dgInt32 z = 0; z < m_height; z ++) {
+				const dgInt32 tileZ = dgMin (z / tileSize, m_tileCache->m_tilesZ - 1);
+				for (dgInt32 tileX = 0; tileX < m_tileCache->m_tilesX; tileX ++) {
+					dgCollisionHeightField* const tile = m_tileCache->GetTile (tileX, tileZ);
+					// the last column of a tile is the first column of the next tile
+					const dgInt32 base = (z - tileZ * tileSize) * tile->m_width;
+					const dgInt32 count = (tileX == (m_tileCache->m_tilesX - 1)) ? tile->m_width : tile->m_width - 1;
+					switch (map) 
+					{
+						case 0:
+							callback (userData, &((dgInt8*)tile->m_elevationMap)[base * elementSize], count * elementSize);
+							break;
+						case 1:
+							callback (userData, &tile->m_atributeMap[base], count * sizeof (dgInt8));
+							break;
+						default:
+							callback (userData, &tile->m_diagonals[base], count * sizeof (dgInt8));
+					}
+					m_tileCache->ReleaseTile (tile);
+				}
+			}
+			if (map) {
+				const dgInt32 padding = 0;
+				callback (userData, &padding, (attibutePaddedMapSize - m_width * m_height) * sizeof (dgInt8));
+			}
 		}
-		case m_unsigned16Bit:
+	} else {
+		switch (m_elevationDataType) 
 		{
-			callback (userData, m_elevationMap, m_width * m_height * sizeof (dgUnsigned16));
-			break;
+			case m_float32Bit:
+			{
+				dgSerializeArray (callback, userData, m_elevationMap, m_width * m_height * sizeof (dgFloat32));
+				break;
+			}
+			case m_unsigned16Bit:
+			{
+				dgSerializeArray (callback, userData, m_elevationMap, m_width * m_height * sizeof (dgUnsigned16));
+				break;
+			}
 		}
-	}
 
-	dgInt32 attibutePaddedMapSize = (m_width * m_height + 4) & -4; 
-	callback (userData, m_atributeMap, attibutePaddedMapSize * sizeof (dgInt8));
-	callback (userData, m_diagonals, attibutePaddedMapSize * sizeof (dgInt8));
+		dgSerializeArray (callback, userData, m_atributeMap, attibutePaddedMapSize * sizeof (dgInt8));
+		dgSerializeArray (callback, userData, m_diagonals, attibutePaddedMapSize * sizeof (dgInt8));
+	}
 	
 	dgInt32 hasDisplacement = m_horizontalDisplacement ? 1 : 0;
 	callback (userData, &hasDisplacement, sizeof (hasDisplacement));
@@ -391,8 +694,26 @@ void dgCollisionHeightField::SetCollisionRayCastCallback (dgCollisionHeightField
 	m_userRayCastCallback = rayCastCallback;
 }
 
+void dgCollisionHeightField::SetTilePrefetchDistance (dgFloat32 distance)
+{
+	if (m_tileCache) {
+		m_tileCache->m_prefetchDistance = dgMax (distance, dgFloat32 (0.0f));
+	}
+}
+
+dgInt32 dgCollisionHeightField::GetResidentTileCount () const
+{
+	return m_tileCache ? m_tileCache->m_lru.GetCount() : 0;
+}
+
 void dgCollisionHeightField::SetHorizontalDisplacement (const dgUnsigned16* const displacemnet, dgFloat32 scale)
 {
+	// the tiles of streaming height fields do not have horizontal displacement
+	dgAssert (!m_tileCache);
+	if (m_tileCache) {
+		return;
+	}
+
 	if (m_horizontalDisplacement) {
 		dgFreeStack(m_horizontalDisplacement);
 		m_horizontalDisplacement = NULL;
@@ -465,32 +786,81 @@ DG_INLINE void dgCollisionHeightField::CalculateMinExtend3d(const dgVector& p0,
 
 void dgCollisionHeightField::CalculateAABB()
 {
-	dgFloat32 y0 = dgFloat32 (dgFloat32 (1.0e10f));
-	dgFloat32 y1 = dgFloat32 (-dgFloat32 (1.0e10f));
-	switch (m_elevationDataType) 
-	{
-		case m_float32Bit:
-		{
-			const dgFloat32* const elevation = (dgFloat32*)m_elevationMap;
-			for (dgInt32 i = 0; i < m_width * m_height; i ++) {
-				y0 = dgMin(y0, elevation[i]);
-				y1 = dgMax(y1, elevation[i]);
-			}
+	// the last level of the pyramid is the range of the whole height field
+	const dgElevationRange& range = m_elevationPyramid[m_pyramidOffset[m_pyramidLevels - 1]];
+	m_minBox = dgVector (dgFloat32 (dgFloat32 (0.0f)),                  range.m_minHeight * m_verticalScale, dgFloat32 (dgFloat32 (0.0f)),               dgFloat32 (0.0f)); 
+	m_maxBox = dgVector (dgFloat32 (m_width - 1) * m_horizontalScale_x, range.m_maxHeight * m_verticalScale, dgFloat32 (m_height-1) * m_horizontalScale_z, dgFloat32 (0.0f)); 
+}
+
+void dgCollisionHeightField::BuildElevationPyramid()
+{
+	dgInt32 count = 0;
+	dgInt32 width = (m_width + DG_HEIGHTFIELD_BLOCK_SIZE - 2) / DG_HEIGHTFIELD_BLOCK_SIZE;
+	dgInt32 height = (m_height + DG_HEIGHTFIELD_BLOCK_SIZE - 2) / DG_HEIGHTFIELD_BLOCK_SIZE;
+	m_pyramidLevels = 0;
+	while (1) {
+		dgAssert (m_pyramidLevels < DG_HEIGHTFIELD_MAX_LEVELS);
+		m_pyramidOffset[m_pyramidLevels] = count;
+		m_pyramidWidth[m_pyramidLevels] = width;
+		m_pyramidHeight[m_pyramidLevels] = height;
+		m_pyramidLevels ++;
+		count += width * height;
+		if ((width == 1) && (height == 1)) {
 			break;
 		}
+		width = (width + 1) >> 1;
+		height = (height + 1) >> 1;
+	}
+	m_elevationPyramid = (dgElevationRange*) dgMallocStack(count * sizeof (dgElevationRange));
+
+	// the blocks share the vertices of their borders, so that each block bounds all of its cells
+	dgElevationRange* range = m_elevationPyramid;
+	for (dgInt32 z = 0; z < m_pyramidHeight[0]; z ++) {
+		const dgInt32 z0 = z * DG_HEIGHTFIELD_BLOCK_SIZE;
+		const dgInt32 z1 = dgMin (z0 + DG_HEIGHTFIELD_BLOCK_SIZE, m_height - 1);
+		for (dgInt32 x = 0; x < m_pyramidWidth[0]; x ++) {
+			const dgInt32 x0 = x * DG_HEIGHTFIELD_BLOCK_SIZE;
+			const dgInt32 x1 = dgMin (x0 + DG_HEIGHTFIELD_BLOCK_SIZE, m_width - 1);
+			range->m_minHeight = dgFloat32 (1.0e10f);
+			range->m_maxHeight = dgFloat32 (-1.0e10f);
+			switch (m_elevationDataType) 
+			{
+				case m_float32Bit:
+				{
+					CalculateMinAndMaxElevation(x0, x1, z0, z1, (dgFloat32*)m_elevationMap, range->m_minHeight, range->m_maxHeight);
+					break;
+				}
 
-		case m_unsigned16Bit:
-		{
-			const dgUnsigned16* const elevation = (dgUnsigned16*)m_elevationMap;
-			for (dgInt32 i = 0; i < m_width * m_height; i ++) {
-				y0 = dgMin(y0, dgFloat32 (elevation[i]));
-				y1 = dgMax(y1, dgFloat32 (elevation[i]));
+				case m_unsigned16Bit:
+				{
+					CalculateMinAndMaxElevation(x0, x1, z0, z1, (dgUnsigned16*)m_elevationMap, range->m_minHeight, range->m_maxHeight);
+					break;
+				}
 			}
+			range ++;
 		}
 	}
 
-	m_minBox = dgVector (dgFloat32 (dgFloat32 (0.0f)),                  y0 * m_verticalScale, dgFloat32 (dgFloat32 (0.0f)),               dgFloat32 (0.0f)); 
-	m_maxBox = dgVector (dgFloat32 (m_width - 1) * m_horizontalScale_x, y1 * m_verticalScale, dgFloat32 (m_height-1) * m_horizontalScale_z, dgFloat32 (0.0f)); 
+	for (dgInt32 level = 1; level < m_pyramidLevels; level ++) {
+		const dgElevationRange* const children = &m_elevationPyramid[m_pyramidOffset[level - 1]];
+		const dgInt32 childWidth = m_pyramidWidth[level - 1];
+		const dgInt32 childHeight = m_pyramidHeight[level - 1];
+		for (dgInt32 z = 0; z < m_pyramidHeight[level]; z ++) {
+			for (dgInt32 x = 0; x < m_pyramidWidth[level]; x ++) {
+				range->m_minHeight = dgFloat32 (1.0e10f);
+				range->m_maxHeight = dgFloat32 (-1.0e10f);
+				for (dgInt32 j = z * 2; j < dgMin (z * 2 + 2, childHeight); j ++) {
+					for (dgInt32 i = x * 2; i < dgMin (x * 2 + 2, childWidth); i ++) {
+						const dgElevationRange& child = children[j * childWidth + i];
+						range->m_minHeight = dgMin (range->m_minHeight, child.m_minHeight);
+						range->m_maxHeight = dgMax (range->m_maxHeight, child.m_maxHeight);
+					}
+				}
+				range ++;
+			}
+		}
+	}
+	dgAssert ((range - m_elevationPyramid) == count);
 }
 
 void dgCollisionHeightField::GetCollisionInfo(dgCollisionInfo* const info) const
@@ -610,101 +980,285 @@ dgFloat32 dgCollisionHeightField::RayCastCell (const dgFastRayTest& ray, dgInt32
 	return t;
 }
 
-dgFloat32 dgCollisionHeightField::RayCast (const dgVector& q0, const dgVector& q1, dgFloat32 maxT, dgContactPoint& contactOut, const dgBody* const body, void* const userData, OnRayPrecastAction preFilter) const
+dgFloat32 dgCollisionHeightField::RayCastBlock (const dgFastRayTest& ray, dgInt32 blockX, dgInt32 blockZ, dgFloat32 entryT, dgFloat32 maxT, dgVector& normalOut, dgInt32& xIndexOut, dgInt32& zIndexOut) const
+{
+	// cells of the block
+	const dgInt32 x0 = blockX * DG_HEIGHTFIELD_BLOCK_SIZE;
+	const dgInt32 z0 = blockZ * DG_HEIGHTFIELD_BLOCK_SIZE;
+	const dgInt32 x1 = dgMin (x0 + DG_HEIGHTFIELD_BLOCK_SIZE, m_width - 1) - 1;
+	const dgInt32 z1 = dgMin (z0 + DG_HEIGHTFIELD_BLOCK_SIZE, m_height - 1) - 1;
+
+	const dgVector& p0 = ray.m_p0;
+	const dgVector& dp = ray.m_diff;
+	const dgVector p (p0 + dp.Scale4 (dgMax (entryT, dgFloat32 (0.0f))));
+
+	// the entry point can be a little outside the block because of the padding, 
+	// clamping it can only add a few cells that the ray does not cross
+	dgInt32 xIndex0 = dgClamp (dgFastInt (p.m_x * m_horizontalScaleInv_x), x0, x1);
+	dgInt32 zIndex0 = dgClamp (dgFastInt (p.m_z * m_horizontalScaleInv_z), z0, z1);
+
+	// 2d dda line algorithm in the parameter space of the ray
+	dgInt32 xInc;
+	dgFloat32 tx;
+	dgFloat32 stepX;
+	if (dp.m_x > dgFloat32 (0.0f)) {
+		xInc = 1;
+		dgFloat32 val = dgFloat32 (1.0f) / dp.m_x;
+		stepX = m_horizontalScale_x * val;
+		tx = (m_horizontalScale_x * (xIndex0 + dgFloat32 (1.0f)) - p0.m_x) * val;
+	} else if (dp.m_x < dgFloat32 (0.0f)) {
+		xInc = -1;
+		dgFloat32 val = -dgFloat32 (1.0f) / dp.m_x;
+		stepX = m_horizontalScale_x * val;
+		tx = -(m_horizontalScale_x * xIndex0 - p0.m_x) * val;
+	} else {
+		xInc = 0;
+		stepX = dgFloat32 (0.0f);
+		tx = dgFloat32 (1.0e10f);
+	}
+
+	dgInt32 zInc;
+	dgFloat32 tz;
+	dgFloat32 stepZ;
+	if (dp.m_z > dgFloat32 (0.0f)) {
+		zInc = 1;
+		dgFloat32 val = dgFloat32 (1.0f) / dp.m_z;
+		stepZ = m_horizontalScale_z * val;
+		tz = (m_horizontalScale_z * (zIndex0 + dgFloat32 (1.0f)) - p0.m_z) * val;
+	} else if (dp.m_z < dgFloat32 (0.0f)) {
+		zInc = -1;
+		dgFloat32 val = -dgFloat32 (1.0f) / dp.m_z;
+		stepZ = m_horizontalScale_z * val;
+		tz = -(m_horizontalScale_z * zIndex0 - p0.m_z) * val;
+	} else {
+		zInc = 0;
+		stepZ = dgFloat32 (0.0f);
+		tz = dgFloat32 (1.0e10f);
+	}
+
+	while (1) {
+		dgFloat32 t = RayCastCell (ray, xIndex0, zIndex0, normalOut, maxT);
+		if (t < maxT) {
+			xIndexOut = xIndex0;
+			zIndexOut = zIndex0;
+			return t;
+		}
+
+		if (tx < tz) {
+			xIndex0 += xInc;
+			if ((tx >= maxT) || (xIndex0 < x0) || (xIndex0 > x1)) {
+				break;
+			}
+			tx += stepX;
+		} else {
+			zIndex0 += zInc;
+			if ((tz >= maxT) || (zIndex0 < z0) || (zIndex0 > z1)) {
+				break;
+			}
+			tz += stepZ;
+		}
+	}
+	return dgFloat32 (1.2f);
+}
+
+dgFloat32 dgCollisionHeightField::RayCastTiles (const dgVector& q0, const dgVector& q1, dgFloat32 maxT, dgContactPoint& contactOut, const dgBody* const body, void* const userData, OnRayPrecastAction preFilter) const
 {
 	dgVector boxP0;
 	dgVector boxP1;
-
-	// calculate the ray bounding box
 	CalculateMinExtend2d (q0, q1, boxP0, boxP1);
 
 	dgVector p0 (q0);
 	dgVector p1 (q1);
+	if (!dgRayBoxClip (p0, p1, boxP0, boxP1)) { 
+		return dgFloat32 (1.2f);
+	}
 
-	// clip the line against the bounding box
-	if (dgRayBoxClip (p0, p1, boxP0, boxP1)) { 
-		dgVector dp (p1 - p0);
-		dgVector normalOut (dgFloat32 (0.0f), dgFloat32 (0.0f), dgFloat32 (0.0f), dgFloat32 (0.0f));
-
-		dgFloat32 scale_x = m_horizontalScale_x;
-		dgFloat32 invScale_x = m_horizontalScaleInv_x;
-		dgFloat32 scale_z = m_horizontalScale_z;
-		dgFloat32 invScale_z = m_horizontalScaleInv_z;
-		dgInt32 ix0 = dgFastInt (p0.m_x * invScale_x);
-		dgInt32 iz0 = dgFastInt (p0.m_z * invScale_z);
-
-		// implement a 3ddda line algorithm 
-		dgInt32 xInc;
-		dgFloat32 tx;
-		dgFloat32 stepX;
-		if (dp.m_x > dgFloat32 (0.0f)) {
-			xInc = 1;
-			dgFloat32 val = dgFloat32 (1.0f) / dp.m_x;
-			stepX = scale_x * val;
-			tx = (scale_x * (ix0 + dgFloat32 (1.0f)) - p0.m_x) * val;
-		} else if (dp.m_x < dgFloat32 (0.0f)) {
-			xInc = -1;
-			dgFloat32 val = -dgFloat32 (1.0f) / dp.m_x;
-			stepX = scale_x * val;
-			tx = -(scale_x * ix0 - p0.m_x) * val;
-		} else {
-			xInc = 0;
-			stepX = dgFloat32 (0.0f);
-			tx = dgFloat32 (1.0e10f);
-		}
-
-		dgInt32 zInc;
-		dgFloat32 tz;
-		dgFloat32 stepZ;
-		if (dp.m_z > dgFloat32 (0.0f)) {
-			zInc = 1;
-			dgFloat32 val = dgFloat32 (1.0f) / dp.m_z;
-			stepZ = scale_z * val;
-			tz = (scale_z * (iz0 + dgFloat32 (1.0f)) - p0.m_z) * val;
-		} else if (dp.m_z < dgFloat32 (0.0f)) {
-			zInc = -1;
-			dgFloat32 val = -dgFloat32 (1.0f) / dp.m_z;
-			stepZ = scale_z * val;
-			tz = -(scale_z * iz0 - p0.m_z) * val;
-		} else {
-			zInc = 0;
-			stepZ = dgFloat32 (0.0f);
-			tz = dgFloat32 (1.0e10f);
-		}
+	// step the tiles along the ray, the tiles do not overlap so the first tile with a hit has the closest hit
+	const dgInt32 tileSize = m_tileCache->m_tileSize;
+	const dgInt32 tilesX = m_tileCache->m_tilesX;
+	const dgInt32 tilesZ = m_tileCache->m_tilesZ;
+	const dgFloat32 tileSize_x = dgFloat32 (tileSize) * m_horizontalScale_x;
+	const dgFloat32 tileSize_z = dgFloat32 (tileSize) * m_horizontalScale_z;
+	const dgVector dp (q1 - q0);
+	dgInt32 tileX = dgClamp (dgFastInt (p0.m_x / tileSize_x), 0, tilesX - 1);
+	dgInt32 tileZ = dgClamp (dgFastInt (p0.m_z / tileSize_z), 0, tilesZ - 1);
+
+	dgInt32 xInc;
+	dgFloat32 tx;
+	dgFloat32 stepX;
+	if (dp.m_x > dgFloat32 (0.0f)) {
+		xInc = 1;
+		dgFloat32 val = dgFloat32 (1.0f) / dp.m_x;
+		stepX = tileSize_x * val;
+		tx = (tileSize_x * (tileX + dgFloat32 (1.0f)) - q0.m_x) * val;
+	} else if (dp.m_x < dgFloat32 (0.0f)) {
+		xInc = -1;
+		dgFloat32 val = -dgFloat32 (1.0f) / dp.m_x;
+		stepX = tileSize_x * val;
+		tx = -(tileSize_x * tileX - q0.m_x) * val;
+	} else {
+		xInc = 0;
+		stepX = dgFloat32 (0.0f);
+		tx = dgFloat32 (1.0e10f);
+	}
 
-		dgFloat32 txAcc = tx;
-		dgFloat32 tzAcc = tz;
-		dgInt32 xIndex0 = ix0;
-		dgInt32 zIndex0 = iz0;
-		dgFastRayTest ray (q0, q1); 
+	dgInt32 zInc;
+	dgFloat32 tz;
+	dgFloat32 stepZ;
+	if (dp.m_z > dgFloat32 (0.0f)) {
+		zInc = 1;
+		dgFloat32 val = dgFloat32 (1.0f) / dp.m_z;
+		stepZ = tileSize_z * val;
+		tz = (tileSize_z * (tileZ + dgFloat32 (1.0f)) - q0.m_z) * val;
+	} else if (dp.m_z < dgFloat32 (0.0f)) {
+		zInc = -1;
+		dgFloat32 val = -dgFloat32 (1.0f) / dp.m_z;
+		stepZ = tileSize_z * val;
+		tz = -(tileSize_z * tileZ - q0.m_z) * val;
+	} else {
+		zInc = 0;
+		stepZ = dgFloat32 (0.0f);
+		tz = dgFloat32 (1.0e10f);
+	}
 
-		// for each cell touched by the line
-		do {
-			dgFloat32 t = RayCastCell (ray, xIndex0, zIndex0, normalOut, maxT);
+	dgFastRayTest ray (q0, q1); 
+	while (1) {
+		// tiles that were never read are bounded by the elevation range of the whole map
+		const dgTileCache::dgTile& tileRange = m_tileCache->m_tiles[tileZ * tilesX + tileX];
+		const dgVector origin (dgFloat32 (tileX) * tileSize_x, dgFloat32 (0.0f), dgFloat32 (tileZ) * tileSize_z, dgFloat32 (0.0f));
+		const dgVector minBox (origin.m_x, tileRange.m_minHeight * m_verticalScale, origin.m_z, dgFloat32 (0.0f));
+		const dgVector maxBox (dgMin (origin.m_x + tileSize_x, m_maxBox.m_x), tileRange.m_maxHeight * m_verticalScale, dgMin (origin.m_z + tileSize_z, m_maxBox.m_z), dgFloat32 (0.0f));
+		if (ray.BoxIntersect (minBox - m_padding, maxBox + m_padding) < maxT) {
+			dgCollisionHeightField* const tile = m_tileCache->GetTile (tileX, tileZ);
+			dgFloat32 t = tile->RayCast (q0 - origin, q1 - origin, maxT, contactOut, body, userData, preFilter);
+			m_tileCache->ReleaseTile (tile);
 			if (t < maxT) {
-				// bail out at the first intersection and copy the data into the descriptor
-				contactOut.m_normal = normalOut.Scale3 (dgRsqrt (normalOut.DotProduct3(normalOut)));
-				contactOut.m_shapeId0 = m_atributeMap[zIndex0 * m_width + xIndex0];
-				contactOut.m_shapeId1 = m_atributeMap[zIndex0 * m_width + xIndex0];
-
 				if (m_userRayCastCallback) {
+					const dgVector hitPoint (q0 + dp.Scale4 (t));
+					const dgInt32 xIndex = dgClamp (dgFastInt (hitPoint.m_x * m_horizontalScaleInv_x), 0, m_width - 2);
+					const dgInt32 zIndex = dgClamp (dgFastInt (hitPoint.m_z * m_horizontalScaleInv_z), 0, m_height - 2);
 					dgVector normal (body->GetCollision()->GetGlobalMatrix().RotateVector (contactOut.m_normal));
-					m_userRayCastCallback (body, this, t, xIndex0, zIndex0, &normal, dgInt32 (contactOut.m_shapeId0), userData);
+					m_userRayCastCallback (body, this, t, xIndex, zIndex, &normal, dgInt32 (contactOut.m_shapeId0), userData);
 				}
-
 				return t;
 			}
+		}
 
-			if (txAcc < tzAcc) {
-				xIndex0 += xInc;
-				tx = txAcc;
-				txAcc += stepX;
-			} else {
-				zIndex0 += zInc;
-				tz = tzAcc;
-				tzAcc += stepZ;
+		if (tx < tz) {
+			tileX += xInc;
+			if ((tx >= maxT) || (tileX < 0) || (tileX >= tilesX)) {
+				break;
 			}
-		} while ((tx <= dgFloat32 (1.0f)) || (tz <= dgFloat32 (1.0f)));
+			tx += stepX;
+		} else {
+			tileZ += zInc;
+			if ((tz >= maxT) || (tileZ < 0) || (tileZ >= tilesZ)) {
+				break;
+			}
+			tz += stepZ;
+		}
+	}
+	return dgFloat32 (1.2f);
+}
+
+dgFloat32 dgCollisionHeightField::RayCast (const dgVector& q0, const dgVector& q1, dgFloat32 maxT, dgContactPoint& contactOut, const dgBody* const body, void* const userData, OnRayPrecastAction preFilter) const
+{
+	dgVector boxP0;
+	dgVector boxP1;
+
+	if (m_tileCache) {
+		return RayCastTiles (q0, q1, maxT, contactOut, body, userData, preFilter);
+	}
+
+	// calculate the ray bounding box
+	CalculateMinExtend2d (q0, q1, boxP0, boxP1);
+
+	dgVector p0 (q0);
+	dgVector p1 (q1);
+
+	// clip the line against the bounding box
+	if (!dgRayBoxClip (p0, p1, boxP0, boxP1)) { 
+		return dgFloat32 (1.2f);
+	}
+
+	// walk the elevation pyramid front to back, and only step the cells of the blocks whose elevation range the ray crosses
+	dgFastRayTest ray (q0, q1); 
+	dgInt32 stack = 1;
+	dgInt32 stackLevel[DG_HEIGHTFIELD_MAX_LEVELS * 4];
+	dgInt32 stackX[DG_HEIGHTFIELD_MAX_LEVELS * 4];
+	dgInt32 stackZ[DG_HEIGHTFIELD_MAX_LEVELS * 4];
+	dgFloat32 distance[DG_HEIGHTFIELD_MAX_LEVELS * 4];
+	stackLevel[0] = m_pyramidLevels - 1;
+	stackX[0] = 0;
+	stackZ[0] = 0;
+	distance[0] = dgFloat32 (0.0f);
+
+	dgInt32 xIndex = -1;
+	dgInt32 zIndex = -1;
+	dgVector normalOut (dgFloat32 (0.0f));
+	while (stack) {
+		stack --;
+		if (distance[stack] >= maxT) {
+			// the stack is sorted, all other blocks are farther than the hit
+			break;
+		}
+		const dgInt32 level = stackLevel[stack];
+		const dgInt32 blockX = stackX[stack];
+		const dgInt32 blockZ = stackZ[stack];
+		if (!level) {
+			dgInt32 x;
+			dgInt32 z;
+			dgVector normal;
+			dgFloat32 t = RayCastBlock (ray, blockX, blockZ, distance[stack], maxT, normal, x, z);
+			if (t < maxT) {
+				maxT = t;
+				xIndex = x;
+				zIndex = z;
+				normalOut = normal;
+			}
+		} else {
+			const dgInt32 childLevel = level - 1;
+			const dgInt32 size = DG_HEIGHTFIELD_BLOCK_SIZE << childLevel;
+			const dgInt32 childWidth = m_pyramidWidth[childLevel];
+			const dgInt32 childHeight = m_pyramidHeight[childLevel];
+			const dgElevationRange* const children = &m_elevationPyramid[m_pyramidOffset[childLevel]];
+			for (dgInt32 j = blockZ * 2; j < dgMin (blockZ * 2 + 2, childHeight); j ++) {
+				for (dgInt32 i = blockX * 2; i < dgMin (blockX * 2 + 2, childWidth); i ++) {
+					const dgElevationRange& range = children[j * childWidth + i];
+					const dgVector minBox (dgFloat32 (i * size) * m_horizontalScale_x, range.m_minHeight * m_verticalScale, dgFloat32 (j * size) * m_horizontalScale_z, dgFloat32 (0.0f));
+					const dgVector maxBox (dgFloat32 (dgMin ((i + 1) * size, m_width - 1)) * m_horizontalScale_x, range.m_maxHeight * m_verticalScale, dgFloat32 (dgMin ((j + 1) * size, m_height - 1)) * m_horizontalScale_z, dgFloat32 (0.0f));
+					const dgFloat32 dist = ray.BoxIntersect (minBox - m_padding, maxBox + m_padding);
+					if (dist < maxT) {
+						dgInt32 k = stack;
+						for ( ; k && (distance[k - 1] < dist); k --) {
+							stackLevel[k] = stackLevel[k - 1];
+							stackX[k] = stackX[k - 1];
+							stackZ[k] = stackZ[k - 1];
+							distance[k] = distance[k - 1];
+						}
+						stackLevel[k] = childLevel;
+						stackX[k] = i;
+						stackZ[k] = j;
+						distance[k] = dist;
+						stack ++;
+						dgAssert (stack < dgInt32 (sizeof (distance) / sizeof (distance[0])));
+					}
+				}
+			}
+		}
+	}
+
+	if (xIndex >= 0) {
+		// copy the data of the closest intersection into the descriptor
+		contactOut.m_normal = normalOut.Scale3 (dgRsqrt (normalOut.DotProduct3(normalOut)));
+		contactOut.m_shapeId0 = m_atributeMap[zIndex * m_width + xIndex];
+		contactOut.m_shapeId1 = m_atributeMap[zIndex * m_width + xIndex];
+
+		if (m_userRayCastCallback) {
+			dgVector normal (body->GetCollision()->GetGlobalMatrix().RotateVector (contactOut.m_normal));
+			m_userRayCastCallback (body, this, maxT, xIndex, zIndex, &normal, dgInt32 (contactOut.m_shapeId0), userData);
+		}
+		return maxT;
 	}
 
 	// if no cell was hit, return a large value
@@ -727,6 +1281,12 @@ struct dgCollisionHeightFieldShowPolyContext
 
 dgVector dgCollisionHeightField::SupportVertex (const dgVector& dir, dgInt32* const vertexIndex) const
 {
+	if (m_tileCache) {
+		// do not read the whole map, the corners of the box are close enough
+		const dgVector mask (dir > dgVector (dgFloat32 (0.0f)));
+		return ((m_maxBox & mask) | m_minBox.AndNot(mask)) & dgVector::m_triplexMask;
+	}
+
 	dgFloat32 maxProject (dgFloat32 (-1.e-20f));
 	dgVector support (dgFloat32 (0.0f));
 	if (m_elevationDataType == m_float32Bit)  {
@@ -770,6 +1330,23 @@ dgVector dgCollisionHeightField::SupportVertexSpecial (const dgVector& dir, dgIn
 
 void dgCollisionHeightField::DebugCollision (const dgMatrix& matrix, dgCollision::OnDebugCollisionMeshCallback callback, void* const userData) const
 {
+	if (m_tileCache) {
+		// only show the resident tiles
+		const dgInt32 tileSize = m_tileCache->m_tileSize;
+		for (dgInt32 i = 0; i < m_tileCache->m_tilesX * m_tileCache->m_tilesZ; i ++) {
+			if (m_tileCache->m_tiles[i].m_state == dgTileCache::m_resident) {
+				const dgInt32 tileX = i % m_tileCache->m_tilesX;
+				const dgInt32 tileZ = i / m_tileCache->m_tilesX;
+				dgCollisionHeightField* const tile = m_tileCache->GetTile (tileX, tileZ);
+				dgMatrix tileMatrix (matrix);
+				tileMatrix.m_posit = matrix.TransformVector (dgVector (dgFloat32 (tileX * tileSize) * m_horizontalScale_x, dgFloat32 (0.0f), dgFloat32 (tileZ * tileSize) * m_horizontalScale_z, dgFloat32 (0.0f)));
+				tile->DebugCollision (tileMatrix, callback, userData);
+				m_tileCache->ReleaseTile (tile);
+			}
+		}
+		return;
+	}
+
 	dgVector points[4];
 
 	dgInt32 base = 0;
@@ -897,7 +1474,7 @@ void dgCollisionHeightField::CalculateMinAndMaxElevation(dgInt32 x0, dgInt32 x1,
 	}
 }
 
-void dgCollisionHeightField::CalculateMinAndMaxElevation(dgInt32 x0, dgInt32 x1, dgInt32 z0, dgInt32 z1, const dgInt16* const elevation, dgFloat32& minHeight, dgFloat32& maxHeight) const
+void dgCollisionHeightField::CalculateMinAndMaxElevation(dgInt32 x0, dgInt32 x1, dgInt32 z0, dgInt32 z1, const dgUnsigned16* const elevation, dgFloat32& minHeight, dgFloat32& maxHeight) const
 {
 	dgInt32 base = z0 * m_width;
 	for (dgInt32 z = z0; z <= z1; z++) {
@@ -910,6 +1487,111 @@ void dgCollisionHeightField::CalculateMinAndMaxElevation(dgInt32 x0, dgInt32 x1,
 	}
 }
 
+void dgCollisionHeightField::CalculateMinAndMaxElevation(dgInt32 level, dgInt32 blockX, dgInt32 blockZ, dgInt32 x0, dgInt32 x1, dgInt32 z0, dgInt32 z1, dgFloat32& minHeight, dgFloat32& maxHeight) const
+{
+	const dgInt32 size = DG_HEIGHTFIELD_BLOCK_SIZE << level;
+	const dgInt32 blockX0 = blockX * size;
+	const dgInt32 blockZ0 = blockZ * size;
+	const dgInt32 blockX1 = dgMin (blockX0 + size, m_width - 1);
+	const dgInt32 blockZ1 = dgMin (blockZ0 + size, m_height - 1);
+	if ((blockX0 > x1) || (blockX1 < x0) || (blockZ0 > z1) || (blockZ1 < z0)) {
+		return;
+	}
+
+	// nothing to do when the block can not widen the range found so far
+	const dgElevationRange& range = m_elevationPyramid[m_pyramidOffset[level] + blockZ * m_pyramidWidth[level] + blockX];
+	if ((range.m_minHeight >= minHeight) && (range.m_maxHeight <= maxHeight)) {
+		return;
+	}
+
+	if ((blockX0 >= x0) && (blockX1 <= x1) && (blockZ0 >= z0) && (blockZ1 <= z1)) {
+		minHeight = dgMin (minHeight, range.m_minHeight);
+		maxHeight = dgMax (maxHeight, range.m_maxHeight);
+	} else if (!level) {
+		const dgInt32 i0 = dgMax (x0, blockX0);
+		const dgInt32 i1 = dgMin (x1, blockX1);
+		const dgInt32 j0 = dgMax (z0, blockZ0);
+		const dgInt32 j1 = dgMin (z1, blockZ1);
+		switch (m_elevationDataType) 
+		{
+			case m_float32Bit:
+			{
+				CalculateMinAndMaxElevation(i0, i1, j0, j1, (dgFloat32*)m_elevationMap, minHeight, maxHeight);
+				break;
+			}
+
+			case m_unsigned16Bit:
+			{
+				CalculateMinAndMaxElevation(i0, i1, j0, j1, (dgUnsigned16*)m_elevationMap, minHeight, maxHeight);
+				break;
+			}
+		}
+	} else {
+		const dgInt32 childWidth = m_pyramidWidth[level - 1];
+		const dgInt32 childHeight = m_pyramidHeight[level - 1];
+		for (dgInt32 j = blockZ * 2; j < dgMin (blockZ * 2 + 2, childHeight); j ++) {
+			for (dgInt32 i = blockX * 2; i < dgMin (blockX * 2 + 2, childWidth); i ++) {
+				CalculateMinAndMaxElevation(level - 1, i, j, x0, x1, z0, z1, minHeight, maxHeight);
+			}
+		}
+	}
+}
+
+void dgCollisionHeightField::CalculateMinAndMaxElevation(dgInt32 x0, dgInt32 x1, dgInt32 z0, dgInt32 z1, dgFloat32& minHeight, dgFloat32& maxHeight) const
+{
+	x0 = dgMax (x0, 0);
+	z0 = dgMax (z0, 0);
+	x1 = dgMin (x1, m_width - 1);
+	z1 = dgMin (z1, m_height - 1);
+	if (m_tileCache) {
+		// use the range of the covered tiles, and only read the tiles that are partially covered
+		const dgInt32 tileSize = m_tileCache->m_tileSize;
+		const dgInt32 tileX1 = dgMin (x1 / tileSize, m_tileCache->m_tilesX - 1);
+		const dgInt32 tileZ1 = dgMin (z1 / tileSize, m_tileCache->m_tilesZ - 1);
+		for (dgInt32 tileZ = dgMin (z0 / tileSize, tileZ1); tileZ <= tileZ1; tileZ ++) {
+			const dgInt32 originZ = tileZ * tileSize;
+			const dgInt32 tileHeight = dgMin (tileSize, m_height - 1 - originZ);
+			for (dgInt32 tileX = dgMin (x0 / tileSize, tileX1); tileX <= tileX1; tileX ++) {
+				const dgInt32 originX = tileX * tileSize;
+				const dgInt32 tileWidth = dgMin (tileSize, m_width - 1 - originX);
+				const dgTileCache::dgTile& tileRange = m_tileCache->m_tiles[tileZ * m_tileCache->m_tilesX + tileX];
+				if ((tileRange.m_minHeight < minHeight) || (tileRange.m_maxHeight > maxHeight)) {
+					const dgInt32 i0 = dgMax (x0 - originX, 0);
+					const dgInt32 i1 = dgMin (x1 - originX, tileWidth);
+					const dgInt32 j0 = dgMax (z0 - originZ, 0);
+					const dgInt32 j1 = dgMin (z1 - originZ, tileHeight);
+					if ((i0 == 0) && (j0 == 0) && (i1 == tileWidth) && (j1 == tileHeight)) {
+						minHeight = dgMin (minHeight, tileRange.m_minHeight);
+						maxHeight = dgMax (maxHeight, tileRange.m_maxHeight);
+					} else {
+						dgCollisionHeightField* const tile = m_tileCache->GetTile (tileX, tileZ);
+						tile->CalculateMinAndMaxElevation(i0, i1, j0, j1, minHeight, maxHeight);
+						m_tileCache->ReleaseTile (tile);
+					}
+				}
+			}
+		}
+	} else if (((x1 - x0) <= DG_HEIGHTFIELD_BLOCK_SIZE) && ((z1 - z0) <= DG_HEIGHTFIELD_BLOCK_SIZE)) {
+		// small boxes are faster to scan than to walk the pyramid
+		switch (m_elevationDataType) 
+		{
+			case m_float32Bit:
+			{
+				CalculateMinAndMaxElevation(x0, x1, z0, z1, (dgFloat32*)m_elevationMap, minHeight, maxHeight);
+				break;
+			}
+
+			case m_unsigned16Bit:
+			{
+				CalculateMinAndMaxElevation(x0, x1, z0, z1, (dgUnsigned16*)m_elevationMap, minHeight, maxHeight);
+				break;
+			}
+		}
+	} else {
+		CalculateMinAndMaxElevation(m_pyramidLevels - 1, 0, 0, x0, x1, z0, z1, minHeight, maxHeight);
+	}
+}
+
 
 void dgCollisionHeightField::GetLocalAABB (const dgVector& q0, const dgVector& q1, dgVector& boxP0, dgVector& boxP1) const
 {
@@ -931,21 +1613,7 @@ void dgCollisionHeightField::GetLocalAABB (const dgVector& q0, const dgVector& q
 
 	dgFloat32 minHeight = dgFloat32 (1.0e10f);
 	dgFloat32 maxHeight = dgFloat32 (-1.0e10f);
-	//dgInt32 base = z0 * m_width;
-	switch (m_elevationDataType) 
-	{
-		case m_float32Bit:
-		{
-			CalculateMinAndMaxElevation(x0, x1, z0, z1, (dgFloat32*)m_elevationMap, minHeight, maxHeight);
-			break;
-		}
-
-		case m_unsigned16Bit:
-		{
-			CalculateMinAndMaxElevation(x0, x1, z0, z1, (dgInt16*)m_elevationMap, minHeight, maxHeight);
-			break;
-		}
-	}
+	CalculateMinAndMaxElevation(x0, x1, z0, z1, minHeight, maxHeight);
 
 	boxP0.m_y = m_verticalScale * minHeight;
 	boxP1.m_y = m_verticalScale * maxHeight;
@@ -968,6 +1636,55 @@ void dgCollisionHeightField::AddDisplacement (dgVector* const vertex, dgInt32 x0
 	}
 }
 
+void dgCollisionHeightField::GetTiledVertexWindow (dgVector* const vertex, dgInt8* const atributes, dgInt8* const diagonals, dgInt32 x0, dgInt32 x1, dgInt32 z0, dgInt32 z1) const
+{
+	// vertices x0, z0 to x1, z1 and the cells in between, in the same layout as a window of a resident height field
+	const dgInt32 tileSize = m_tileCache->m_tileSize;
+	const dgInt32 vertexStride = x1 - x0 + 1;
+	const dgInt32 cellStride = x1 - x0;
+	const dgInt32 tileX1 = dgMin (x1 / tileSize, m_tileCache->m_tilesX - 1);
+	const dgInt32 tileZ1 = dgMin (z1 / tileSize, m_tileCache->m_tilesZ - 1);
+	for (dgInt32 tileZ = dgMin (z0 / tileSize, tileZ1); tileZ <= tileZ1; tileZ ++) {
+		const dgInt32 originZ = tileZ * tileSize;
+		for (dgInt32 tileX = dgMin (x0 / tileSize, tileX1); tileX <= tileX1; tileX ++) {
+			const dgInt32 originX = tileX * tileSize;
+			dgCollisionHeightField* const tile = m_tileCache->GetTile (tileX, tileZ);
+			const dgInt32 tileWidth = tile->m_width;
+
+			const dgInt32 i0 = dgMax (x0, originX);
+			const dgInt32 i1 = dgMin (x1, originX + tileWidth - 1);
+			const dgInt32 j0 = dgMax (z0, originZ);
+			const dgInt32 j1 = dgMin (z1, originZ + tile->m_height - 1);
+			for (dgInt32 z = j0; z <= j1; z ++) {
+				const dgFloat32 zVal = m_horizontalScale_z * z;
+				const dgInt32 tileBase = (z - originZ) * tileWidth - originX;
+				dgVector* const row = &vertex[(z - z0) * vertexStride - x0];
+				if (m_elevationDataType == m_float32Bit) {
+					const dgFloat32* const elevation = (dgFloat32*)tile->m_elevationMap;
+					for (dgInt32 x = i0; x <= i1; x ++) {
+						row[x] = dgVector(m_horizontalScale_x * x, m_verticalScale * elevation[tileBase + x], zVal, dgFloat32 (0.0f));
+					}
+				} else {
+					const dgUnsigned16* const elevation = (dgUnsigned16*)tile->m_elevationMap;
+					for (dgInt32 x = i0; x <= i1; x ++) {
+						row[x] = dgVector(m_horizontalScale_x * x, m_verticalScale * dgFloat32 (elevation[tileBase + x]), zVal, dgFloat32 (0.0f));
+					}
+				}
+
+				// the last row and column of vertices have no cells
+				if ((z < z1) && (z < (originZ + tile->m_height - 1))) {
+					const dgInt32 cellBase = (z - z0) * cellStride - x0;
+					for (dgInt32 x = i0; x < dgMin (x1, originX + tileWidth - 1); x ++) {
+						atributes[cellBase + x] = tile->m_atributeMap[tileBase + x];
+						diagonals[cellBase + x] = tile->m_diagonals[tileBase + x];
+					}
+				}
+			}
+			m_tileCache->ReleaseTile (tile);
+		}
+	}
+}
+
 void dgCollisionHeightField::GetCollidingFaces (dgPolygonMeshDesc* const data) const
 {
 	dgVector boxP0;
@@ -996,24 +1713,19 @@ void dgCollisionHeightField::GetCollidingFaces (dgPolygonMeshDesc* const data) c
 	dgInt32 z0 = dgInt32 (p0.m_iz);
 	dgInt32 z1 = dgInt32 (p1.m_iz);
 
+	if (m_tileCache && (m_tileCache->m_prefetchDistance > dgFloat32 (0.0f))) {
+		// the broad phase calls here for every body that overlaps the height field, read ahead the tiles around it
+		const dgFloat32 distance = m_tileCache->m_prefetchDistance;
+		const dgFloat32 tileSizeInv_x = dgFloat32 (1.0f) / (dgFloat32 (m_tileCache->m_tileSize) * m_horizontalScale_x);
+		const dgFloat32 tileSizeInv_z = dgFloat32 (1.0f) / (dgFloat32 (m_tileCache->m_tileSize) * m_horizontalScale_z);
+		m_tileCache->Prefetch (dgFastInt ((boxP0.m_x - distance) * tileSizeInv_x), dgFastInt ((boxP1.m_x + distance) * tileSizeInv_x), 
+							   dgFastInt ((boxP0.m_z - distance) * tileSizeInv_z), dgFastInt ((boxP1.m_z + distance) * tileSizeInv_z));
+	}
+
 	data->m_separationDistance = dgFloat32 (0.0f);
 	dgFloat32 minHeight = dgFloat32 (1.0e10f);
 	dgFloat32 maxHeight = dgFloat32 (-1.0e10f);
-//	dgInt32 base = z0 * m_width;
-	switch (m_elevationDataType) 
-	{
-		case m_float32Bit:
-		{
-			CalculateMinAndMaxElevation(x0, x1, z0, z1, (dgFloat32*)m_elevationMap, minHeight, maxHeight);
-			break;
-		}
-
-		case m_unsigned16Bit:
-		{
-			CalculateMinAndMaxElevation(x0, x1, z0, z1, (dgInt16*)m_elevationMap, minHeight, maxHeight);
-			break;
-		}
-	}
+	CalculateMinAndMaxElevation(x0, x1, z0, z1, minHeight, maxHeight);
 
 	minHeight *= m_verticalScale;
 	maxHeight *= m_verticalScale;
@@ -1029,42 +1741,62 @@ void dgCollisionHeightField::GetCollidingFaces (dgPolygonMeshDesc* const data) c
 		base = z0 * m_width;
 		dgVector* const vertex = &m_instanceData->m_vertex[data->m_threadNumber][0];
 
-		switch (m_elevationDataType) 
-		{
-			case m_float32Bit:
+		// cell attributes and diagonals starting at cell x0, z0
+		dgInt32 cellStride = m_width;
+		const dgInt8* atributes = NULL;
+		const dgInt8* diagonals = NULL;
+		if (m_tileCache) {
+			// gather the window from the tiles
+			cellStride = x1 - x0;
+			const dgInt32 cellCount = cellStride * (z1 - z0);
+			dgArray<dgInt8>& cells = m_instanceData->m_cells[data->m_threadNumber];
+			cells.ResizeIfNecessary (2 * cellCount);
+			dgInt8* const cellBuffer = &cells[0];
+			GetTiledVertexWindow (vertex, cellBuffer, &cellBuffer[cellCount], x0, x1, z0, z1);
+			atributes = cellBuffer;
+			diagonals = &cellBuffer[cellCount];
+			vertexIndex = (z1 - z0 + 1) * (x1 - x0 + 1);
+		} else {
+			atributes = &m_atributeMap[z0 * m_width + x0];
+			diagonals = &m_diagonals[z0 * m_width + x0];
+
+			switch (m_elevationDataType) 
 			{
-				const dgFloat32* const elevation = (dgFloat32*)m_elevationMap;
-				for (dgInt32 z = z0; z <= z1; z ++) {
-					dgFloat32 zVal = m_horizontalScale_z * z;
-					for (dgInt32 x = x0; x <= x1; x ++) {
-						vertex[vertexIndex] = dgVector(m_horizontalScale_x * x, m_verticalScale * elevation[base + x], zVal, dgFloat32 (0.0f));
-						vertexIndex ++;
-						dgAssert (vertexIndex <= m_instanceData->m_vertexCount[data->m_threadNumber]); 
+				case m_float32Bit:
+				{
+					const dgFloat32* const elevation = (dgFloat32*)m_elevationMap;
+					for (dgInt32 z = z0; z <= z1; z ++) {
+						dgFloat32 zVal = m_horizontalScale_z * z;
+						for (dgInt32 x = x0; x <= x1; x ++) {
+							vertex[vertexIndex] = dgVector(m_horizontalScale_x * x, m_verticalScale * elevation[base + x], zVal, dgFloat32 (0.0f));
+							vertexIndex ++;
+							dgAssert (vertexIndex <= m_instanceData->m_vertexCount[data->m_threadNumber]); 
+						}
+						base += m_width;
 					}
-					base += m_width;
-				}
-				if (m_horizontalDisplacement) {
-					AddDisplacement (vertex, x0, x1, z0, z1);
+					if (m_horizontalDisplacement) {
+						AddDisplacement (vertex, x0, x1, z0, z1);
+					}
+					break;
 				}
-				break;
-			}
 
-			case m_unsigned16Bit:
-			{
-				const dgUnsigned16* const elevation = (dgUnsigned16*)m_elevationMap;
-				for (dgInt32 z = z0; z <= z1; z ++) {
-					dgFloat32 zVal = m_horizontalScale_z * z;
-					for (dgInt32 x = x0; x <= x1; x ++) {
-						vertex[vertexIndex] = dgVector(m_horizontalScale_x * x, m_verticalScale * dgFloat32 (elevation[base + x]), zVal, dgFloat32 (0.0f));
-						vertexIndex ++;
-						dgAssert (vertexIndex <= m_instanceData->m_vertexCount[data->m_threadNumber]); 
+				case m_unsigned16Bit:
+				{
+					const dgUnsigned16* const elevation = (dgUnsigned16*)m_elevationMap;
+					for (dgInt32 z = z0; z <= z1; z ++) {
+						dgFloat32 zVal = m_horizontalScale_z * z;
+						for (dgInt32 x = x0; x <= x1; x ++) {
+							vertex[vertexIndex] = dgVector(m_horizontalScale_x * x, m_verticalScale * dgFloat32 (elevation[base + x]), zVal, dgFloat32 (0.0f));
+							vertexIndex ++;
+							dgAssert (vertexIndex <= m_instanceData->m_vertexCount[data->m_threadNumber]); 
+						}
+						base += m_width;
 					}
-					base += m_width;
-				}
-				if (m_horizontalDisplacement) {
-					AddDisplacement(vertex, x0, x1, z0, z1);
+					if (m_horizontalDisplacement) {
+						AddDisplacement(vertex, x0, x1, z0, z1);
+					}
+					break;
 				}
-				break;
 			}
 		}
 	
@@ -1078,9 +1810,9 @@ void dgCollisionHeightField::GetCollidingFaces (dgPolygonMeshDesc* const data) c
 		dgInt32 faceSize = dgInt32 (dgMax (m_horizontalScale_x, m_horizontalScale_z) * dgFloat32 (2.0f)); 
 
 		for (dgInt32 z = z0; (z < z1) && (faceCount < DG_MAX_COLLIDING_FACES); z ++) {
-			dgInt32 zStep = z * m_width;
+			dgInt32 zStep = (z - z0) * cellStride - x0;
 			for (dgInt32 x = x0; (x < x1) && (faceCount < DG_MAX_COLLIDING_FACES); x ++) {
-				const dgInt32* const indirectIndex = &m_cellIndices[dgInt32 (m_diagonals[zStep + x])][0];
+				const dgInt32* const indirectIndex = &m_cellIndices[dgInt32 (diagonals[zStep + x])][0];
 
 				dgInt32 vIndex[4];
 				vIndex[0] = vertexIndex;
@@ -1112,7 +1844,7 @@ void dgCollisionHeightField::GetCollidingFaces (dgPolygonMeshDesc* const data) c
 				indices[index + 0 + 0] = i2;
 				indices[index + 0 + 1] = i1;
 				indices[index + 0 + 2] = i0;
-				indices[index + 0 + 3] = m_atributeMap[zStep + x];
+				indices[index + 0 + 3] = atributes[zStep + x];
 				indices[index + 0 + 4] = normalIndex0;
 				indices[index + 0 + 5] = normalIndex0;
 				indices[index + 0 + 6] = normalIndex0;
@@ -1123,7 +1855,7 @@ void dgCollisionHeightField::GetCollidingFaces (dgPolygonMeshDesc* const data) c
 				indices[index + 9 + 0] = i1;
 				indices[index + 9 + 1] = i2;
 				indices[index + 9 + 2] = i3;
-				indices[index + 9 + 3] = m_atributeMap[zStep + x];
+				indices[index + 9 + 3] = atributes[zStep + x];
 				indices[index + 9 + 4] = normalIndex1;
 				indices[index + 9 + 5] = normalIndex1;
 				indices[index + 9 + 6] = normalIndex1;
@@ -1154,12 +1886,12 @@ void dgCollisionHeightField::GetCollidingFaces (dgPolygonMeshDesc* const data) c
 		const int maxIndex = index;
 		dgInt32 stepBase = (x1 - x0) * (2 * 9);
 		for (dgInt32 z = z0; z < z1; z ++) {
-			const dgInt32 diagBase = m_width * z;
+			const dgInt32 diagBase = cellStride * (z - z0) - x0;
 			const dgInt32 triangleIndexBase = (z - z0) * stepBase;
 			for (dgInt32 x = x0; x < (x1 - 1); x ++) {
 				dgInt32 index1 = (x - x0) * (2 * 9) + triangleIndexBase;
 				if (index1 < maxIndex) {
-					const dgInt32 code = (m_diagonals[diagBase + x] << 1) + m_diagonals[diagBase + x + 1];
+					const dgInt32 code = (diagonals[diagBase + x] << 1) + diagonals[diagBase + x + 1];
 					const dgInt32* const edgeMap = &m_horizontalEdgeMap[code][0];
 				
 					dgInt32* const triangles = &indices[index1];
@@ -1189,8 +1921,8 @@ void dgCollisionHeightField::GetCollidingFaces (dgPolygonMeshDesc* const data) c
 			for (dgInt32 z = z0; z < (z1 - 1); z ++) {	
 				dgInt32 index1 = (z - z0) * stepBase + triangleIndexBase;
 				if (index1 < maxIndex) {
-					const dgInt32 diagBase = m_width * z;
-					const dgInt32 code = (m_diagonals[diagBase + x] << 1) + m_diagonals[diagBase + m_width + x];
+					const dgInt32 diagBase = cellStride * (z - z0) - x0;
+					const dgInt32 code = (diagonals[diagBase + x] << 1) + diagonals[diagBase + cellStride + x];
 					const dgInt32* const edgeMap = &m_verticalEdgeMap[code][0];
 
 					dgInt32* const triangles = &indices[index1];
@@ -26,6 +26,14 @@
 #include "dgCollisionMesh.h"
 
 class dgCollisionHeightField;
+
+// cells per side of the blocks at the bottom of the elevation pyramid
+#define DG_HEIGHTFIELD_BLOCK_SIZE		8
+#define DG_HEIGHTFIELD_MAX_LEVELS		32
+
+// fill the elevation and attributes of the width x height vertices starting at vertex x0, z0. It is called from the physics threads
+// and from the tile loader thread, so it must be thread safe
+typedef void (*dgCollisionHeightFieldTileCallback) (dgInt32 x0, dgInt32 z0, dgInt32 width, dgInt32 height, void* const elevationMap, dgInt8* const atributeMap, void* const userData);
 typedef dgFloat32 (*dgCollisionHeightFieldRayCastCallback) (const dgBody* const body, const dgCollisionHeightField* const heightFieldCollision, dgFloat32 interception, dgInt32 row, dgInt32 col, dgVector* const normal, int faceId, void* const usedData);
 
 
@@ -53,6 +61,12 @@ class dgCollisionHeightField: public dgCollisionMesh
 							const void* const elevationMap, dgElevationType elevationDataType, dgFloat32 verticalScale, 
 							const dgInt8* const atributeMap, dgFloat32 horizontalScale_x, dgFloat32 horizontalScale_z);
 
+	// streaming height field, only the last used tiles of tileSize x tileSize cells are resident, and tiles are read with the callback on demand.
+	// minElevation and maxElevation bound the elevation of the whole map
+	dgCollisionHeightField (dgWorld* const world, dgInt32 width, dgInt32 height, dgInt32 tileSize, dgInt32 maxResidentTiles, dgInt32 contructionMode, 
+							dgElevationType elevationDataType, dgFloat32 minElevation, dgFloat32 maxElevation, dgFloat32 verticalScale, 
+							dgFloat32 horizontalScale_x, dgFloat32 horizontalScale_z, dgCollisionHeightFieldTileCallback tileCallback, void* const tileUserData);
+
 	dgCollisionHeightField (dgWorld* const world, dgDeserialize deserialization, void* const userData, dgInt32 revisionNumber);
 
 	virtual ~dgCollisionHeightField(void);
@@ -62,24 +76,103 @@ class dgCollisionHeightField: public dgCollisionMesh
 
 	void SetHorizontalDisplacement (const dgUnsigned16* const displacemnet, dgFloat32 scale);
 
+	// tiles within this distance of the bodies touching a streaming height field are read in the background
+	void SetTilePrefetchDistance (dgFloat32 distance);
+	dgInt32 GetResidentTileCount () const;
+
 	private:
 	class dgPerIntanceData
 	{
 		public:
+		dgPerIntanceData (dgWorld* const world);
+		~dgPerIntanceData ();
+
 		dgWorld* m_world;
 		dgInt32 m_refCount;
-		dgInt32 m_vertexCount[DG_MAX_THREADS_HIVE_COUNT];
-		dgArray<dgVector> m_vertex[DG_MAX_THREADS_HIVE_COUNT];
+		dgInt32 m_threadCount;
+		dgInt32* m_vertexCount;
+		dgArray<dgVector>* m_vertex;
+		dgArray<dgInt8>* m_cells;
+	};
+
+	// least recently used cache of the tiles of a streaming height field, each resident tile is a height field of its own.
+	// the thread reads the prefetched tiles in the background, it is started by the first prefetch request
+	class dgTileCache: public dgThread
+	{
+		public:
+		enum dgTileState
+		{
+			m_unloaded = 0,
+			m_queued,
+			m_loading,
+			m_resident,
+		};
+
+		class dgTile
+		{
+			public:
+			dgCollisionHeightField* m_field;
+			dgList<dgInt32>::dgListNode* m_lruNode;
+			dgFloat32 m_minHeight;
+			dgFloat32 m_maxHeight;
+			dgInt32 m_state;
+			dgInt32 m_inQueue;
+		};
+
+		DG_CLASS_ALLOCATOR(allocator)
+		dgTileCache (dgCollisionHeightField* const owner, dgInt32 tileSize, dgInt32 maxResidentTiles, dgFloat32 minElevation, dgFloat32 maxElevation, dgCollisionHeightFieldTileCallback callback, void* const userData);
+		~dgTileCache ();
+
+		// the returned tile stays valid until it is released, even if it is evicted in the meantime
+		dgCollisionHeightField* GetTile (dgInt32 tileX, dgInt32 tileZ);
+		void ReleaseTile (dgCollisionHeightField* const tile);
+		void Prefetch (dgInt32 tileX0, dgInt32 tileX1, dgInt32 tileZ0, dgInt32 tileZ1);
+
+		virtual void Execute (dgInt32 threadID);
+
+		void LoadTile (dgInt32 index);
+		void InsertTile (dgInt32 index, dgCollisionHeightField* const tile);
+
+		dgCollisionHeightField* m_owner;
+		dgCollisionHeightFieldTileCallback m_callback;
+		void* m_userData;
+		dgTile* m_tiles;
+		dgInt32* m_queue;
+		dgList<dgInt32> m_lru;
+		dgThread::dgCriticalSection m_lock;
+		dgThread::dgSemaphore m_semaphore;
+		dgFloat32 m_prefetchDistance;
+		dgInt32 m_tileSize;
+		dgInt32 m_tilesX;
+		dgInt32 m_tilesZ;
+		dgInt32 m_maxResidentTiles;
+		dgInt32 m_queueHead;
+		dgInt32 m_queueTail;
+		dgInt32 m_loaderStarted;
+	};
+
+	// min and max elevation of a block of cells, in elevation map units
+	class dgElevationRange
+	{
+		public:
+		dgFloat32 m_minHeight;
+		dgFloat32 m_maxHeight;
 	};
 
 	void CalculateAABB();
-	void CalculateMinAndMaxElevation(dgInt32 x0, dgInt32 x1, dgInt32 z0, dgInt32 z1, const dgInt16* const elevation, dgFloat32& minHeight, dgFloat32& maxHeight) const;
+	void BuildElevationPyramid();
+	void CalculateMinAndMaxElevation(dgInt32 x0, dgInt32 x1, dgInt32 z0, dgInt32 z1, dgFloat32& minHeight, dgFloat32& maxHeight) const;
+	void CalculateMinAndMaxElevation(dgInt32 level, dgInt32 blockX, dgInt32 blockZ, dgInt32 x0, dgInt32 x1, dgInt32 z0, dgInt32 z1, dgFloat32& minHeight, dgFloat32& maxHeight) const;
+	void CalculateMinAndMaxElevation(dgInt32 x0, dgInt32 x1, dgInt32 z0, dgInt32 z1, const dgUnsigned16* const elevation, dgFloat32& minHeight, dgFloat32& maxHeight) const;
 	void CalculateMinAndMaxElevation(dgInt32 x0, dgInt32 x1, dgInt32 z0, dgInt32 z1, const dgFloat32* const elevation, dgFloat32& minHeight, dgFloat32& maxHeight) const;
 		
 	void AllocateVertex(dgWorld* const world, dgInt32 thread) const;
 	void CalculateMinExtend2d (const dgVector& p0, const dgVector& p1, dgVector& boxP0, dgVector& boxP1) const;
 	void CalculateMinExtend3d (const dgVector& p0, const dgVector& p1, dgVector& boxP0, dgVector& boxP1) const;
 	dgFloat32 RayCastCell (const dgFastRayTest& ray, dgInt32 xIndex0, dgInt32 zIndex0, dgVector& normalOut, dgFloat32 maxT) const;
+	dgFloat32 RayCastTiles (const dgVector& localP0, const dgVector& localP1, dgFloat32 maxT, dgContactPoint& contactOut, const dgBody* const body, void* const userData, OnRayPrecastAction preFilter) const;
+	void GetTiledVertexWindow (dgVector* const vertex, dgInt8* const atributes, dgInt8* const diagonals, dgInt32 x0, dgInt32 x1, dgInt32 z0, dgInt32 z1) const;
+	dgFloat32 RayCastBlock (const dgFastRayTest& ray, dgInt32 blockX, dgInt32 blockZ, dgFloat32 entryT, dgFloat32 maxT, dgVector& normalOut, dgInt32& xIndexOut, dgInt32& zIndexOut) const;
 
 	virtual void Serialize(dgSerialize callback, void* const userData) const;
 	virtual dgFloat32 RayCast (const dgVector& localP0, const dgVector& localP1, dgFloat32 maxT, dgContactPoint& contactOut, const dgBody* const body, void* const userData, OnRayPrecastAction preFilter) const;
@@ -125,6 +218,19 @@ class dgCollisionHeightField: public dgCollisionMesh
 	dgCollisionHeightFieldRayCastCallback m_userRayCastCallback;
 	dgElevationType m_elevationDataType;
 
+	// quadtree of the elevation ranges, level zero are the blocks of DG_HEIGHTFIELD_BLOCK_SIZE cells,
+	// and the last level is a single node that covers the whole height field
+	dgElevationRange* m_elevationPyramid;
+	dgInt32 m_pyramidLevels;
+	dgInt32 m_pyramidOffset[DG_HEIGHTFIELD_MAX_LEVELS];
+	dgInt32 m_pyramidWidth[DG_HEIGHTFIELD_MAX_LEVELS];
+	dgInt32 m_pyramidHeight[DG_HEIGHTFIELD_MAX_LEVELS];
+
+	// not null for streaming height fields, which do not have elevation, attribute or diagonal maps of their own
+	dgTileCache* m_tileCache;
+
+	// true when the maps are used in place from a relocatable image
+	bool m_inPlace;
 	
 	static dgVector m_yMask;
 	static dgVector m_padding;
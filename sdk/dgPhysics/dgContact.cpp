@@ -65,8 +65,74 @@ dgContactMaterial::dgContactMaterial()
 	m_flags = m_collisionEnable | m_friction0Enable | m_friction1Enable;
 }
 
+dgContactPointPool::dgContactPointPool (dgMemoryAllocator* const allocator)
+	:m_allocator(allocator)
+	,m_pages(NULL)
+	,m_lock(0)
+{
+	dgAssert ((4 << (DG_CONTACT_POINT_BLOCK_SIZES - 1)) == DG_MAX_CONTACT_POINTS);
+	dgAssert (DG_CONTACT_POINT_PAGE_SIZE >= DG_MAX_CONTACT_POINTS);
+	for (dgInt32 i = 0; i < DG_CONTACT_POINT_BLOCK_SIZES; i ++) {
+		m_freeBlocks[i] = NULL;
+	}
+}
+
+dgContactPointPool::~dgContactPointPool ()
+{
+	while (m_pages) {
+		dgPage* const page = m_pages;
+		m_pages = page->m_next;
+		m_allocator->FreeLow (page);
+	}
+}
+
+dgContactMaterial* dgContactPointPool::Alloc (dgInt32 count, dgInt32& capacity)
+{
+	dgAssert (count > 0);
+	dgAssert (count <= DG_MAX_CONTACT_POINTS);
+	dgInt32 sizeIndex = 0;
+	capacity = 4;
+	while (capacity < count) {
+		capacity *= 2;
+		sizeIndex ++;
+	}
+
+	dgSpinLock (&m_lock, false);
+	if (!m_freeBlocks[sizeIndex]) {
+		dgPage* const page = (dgPage*) m_allocator->MallocLow (dgInt32 (sizeof (dgPage) + DG_CONTACT_POINT_PAGE_SIZE * sizeof (dgContactMaterial)));
+		page->m_next = m_pages;
+		m_pages = page;
+
+		dgContactMaterial* const points = (dgContactMaterial*) (page + 1);
+		for (dgInt32 i = DG_CONTACT_POINT_PAGE_SIZE - capacity; i >= 0; i -= capacity) {
+			dgFreeBlock* const block = (dgFreeBlock*) &points[i];
+			block->m_next = m_freeBlocks[sizeIndex];
+			m_freeBlocks[sizeIndex] = block;
+		}
+	}
+	dgFreeBlock* const block = m_freeBlocks[sizeIndex];
+	m_freeBlocks[sizeIndex] = block->m_next;
+	dgSpinUnlock (&m_lock);
+	return (dgContactMaterial*) block;
+}
+
+void dgContactPointPool::Free (dgContactMaterial* const points, dgInt32 capacity)
+{
+	dgInt32 sizeIndex = 0;
+	for (dgInt32 size = 4; size < capacity; size *= 2) {
+		sizeIndex ++;
+	}
+	dgAssert ((4 << sizeIndex) == capacity);
+
+	dgFreeBlock* const block = (dgFreeBlock*) points;
+	dgSpinLock (&m_lock, false);
+	block->m_next = m_freeBlocks[sizeIndex];
+	m_freeBlocks[sizeIndex] = block;
+	dgSpinUnlock (&m_lock);
+}
+
 dgContact::dgContact(dgWorld* const world, const dgContactMaterial* const material)
-	:dgConstraint(), dgList<dgContactMaterial>(world->GetAllocator())
+	:dgConstraint()
 	,m_positAcc (dgFloat32(0.0f))
 	,m_rotationAcc (dgFloat32(1.0f), dgFloat32(0.0f), dgFloat32(0.0f), dgFloat32(0.0f))
 	,m_closestDistance (dgFloat32 (0.0f))
@@ -77,6 +143,11 @@ dgContact::dgContact(dgWorld* const world, const dgContactMaterial* const materi
 	,m_contactNode(NULL)
 	,m_contactPruningTolereance(world->GetContactMergeTolerance())
 	,m_broadphaseLru(0)
+	,m_contactPoints(NULL)
+	,m_removedPoints(0)
+	,m_pointsCount(0)
+	,m_pointsCapacity(0)
+	,m_contactCount(0)
 	,m_isNewContact(true)
 {
 	dgAssert ((((dgUnsigned64) this) & 15) == 0);
@@ -86,7 +157,7 @@ dgContact::dgContact(dgWorld* const world, const dgContactMaterial* const materi
 }
 
 dgContact::dgContact(dgContact* const clone)
-	:dgConstraint(*clone), dgList<dgContactMaterial>(clone->GetAllocator())
+	:dgConstraint(*clone)
 	,m_positAcc(clone->m_positAcc)
 	,m_rotationAcc(clone->m_rotationAcc)
 	,m_separtingVector (clone->m_separtingVector)
@@ -98,6 +169,11 @@ dgContact::dgContact(dgContact* const clone)
 	,m_contactNode(clone->m_contactNode)
 	,m_contactPruningTolereance(clone->m_contactPruningTolereance)
 	,m_broadphaseLru(clone->m_broadphaseLru)
+	,m_contactPoints(NULL)
+	,m_removedPoints(clone->m_removedPoints)
+	,m_pointsCount(0)
+	,m_pointsCapacity(0)
+	,m_contactCount(clone->m_contactCount)
 	,m_isNewContact(clone->m_isNewContact)
 {
 	dgAssert((((dgUnsigned64) this) & 15) == 0);
@@ -107,13 +183,20 @@ dgContact::dgContact(dgContact* const clone)
 	m_constId = m_contactConstraint;
 	m_contactActive = clone->m_contactActive;
 	m_enableCollision = clone->m_enableCollision;
-	Merge (*clone);
+	if (clone->m_pointsCount) {
+		ReservePoints (clone->m_pointsCount);
+		m_pointsCount = clone->m_pointsCount;
+		for (dgInt32 i = 0; i < m_pointsCount; i ++) {
+			m_contactPoints[i] = clone->m_contactPoints[i];
+		}
+	}
 }
 
 dgContact::~dgContact()
 {
-	dgList<dgContactMaterial>::RemoveAll();
-
+	if (m_contactPoints) {
+		m_world->m_contactPointPool.Free (m_contactPoints, m_pointsCapacity);
+	}
 	if (m_contactNode) {
 		dgActiveContacts* const activeContacts = m_world;
 		activeContacts->Remove (m_contactNode);
@@ -133,6 +216,24 @@ void dgContact::SwapBodies()
 	dgSwap (m_link0, m_link1);
 }
 
+void dgContact::ReservePoints (dgInt32 count)
+{
+	// blocks only grow, a pair that lost some points keeps its block for when they come back
+	if (count > m_pointsCapacity) {
+		dgContactPointPool& pool = m_world->m_contactPointPool;
+		dgInt32 capacity;
+		dgContactMaterial* const points = pool.Alloc (count, capacity);
+		for (dgInt32 i = 0; i < m_pointsCount; i ++) {
+			points[i] = m_contactPoints[i];
+		}
+		if (m_contactPoints) {
+			pool.Free (m_contactPoints, m_pointsCapacity);
+		}
+		m_contactPoints = points;
+		m_pointsCapacity = capacity;
+	}
+}
+
 
 void dgContact::GetInfo (dgConstraintInfo* const info) const
 {
@@ -177,10 +278,11 @@ dgUnsigned32 dgContact::JacobianDerivative (dgContraintDescritor& params)
 	if (m_maxDOF) {
 		dgInt32 i = 0;
 		frictionIndex = GetCount();
-		for (dgList<dgContactMaterial>::dgListNode* node = GetFirst(); node; node = node->GetNext()) {
-			const dgContactMaterial& contact = node->GetInfo(); 
-			JacobianContactDerivative (params, contact, i, frictionIndex);
-			i ++;
+		for (dgInt32 j = 0; j < m_pointsCount; j ++) {
+			if (!(m_removedPoints & (1 << j))) {
+				JacobianContactDerivative (params, m_contactPoints[j], i, frictionIndex);
+				i ++;
+			}
 		}
 	}
 
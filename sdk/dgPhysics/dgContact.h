@@ -35,6 +35,9 @@ class dgCollisionInstance;
 
 
 #define DG_MAX_CONTATCS					128
+#define DG_MAX_CONTACT_POINTS			(DG_CONSTRAINT_MAX_ROWS / 3)
+#define DG_CONTACT_POINT_BLOCK_SIZES	3
+#define DG_CONTACT_POINT_PAGE_SIZE		64
 #define DG_RESTING_CONTACT_PENETRATION	(DG_PENETRATION_TOL + dgFloat32 (1.0f / 1024.0f))
 
 class dgActiveContacts: public dgList<dgContact*>
@@ -46,6 +49,38 @@ class dgActiveContacts: public dgList<dgContact*>
 	}
 };
 
+// contact points of all the contact joints of a world. 
+// a joint only holds a block for the points it has, blocks of 4, 8 or 16 points are carved 
+// from pages of DG_CONTACT_POINT_PAGE_SIZE points and recycled through a free list per block size.
+class dgContactPointPool
+{
+	public:
+	dgContactPointPool (dgMemoryAllocator* const allocator);
+	~dgContactPointPool ();
+
+	dgContactMaterial* Alloc (dgInt32 count, dgInt32& capacity);
+	void Free (dgContactMaterial* const points, dgInt32 capacity);
+
+	private:
+	DG_MSC_VECTOR_ALIGMENT
+	class dgPage
+	{
+		public:
+		dgPage* m_next;
+	} DG_GCC_VECTOR_ALIGMENT;
+
+	class dgFreeBlock
+	{
+		public:
+		dgFreeBlock* m_next;
+	};
+
+	dgMemoryAllocator* m_allocator;
+	dgPage* m_pages;
+	dgFreeBlock* m_freeBlocks[DG_CONTACT_POINT_BLOCK_SIZES];
+	dgInt32 m_lock;
+};
+
 
 DG_MSC_VECTOR_ALIGMENT
 class dgCollisionParamProxy
@@ -175,9 +210,14 @@ class dgContactMaterial: public dgContactPoint
 
 
 DG_MSC_VECTOR_ALIGMENT 
-class dgContact: public dgConstraint, public dgList<dgContactMaterial>
+class dgContact: public dgConstraint
 {
 	public:
+	dgInt32 GetCount() const;
+	dgContactMaterial* GetFirstContact();
+	dgContactMaterial* GetNextContact(const dgContactMaterial* const contact);
+	void RemoveContact(const dgContactMaterial* const contact);
+
     dgFloat32 GetClosestDistance() const;
 	dgFloat32 GetTimeOfImpact() const;
 	void SetTimeOfImpact(dgFloat32 timetoImpact);
@@ -207,6 +247,7 @@ class dgContact: public dgConstraint, public dgList<dgContactMaterial>
 
 	void AppendToActiveList();
 	void SwapBodies();
+	void ReservePoints (dgInt32 count);
 
 	dgVector m_positAcc;
 	dgQuaternion m_rotationAcc;
@@ -219,6 +260,14 @@ class dgContact: public dgConstraint, public dgList<dgContactMaterial>
 	dgActiveContacts::dgListNode* m_contactNode;
 	dgFloat32 m_contactPruningTolereance;
 	dgUnsigned32 m_broadphaseLru;
+
+	// contact points live in a block of the world contact point pool, removed points are only 
+	// flagged so that handles given to the application stay valid until the next update
+	dgContactMaterial* m_contactPoints;
+	dgUnsigned32 m_removedPoints;
+	dgInt32 m_pointsCount;
+	dgInt32 m_pointsCapacity;
+	dgInt32 m_contactCount;
 	dgUnsigned32 m_isNewContact				: 1;
 
     friend class dgBody;
@@ -270,6 +319,42 @@ inline void dgContact::SetDestructorCallback (OnConstraintDestroy destructor)
 {
 }
 
+inline dgInt32 dgContact::GetCount() const
+{
+	return m_contactCount;
+}
+
+inline dgContactMaterial* dgContact::GetFirstContact()
+{
+	for (dgInt32 i = 0; i < m_pointsCount; i ++) {
+		if (!(m_removedPoints & (1 << i))) {
+			return &m_contactPoints[i];
+		}
+	}
+	return NULL;
+}
+
+inline dgContactMaterial* dgContact::GetNextContact(const dgContactMaterial* const contact)
+{
+	dgAssert ((contact >= m_contactPoints) && (contact < &m_contactPoints[m_pointsCount]));
+	for (dgInt32 i = dgInt32 (contact - m_contactPoints) + 1; i < m_pointsCount; i ++) {
+		if (!(m_removedPoints & (1 << i))) {
+			return &m_contactPoints[i];
+		}
+	}
+	return NULL;
+}
+
+inline void dgContact::RemoveContact(const dgContactMaterial* const contact)
+{
+	const dgInt32 index = dgInt32 (contact - m_contactPoints);
+	dgAssert ((index >= 0) && (index < m_pointsCount));
+	if (!(m_removedPoints & (1 << index))) {
+		m_removedPoints |= (1 << index);
+		m_contactCount --;
+	}
+}
+
 inline const dgContactMaterial* dgContact::GetMaterial() const
 {
 	return m_material;
@@ -50,6 +50,20 @@
 #include "dgCollisionMassSpringDamperSystem.h"
 #include "dgCollisionIncompressibleParticles.h"
 
+//#define DG_COLLISION_IMAGE_MAGIC	'mign'
+#define DG_COLLISION_IMAGE_MAGIC	0x6d69676e
+#define DG_COLLISION_IMAGE_VERSION	1
+
+// the header keeps the image stream 16 byte aligned
+class dgCollisionImageHeader
+{
+	public:
+	dgInt32 m_magic;
+	dgInt32 m_version;
+	dgInt32 m_size;
+	dgInt32 m_reserved;
+};
+
 
 DG_MSC_VECTOR_ALIGMENT
 class dgCollisionContactCloud: public dgCollisionConvex
@@ -315,6 +329,19 @@ dgCollisionInstance* dgWorld::CreateHeightField(
 	return instance;
 }
 
+dgCollisionInstance* dgWorld::CreateTiledHeightField(
+	dgInt32 width, dgInt32 height, dgInt32 tileSize, dgInt32 maxResidentTiles, dgInt32 contructionMode, dgInt32 elevationDataType, 
+	dgFloat32 minElevation, dgFloat32 maxElevation, dgFloat32 verticalScale, dgFloat32 horizontalScale_x, dgFloat32 horizontalScale_z, 
+	dgCollisionHeightFieldTileCallback tileCallback, void* const tileUserData)
+{
+	dgCollision* const collision = new  (m_allocator) dgCollisionHeightField (this, width, height, tileSize, maxResidentTiles, contructionMode, 
+																			  elevationDataType	? dgCollisionHeightField::m_unsigned16Bit : dgCollisionHeightField::m_float32Bit,	
+																			  minElevation, maxElevation, verticalScale, horizontalScale_x, horizontalScale_z, tileCallback, tileUserData);
+	dgCollisionInstance* const instance = CreateInstance (collision, 0, dgGetIdentityMatrix()); 
+	collision->Release();
+	return instance;
+}
+
 dgCollisionInstance* dgWorld::CreateInstance (const dgCollision* const child, dgInt32 shapeID, const dgMatrix& offsetMatrix)
 {
 	dgAssert (dgAbsf (offsetMatrix[0].DotProduct3(offsetMatrix[0]) - dgFloat32 (1.0f)) < dgFloat32 (1.0e-5f));
@@ -343,31 +370,71 @@ dgCollisionInstance* dgWorld::CreateCollisionFromSerialization (dgDeserialize de
 	return instance;
 }
 
+void dgWorld::SerializeCollisionImage (dgCollisionInstance* const shape, dgSerialize serialization, void* const userData) const
+{
+	// the first pass only measures the image, so that the header can carry its size
+	dgImageWriter writer;
+	writer.m_callback = NULL;
+	writer.m_userData = NULL;
+	writer.m_offset = sizeof (dgCollisionImageHeader);
+	dgSerializeMarker (dgImageWriterCallback, &writer);
+	shape->Serialize (dgImageWriterCallback, &writer);
+
+	dgCollisionImageHeader header;
+	header.m_magic = DG_COLLISION_IMAGE_MAGIC;
+	header.m_version = DG_COLLISION_IMAGE_VERSION;
+	header.m_size = writer.m_offset;
+	header.m_reserved = 0;
+
+	writer.m_callback = serialization;
+	writer.m_userData = userData;
+	writer.m_offset = 0;
+	dgImageWriterCallback (&writer, &header, sizeof (header));
+	dgSerializeMarker (dgImageWriterCallback, &writer);
+	shape->Serialize (dgImageWriterCallback, &writer);
+	dgAssert (writer.m_offset == header.m_size);
+}
 
-dgContactMaterial* dgWorld::GetMaterial (dgUnsigned32 bodyGroupId0, dgUnsigned32 bodyGroupId1)	const
+dgCollisionInstance* dgWorld::CreateCollisionFromImage (const void* const image, dgInt32 size)
 {
-	if (bodyGroupId0 > bodyGroupId1) {
-		dgSwap (bodyGroupId0, bodyGroupId1);
+	const dgCollisionImageHeader* const header = (dgCollisionImageHeader*) image;
+	if (!image || (size < dgInt32 (sizeof (dgCollisionImageHeader))) || (header->m_magic != DG_COLLISION_IMAGE_MAGIC) || (header->m_version != DG_COLLISION_IMAGE_VERSION) || (header->m_size > size)) {
+		return NULL;
 	}
 
-	dgUnsigned32 key = (bodyGroupId1 << 16) + bodyGroupId0;
-	dgBodyMaterialList::dgTreeNode *const node = dgBodyMaterialList::Find (key);
+	// the shapes keep pointers into the image, so it has to be aligned and has to outlive them
+	dgAssert (!(dgUnsigned64 (image) & (DG_IMAGE_ALIGNMENT - 1)));
+	if (dgUnsigned64 (image) & (DG_IMAGE_ALIGNMENT - 1)) {
+		return NULL;
+	}
 
-	return node ? &node->GetInfo() : NULL;
+	dgImageReader reader;
+	reader.m_image = (const dgInt8*) image;
+	reader.m_offset = sizeof (dgCollisionImageHeader);
+	reader.m_size = header->m_size;
+	dgInt32 revision = dgDeserializeMarker (dgImageReaderCallback, &reader);
+	dgCollisionInstance* const instance = new  (m_allocator) dgCollisionInstance (this, dgImageReaderCallback, &reader, revision);
+	return instance;
+}
+
+
+dgContactMaterial* dgWorld::GetMaterial (dgUnsigned32 bodyGroupId0, dgUnsigned32 bodyGroupId1)	const
+{
+	return dgBodyMaterialList::FindMaterial (bodyGroupId0, bodyGroupId1);
 }
 
 dgContactMaterial* dgWorld::GetFirstMaterial () const
 {
-	dgBodyMaterialList::dgTreeNode *const node = dgBodyMaterialList::Minimum();
+	dgBodyMaterialList::dgListNode *const node = dgBodyMaterialList::GetFirst();
 	dgAssert (node);
 	return &node->GetInfo();
 }
 
 dgContactMaterial* dgWorld::GetNextMaterial (dgContactMaterial* material) const
 {
-	dgBodyMaterialList::dgTreeNode *const thisNode = dgBodyMaterialList::GetNodeFromInfo (*material);
+	dgBodyMaterialList::dgListNode *const thisNode = dgBodyMaterialList::GetNodeFromInfo (*material);
 	dgAssert (thisNode);
-	dgBodyMaterialList::dgTreeNode *const node = (dgBodyMaterialList::dgTreeNode *)thisNode->Next();
+	dgBodyMaterialList::dgListNode *const node = thisNode->GetNext();
 	if (node) {
 		return &node->GetInfo();
 	}
@@ -390,17 +457,29 @@ dgUnsigned32 dgWorld::CreateBodyGroupID()
 	pairMaterial.m_processContactPoint = NULL;
 	pairMaterial.m_compoundAABBOverlap = NULL;
 
-	dgUnsigned32 newId = m_bodyGroupID;
-	m_bodyGroupID += 1;
-	for (dgUnsigned32 i = 0; i < m_bodyGroupID ; i ++) {
-		dgUnsigned32 key = (newId  << 16) + i;
+	return dgBodyMaterialList::AddGroup (pairMaterial);
+}
 
-		dgBodyMaterialList::Insert(pairMaterial, key);
-	}
 
+// the pairs of a new group have larger keys than all the existing ones, so appending keeps the list sorted
+dgUnsigned32 dgBodyMaterialList::AddGroup (const dgContactMaterial& material)
+{
+	const dgUnsigned32 newId = m_groupCount;
+	const dgInt32 base = dgInt32 ((newId * (newId + 1)) / 2);
+	m_materialTable.ResizeIfNecessary (base + dgInt32 (newId) + 1);
+	for (dgUnsigned32 i = 0; i <= newId; i ++) {
+		m_materialTable[base + dgInt32 (i)] = &Append(material)->GetInfo();
+	}
+	m_groupCount ++;
 	return newId;
 }
 
+void dgBodyMaterialList::RemoveAllGroups ()
+{
+	RemoveAll();
+	m_groupCount = 0;
+}
+
 
 void dgWorld::ReleaseCollision(const dgCollision* const collision)
 {
@@ -723,13 +802,9 @@ void dgWorld::ProcessCachedContacts (dgContact* const contact, dgFloat32 timeste
 	dgAssert (contact->m_material);
 	dgAssert (contact->m_body0 != contact->m_body1);
 
-	dgList<dgContactMaterial>& list = *contact;
 	const dgContactMaterial* const material = contact->m_material;
-
-	dgList<dgContactMaterial>::dgListNode* nextContactNode;
-	for (dgList<dgContactMaterial>::dgListNode *contactNode = list.GetFirst(); contactNode; contactNode = nextContactNode) {
-		nextContactNode = contactNode->GetNext();
-		dgContactMaterial& contactMaterial = contactNode->GetInfo();
+	for (dgContactMaterial* point = contact->GetFirstContact(); point; point = contact->GetNextContact(point)) {
+		dgContactMaterial& contactMaterial = *point;
 
 		dgAssert (dgCheckFloat(contactMaterial.m_point.m_x));
 		dgAssert (dgCheckFloat(contactMaterial.m_point.m_y));
@@ -774,21 +849,69 @@ void dgWorld::PopulateContacts (dgBroadPhase::dgPair* const pair, dgInt32 thread
 	const dgContactMaterial* const material = contact->m_material;
 	const dgContactPoint* const contactArray = pair->m_contactBuffer;
 
-	dgInt32 contactCount = pair->m_contactCount;
-	dgList<dgContactMaterial>& list = *contact;
+	dgAssert (pair->m_contactCount <= DG_MAX_CONTACT_POINTS);
+	const dgInt32 contactCount = dgMin (dgInt32 (pair->m_contactCount), DG_MAX_CONTACT_POINTS);
 
 	contact->m_timeOfImpact = pair->m_timestep;
 
+	// copy the live points so that the ones that persist keep their accumulated forces
 	dgInt32 count = 0;
-	dgVector cachePosition [DG_MAX_CONTATCS];
-	dgList<dgContactMaterial>::dgListNode *nodes[DG_MAX_CONTATCS];
+	dgInt32 cacheIndex[DG_MAX_CONTACT_POINTS];
+	dgInt32 cacheTarget[DG_MAX_CONTACT_POINTS];
+	dgVector cachePosition[DG_MAX_CONTACT_POINTS];
+	dgContactMaterial cachePoints[DG_MAX_CONTACT_POINTS];
+	for (dgContactMaterial* point = contact->GetFirstContact(); point; point = contact->GetNextContact(point)) {
+		cachePoints[count] = *point;
+		cachePosition[count] = point->m_point;
+		cacheIndex[count] = count;
+		cacheTarget[count] = -1;
+		count ++;
+	}
+	const dgInt32 cacheCount = count;
+
+	// match each new point to the closest cached point
+	dgInt32 newCount = 0;
+	dgInt32 newPoints[DG_MAX_CONTACT_POINTS];
+	for (dgInt32 i = 0; i < contactCount; i ++) {
+		dgFloat32 min = dgFloat32 (1.0e20f);
+		dgInt32 index = -1;
+		for (dgInt32 j = 0; j < count; j ++) {
+			dgVector v (cachePosition[j] - contactArray[i].m_point);
+			dgFloat32 dist2 = v.DotProduct3(v);
+			if (dist2 < min) {
+				min = dist2;
+				index = j;
+			}
+		}
 
-	for (dgList<dgContactMaterial>::dgListNode *contactNode = list.GetFirst(); contactNode; contactNode = contactNode->GetNext()) {
+		if (index != -1) {
+			count --;
+			cacheTarget[cacheIndex[index]] = i;
+			cacheIndex[index] = cacheIndex[count];
+			cachePosition[index] = cachePosition[count];
+		} else {
+			newPoints[newCount] = i;
+			newCount ++;
+		}
+	}
 
-		nodes[count] = contactNode;
-		cachePosition[count] = contactNode->GetInfo().m_point;
-		count ++;
+	// persistent points keep their order, new points go at the end
+	dgInt32 pointSource[DG_MAX_CONTACT_POINTS];
+	dgInt32 pointTarget[DG_MAX_CONTACT_POINTS];
+	dgInt32 pointsCount = 0;
+	for (dgInt32 i = 0; i < cacheCount; i ++) {
+		if (cacheTarget[i] != -1) {
+			pointSource[pointsCount] = i;
+			pointTarget[pointsCount] = cacheTarget[i];
+			pointsCount ++;
+		}
+	}
+	for (dgInt32 i = 0; i < newCount; i ++) {
+		pointSource[pointsCount] = -1;
+		pointTarget[pointsCount] = newPoints[i];
+		pointsCount ++;
 	}
+	dgAssert (pointsCount == contactCount);
 
 	const dgVector& v0 = body0->m_veloc;
 	const dgVector& w0 = body0->m_omega;
@@ -822,37 +945,22 @@ void dgWorld::PopulateContacts (dgBroadPhase::dgPair* const pair, dgInt32 thread
 		dgAssert (dgAbsf(controlNormal.DotProduct3(controlDir0.CrossProduct3(controlDir1)) - dgFloat32 (1.0f)) < dgFloat32 (1.0e-3f));
 	}
 
+	// the live points were copied above, so the block can move when it grows
+	contact->m_pointsCount = 0;
+	contact->ReservePoints (pointsCount);
+
 	dgFloat32 maxImpulse = dgFloat32 (-1.0f);
 //	dgFloat32 breakImpulse0 = dgFloat32 (0.0f);
 //	dgFloat32 breakImpulse1 = dgFloat32 (0.0f);
-	for (dgInt32 i = 0; i < contactCount; i ++) {
-
-		dgList<dgContactMaterial>::dgListNode* contactNode = NULL;
-		dgFloat32 min = dgFloat32 (1.0e20f);
-		dgInt32 index = -1;
-		for (dgInt32 j = 0; j < count; j ++) {
-			dgVector v (cachePosition[j] - contactArray[i].m_point);
-			diff = v.DotProduct3(v);
-			if (diff < min) {
-				min = diff;
-				index = j;
-				contactNode = nodes[j];
-			}
-		}
-
-		if (contactNode) {
-			count --;
-			dgAssert (index != -1);
-			nodes[index] = nodes[count];
-			cachePosition[index] = cachePosition[count];
+	for (dgInt32 k = 0; k < pointsCount; k ++) {
+		const dgInt32 i = pointTarget[k];
+		dgContactMaterial* const contactMaterial = &contact->m_contactPoints[k];
+		if (pointSource[k] != -1) {
+			*contactMaterial = cachePoints[pointSource[k]];
 		} else {
-			GlobalLock(false);
-			contactNode = list.Append ();
-			GlobalUnlock();
+			*contactMaterial = dgContactMaterial();
 		}
 
-		dgContactMaterial* const contactMaterial = &contactNode->GetInfo();
-
 		dgAssert (dgCheckFloat(contactArray[i].m_point.m_x));
 		dgAssert (dgCheckFloat(contactArray[i].m_point.m_y));
 		dgAssert (dgCheckFloat(contactArray[i].m_point.m_z));
@@ -941,13 +1049,9 @@ void dgWorld::PopulateContacts (dgBroadPhase::dgPair* const pair, dgInt32 thread
 		contactMaterial->m_dir1.m_w = dgFloat32 (0.0f); 
 	}
 
-	if (count) {
-		GlobalLock(false);
-		for (dgInt32 i = 0; i < count; i ++) {
-			list.Remove(nodes[i]);
-		}
-		GlobalUnlock();
-	}
+	contact->m_pointsCount = pointsCount;
+	contact->m_contactCount = pointsCount;
+	contact->m_removedPoints = 0;
 
 	contact->m_maxDOF = dgUnsigned32 (3 * contact->GetCount());
 	if (material->m_processContactPoint) {
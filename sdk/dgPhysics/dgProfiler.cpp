@@ -0,0 +1,238 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dgPhysicsStdafx.h"
+#include "dgProfiler.h"
+
+
+static const char* const dgProfilerPhaseNames[dgProfiler::m_phaseCount] =
+{
+	"skeletonUpdate",
+	"forceCallbacks",
+	"aggregateEntropy",
+	"fitness",
+	"pairScan",
+	"narrowPhase",
+	"clusterBuild",
+	"jacobianBuild",
+	"solverPasses",
+	"integration",
+	"transformCallbacks",
+};
+
+// accumulates the trace text, and keeps counting the size once the buffer is full
+class dgProfilerTraceWriter
+{
+	public:
+	dgProfilerTraceWriter (char* const buffer, dgInt32 size)
+		:m_buffer(buffer)
+		,m_size(size)
+		,m_index(0)
+	{
+	}
+
+	void Append (const char* const text)
+	{
+		const dgInt32 length = dgInt32 (strlen (text));
+		if ((m_index + length) < m_size) {
+			memcpy (&m_buffer[m_index], text, length);
+		}
+		m_index += length;
+	}
+
+	dgInt32 Finish ()
+	{
+		if (m_index < m_size) {
+			m_buffer[m_index] = 0;
+		} else if (m_size) {
+			m_buffer[0] = 0;
+		}
+		return m_index + 1;
+	}
+
+	char* m_buffer;
+	dgInt32 m_size;
+	dgInt32 m_index;
+};
+
+
+dgProfiler::dgProfiler (dgMemoryAllocator* const allocator, dgInt32 workerCount)
+	:m_allocator(allocator)
+	,m_trackCount(workerCount + 1)
+	,m_recording(0)
+	,m_hasFrame(false)
+{
+	memset (m_frames, 0, sizeof (m_frames));
+}
+
+dgProfiler::~dgProfiler ()
+{
+	for (dgInt32 i = 0; i < 2; i ++) {
+		if (m_frames[i].m_tracks) {
+			m_allocator->FreeLow (m_frames[i].m_tracks[0].m_events);
+			m_allocator->FreeLow (m_frames[i].m_tracks);
+		}
+	}
+}
+
+void dgProfiler::AllocateFrames ()
+{
+	for (dgInt32 i = 0; i < 2; i ++) {
+		dgFrame& frame = m_frames[i];
+		frame.m_tracks = (dgTrack*) m_allocator->MallocLow (m_trackCount * sizeof (dgTrack), 64);
+		memset (frame.m_tracks, 0, m_trackCount * sizeof (dgTrack));
+
+		dgEvent* const events = (dgEvent*) m_allocator->MallocLow (m_trackCount * DG_PROFILER_MAX_EVENTS * sizeof (dgEvent), 64);
+		for (dgInt32 j = 0; j < m_trackCount; j ++) {
+			frame.m_tracks[j].m_events = &events[j * DG_PROFILER_MAX_EVENTS];
+		}
+	}
+}
+
+void dgProfiler::BeginFrame ()
+{
+	if (!m_frames[0].m_tracks) {
+		AllocateFrames ();
+	}
+
+	dgFrame& frame = m_frames[m_recording];
+	for (dgInt32 i = 0; i < m_trackCount; i ++) {
+		dgTrack& track = frame.m_tracks[i];
+		memset (track.m_phases, 0, sizeof (track.m_phases));
+		track.m_eventCount = 0;
+		track.m_droppedEvents = 0;
+	}
+	frame.m_start = GetTimeInNanoseconds();
+	frame.m_end = frame.m_start;
+}
+
+void dgProfiler::EndFrame ()
+{
+	m_frames[m_recording].m_end = GetTimeInNanoseconds();
+	m_recording = m_recording ^ 1;
+	m_hasFrame = true;
+}
+
+bool dgProfiler::HasFrame () const
+{
+	return m_hasFrame;
+}
+
+dgInt32 dgProfiler::GetTrackCount () const
+{
+	return m_trackCount;
+}
+
+dgUnsigned64 dgProfiler::GetFrameTime () const
+{
+	dgAssert (m_hasFrame);
+	const dgFrame& frame = m_frames[m_recording ^ 1];
+	return frame.m_end - frame.m_start;
+}
+
+const dgProfiler::dgPhaseInfo& dgProfiler::GetPhaseInfo (dgInt32 track, dgPhase phase) const
+{
+	dgAssert (m_hasFrame);
+	dgAssert (track < m_trackCount);
+	return m_frames[m_recording ^ 1].m_tracks[track].m_phases[phase];
+}
+
+const char* dgProfiler::GetPhaseName (dgPhase phase)
+{
+	return dgProfilerPhaseNames[phase];
+}
+
+dgUnsigned64 dgProfiler::GetTimeInNanoseconds ()
+{
+#if defined (_MSC_VER)
+	static LARGE_INTEGER frequency;
+	if (!frequency.QuadPart) {
+		QueryPerformanceFrequency(&frequency);
+	}
+	LARGE_INTEGER count;
+	QueryPerformanceCounter (&count);
+	const dgUnsigned64 seconds = dgUnsigned64 (count.QuadPart / frequency.QuadPart);
+	const dgUnsigned64 remainder = dgUnsigned64 (count.QuadPart % frequency.QuadPart);
+	return seconds * 1000000000 + remainder * 1000000000 / dgUnsigned64 (frequency.QuadPart);
+#elif (defined (_POSIX_VER) || defined (_POSIX_VER_64))
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return dgUnsigned64 (ts.tv_sec) * 1000000000 + dgUnsigned64 (ts.tv_nsec);
+#else
+	return dgGetTimeInMicrosenconds() * 1000;
+#endif
+}
+
+dgInt32 dgProfiler::ExportChromeTrace (char* const buffer, dgInt32 bufferSize) const
+{
+	dgProfilerTraceWriter writer (buffer, bufferSize);
+	if (!m_hasFrame) {
+		writer.Append ("{\"traceEvents\":[]}");
+		return writer.Finish();
+	}
+
+	// time stamps are microseconds from the start of the frame
+	char text[256];
+	const dgFrame& frame = m_frames[m_recording ^ 1];
+	writer.Append ("{\"traceEvents\":[\n");
+	sprintf (text, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"newton\"}}");
+	writer.Append (text);
+	for (dgInt32 i = 0; i < m_trackCount; i ++) {
+		if (i == GetUpdateThreadID()) {
+			sprintf (text, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"update\"}}", i);
+		} else {
+			sprintf (text, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"worker %d\"}}", i, i);
+		}
+		writer.Append (text);
+	}
+
+	sprintf (text, ",\n{\"name\":\"frame\",\"cat\":\"newton\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":0.000,\"dur\":%.3f}", GetUpdateThreadID(), dgFloat64 (frame.m_end - frame.m_start) * 1.0e-3);
+	writer.Append (text);
+
+	for (dgInt32 i = 0; i < m_trackCount; i ++) {
+		const dgTrack& track = frame.m_tracks[i];
+		for (dgInt32 j = 0; j < track.m_eventCount; j ++) {
+			const dgEvent& event = track.m_events[j];
+			sprintf (text, ",\n{\"name\":\"%s\",\"cat\":\"newton\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+					 dgProfilerPhaseNames[event.m_phase], i, dgFloat64 (event.m_start - frame.m_start) * 1.0e-3, dgFloat64 (event.m_end - event.m_start) * 1.0e-3);
+			writer.Append (text);
+		}
+		if (track.m_droppedEvents) {
+			sprintf (text, ",\n{\"name\":\"dropped events\",\"ph\":\"i\",\"s\":\"t\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"args\":{\"count\":%d}}",
+					 i, dgFloat64 (frame.m_end - frame.m_start) * 1.0e-3, track.m_droppedEvents);
+			writer.Append (text);
+		}
+	}
+
+	// frame totals of every phase as a counter track
+	for (dgInt32 i = 0; i < m_phaseCount; i ++) {
+		dgUnsigned64 time = 0;
+		dgInt32 items = 0;
+		for (dgInt32 j = 0; j < m_trackCount; j ++) {
+			time += frame.m_tracks[j].m_phases[i].m_time;
+			items += frame.m_tracks[j].m_phases[i].m_items;
+		}
+		sprintf (text, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":0,\"ts\":0.000,\"args\":{\"ms\":%.4f,\"items\":%d}}", dgProfilerPhaseNames[i], dgFloat64 (time) * 1.0e-6, items);
+		writer.Append (text);
+	}
+	writer.Append ("\n]}\n");
+	return writer.Finish();
+}
@@ -0,0 +1,198 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __dgProfiler__
+#define __dgProfiler__
+
+#include "dgPhysicsStdafx.h"
+
+// most events each track can record in one frame, the rest are only accumulated in the phase totals
+#define DG_PROFILER_MAX_EVENTS		4096
+
+#ifdef DG_PROFILE_PHYSICS
+	#define DG_PROFILE_PHASE(world,phase,threadID)				dgProfiler::dgScope profilerScope_##phase ((world)->m_profiler, dgProfiler::phase, threadID)
+	#define DG_PROFILE_UPDATE_PHASE(world,phase)				dgProfiler::dgScope profilerScope_##phase ((world)->m_profiler, dgProfiler::phase, (world)->m_profiler.GetUpdateThreadID())
+	#define DG_PROFILE_ITEMS(world,phase,threadID,count)		(world)->m_profiler.AddItems (dgProfiler::phase, threadID, count)
+	#define DG_PROFILE_UPDATE_ITEMS(world,phase,count)			(world)->m_profiler.AddItems (dgProfiler::phase, (world)->m_profiler.GetUpdateThreadID(), count)
+	#define DG_PROFILE_BEGIN_FRAME(world)						(world)->m_profiler.BeginFrame()
+	#define DG_PROFILE_END_FRAME(world)							(world)->m_profiler.EndFrame()
+#else
+	#define DG_PROFILE_PHASE(world,phase,threadID)
+	#define DG_PROFILE_UPDATE_PHASE(world,phase)
+	#define DG_PROFILE_ITEMS(world,phase,threadID,count)
+	#define DG_PROFILE_UPDATE_ITEMS(world,phase,count)
+	#define DG_PROFILE_BEGIN_FRAME(world)
+	#define DG_PROFILE_END_FRAME(world)
+#endif
+
+// per phase and per thread timing of the world update.
+// every hive thread records into its own track, the thread that drives the update records into
+// one more track after the worker tracks. Instrumentation compiles away unless DG_PROFILE_PHYSICS
+// is defined, and the event buffers are not allocated until the first profiled frame.
+class dgProfiler
+{
+	public:
+	enum dgPhase
+	{
+		m_skeletonUpdate,
+		m_forceCallbacks,
+		m_aggregateEntropy,
+		m_fitness,
+		m_pairScan,
+		m_narrowPhase,
+		m_clusterBuild,
+		m_jacobianBuild,
+		m_solverPasses,
+		m_integration,
+		m_transformCallbacks,
+		m_phaseCount,
+	};
+
+	class dgPhaseInfo
+	{
+		public:
+		dgUnsigned64 m_time;
+		dgInt32 m_calls;
+		dgInt32 m_items;
+	};
+
+	class dgScope
+	{
+		public:
+		dgScope (dgProfiler& profiler, dgPhase phase, dgInt32 threadID);
+		~dgScope ();
+
+		private:
+		dgProfiler& m_profiler;
+		dgUnsigned64 m_start;
+		dgPhase m_phase;
+		dgInt32 m_threadID;
+	};
+
+	dgProfiler (dgMemoryAllocator* const allocator, dgInt32 workerCount);
+	~dgProfiler ();
+
+	void BeginFrame ();
+	void EndFrame ();
+
+	dgInt32 GetUpdateThreadID () const;
+	void AddItems (dgPhase phase, dgInt32 threadID, dgInt32 count);
+
+	// the queries below report the last completed frame, times are in nanoseconds
+	bool HasFrame () const;
+	dgInt32 GetTrackCount () const;
+	dgUnsigned64 GetFrameTime () const;
+	const dgPhaseInfo& GetPhaseInfo (dgInt32 track, dgPhase phase) const;
+
+	// writes the frame as chrome trace event json, returns the size of the whole trace
+	// including the terminator, which is more than bufferSize when the buffer is too small
+	dgInt32 ExportChromeTrace (char* const buffer, dgInt32 bufferSize) const;
+
+	static const char* GetPhaseName (dgPhase phase);
+	static dgUnsigned64 GetTimeInNanoseconds ();
+
+	private:
+	class dgEvent
+	{
+		public:
+		dgUnsigned64 m_start;
+		dgUnsigned64 m_end;
+		dgInt32 m_phase;
+		dgInt32 m_padding;
+	};
+
+	class dgTrack
+	{
+		public:
+		dgPhaseInfo m_phases[m_phaseCount];
+		dgEvent* m_events;
+		dgInt32 m_eventCount;
+		dgInt32 m_droppedEvents;
+		dgInt8 m_padding[64];
+	};
+
+	class dgFrame
+	{
+		public:
+		dgTrack* m_tracks;
+		dgUnsigned64 m_start;
+		dgUnsigned64 m_end;
+	};
+
+	void AllocateFrames ();
+	void Record (dgPhase phase, dgInt32 threadID, dgUnsigned64 start, dgUnsigned64 end);
+
+	dgFrame m_frames[2];
+	dgMemoryAllocator* m_allocator;
+	dgInt32 m_trackCount;
+	dgInt32 m_recording;
+	bool m_hasFrame;
+};
+
+DG_INLINE dgInt32 dgProfiler::GetUpdateThreadID () const
+{
+	return m_trackCount - 1;
+}
+
+DG_INLINE void dgProfiler::AddItems (dgPhase phase, dgInt32 threadID, dgInt32 count)
+{
+	dgAssert (threadID < m_trackCount);
+	dgTrack* const tracks = m_frames[m_recording].m_tracks;
+	if (tracks) {
+		tracks[threadID].m_phases[phase].m_items += count;
+	}
+}
+
+DG_INLINE void dgProfiler::Record (dgPhase phase, dgInt32 threadID, dgUnsigned64 start, dgUnsigned64 end)
+{
+	dgAssert (threadID < m_trackCount);
+	dgTrack* const tracks = m_frames[m_recording].m_tracks;
+	if (!tracks) {
+		return;
+	}
+	dgTrack& track = tracks[threadID];
+	track.m_phases[phase].m_time += end - start;
+	track.m_phases[phase].m_calls ++;
+	if (track.m_eventCount < DG_PROFILER_MAX_EVENTS) {
+		dgEvent& event = track.m_events[track.m_eventCount];
+		event.m_start = start;
+		event.m_end = end;
+		event.m_phase = phase;
+		track.m_eventCount ++;
+	} else {
+		track.m_droppedEvents ++;
+	}
+}
+
+DG_INLINE dgProfiler::dgScope::dgScope (dgProfiler& profiler, dgPhase phase, dgInt32 threadID)
+	:m_profiler(profiler)
+	,m_start(GetTimeInNanoseconds())
+	,m_phase(phase)
+	,m_threadID(threadID)
+{
+}
+
+DG_INLINE dgProfiler::dgScope::~dgScope ()
+{
+	m_profiler.Record (m_phase, m_threadID, m_start, GetTimeInNanoseconds());
+}
+
+#endif
@@ -0,0 +1,365 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dgPhysicsStdafx.h"
+#include "dgBody.h"
+#include "dgWorld.h"
+#include "dgConstraint.h"
+#include "dgDynamicBody.h"
+#include "dgSoaJointSolver.h"
+#include "dgWorldDynamicUpdate.h"
+
+// the normal force slot of rows that are bounded by their friction coefficients alone
+#define DG_SOA_SOLVER_UNIT_NORMAL	DG_CONSTRAINT_MAX_ROWS
+
+
+// load the xyz components of the internal force of one body per lane
+static DG_INLINE void dgSoaLoadForces (dgSoaFloat* const dst, const dgJacobian* const internalForces, const dgInt32* const index, bool angular)
+{
+	dgVector src[DG_SOA_SOLVER_LANES];
+	for (dgInt32 i = 0; i < DG_SOA_SOLVER_LANES; i ++) {
+		src[i] = angular ? internalForces[index[i]].m_angular : internalForces[index[i]].m_linear;
+	}
+
+	dgVector x0;
+	dgVector y0;
+	dgVector z0;
+	dgVector w0;
+	dgVector::Transpose4x4 (x0, y0, z0, w0, src[0], src[1], src[2], src[3]);
+#if (DG_SOA_SOLVER_LANES == 4)
+	dst[0] = x0;
+	dst[1] = y0;
+	dst[2] = z0;
+#else
+	dgVector x1;
+	dgVector y1;
+	dgVector z1;
+	dgVector w1;
+	dgVector::Transpose4x4 (x1, y1, z1, w1, src[4], src[5], src[6], src[7]);
+	dst[0] = dgSoaFloat (x0, x1);
+	dst[1] = dgSoaFloat (y0, y1);
+	dst[2] = dgSoaFloat (z0, z1);
+#endif
+}
+
+// inverse of dgSoaLoadForces, lanes that share a body must not carry any force for it
+static DG_INLINE void dgSoaStoreForces (dgJacobian* const internalForces, const dgInt32* const index, const dgSoaFloat* const src, bool angular)
+{
+	dgVector dst[DG_SOA_SOLVER_LANES];
+#if (DG_SOA_SOLVER_LANES == 4)
+	dgVector::Transpose4x4 (dst[0], dst[1], dst[2], dst[3], src[0], src[1], src[2], dgVector::m_zero);
+#else
+	dgVector::Transpose4x4 (dst[0], dst[1], dst[2], dst[3], src[0].GetLow(), src[1].GetLow(), src[2].GetLow(), dgVector::m_zero);
+	dgVector::Transpose4x4 (dst[4], dst[5], dst[6], dst[7], src[0].GetHigh(), src[1].GetHigh(), src[2].GetHigh(), dgVector::m_zero);
+#endif
+	for (dgInt32 i = 0; i < DG_SOA_SOLVER_LANES; i ++) {
+		if (angular) {
+			internalForces[index[i]].m_angular = dst[i];
+		} else {
+			internalForces[index[i]].m_linear = dst[i];
+		}
+	}
+}
+
+
+dgSoaJointSolver::dgSoaJointSolver (dgFrameArena& arena, dgInt32 threadID, const dgJointInfo* const jointInfoArray, dgInt32 jointCount, dgJacobianMatrixElement* const matrixRow, dgInt32 rowCount)
+	:m_buffer(arena, threadID, dgInt32 (jointCount * sizeof (dgSoaJointBlock) + rowCount * sizeof (dgSoaMatrixRow) + DG_SOA_SOLVER_ALIGMENT))
+	,m_jointInfoArray(jointInfoArray)
+	,m_matrixRow(matrixRow)
+	,m_blocks(NULL)
+	,m_rows(NULL)
+	,m_blockCount(0)
+	,m_rowCount(rowCount)
+{
+	// the arena only guarantees simd alignment, the wide lanes need more
+	dgInt8* const memory = (dgInt8*) ((PointerToInt (m_buffer.GetBuffer()) + DG_SOA_SOLVER_ALIGMENT - 1) & -DG_SOA_SOLVER_ALIGMENT);
+	m_blocks = (dgSoaJointBlock*) memory;
+	m_rows = (dgSoaMatrixRow*) &memory[jointCount * sizeof (dgSoaJointBlock)];
+
+	PackJoints (jointInfoArray, jointCount);
+	TransposeRows ();
+}
+
+void dgSoaJointSolver::PackJoints (const dgJointInfo* const jointInfoArray, dgInt32 jointCount)
+{
+	// greedy coloring, each joint goes to the first of the last few open blocks that has no body in common with it.
+	// index zero is the static sentinel and never conflicts, since its forces are discarded.
+	m_blockCount = 0;
+	for (dgInt32 i = 0; i < jointCount; i ++) {
+		const dgJointInfo* const jointInfo = &jointInfoArray[i];
+		const dgInt32 m0 = jointInfo->m_m0;
+		const dgInt32 m1 = jointInfo->m_m1;
+
+		dgSoaJointBlock* block = NULL;
+		for (dgInt32 j = dgMax (0, m_blockCount - DG_SOA_SOLVER_BLOCK_WINDOW); (j < m_blockCount) && !block; j ++) {
+			dgSoaJointBlock* const candidate = &m_blocks[j];
+			if (candidate->m_laneCount < DG_SOA_SOLVER_LANES) {
+				bool conflict = false;
+				for (dgInt32 k = 0; (k < candidate->m_laneCount) && !conflict; k ++) {
+					const dgInt32 n0 = candidate->m_m0[k];
+					const dgInt32 n1 = candidate->m_m1[k];
+					conflict = (m0 && ((m0 == n0) || (m0 == n1))) || (m1 && ((m1 == n0) || (m1 == n1)));
+				}
+				if (!conflict) {
+					block = candidate;
+				}
+			}
+		}
+
+		if (!block) {
+			block = &m_blocks[m_blockCount];
+			m_blockCount ++;
+			block->m_scale0 = dgSoaFloat (dgFloat32 (0.0f));
+			block->m_scale1 = dgSoaFloat (dgFloat32 (0.0f));
+			for (dgInt32 j = 0; j < DG_SOA_SOLVER_LANES; j ++) {
+				block->m_m0[j] = 0;
+				block->m_m1[j] = 0;
+				block->m_joint[j] = -1;
+			}
+			block->m_rowCount = 0;
+			block->m_laneCount = 0;
+		}
+
+		const dgInt32 lane = block->m_laneCount;
+		block->m_m0[lane] = m0;
+		block->m_m1[lane] = m1;
+		block->m_joint[lane] = i;
+		block->m_scale0[lane] = jointInfo->m_scale0;
+		block->m_scale1[lane] = jointInfo->m_scale1;
+		block->m_rowCount = dgMax (block->m_rowCount, jointInfo->m_pairCount);
+		block->m_laneCount ++;
+	}
+
+	dgInt32 rowStart = 0;
+	for (dgInt32 i = 0; i < m_blockCount; i ++) {
+		m_blocks[i].m_rowStart = rowStart;
+		rowStart += m_blocks[i].m_rowCount;
+	}
+	dgAssert (rowStart <= m_rowCount);
+	m_rowCount = rowStart;
+}
+
+void dgSoaJointSolver::TransposeRows ()
+{
+	for (dgInt32 i = 0; i < m_blockCount; i ++) {
+		const dgSoaJointBlock* const block = &m_blocks[i];
+		for (dgInt32 j = 0; j < block->m_rowCount; j ++) {
+			dgSoaMatrixRow* const dst = &m_rows[block->m_rowStart + j];
+			dgInt32 sharedIndex = -1;
+			bool shared = true;
+			for (dgInt32 k = 0; k < DG_SOA_SOLVER_LANES; k ++) {
+				const dgInt32 joint = block->m_joint[k];
+				const dgJointInfo* const jointInfo = (joint >= 0) ? &m_jointInfoArray[joint] : NULL;
+				if (jointInfo && (j < jointInfo->m_pairCount)) {
+					const dgJacobianMatrixElement* const src = &m_matrixRow[jointInfo->m_pairStart + j];
+					for (dgInt32 n = 0; n < 3; n ++) {
+						dst->m_Jt[n + 0][k] = src->m_Jt.m_jacobianM0.m_linear[n];
+						dst->m_Jt[n + 3][k] = src->m_Jt.m_jacobianM0.m_angular[n];
+						dst->m_Jt[n + 6][k] = src->m_Jt.m_jacobianM1.m_linear[n];
+						dst->m_Jt[n + 9][k] = src->m_Jt.m_jacobianM1.m_angular[n];
+						dst->m_JMinv[n + 0][k] = src->m_JMinv.m_jacobianM0.m_linear[n];
+						dst->m_JMinv[n + 3][k] = src->m_JMinv.m_jacobianM0.m_angular[n];
+						dst->m_JMinv[n + 6][k] = src->m_JMinv.m_jacobianM1.m_linear[n];
+						dst->m_JMinv[n + 9][k] = src->m_JMinv.m_jacobianM1.m_angular[n];
+					}
+					dst->m_force[k] = src->m_force;
+					dst->m_diagDamp[k] = src->m_diagDamp;
+					dst->m_invJinvMJt[k] = src->m_invJinvMJt;
+					dst->m_coordenateAccel[k] = src->m_coordenateAccel;
+					dst->m_lowerBoundFrictionCoefficent[k] = src->m_lowerBoundFrictionCoefficent;
+					dst->m_upperBoundFrictionCoefficent[k] = src->m_upperBoundFrictionCoefficent;
+					dst->m_maxImpact[k] = src->m_maxImpact;
+
+					dgAssert (src->m_normalForceIndex >= 0);
+					dgAssert (src->m_normalForceIndex <= jointInfo->m_pairCount);
+					const dgInt32 normalIndex = (src->m_normalForceIndex == jointInfo->m_pairCount) ? DG_SOA_SOLVER_UNIT_NORMAL : src->m_normalForceIndex;
+					dst->m_normalForceIndex[k] = normalIndex;
+					shared = shared && ((sharedIndex == -1) || (sharedIndex == normalIndex));
+					sharedIndex = normalIndex;
+				} else {
+					// padding rows have zero bounds, so their force never leaves zero
+					for (dgInt32 n = 0; n < 12; n ++) {
+						dst->m_Jt[n][k] = dgFloat32 (0.0f);
+						dst->m_JMinv[n][k] = dgFloat32 (0.0f);
+					}
+					dst->m_force[k] = dgFloat32 (0.0f);
+					dst->m_diagDamp[k] = dgFloat32 (0.0f);
+					dst->m_invJinvMJt[k] = dgFloat32 (0.0f);
+					dst->m_coordenateAccel[k] = dgFloat32 (0.0f);
+					dst->m_lowerBoundFrictionCoefficent[k] = dgFloat32 (0.0f);
+					dst->m_upperBoundFrictionCoefficent[k] = dgFloat32 (0.0f);
+					dst->m_maxImpact[k] = dgFloat32 (0.0f);
+					dst->m_normalForceIndex[k] = -1;
+				}
+			}
+
+			dgAssert (sharedIndex != -1);
+			for (dgInt32 k = 0; k < DG_SOA_SOLVER_LANES; k ++) {
+				if (dst->m_normalForceIndex[k] == -1) {
+					dst->m_normalForceIndex[k] = sharedIndex;
+				}
+			}
+			dst->m_sharedNormalForceIndex = shared ? sharedIndex : -1;
+		}
+	}
+}
+
+void dgSoaJointSolver::UpdateAccelerations ()
+{
+	for (dgInt32 i = 0; i < m_blockCount; i ++) {
+		const dgSoaJointBlock* const block = &m_blocks[i];
+		for (dgInt32 k = 0; k < block->m_laneCount; k ++) {
+			const dgJointInfo* const jointInfo = &m_jointInfoArray[block->m_joint[k]];
+			const dgJacobianMatrixElement* const src = &m_matrixRow[jointInfo->m_pairStart];
+			dgSoaMatrixRow* const dst = &m_rows[block->m_rowStart];
+			for (dgInt32 j = 0; j < jointInfo->m_pairCount; j ++) {
+				dst[j].m_coordenateAccel[k] = src[j].m_coordenateAccel;
+			}
+		}
+	}
+}
+
+void dgSoaJointSolver::UpdateForces () const
+{
+	for (dgInt32 i = 0; i < m_blockCount; i ++) {
+		const dgSoaJointBlock* const block = &m_blocks[i];
+		for (dgInt32 k = 0; k < block->m_laneCount; k ++) {
+			const dgJointInfo* const jointInfo = &m_jointInfoArray[block->m_joint[k]];
+			dgJacobianMatrixElement* const dst = &m_matrixRow[jointInfo->m_pairStart];
+			const dgSoaMatrixRow* const src = &m_rows[block->m_rowStart];
+			for (dgInt32 j = 0; j < jointInfo->m_pairCount; j ++) {
+				dst[j].m_force = src[j].m_force[k];
+				dst[j].m_maxImpact = src[j].m_maxImpact[k];
+			}
+		}
+	}
+}
+
+dgFloat32 dgSoaJointSolver::CalculateJointForces (const dgBodyInfo* const bodyArray, dgJacobian* const internalForces) const
+{
+	dgFloat32 accNorm = dgFloat32 (0.0f);
+	for (dgInt32 i = 0; i < m_blockCount; i ++) {
+		accNorm += CalculateBlockForces (&m_blocks[i], bodyArray, internalForces);
+	}
+	return accNorm;
+}
+
+// same iteration as dgWorldDynamicUpdate::CalculateJointForce_3_13 with one joint per lane
+dgFloat32 dgSoaJointSolver::CalculateBlockForces (const dgSoaJointBlock* const block, const dgBodyInfo* const bodyArray, dgJacobian* const internalForces) const
+{
+	dgSoaFloat active (dgFloat32 (0.0f));
+	bool hasActiveLanes = false;
+	for (dgInt32 i = 0; i < block->m_laneCount; i ++) {
+		const dgBody* const body0 = bodyArray[block->m_m0[i]].m_body;
+		const dgBody* const body1 = bodyArray[block->m_m1[i]].m_body;
+		if (!(body0->m_resting & body1->m_resting)) {
+			active[i] = dgFloat32 (1.0f);
+			hasActiveLanes = true;
+		}
+	}
+	if (!hasActiveLanes) {
+		return dgFloat32 (0.0f);
+	}
+
+	const dgSoaFloat zero (dgFloat32 (0.0f));
+	const dgSoaFloat activeMask (active > zero);
+
+	dgSoaFloat body[12];
+	dgSoaLoadForces (&body[0], internalForces, block->m_m0, false);
+	dgSoaLoadForces (&body[3], internalForces, block->m_m0, true);
+	dgSoaLoadForces (&body[6], internalForces, block->m_m1, false);
+	dgSoaLoadForces (&body[9], internalForces, block->m_m1, true);
+
+	const dgSoaFloat scale0 (block->m_scale0);
+	const dgSoaFloat scale1 (block->m_scale1);
+
+	dgSoaMatrixRow* const rows = &m_rows[block->m_rowStart];
+	const dgInt32 rowsCount = block->m_rowCount;
+
+	dgSoaFloat normalForce[DG_CONSTRAINT_MAX_ROWS + 1];
+	for (dgInt32 i = 0; i < rowsCount; i ++) {
+		normalForce[i] = rows[i].m_force;
+	}
+	normalForce[DG_SOA_SOLVER_UNIT_NORMAL] = dgSoaFloat (dgFloat32 (1.0f));
+
+	dgSoaFloat accNorm (zero);
+	dgSoaFloat firstPass (dgFloat32 (1.0f));
+	dgFloat32 maxAccel = dgFloat32 (3.0f);
+	const dgFloat32 restAcceleration = DG_SOLVER_MAX_ERROR * DG_SOLVER_MAX_ERROR * dgFloat32(4.0f);
+	for (dgInt32 i = 0; (i < 4) && (maxAccel > restAcceleration); i ++) {
+		dgSoaFloat maxAccelLanes (zero);
+		for (dgInt32 k = 0; k < rowsCount; k ++) {
+			dgSoaMatrixRow* const row = &rows[k];
+
+			dgSoaFloat diag (row->m_JMinv[0] * body[0]);
+			for (dgInt32 n = 1; n < 12; n ++) {
+				diag += row->m_JMinv[n] * body[n];
+			}
+
+			dgSoaFloat accel (row->m_coordenateAccel - row->m_force * row->m_diagDamp - diag);
+			dgSoaFloat force (row->m_force + row->m_invJinvMJt * accel);
+
+			dgSoaFloat frictionNormal;
+			if (row->m_sharedNormalForceIndex >= 0) {
+				frictionNormal = normalForce[row->m_sharedNormalForceIndex];
+			} else {
+				for (dgInt32 n = 0; n < DG_SOA_SOLVER_LANES; n ++) {
+					frictionNormal[n] = normalForce[row->m_normalForceIndex[n]][n];
+				}
+			}
+			const dgSoaFloat lowerFrictionForce (frictionNormal * row->m_lowerBoundFrictionCoefficent);
+			const dgSoaFloat upperFrictionForce (frictionNormal * row->m_upperBoundFrictionCoefficent);
+
+			accel = accel.AndNot ((force > upperFrictionForce) | (force < lowerFrictionForce)) & activeMask;
+			force = force.GetMax (lowerFrictionForce).GetMin (upperFrictionForce);
+
+			maxAccelLanes = maxAccelLanes.GetMax (accel.Abs());
+			accNorm = accNorm.GetMax (maxAccelLanes * firstPass);
+
+			// resting lanes keep their force
+			const dgSoaFloat deltaForce ((force - row->m_force) & activeMask);
+			force = row->m_force + deltaForce;
+			row->m_force = force;
+			normalForce[k] = force;
+
+			const dgSoaFloat deltaforce0 (scale0 * deltaForce);
+			const dgSoaFloat deltaforce1 (scale1 * deltaForce);
+			for (dgInt32 n = 0; n < 6; n ++) {
+				body[n] += row->m_Jt[n] * deltaforce0;
+				body[n + 6] += row->m_Jt[n + 6] * deltaforce1;
+			}
+		}
+		firstPass = zero;
+		maxAccel = maxAccelLanes.MaxHorizontal();
+	}
+
+	for (dgInt32 i = 0; i < rowsCount; i ++) {
+		dgSoaMatrixRow* const row = &rows[i];
+		row->m_maxImpact = row->m_maxImpact.GetMax (row->m_force.Abs());
+	}
+
+	dgSoaStoreForces (internalForces, block->m_m0, &body[0], false);
+	dgSoaStoreForces (internalForces, block->m_m0, &body[3], true);
+	dgSoaStoreForces (internalForces, block->m_m1, &body[6], false);
+	dgSoaStoreForces (internalForces, block->m_m1, &body[9], true);
+
+	return (accNorm * accNorm).AddHorizontal();
+}
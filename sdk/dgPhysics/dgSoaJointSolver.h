@@ -0,0 +1,325 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef _DG_SOA_JOINT_SOLVER_H__
+#define _DG_SOA_JOINT_SOLVER_H__
+
+#include "dgPhysicsStdafx.h"
+#include "dgWorldDynamicUpdate.h"
+
+// clusters with fewer joints than this are solved one joint at the time
+#define DG_SOA_SOLVER_MIN_JOINTS		8
+
+// how many of the last open blocks a joint is tested against before it starts a new block
+#define DG_SOA_SOLVER_BLOCK_WINDOW		8
+
+#if defined (__AVX2__) && !defined (DG_SCALAR_VECTOR_CLASS) && !defined (_NEWTON_USE_DOUBLE)
+	#include <immintrin.h>
+	#define DG_SOA_SOLVER_LANES			8
+	#define DG_SOA_SOLVER_ALIGMENT		DG_VECTOR_AVX2_SIZE
+
+	// eight single precision lanes, with the subset of the dgVector interface the soa solver uses
+	DG_MSC_AVX2_ALIGMENT
+	class dgSoaFloat
+	{
+		public:
+		DG_INLINE dgSoaFloat ()
+		{
+		}
+
+		DG_INLINE dgSoaFloat (dgFloat32 val)
+			:m_type(_mm256_set1_ps (val))
+		{
+		}
+
+		DG_INLINE dgSoaFloat (const __m256 type)
+			:m_type(type)
+		{
+		}
+
+		DG_INLINE dgSoaFloat (const dgVector& low, const dgVector& high)
+			:m_type(_mm256_insertf128_ps (_mm256_castps128_ps256 (low.m_type), high.m_type, 1))
+		{
+		}
+
+		DG_INLINE dgFloat32& operator[] (dgInt32 i)
+		{
+			dgAssert (i < DG_SOA_SOLVER_LANES);
+			dgAssert (i >= 0);
+			return m_f[i];
+		}
+
+		DG_INLINE const dgFloat32& operator[] (dgInt32 i) const
+		{
+			dgAssert (i < DG_SOA_SOLVER_LANES);
+			dgAssert (i >= 0);
+			return m_f[i];
+		}
+
+		DG_INLINE dgVector GetLow () const
+		{
+			return _mm256_castps256_ps128 (m_type);
+		}
+
+		DG_INLINE dgVector GetHigh () const
+		{
+			return _mm256_extractf128_ps (m_type, 1);
+		}
+
+		DG_INLINE dgSoaFloat operator+ (const dgSoaFloat& A) const
+		{
+			return _mm256_add_ps (m_type, A.m_type);
+		}
+
+		DG_INLINE dgSoaFloat& operator+= (const dgSoaFloat& A)
+		{
+			m_type = _mm256_add_ps (m_type, A.m_type);
+			return *this;
+		}
+
+		DG_INLINE dgSoaFloat operator- (const dgSoaFloat& A) const
+		{
+			return _mm256_sub_ps (m_type, A.m_type);
+		}
+
+		DG_INLINE dgSoaFloat operator* (const dgSoaFloat& A) const
+		{
+			return _mm256_mul_ps (m_type, A.m_type);
+		}
+
+		DG_INLINE dgSoaFloat operator> (const dgSoaFloat& A) const
+		{
+			return _mm256_cmp_ps (m_type, A.m_type, _CMP_GT_OQ);
+		}
+
+		DG_INLINE dgSoaFloat operator< (const dgSoaFloat& A) const
+		{
+			return _mm256_cmp_ps (m_type, A.m_type, _CMP_LT_OQ);
+		}
+
+		DG_INLINE dgSoaFloat operator| (const dgSoaFloat& A) const
+		{
+			return _mm256_or_ps (m_type, A.m_type);
+		}
+
+		DG_INLINE dgSoaFloat operator& (const dgSoaFloat& A) const
+		{
+			return _mm256_and_ps (m_type, A.m_type);
+		}
+
+		DG_INLINE dgSoaFloat AndNot (const dgSoaFloat& A) const
+		{
+			return _mm256_andnot_ps (A.m_type, m_type);
+		}
+
+		DG_INLINE dgSoaFloat GetMax (const dgSoaFloat& A) const
+		{
+			return _mm256_max_ps (m_type, A.m_type);
+		}
+
+		DG_INLINE dgSoaFloat GetMin (const dgSoaFloat& A) const
+		{
+			return _mm256_min_ps (m_type, A.m_type);
+		}
+
+		DG_INLINE dgSoaFloat Abs () const
+		{
+			return _mm256_and_ps (m_type, _mm256_castsi256_ps (_mm256_set1_epi32 (0x7fffffff)));
+		}
+
+		DG_INLINE dgFloat32 AddHorizontal () const
+		{
+			return (GetLow() + GetHigh()).AddHorizontal().GetScalar();
+		}
+
+		DG_INLINE dgFloat32 MaxHorizontal () const
+		{
+			const dgVector max (GetLow().GetMax (GetHigh()));
+			return dgMax (dgMax (max.m_x, max.m_y), dgMax (max.m_z, max.m_w));
+		}
+
+		union {
+			__m256 m_type;
+			dgFloat32 m_f[DG_SOA_SOLVER_LANES];
+		};
+	} DG_GCC_AVX2_ALIGMENT;
+#else
+	#define DG_SOA_SOLVER_LANES			4
+	#define DG_SOA_SOLVER_ALIGMENT		DG_VECTOR_SIMD_SIZE
+
+	// four lanes are just a dgVector
+	class dgSoaFloat: public dgVector
+	{
+		public:
+		DG_INLINE dgSoaFloat ()
+			:dgVector()
+		{
+		}
+
+		DG_INLINE dgSoaFloat (dgFloat32 val)
+			:dgVector(val)
+		{
+		}
+
+		DG_INLINE dgSoaFloat (const dgVector& v)
+			:dgVector(v)
+		{
+		}
+
+		DG_INLINE dgSoaFloat operator+ (const dgSoaFloat& A) const
+		{
+			return dgVector::operator+ (A);
+		}
+
+		DG_INLINE dgSoaFloat& operator+= (const dgSoaFloat& A)
+		{
+			dgVector::operator+= (A);
+			return *this;
+		}
+
+		DG_INLINE dgSoaFloat operator- (const dgSoaFloat& A) const
+		{
+			return dgVector::operator- (A);
+		}
+
+		DG_INLINE dgSoaFloat operator* (const dgSoaFloat& A) const
+		{
+			return dgVector::operator* (A);
+		}
+
+		DG_INLINE dgSoaFloat operator> (const dgSoaFloat& A) const
+		{
+			return dgVector::operator> (A);
+		}
+
+		DG_INLINE dgSoaFloat operator< (const dgSoaFloat& A) const
+		{
+			return dgVector::operator< (A);
+		}
+
+		DG_INLINE dgSoaFloat operator| (const dgSoaFloat& A) const
+		{
+			return dgVector::operator| (A);
+		}
+
+		DG_INLINE dgSoaFloat operator& (const dgSoaFloat& A) const
+		{
+			return dgVector::operator& (A);
+		}
+
+		DG_INLINE dgSoaFloat AndNot (const dgSoaFloat& A) const
+		{
+			return dgVector::AndNot (A);
+		}
+
+		DG_INLINE dgSoaFloat GetMax (const dgSoaFloat& A) const
+		{
+			return dgVector::GetMax (A);
+		}
+
+		DG_INLINE dgSoaFloat GetMin (const dgSoaFloat& A) const
+		{
+			return dgVector::GetMin (A);
+		}
+
+		DG_INLINE dgSoaFloat Abs () const
+		{
+			return dgVector::Abs ();
+		}
+
+		DG_INLINE dgFloat32 AddHorizontal () const
+		{
+			return dgVector::AddHorizontal().GetScalar();
+		}
+
+		DG_INLINE dgFloat32 MaxHorizontal () const
+		{
+			return dgMax (dgMax (m_x, m_y), dgMax (m_z, m_w));
+		}
+	};
+#endif
+
+
+// solves the joints of one cluster with projected Gauss Seidel, DG_SOA_SOLVER_LANES joints at the time.
+// joints are packed in blocks of joints that do not share a dynamic body, and the rows of each block
+// are transposed so that every lane of a dgSoaFloat holds the same row of a different joint.
+// the blocks keep the joint order of the cluster as close as the packing allows.
+class dgSoaJointSolver
+{
+	public:
+	dgSoaJointSolver (dgFrameArena& arena, dgInt32 threadID, const dgJointInfo* const jointInfoArray, dgInt32 jointCount, dgJacobianMatrixElement* const matrixRow, dgInt32 rowCount);
+
+	// read the joint accelerations after the joints recalculated them
+	void UpdateAccelerations ();
+
+	// one pass over all blocks, return the sum of the squared joint residual accelerations
+	dgFloat32 CalculateJointForces (const dgBodyInfo* const bodyArray, dgJacobian* const internalForces) const;
+
+	// write the forces back to the jacobian rows
+	void UpdateForces () const;
+
+	private:
+	class dgSoaMatrixRow
+	{
+		public:
+		// linear and angular components of both bodies, xyz each
+		dgSoaFloat m_Jt[12];
+		dgSoaFloat m_JMinv[12];
+		dgSoaFloat m_force;
+		dgSoaFloat m_diagDamp;
+		dgSoaFloat m_invJinvMJt;
+		dgSoaFloat m_coordenateAccel;
+		dgSoaFloat m_lowerBoundFrictionCoefficent;
+		dgSoaFloat m_upperBoundFrictionCoefficent;
+		dgSoaFloat m_maxImpact;
+		dgInt32 m_normalForceIndex[DG_SOA_SOLVER_LANES];
+		// the normal index of all lanes when they agree, -1 otherwise
+		dgInt32 m_sharedNormalForceIndex;
+	};
+
+	class dgSoaJointBlock
+	{
+		public:
+		dgSoaFloat m_scale0;
+		dgSoaFloat m_scale1;
+		dgInt32 m_m0[DG_SOA_SOLVER_LANES];
+		dgInt32 m_m1[DG_SOA_SOLVER_LANES];
+		dgInt32 m_joint[DG_SOA_SOLVER_LANES];
+		dgInt32 m_rowStart;
+		dgInt32 m_rowCount;
+		dgInt32 m_laneCount;
+	};
+
+	void PackJoints (const dgJointInfo* const jointInfoArray, dgInt32 jointCount);
+	void TransposeRows ();
+	dgFloat32 CalculateBlockForces (const dgSoaJointBlock* const block, const dgBodyInfo* const bodyArray, dgJacobian* const internalForces) const;
+
+	dgFrameArena::dgBuffer<dgInt8> m_buffer;
+	const dgJointInfo* m_jointInfoArray;
+	dgJacobianMatrixElement* m_matrixRow;
+	dgSoaJointBlock* m_blocks;
+	dgSoaMatrixRow* m_rows;
+	dgInt32 m_blockCount;
+	dgInt32 m_rowCount;
+};
+
+#endif
+
@@ -38,6 +38,7 @@
 #include "dgWorldDynamicUpdate.h"
 #include "dgCollisionConvexHull.h"
 #include "dgBroadPhasePersistent.h"
+#include "dgBroadPhaseSAP.h"
 #include "dgCollisionChamferCylinder.h"
 
 #include "dgUserConstraint.h"
@@ -214,7 +215,11 @@ dgWorld::dgWorld(dgMemoryAllocator* const allocator)
 	,m_solverJacobiansMemory (allocator, 64)
 	,m_solverForceAccumulatorMemory (allocator, 64)
 	,m_clusterMemory (allocator, 64)
-	,m_stack(allocator)
+	,m_solverThreadMemory (allocator, 64)
+	,m_transformBodiesMemory (allocator, 64)
+	,m_frameArena(allocator, GetMaxThreadCount())
+	,m_contactPointPool(allocator)
+	,m_profiler(allocator, GetMaxThreadCount())
 	,m_postUpdateCallback(NULL)
 {
 	dgMutexThread* const mutexThread = this;
@@ -239,15 +244,21 @@ dgWorld::dgWorld(dgMemoryAllocator* const allocator)
 	m_deserializedJointCallback = NULL;	
 
 	m_inUpdate = 0;
-	m_bodyGroupID = 0;
 	m_lastExecutionTime = 0;
 	
 	m_defualtBodyGroupID = CreateBodyGroupID();
 	m_genericLRUMark = 0;
 	m_delayDelateLock = 0;
 	m_clusterLRU = 0;
+	m_transformBodiesCount = 0;
+	m_transformAtomicIndex = 0;
+	m_movedBodyLists = (dgMovedBodyList*) m_allocator->MallocLow (GetMaxThreadCount() * sizeof (dgMovedBodyList));
+	for (dgInt32 i = 0; i < GetMaxThreadCount(); i ++) {
+		new (&m_movedBodyLists[i]) dgMovedBodyList;
+	}
 
 	m_useParallelSolver = 0;
+	m_useSoaSolver = 0;
 
 	m_solverMode = DG_DEFAULT_SOLVER_ITERATION_COUNT;
 	m_dynamicsLru = 0;
@@ -319,6 +330,14 @@ dgWorld::~dgWorld()
 	DestroyBody (m_sentinelBody);
 
 	delete m_broadPhase;
+
+	for (dgInt32 i = 0; i < GetMaxThreadCount(); i ++) {
+		if (m_movedBodyLists[i].m_bodies) {
+			m_allocator->FreeLow (m_movedBodyLists[i].m_bodies);
+		}
+		m_movedBodyLists[i].~dgMovedBodyList();
+	}
+	m_allocator->FreeLow (m_movedBodyLists);
 }
 
 
@@ -365,6 +384,7 @@ void dgWorld::DestroyAllBodies()
 void dgWorld::SetThreadsCount (dgInt32 count)
 {
 	dgThreadHive::SetThreadsCount(count);
+	m_solverThreadMemory.Resize(GetThreadCount() * sizeof (dgParallelSolverThreadData));
 }
 
 dgUnsigned32 dgWorld::GetPerformanceCount ()
@@ -379,6 +399,8 @@ void dgWorld::AddSentinelBody()
 	collision->Release();
 	m_sentinelBody = CreateDynamicBody(instance, dgGetIdentityMatrix());
 	instance->Release();
+	// the sentinel is not a simulated body, keep it out of the moved body set
+	RemoveMovedBody (m_sentinelBody);
 }
 
 dgDynamicBody* dgWorld::GetSentinelBody() const
@@ -389,12 +411,13 @@ dgDynamicBody* dgWorld::GetSentinelBody() const
 
 void dgWorld::SetSolverMode (dgInt32 mode)
 {
-	m_solverMode = dgUnsigned32 (dgMax (1, mode));
+	m_useSoaSolver = (mode & DG_SOLVER_MODE_SOA_JOINTS) ? 1 : 0;
+	m_solverMode = dgUnsigned32 (dgMax (1, mode & ~DG_SOLVER_MODE_SOA_JOINTS));
 }
 
 dgInt32 dgWorld::GetSolverMode() const
 {
-	return m_solverMode;
+	return dgInt32 (m_solverMode) | (m_useSoaSolver ? DG_SOLVER_MODE_SOA_JOINTS : 0);
 }
 
 
@@ -453,10 +476,7 @@ void dgWorld::SetFrictionThreshold (dgFloat32 acceleration)
 
 void dgWorld::RemoveAllGroupID()
 {
-	while (dgBodyMaterialList::GetCount()) {
-		dgBodyMaterialList::Remove (dgBodyMaterialList::GetRoot());
-	}
-	m_bodyGroupID = 0;
+	dgBodyMaterialList::RemoveAllGroups();
 	m_defualtBodyGroupID = CreateBodyGroupID();
 }
 
@@ -550,7 +570,8 @@ void dgWorld::DestroyBody(dgBody* const body)
 	if (body->m_destructor) {
 		body->m_destructor (*body);
 	}
-	
+
+	RemoveMovedBody (body);
 	if (m_disableBodies.Find(body)) {
 		m_disableBodies.Remove(body);
 	} else {
@@ -910,9 +931,11 @@ void dgWorld::StepDynamics (dgFloat32 timestep)
 
 	m_inUpdate ++;
 
+	m_frameArena.Reset();
 	UpdateSkeletons();
 	UpdateBroadphase(timestep);
 	UpdateDynamics (timestep);
+	m_broadPhase->UpdateQueryStructure();
 
 	if (m_listeners.GetCount()) {
 		for (dgListenerList::dgListNode* node = m_listeners.GetFirst(); node; node = node->GetNext()) {
@@ -953,32 +976,586 @@ void dgWorld::Sync ()
 	}
 }
 
-void dgWorld::UpdateTransforms(dgBodyMasterList::dgListNode* node, dgInt32 threadID)
+void dgWorld::UpdateTransforms(dgInt32 threadID)
 {
-	const dgInt32 threadsCount = GetThreadCount();
-	while (node) {
-		dgBody* const body = node->GetInfo().GetBody();
-		if (body->m_transformIsDirty && body->m_matrixUpdate) {
-			body->m_matrixUpdate (*body, body->m_matrix, threadID);
+	DG_PROFILE_PHASE (this, m_transformCallbacks, threadID);
+	const dgInt32 count = m_transformBodiesCount;
+	dgBody** const bodyArray = (dgBody**) &m_transformBodiesMemory[0];
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&m_transformAtomicIndex, DG_TRANSFORM_BODY_CHUNK); i < count; i = dgAtomicExchangeAndAdd(&m_transformAtomicIndex, DG_TRANSFORM_BODY_CHUNK)) {
+		const dgInt32 chunkEnd = dgMin (i + DG_TRANSFORM_BODY_CHUNK, count);
+		for (dgInt32 j = i; j < chunkEnd; j ++) {
+			dgBody* const body = bodyArray[j];
+			dgAssert (body->m_transformIsDirty);
+			if (body->m_matrixUpdate) {
+				body->m_matrixUpdate (*body, body->m_matrix, threadID);
+			}
+			body->m_transformIsDirty = false;
+			body->m_movedIndex = j;
 		}
+	}
+}
+
+void dgWorld::UpdateTransforms(void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgWorld* const world = (dgWorld*)context;
+	world->UpdateTransforms(threadID);
+}
+
+void dgWorld::AddMovedBody (dgBody* const body, dgInt32 threadIndex)
+{
+	if (body == m_sentinelBody) {
+		return;
+	}
+	// the integration threads append to their own list, moves from outside the update go to the first one
+	const dgInt32 listIndex = (m_inUpdate && (threadIndex < GetThreadCount())) ? threadIndex : 0;
+	dgMovedBodyList& list = m_movedBodyLists[listIndex];
+	dgThreadHiveScopeLock lock (this, &list.m_lock, false);
+	if (list.m_count >= list.m_capacity) {
+		const dgInt32 capacity = dgMax (list.m_capacity * 2, 256);
+		dgBody** const bodies = (dgBody**) m_allocator->MallocLow (capacity * sizeof (dgBody*));
+		if (list.m_bodies) {
+			memcpy (bodies, list.m_bodies, list.m_count * sizeof (dgBody*));
+			m_allocator->FreeLow (list.m_bodies);
+		}
+		list.m_bodies = bodies;
+		list.m_capacity = capacity;
+	}
+	body->m_movedList = listIndex;
+	body->m_movedListEntry = list.m_count;
+	list.m_bodies[list.m_count] = body;
+	list.m_count ++;
+}
+
+void dgWorld::RemoveMovedBody (dgBody* const body)
+{
+	if (body->m_movedList >= 0) {
+		dgMovedBodyList& list = m_movedBodyLists[body->m_movedList];
+		dgThreadHiveScopeLock lock (this, &list.m_lock, false);
+		const dgInt32 entry = body->m_movedListEntry;
+		dgAssert (list.m_bodies[entry] == body);
+		list.m_count --;
+		dgBody* const last = list.m_bodies[list.m_count];
+		list.m_bodies[entry] = last;
+		last->m_movedListEntry = entry;
+		body->m_movedList = -1;
+		body->m_movedListEntry = -1;
 		body->m_transformIsDirty = false;
+	}
+
+	const dgInt32 index = body->m_movedIndex;
+	if (index >= 0) {
+		dgBody** const bodyArray = (dgBody**) &m_transformBodiesMemory[0];
+		dgAssert (bodyArray[index] == body);
+		m_transformBodiesCount --;
+		dgBody* const last = bodyArray[m_transformBodiesCount];
+		bodyArray[index] = last;
+		last->m_movedIndex = index;
+		body->m_movedIndex = -1;
+	}
+}
+
+void dgWorld::CollectMovedBodies ()
+{
+	// the bodies that moved on the previous step leave the moved set
+	dgBody** bodyArray = (dgBody**) &m_transformBodiesMemory[0];
+	for (dgInt32 i = 0; i < m_transformBodiesCount; i ++) {
+		bodyArray[i]->m_movedIndex = -1;
+	}
+
+	dgInt32 count = 0;
+	for (dgInt32 i = 0; i < GetMaxThreadCount(); i ++) {
+		count += m_movedBodyLists[i].m_count;
+	}
+	m_transformBodiesMemory.ResizeIfNecessary ((count + 1) * sizeof (dgBody*));
+	bodyArray = (dgBody**) &m_transformBodiesMemory[0];
+
+	count = 0;
+	for (dgInt32 i = 0; i < GetMaxThreadCount(); i ++) {
+		dgMovedBodyList& list = m_movedBodyLists[i];
+		for (dgInt32 j = 0; j < list.m_count; j ++) {
+			dgBody* const body = list.m_bodies[j];
+			body->m_movedList = -1;
+			body->m_movedListEntry = -1;
+			bodyArray[count] = body;
+			count ++;
+		}
+		list.m_count = 0;
+	}
+	m_transformBodiesCount = count;
+}
+
+dgInt32 dgWorld::GetMovedBodies (OnBodiesInAABB callback, void* const userData) const
+{
+	if (callback) {
+		dgBody* const* const bodyArray = (dgBody* const*) &m_transformBodiesMemory[0];
+		for (dgInt32 i = 0; i < m_transformBodiesCount; i ++) {
+			if (!callback (bodyArray[i], userData)) {
+				break;
+			}
+		}
+	}
+	return m_transformBodiesCount;
+}
+
+void dgWorld::GetBodyStatesKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgBodyStateDescriptor* const descriptor = (dgBodyStateDescriptor*) context;
+	const dgBodyStateArrays* const states = descriptor->m_states;
+	const dgBody* const* const bodies = descriptor->m_bodies;
+	const dgInt32 count = descriptor->m_count;
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, DG_TRANSFORM_BODY_CHUNK); i < count; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, DG_TRANSFORM_BODY_CHUNK)) {
+		const dgInt32 chunkEnd = dgMin (i + DG_TRANSFORM_BODY_CHUNK, count);
+		for (dgInt32 j = i; j < chunkEnd; j ++) {
+			const dgBody* const body = bodies[j];
+			if (states->m_position) {
+				const dgVector& posit = body->m_matrix.m_posit;
+				dgFloat32* const dst = &states->m_position[j * 3];
+				dst[0] = posit.m_x;
+				dst[1] = posit.m_y;
+				dst[2] = posit.m_z;
+			}
+			if (states->m_rotation) {
+				const dgQuaternion& rotation = body->m_rotation;
+				dgFloat32* const dst = &states->m_rotation[j * 4];
+				dst[0] = rotation.m_q0;
+				dst[1] = rotation.m_q1;
+				dst[2] = rotation.m_q2;
+				dst[3] = rotation.m_q3;
+			}
+			if (states->m_veloc) {
+				const dgVector& veloc = body->m_veloc;
+				dgFloat32* const dst = &states->m_veloc[j * 3];
+				dst[0] = veloc.m_x;
+				dst[1] = veloc.m_y;
+				dst[2] = veloc.m_z;
+			}
+			if (states->m_omega) {
+				const dgVector& omega = body->m_omega;
+				dgFloat32* const dst = &states->m_omega[j * 3];
+				dst[0] = omega.m_x;
+				dst[1] = omega.m_y;
+				dst[2] = omega.m_z;
+			}
+		}
+	}
+}
 
+void dgWorld::SetBodyStatesKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgBodyStateDescriptor* const descriptor = (dgBodyStateDescriptor*) context;
+	const dgBodyStateArrays* const states = descriptor->m_states;
+	const dgBody* const* const bodies = descriptor->m_bodies;
+	const dgInt32 count = descriptor->m_count;
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, DG_TRANSFORM_BODY_CHUNK); i < count; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, DG_TRANSFORM_BODY_CHUNK)) {
+		const dgInt32 chunkEnd = dgMin (i + DG_TRANSFORM_BODY_CHUNK, count);
+		for (dgInt32 j = i; j < chunkEnd; j ++) {
+			dgBody* const body = (dgBody*) bodies[j];
+			if (states->m_veloc) {
+				const dgFloat32* const src = &states->m_veloc[j * 3];
+				body->SetVelocity (dgVector (src[0], src[1], src[2], dgFloat32 (0.0f)));
+			}
+			if (states->m_omega) {
+				const dgFloat32* const src = &states->m_omega[j * 3];
+				body->SetOmega (dgVector (src[0], src[1], src[2], dgFloat32 (0.0f)));
+			}
+			if (states->m_position || states->m_rotation) {
+				// the broad phase update of each body is serialized by the broad phase lock
+				dgQuaternion rotation (body->m_rotation);
+				dgVector posit (body->m_matrix.m_posit);
+				if (states->m_rotation) {
+					const dgFloat32* const src = &states->m_rotation[j * 4];
+					rotation = dgQuaternion (src[0], src[1], src[2], src[3]);
+				}
+				if (states->m_position) {
+					const dgFloat32* const src = &states->m_position[j * 3];
+					posit = dgVector (src[0], src[1], src[2], dgFloat32 (1.0f));
+				}
+				dgMatrix matrix (rotation, posit);
+				matrix.m_front.m_w = dgFloat32 (0.0f);
+				matrix.m_up.m_w = dgFloat32 (0.0f);
+				matrix.m_right.m_w = dgFloat32 (0.0f);
+				matrix.m_posit.m_w = dgFloat32 (1.0f);
+				body->SetMatrixResetSleep (matrix);
+			}
+		}
+	}
+}
+
+dgInt32 dgWorld::GetBodyStates (const dgBody* const* const bodies, dgInt32 count, const dgBodyStateArrays* const states)
+{
+	dgAssert (!m_inUpdate);
+	dgBodyStateDescriptor descriptor;
+	descriptor.m_bodies = bodies;
+	descriptor.m_states = states;
+	descriptor.m_count = count;
+	descriptor.m_atomicIndex = 0;
+
+	dgInt32 totalCount = count;
+	if (!bodies) {
+		totalCount = m_transformBodiesCount;
+		descriptor.m_bodies = (const dgBody* const*) &m_transformBodiesMemory[0];
+		descriptor.m_count = dgMin (count, totalCount);
+		if (states->m_bodies) {
+			for (dgInt32 i = 0; i < descriptor.m_count; i ++) {
+				states->m_bodies[i] = descriptor.m_bodies[i];
+			}
+		}
+	}
+
+	const dgInt32 threadsCount = GetThreadCount();
+	if ((threadsCount > 1) && (descriptor.m_count > DG_TRANSFORM_BODY_CHUNK)) {
 		for (dgInt32 i = 0; i < threadsCount; i++) {
-			node = node ? node->GetNext() : NULL;
+			QueueJob(GetBodyStatesKernel, &descriptor, this);
 		}
+		SynchronizationBarrier();
+	} else {
+		GetBodyStatesKernel (&descriptor, this, 0);
 	}
+	return totalCount;
 }
 
-void dgWorld::UpdateTransforms(void* const context, void* const nodePtr, dgInt32 threadID)
+void dgWorld::SetBodyStates (const dgBody* const* const bodies, dgInt32 count, const dgBodyStateArrays* const states)
 {
-	dgWorld* const world = (dgWorld*)context;
-	dgBodyMasterList::dgListNode* node = (dgBodyMasterList::dgListNode*) nodePtr;
-	world->UpdateTransforms(node, threadID);
+	dgAssert (!m_inUpdate);
+	dgBodyStateDescriptor descriptor;
+	descriptor.m_bodies = bodies ? bodies : states->m_bodies;
+	descriptor.m_states = states;
+	descriptor.m_count = count;
+	descriptor.m_atomicIndex = 0;
+	dgAssert (descriptor.m_bodies || !count);
+
+	const dgInt32 threadsCount = GetThreadCount();
+	if ((threadsCount > 1) && (count > DG_TRANSFORM_BODY_CHUNK)) {
+		for (dgInt32 i = 0; i < threadsCount; i++) {
+			QueueJob(SetBodyStatesKernel, &descriptor, this);
+		}
+		SynchronizationBarrier();
+	} else {
+		SetBodyStatesKernel (&descriptor, this, 0);
+	}
+}
+
+dgInt32 dgWorld::SaveState (void* const buffer, dgInt32 bufferSize) const
+{
+	// only the state the simulation changes is saved, the bodies, joints, shapes and broad phase nodes
+	// are saved by address. lru values are saved relative to the broad phase lru, which keeps counting.
+	dgAssert (!m_inUpdate);
+	dgWorldStateStream stream (buffer, bufferSize);
+	const dgBodyMasterList& masterList = *this;
+	const dgActiveContacts& contactList = *this;
+
+	dgWorldStateHeader header;
+	header.m_size = 0;
+	header.m_bodyCount = masterList.GetCount();
+	header.m_jointCount = 0;
+	header.m_contactCount = contactList.GetCount();
+	header.m_aggregateCount = m_broadPhase->m_aggregateList.GetCount();
+	header.m_nodeCount = m_broadPhase->GetStateNodeCount();
+	header.m_broadPhaseType = m_broadPhase->GetType();
+	header.m_bodiesUniqueID = m_bodiesUniqueID;
+	stream.Write (header);
+
+	for (dgBodyMasterList::dgListNode* node = masterList.GetFirst(); node; node = node->GetNext()) {
+		dgBody* const body = node->GetInfo().GetBody();
+		stream.Write (body);
+		stream.Write (body->m_broadPhaseNode);
+	}
+	for (dgBodyMasterList::dgListNode* node = masterList.GetFirst(); node; node = node->GetNext()) {
+		const dgBodyMasterListRow& row = node->GetInfo();
+		for (dgBodyMasterListRow::dgListNode* jointNode = row.GetFirst(); jointNode; jointNode = jointNode->GetNext()) {
+			dgConstraint* const joint = jointNode->GetInfo().m_joint;
+			if (joint->IsBilateral() && (joint->m_body0 == row.GetBody())) {
+				stream.Write (joint);
+				header.m_jointCount ++;
+			}
+		}
+	}
+
+	// the broad phase is restored last but saved here, so that it can be checked before anything changes
+	m_broadPhase->SaveState (stream);
+
+	// the bodies and materials of all contacts go in front of the contacts, so that they can be checked too
+	for (dgActiveContacts::dgListNode* contactNode = contactList.GetFirst(); contactNode; contactNode = contactNode->GetNext()) {
+		const dgContact* const contact = contactNode->GetInfo();
+		stream.Write (contact->m_body0);
+		stream.Write (contact->m_body1);
+		stream.Write (contact->m_material);
+		stream.Write (contact->m_pointsCount);
+	}
+
+	// contacts go first, creating and destroying them on restore touches the bodies
+	const dgUnsigned32 lru = m_broadPhase->GetLRU();
+	for (dgActiveContacts::dgListNode* contactNode = contactList.GetFirst(); contactNode; contactNode = contactNode->GetNext()) {
+		const dgContact* const contact = contactNode->GetInfo();
+		stream.Write (contact->m_positAcc);
+		stream.Write (contact->m_rotationAcc);
+		stream.Write (contact->m_separtingVector);
+		stream.Write (contact->m_closestDistance);
+		stream.Write (contact->m_separationDistance);
+		stream.Write (contact->m_timeOfImpact);
+		stream.Write (contact->m_contactPruningTolereance);
+		stream.Write (dgUnsigned32 (lru - contact->m_broadphaseLru));
+		stream.Write (contact->m_removedPoints);
+		stream.Write (contact->m_contactCount);
+		stream.Write (dgInt32 (contact->m_isNewContact));
+		stream.Write (dgInt32 (contact->m_maxDOF));
+		stream.Write (dgInt32 (contact->m_contactActive));
+		stream.Write (dgInt32 (contact->m_enableCollision));
+		for (dgInt32 i = 0; i < contact->m_pointsCount; i ++) {
+			stream.Write (contact->m_contactPoints[i]);
+		}
+	}
+
+	for (dgBodyMasterList::dgListNode* node = masterList.GetFirst(); node; node = node->GetNext()) {
+		const dgBody* const body = node->GetInfo().GetBody();
+		stream.Write (body->m_invWorldInertiaMatrix);
+		stream.Write (body->m_matrix);
+		stream.Write (body->m_rotation);
+		stream.Write (body->m_veloc);
+		stream.Write (body->m_omega);
+		stream.Write (body->m_accel);
+		stream.Write (body->m_alpha);
+		stream.Write (body->m_minAABB);
+		stream.Write (body->m_maxAABB);
+		stream.Write (body->m_globalCentreOfMass);
+		stream.Write (body->m_impulseForce);
+		stream.Write (body->m_impulseTorque);
+		stream.Write (dgInt32 (body->m_freeze | (body->m_resting << 1) | (body->m_sleeping << 2) | (body->m_equilibrium << 3)));
+		if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
+			const dgDynamicBody* const dynamicBody = (dgDynamicBody*)body;
+			stream.Write (dynamicBody->m_externalForce);
+			stream.Write (dynamicBody->m_externalTorque);
+			stream.Write (dynamicBody->m_savedExternalForce);
+			stream.Write (dynamicBody->m_savedExternalTorque);
+			stream.Write (dynamicBody->m_cachedDampCoef);
+			stream.Write (dynamicBody->m_cachedTimeStep);
+			stream.Write (dynamicBody->m_sleepingCounter);
+		}
+	}
+
+	for (dgBodyMasterList::dgListNode* node = masterList.GetFirst(); node; node = node->GetNext()) {
+		const dgBodyMasterListRow& row = node->GetInfo();
+		for (dgBodyMasterListRow::dgListNode* jointNode = row.GetFirst(); jointNode; jointNode = jointNode->GetNext()) {
+			dgConstraint* const joint = jointNode->GetInfo().m_joint;
+			if (joint->IsBilateral() && (joint->m_body0 == row.GetBody())) {
+				const dgBilateralConstraint* const bilateral = (dgBilateralConstraint*)joint;
+				stream.Write (bilateral->m_jointForce);
+				stream.Write (bilateral->m_motorAcceleration);
+				stream.Write (bilateral->m_inverseDynamicsAcceleration);
+				stream.Write (bilateral->m_rowIsMotor);
+				stream.Write (bilateral->m_rowIsIk);
+			}
+		}
+	}
+
+	header.m_size = stream.GetSize();
+	dgWorldStateStream headerStream (buffer, bufferSize);
+	headerStream.Write (header);
+	return header.m_size;
+}
+
+bool dgWorld::RestoreState (const void* const buffer, dgInt32 bufferSize)
+{
+	dgAssert (!m_inUpdate);
+	dgWorldStateHeader header;
+	dgWorldStateStream stream ((void*)buffer, bufferSize);
+	dgBodyMasterList& masterList = *this;
+	dgActiveContacts& contactList = *this;
+
+	// the state only applies to the bodies, joints and aggregates it was saved from, check it all before changing anything
+	if (bufferSize < dgInt32 (sizeof (header))) {
+		return false;
+	}
+	stream.Read (header);
+	if ((header.m_size > bufferSize) || (header.m_bodyCount != masterList.GetCount()) || (header.m_bodiesUniqueID != m_bodiesUniqueID) ||
+		(header.m_broadPhaseType != m_broadPhase->GetType()) || (header.m_aggregateCount != m_broadPhase->m_aggregateList.GetCount()) ||
+		(header.m_nodeCount != m_broadPhase->GetStateNodeCount())) {
+		return false;
+	}
+	for (dgBodyMasterList::dgListNode* node = masterList.GetFirst(); node; node = node->GetNext()) {
+		dgBody* body;
+		dgBroadPhaseBodyNode* broadPhaseNode;
+		stream.Read (body);
+		stream.Read (broadPhaseNode);
+		if ((body != node->GetInfo().GetBody()) || (broadPhaseNode != body->m_broadPhaseNode)) {
+			return false;
+		}
+	}
+	dgInt32 jointCount = 0;
+	for (dgBodyMasterList::dgListNode* node = masterList.GetFirst(); node; node = node->GetNext()) {
+		const dgBodyMasterListRow& row = node->GetInfo();
+		for (dgBodyMasterListRow::dgListNode* jointNode = row.GetFirst(); jointNode; jointNode = jointNode->GetNext()) {
+			dgConstraint* const joint = jointNode->GetInfo().m_joint;
+			if (joint->IsBilateral() && (joint->m_body0 == row.GetBody())) {
+				if (jointCount == header.m_jointCount) {
+					return false;
+				}
+				dgConstraint* savedJoint;
+				stream.Read (savedJoint);
+				if (savedJoint != joint) {
+					return false;
+				}
+				jointCount ++;
+			}
+		}
+	}
+	if (jointCount != header.m_jointCount) {
+		return false;
+	}
+
+	dgWorldStatePointerSet bodies (masterList.GetCount());
+	for (dgBodyMasterList::dgListNode* node = masterList.GetFirst(); node; node = node->GetNext()) {
+		bodies.Add (node->GetInfo().GetBody());
+	}
+
+	dgWorldStateStream broadPhaseStream (stream);
+	if (!m_broadPhase->ValidateState (stream, bodies)) {
+		return false;
+	}
+
+	const dgBodyMaterialList& materialList = *this;
+	dgWorldStatePointerSet materials (materialList.GetCount());
+	for (dgBodyMaterialList::dgListNode* node = materialList.GetFirst(); node; node = node->GetNext()) {
+		materials.Add (&node->GetInfo());
+	}
+
+	dgWorldStateStream contactTable (stream);
+	for (dgInt32 i = 0; i < header.m_contactCount; i ++) {
+		dgBody* body0;
+		dgBody* body1;
+		const dgContactMaterial* material;
+		dgInt32 pointsCount;
+		stream.Read (body0);
+		stream.Read (body1);
+		stream.Read (material);
+		stream.Read (pointsCount);
+		if (!bodies.Find (body0) || !bodies.Find (body1) || (body0 == body1) || !materials.Find (material) || (pointsCount < 0) || (pointsCount > DG_MAX_CONTACT_POINTS) || stream.IsOverflow()) {
+			return false;
+		}
+	}
+
+	// each saved contact is moved to the end of the list, what is left at the head did not exist when the state was saved
+	const dgUnsigned32 lru = m_broadPhase->GetLRU();
+	for (dgInt32 i = 0; i < header.m_contactCount; i ++) {
+		dgBody* body0;
+		dgBody* body1;
+		const dgContactMaterial* material;
+		dgInt32 pointsCount;
+		contactTable.Read (body0);
+		contactTable.Read (body1);
+		contactTable.Read (material);
+		contactTable.Read (pointsCount);
+
+		dgContact* contact = FindContactJoint (body0, body1);
+		if (!contact) {
+			contact = new (m_allocator) dgContact (this, material);
+			contact->AppendToActiveList();
+			AttachConstraint (contact, body0, body1);
+		} else if (contact->m_body0 != body0) {
+			contact->SwapBodies();
+		}
+		contactList.RotateToEnd (contact->m_contactNode);
+
+		dgUnsigned32 contactLru;
+		dgInt32 isNewContact;
+		dgInt32 maxDOF;
+		dgInt32 contactActive;
+		dgInt32 enableCollision;
+		contact->m_material = material;
+		stream.Read (contact->m_positAcc);
+		stream.Read (contact->m_rotationAcc);
+		stream.Read (contact->m_separtingVector);
+		stream.Read (contact->m_closestDistance);
+		stream.Read (contact->m_separationDistance);
+		stream.Read (contact->m_timeOfImpact);
+		stream.Read (contact->m_contactPruningTolereance);
+		stream.Read (contactLru);
+		stream.Read (contact->m_removedPoints);
+		stream.Read (contact->m_contactCount);
+		stream.Read (isNewContact);
+		stream.Read (maxDOF);
+		stream.Read (contactActive);
+		stream.Read (enableCollision);
+		contact->m_pointsCount = 0;
+		contact->ReservePoints (pointsCount);
+		contact->m_pointsCount = pointsCount;
+		contact->m_broadphaseLru = lru - contactLru;
+		contact->m_isNewContact = isNewContact;
+		contact->m_maxDOF = maxDOF;
+		contact->m_contactActive = contactActive;
+		contact->m_enableCollision = enableCollision;
+		for (dgInt32 j = 0; j < contact->m_pointsCount; j ++) {
+			stream.Read (contact->m_contactPoints[j]);
+		}
+	}
+	while (contactList.GetCount() > header.m_contactCount) {
+		DestroyConstraint (contactList.GetFirst()->GetInfo());
+	}
+
+	for (dgBodyMasterList::dgListNode* node = masterList.GetFirst(); node; node = node->GetNext()) {
+		dgBody* const body = node->GetInfo().GetBody();
+		const dgMatrix matrix (body->m_matrix);
+		dgInt32 flags;
+		stream.Read (body->m_invWorldInertiaMatrix);
+		stream.Read (body->m_matrix);
+		stream.Read (body->m_rotation);
+		stream.Read (body->m_veloc);
+		stream.Read (body->m_omega);
+		stream.Read (body->m_accel);
+		stream.Read (body->m_alpha);
+		stream.Read (body->m_minAABB);
+		stream.Read (body->m_maxAABB);
+		stream.Read (body->m_globalCentreOfMass);
+		stream.Read (body->m_impulseForce);
+		stream.Read (body->m_impulseTorque);
+		stream.Read (flags);
+		body->m_freeze = flags & 1;
+		body->m_resting = (flags >> 1) & 1;
+		body->m_sleeping = (flags >> 2) & 1;
+		body->m_equilibrium = (flags >> 3) & 1;
+		if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
+			dgDynamicBody* const dynamicBody = (dgDynamicBody*)body;
+			stream.Read (dynamicBody->m_externalForce);
+			stream.Read (dynamicBody->m_externalTorque);
+			stream.Read (dynamicBody->m_savedExternalForce);
+			stream.Read (dynamicBody->m_savedExternalTorque);
+			stream.Read (dynamicBody->m_cachedDampCoef);
+			stream.Read (dynamicBody->m_cachedTimeStep);
+			stream.Read (dynamicBody->m_sleepingCounter);
+		}
+
+		// the broad phase restores the active set
+		body->m_activeIndex = -1;
+		body->UpdateWorlCollisionMatrix();
+		if (memcmp (&matrix, &body->m_matrix, sizeof (dgMatrix))) {
+			body->MarkMoved (0);
+		}
+	}
+
+	for (dgBodyMasterList::dgListNode* node = masterList.GetFirst(); node; node = node->GetNext()) {
+		const dgBodyMasterListRow& row = node->GetInfo();
+		for (dgBodyMasterListRow::dgListNode* jointNode = row.GetFirst(); jointNode; jointNode = jointNode->GetNext()) {
+			dgConstraint* const joint = jointNode->GetInfo().m_joint;
+			if (joint->IsBilateral() && (joint->m_body0 == row.GetBody())) {
+				dgBilateralConstraint* const bilateral = (dgBilateralConstraint*)joint;
+				stream.Read (bilateral->m_jointForce);
+				stream.Read (bilateral->m_motorAcceleration);
+				stream.Read (bilateral->m_inverseDynamicsAcceleration);
+				stream.Read (bilateral->m_rowIsMotor);
+				stream.Read (bilateral->m_rowIsIk);
+			}
+		}
+	}
+
+	m_broadPhase->RestoreState (broadPhaseStream);
+	dgAssert (stream.GetSize() == header.m_size);
+	return true;
 }
 
 void dgWorld::RunStep ()
 {
 	dgUnsigned64 timeAcc = m_getDebugTime ? m_getDebugTime() : 0;
+	DG_PROFILE_BEGIN_FRAME (this);
 	dgFloat32 step = m_savetimestep / m_numberOfSubsteps;
 	for (dgUnsigned32 i = 0; i < m_numberOfSubsteps; i ++) {
 		dgInterlockedExchange(&m_delayDelateLock, 1);
@@ -992,19 +1569,24 @@ void dgWorld::RunStep ()
 		bodyList.DestroyBodies (*this);
 	}
 
-	const dgBodyMasterList* const masterList = this;
-	dgBodyMasterList::dgListNode* node = masterList->GetFirst();
-	const dgInt32 threadsCount = GetThreadCount();
-	for (dgInt32 i = 0; i < threadsCount; i++) {
-		QueueJob(UpdateTransforms, this, node);
-		node = node ? node->GetNext() : NULL;
+	CollectMovedBodies ();
+	m_transformAtomicIndex = 0;
+
+	{
+		DG_PROFILE_UPDATE_PHASE (this, m_transformCallbacks);
+		DG_PROFILE_UPDATE_ITEMS (this, m_transformCallbacks, m_transformBodiesCount);
+		const dgInt32 threadsCount = GetThreadCount();
+		for (dgInt32 i = 0; i < threadsCount; i++) {
+			QueueJob(UpdateTransforms, this, this);
+		}
+		SynchronizationBarrier();
 	}
-	SynchronizationBarrier();
 
 	if (m_postUpdateCallback) {
 		m_postUpdateCallback (this, m_savetimestep);
 	}
 
+	DG_PROFILE_END_FRAME (this);
 	m_lastExecutionTime = m_getDebugTime ? dgFloat32 (m_getDebugTime() - timeAcc) * dgFloat32 (1.0e-6f): 0;
 }
 
@@ -1077,6 +1659,10 @@ void dgWorld::SetBroadPhaseType(dgInt32 type)
 				newBroadPhase = new (m_allocator) dgBroadPhasePersistent(this);
 				break;
 
+			case m_sapBroadphase:
+				newBroadPhase = new (m_allocator) dgBroadPhaseSAP(this);
+				break;
+
 			case m_defaultBroadphase:
 			default:
 				newBroadPhase = new (m_allocator) dgBroadPhaseDefault(this);
@@ -1099,6 +1685,10 @@ void dgWorld::ResetBroadPhase()
 			newBroadPhase = new (m_allocator) dgBroadPhasePersistent(this);
 			break;
 
+		case m_sapBroadphase:
+			newBroadPhase = new (m_allocator) dgBroadPhaseSAP(this);
+			break;
+
 		case m_defaultBroadphase:
 		default:
 			newBroadPhase = new (m_allocator) dgBroadPhaseDefault(this);
@@ -1268,6 +1858,7 @@ dgInt32 dgWorld::CompareJointByInvMass(const dgBilateralConstraint* const jointA
 
 void dgWorld::UpdateSkeletons()
 {
+	DG_PROFILE_UPDATE_PHASE (this, m_skeletonUpdate);
 	dgSkeletonList& skelManager = *this;
 	if (skelManager.m_skelListIsDirty) {
 		skelManager.m_skelListIsDirty = false;
@@ -1282,8 +1873,8 @@ void dgWorld::UpdateSkeletons()
 		dgUnsigned32 lru = m_dynamicsLru;
 
 		dgBodyMasterList& masterList = *this;
-		m_solverJacobiansMemory.ResizeIfNecessary((2 * (masterList.m_constraintCount + 1024)) * sizeof (dgBilateralConstraint*));
-		dgBilateralConstraint** const jointList = (dgBilateralConstraint**)&m_solverJacobiansMemory[0];
+		dgFrameArena::dgBuffer<dgBilateralConstraint*> jointBuffer (m_frameArena, 0, 2 * (masterList.m_constraintCount + 1024));
+		dgBilateralConstraint** const jointList = jointBuffer.GetBuffer();
 
 		dgInt32 jointCount = 0;
 		for (dgBodyMasterList::dgListNode* node = masterList.GetFirst(); node; node = node->GetNext()) {
@@ -27,7 +27,9 @@
 #include "dgCollision.h"
 #include "dgBroadPhase.h"
 #include "dgCollisionScene.h"
+#include "dgCollisionHeightField.h"
 #include "dgBodyMasterList.h"
+#include "dgProfiler.h"
 #include "dgWorldDynamicUpdate.h"
 //#include "dgDeformableBodiesUpdate.h"
 #include "dgCollisionCompoundFractured.h"
@@ -37,6 +39,10 @@
 
 #define DG_SLEEP_ENTRIES					8
 #define DG_MAX_DESTROYED_BODIES_BY_FORCE	8
+#define DG_TRANSFORM_BODY_CHUNK				16
+
+// or'ed with the iteration count of the solver mode, solves the joints of each cluster in simd lanes
+#define DG_SOLVER_MODE_SOA_JOINTS			0x10000
 
 class dgBody;
 class dgDynamicBody;
@@ -64,13 +70,38 @@ class dgBodyCollisionList: public dgTree<const dgCollision*, dgUnsigned32>
 	}
 };
 
-class dgBodyMaterialList: public dgTree<dgContactMaterial, dgUnsigned32>
+// materials are kept in the order of their pair keys (group1 << 16) + group0, with group0 <= group1, 
+// so the material of a pair of body groups is at index group1 * (group1 + 1) / 2 + group0 of the look up table.
+class dgBodyMaterialList: public dgList<dgContactMaterial>
 {
 	public:
 	dgBodyMaterialList (dgMemoryAllocator* const allocator)
-		:dgTree<dgContactMaterial, dgUnsigned32>(allocator)
+		:dgList<dgContactMaterial>(allocator)
+		,m_materialTable(allocator)
+		,m_groupCount(0)
+	{
+		m_materialTable.Resize(256);
+	}
+
+	DG_INLINE dgContactMaterial* FindMaterial (dgUnsigned32 bodyGroupId0, dgUnsigned32 bodyGroupId1) const
+	{
+		if (bodyGroupId0 > bodyGroupId1) {
+			dgSwap (bodyGroupId0, bodyGroupId1);
+		}
+		return (bodyGroupId1 < m_groupCount) ? m_materialTable[dgInt32 ((bodyGroupId1 * (bodyGroupId1 + 1)) / 2 + bodyGroupId0)] : NULL;
+	}
+
+	dgUnsigned32 GetGroupCount () const
 	{
+		return m_groupCount;
 	}
+
+	dgUnsigned32 AddGroup (const dgContactMaterial& material);
+	void RemoveAllGroups ();
+
+	private:
+	dgArray<dgContactMaterial*> m_materialTable;
+	dgUnsigned32 m_groupCount;
 };
 
 class dgSkeletonList: public dgTree<dgSkeletonContainer*, dgInt32>
@@ -152,6 +183,128 @@ class dgDeadBodies: public dgTree<dgBody*, void* >
 
 typedef void (*dgPostUpdateCallback) (const dgWorld* const world, dgFloat32 timestep);
 
+class dgBodyStateArrays
+{
+	public:
+	const dgBody** m_bodies;				// body of each entry
+	dgFloat32* m_position;					// three values per body, NULL to skip
+	dgFloat32* m_rotation;					// four values per body q0, q1, q2, q3, NULL to skip
+	dgFloat32* m_veloc;						// three values per body, NULL to skip
+	dgFloat32* m_omega;						// three values per body, NULL to skip
+};
+
+// flat byte stream of the world state, writes past the end of the buffer are only counted
+class dgWorldStateStream
+{
+	public:
+	dgWorldStateStream (void* const buffer, dgInt32 size)
+		:m_buffer((dgUnsigned8*) buffer)
+		,m_size(size)
+		,m_offset(0)
+	{
+	}
+
+	template<class T>
+	DG_INLINE void Write (const T& value)
+	{
+		if ((m_offset + dgInt32 (sizeof (T))) <= m_size) {
+			memcpy (&m_buffer[m_offset], (const void*)&value, sizeof (T));
+		}
+		m_offset += dgInt32 (sizeof (T));
+	}
+
+	// reads past the end of the buffer return zeros, the caller checks IsOverflow
+	template<class T>
+	DG_INLINE void Read (T& value)
+	{
+		if ((m_offset + dgInt32 (sizeof (T))) <= m_size) {
+			memcpy ((void*)&value, &m_buffer[m_offset], sizeof (T));
+		} else {
+			memset ((void*)&value, 0, sizeof (T));
+		}
+		m_offset += dgInt32 (sizeof (T));
+	}
+
+	DG_INLINE dgInt32 GetSize() const
+	{
+		return m_offset;
+	}
+
+	DG_INLINE bool IsOverflow() const
+	{
+		return m_offset > m_size;
+	}
+
+	private:
+	dgUnsigned8* m_buffer;
+	dgInt32 m_size;
+	dgInt32 m_offset;
+};
+
+// sorted addresses of the live objects a saved state can refer to, restore checks every address it reads against them
+class dgWorldStatePointerSet
+{
+	public:
+	dgWorldStatePointerSet (dgInt32 capacity)
+		:m_pointers (CalculateTableSize (capacity))
+		,m_mask (m_pointers.GetElementsCount() - 1)
+		,m_count(0)
+	{
+		memset (&m_pointers[0], 0, m_pointers.GetSizeInBytes());
+	}
+
+	DG_INLINE void Add (const void* const ptr)
+	{
+		dgAssert (ptr);
+		dgAssert (m_count < m_mask);
+		dgInt32 index = Hash (ptr);
+		for (; m_pointers[index]; index = (index + 1) & m_mask) {
+			if (m_pointers[index] == ptr) {
+				return;
+			}
+		}
+		m_pointers[index] = ptr;
+		m_count ++;
+	}
+
+	DG_INLINE bool Find (const void* const ptr) const
+	{
+		if (ptr) {
+			for (dgInt32 index = Hash (ptr); m_pointers[index]; index = (index + 1) & m_mask) {
+				if (m_pointers[index] == ptr) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	DG_INLINE dgInt32 GetCount () const
+	{
+		return m_count;
+	}
+
+	private:
+	// open addressing, the table is kept at most half full so probes stay short
+	static dgInt32 CalculateTableSize (dgInt32 capacity)
+	{
+		dgInt32 size = 16;
+		while (size < capacity * 2) {
+			size *= 2;
+		}
+		return size;
+	}
+
+	DG_INLINE dgInt32 Hash (const void* const ptr) const
+	{
+		return dgInt32 (((dgUnsigned64 (PointerToInt (ptr)) >> 4) * dgUnsigned64 (0x9e3779b97f4a7c15ULL)) >> 32) & m_mask;
+	}
+
+	dgStack<const void*> m_pointers;
+	dgInt32 m_mask;
+	dgInt32 m_count;
+};
+
 DG_MSC_VECTOR_ALIGMENT
 class dgWorld
 	:public dgBodyMasterList
@@ -190,6 +343,7 @@ class dgWorld
 	{
 		m_defaultBroadphase,
 		m_persistentBroadphase,
+		m_sapBroadphase,
 	};
 
 	class dgListener
@@ -324,6 +478,14 @@ class dgWorld
 	dgInt32 GetBodiesCount() const;
 	dgInt32 GetConstraintsCount() const;
 
+	dgInt32 GetBodyStates (const dgBody* const* const bodies, dgInt32 count, const dgBodyStateArrays* const states);
+	void SetBodyStates (const dgBody* const* const bodies, dgInt32 count, const dgBodyStateArrays* const states);
+	dgInt32 GetMovedBodies (OnBodiesInAABB callback, void* const userData) const;
+
+	// snapshot of the simulation state for rollback, bodies, joints and shapes are referenced not copied
+	dgInt32 SaveState (void* const buffer, dgInt32 bufferSize) const;
+	bool RestoreState (const void* const buffer, dgInt32 bufferSize);
+
     dgCollisionInstance* CreateInstance (const dgCollision* const child, dgInt32 shapeID, const dgMatrix& offsetMatrix);
 
 	dgCollisionInstance* CreateNull ();
@@ -344,6 +506,7 @@ class dgWorld
 	dgCollisionInstance* CreateBVH ();	
 	dgCollisionInstance* CreateStaticUserMesh (const dgVector& boxP0, const dgVector& boxP1, const dgUserMeshCreation& data);
 	dgCollisionInstance* CreateHeightField (dgInt32 width, dgInt32 height, dgInt32 contructionMode, dgInt32 elevationDataType, const void* const elevationMap, const dgInt8* const atributeMap, dgFloat32 verticalScale, dgFloat32 horizontalScale_x, dgFloat32 horizontalScale_z);
+	dgCollisionInstance* CreateTiledHeightField (dgInt32 width, dgInt32 height, dgInt32 tileSize, dgInt32 maxResidentTiles, dgInt32 contructionMode, dgInt32 elevationDataType, dgFloat32 minElevation, dgFloat32 maxElevation, dgFloat32 verticalScale, dgFloat32 horizontalScale_x, dgFloat32 horizontalScale_z, dgCollisionHeightFieldTileCallback tileCallback, void* const tileUserData);
 	dgCollisionInstance* CreateScene ();	
 
 	dgBroadPhaseAggregate* CreateAggreGate() const; 
@@ -377,6 +540,8 @@ class dgWorld
 
 	void SerializeCollision (dgCollisionInstance* const shape, dgSerialize deserialization, void* const userData) const;
 	dgCollisionInstance* CreateCollisionFromSerialization (dgDeserialize deserialization, void* const userData);
+	void SerializeCollisionImage (dgCollisionInstance* const shape, dgSerialize serialization, void* const userData) const;
+	dgCollisionInstance* CreateCollisionFromImage (const void* const image, dgInt32 size);
 	void ReleaseCollision(const dgCollision* const collision);
 	
 	dgUpVectorConstraint* CreateUpVectorConstraint (const dgVector& pin, dgBody *body);
@@ -424,60 +589,56 @@ class dgWorld
 
 	void SetSubsteps (dgInt32 subSteps);
 	dgInt32 GetSubsteps () const;
+
+	dgInt32 GetFrameMemoryHighWaterMark () const;
+	const dgProfiler& GetProfiler () const;
 	
 	private:
-	class dgAdressDistPair
+	class dgMovedBodyList
 	{
 		public:
-		dgInt32 m_adress;
-		dgFloat32 m_dist;
-	};
-
-	class dgStack: public dgArray<dgUnsigned8>
-	{
-		public:
-		dgStack(dgMemoryAllocator* const allocator)
-			:dgArray<dgUnsigned8>(allocator, 256)
-			,m_index(0)
-		{
-			Resize(1024 * 32);
-		}
-
-		~dgStack()
+		dgMovedBodyList()
+			:m_bodies(NULL)
+			,m_count(0)
+			,m_capacity(0)
+			,m_lock()
 		{
 		}
 
-		dgInt32 m_index;
+		dgBody** m_bodies;
+		dgInt32 m_count;
+		dgInt32 m_capacity;
+		dgThread::dgCriticalSection m_lock;
+		dgInt8 m_padding[32];
 	};
 
-	template<class T>
-	class dgStackBuffer 
+	class dgBodyStateDescriptor
 	{
-		public: 
-		dgStackBuffer(dgWorld* const world, dgInt32 elements)
-			:m_stack(&world->m_stack)
-		{
-			dgInt32 sizeInBytes = m_stack->m_index + sizeof(T) * elements + 32;
-			m_stack->ResizeIfNecessary(sizeInBytes);
-			dgInt32 index = (m_stack->m_index + 0x0f) & -0x10;
-			m_ptr = (T*)(&(*m_stack)[index]);
-			m_previusIndex = m_stack->m_index;
-			m_stack->m_index = sizeInBytes;
-		}
-
-		~dgStackBuffer()
-		{
-			m_stack->m_index = m_previusIndex;
-		}
+		public:
+		const dgBody* const* m_bodies;
+		const dgBodyStateArrays* m_states;
+		dgInt32 m_count;
+		dgInt32 m_atomicIndex;
+	};
 
-		T* GetBuffer()
-		{
-			return m_ptr;
-		}
+	class dgWorldStateHeader
+	{
+		public:
+		dgInt32 m_size;
+		dgInt32 m_bodyCount;
+		dgInt32 m_jointCount;
+		dgInt32 m_contactCount;
+		dgInt32 m_aggregateCount;
+		dgInt32 m_nodeCount;
+		dgInt32 m_broadPhaseType;
+		dgUnsigned32 m_bodiesUniqueID;
+	};
 
-		void* m_ptr;
-		dgStack* m_stack;
-		dgInt32 m_previusIndex;
+	class dgAdressDistPair
+	{
+		public:
+		dgInt32 m_adress;
+		dgFloat32 m_dist;
 	};
 
 	void RunStep ();
@@ -518,10 +679,15 @@ class dgWorld
 
 	virtual void Execute (dgInt32 threadID);
 	virtual void TickCallback (dgInt32 threadID);
-	void UpdateTransforms(dgBodyMasterList::dgListNode* node, dgInt32 threadID);
+	void UpdateTransforms(dgInt32 threadID);
+	void AddMovedBody (dgBody* const body, dgInt32 threadIndex);
+	void RemoveMovedBody (dgBody* const body);
+	void CollectMovedBodies ();
 
 	static dgUnsigned32 dgApi GetPerformanceCount ();
 	static void UpdateTransforms(void* const context, void* const node, dgInt32 threadID);
+	static void GetBodyStatesKernel (void* const context, void* const worldContext, dgInt32 threadID);
+	static void SetBodyStatesKernel (void* const context, void* const worldContext, dgInt32 threadID);
 	static dgInt32 SortFaces (const dgAdressDistPair* const A, const dgAdressDistPair* const B, void* const context);
 	static dgInt32 CompareJointByInvMass (const dgBilateralConstraint* const jointA, const dgBilateralConstraint* const jointB, void* notUsed);
 
@@ -529,10 +695,10 @@ class dgWorld
 	dgUnsigned32 m_dynamicsLru;
 	dgUnsigned32 m_inUpdate;
 	dgUnsigned32 m_solverMode;
-	dgUnsigned32 m_bodyGroupID;
 	dgUnsigned32 m_defualtBodyGroupID;
 	dgUnsigned32 m_bodiesUniqueID;
 	dgUnsigned32 m_useParallelSolver;
+	dgUnsigned32 m_useSoaSolver;
 	dgUnsigned32 m_genericLRUMark;
 	dgInt32 m_delayDelateLock;
 	dgInt32 m_clusterLRU;
@@ -569,7 +735,14 @@ class dgWorld
 	dgArray<dgUnsigned8> m_solverJacobiansMemory;  
 	dgArray<dgUnsigned8> m_solverForceAccumulatorMemory;
 	dgArray<dgUnsigned8> m_clusterMemory;
-	dgStack m_stack;
+	dgArray<dgUnsigned8> m_solverThreadMemory;
+	dgArray<dgUnsigned8> m_transformBodiesMemory;
+	dgInt32 m_transformBodiesCount;
+	dgInt32 m_transformAtomicIndex;
+	dgMovedBodyList* m_movedBodyLists;
+	dgFrameArena m_frameArena;
+	dgContactPointPool m_contactPointPool;
+	dgProfiler m_profiler;
 
 	dgPostUpdateCallback m_postUpdateCallback;
 	
@@ -578,6 +751,7 @@ class dgWorld
 	friend class dgBroadPhase;
 	friend class dgDeadBodies;
 	friend class dgDeadJoints;
+	friend class dgBroadPhaseSAP;
 	friend class dgActiveContacts;
 	friend class dgUserConstraint;
 	friend class dgBodyMasterList;
@@ -632,6 +806,16 @@ inline dgInt32 dgWorld::GetSubsteps () const
 	return m_numberOfSubsteps;
 }
 
+inline dgInt32 dgWorld::GetFrameMemoryHighWaterMark () const
+{
+	return m_frameArena.GetHighWaterMark();
+}
+
+inline const dgProfiler& dgWorld::GetProfiler () const
+{
+	return m_profiler;
+}
+
 inline dgFloat32 dgWorld::GetUpdateTime() const
 {
 	return m_lastExecutionTime;
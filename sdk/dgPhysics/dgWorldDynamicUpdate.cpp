@@ -35,6 +35,17 @@
 #define DG_CCD_EXTRA_CONTACT_COUNT			(8 * 3)
 #define DG_PARALLEL_JOINT_COUNT_CUT_OFF		(256)
 
+// worlds with fewer bodies than this build their clusters with the serial spanning tree
+#define DG_PARALLEL_CLUSTER_BODY_CUT_OFF	(1024)
+
+#define DG_CLUSTER_SEED_BODY				1
+#define DG_CLUSTER_AWAKE_BODY				2
+#define DG_CLUSTER_SOFT_BODY				4
+#define DG_CLUSTER_CCD_BODY					8
+
+#define DG_CLUSTER_INACTIVE					-1
+#define DG_CLUSTER_ASLEEP					-2
+
 dgVector dgWorldDynamicUpdate::m_velocTol (dgFloat32 (1.0e-8f));
 
 
@@ -54,6 +65,87 @@ class dgWorldDynamicUpdateSyncDescriptor
 	dgThread::dgCriticalSection* m_criticalSection;
 };
 
+class dgParallelClusterSyncData
+{
+	public:
+	// one entry per dynamic body, the array index is the union find key
+	class dgClusterBody
+	{
+		public:
+		dgBody* m_body;
+		dgInt32 m_parent;
+		dgInt32 m_island;
+		dgInt32 m_rank;
+		dgInt32 m_jointStart;
+		dgInt32 m_jointCount;
+		dgInt32 m_rowCount;
+		dgInt32 m_flags;
+	};
+
+	// partial counts of one body range in one island, the prefix sum turns them into scatter offsets
+	class dgClusterCount
+	{
+		public:
+		dgInt32 m_bodyCount;
+		dgInt32 m_jointCount;
+		dgInt32 m_rowCount;
+		dgInt32 m_flags;
+	};
+
+	dgParallelClusterSyncData()
+	{
+		memset (this, 0, sizeof (dgParallelClusterSyncData));
+	}
+
+	dgClusterBody* m_bodies;
+	dgConstraint** m_joints;
+	dgClusterCount* m_counts;
+	dgInt32* m_rangeIslands;
+	dgInt32* m_islandClusters;
+	dgBodyInfo* m_bodyArray;
+	dgJointInfo* m_jointArray;
+	dgBodyCluster* m_clusters;
+	dgFloat32 m_timestep;
+	dgInt32 m_bodyCount;
+	dgInt32 m_rangeSize;
+	dgInt32 m_rangeCount;
+	dgInt32 m_islandCount;
+	dgInt32 m_atomicIndex;
+	dgUnsigned32 m_markLru;
+};
+
+static DG_INLINE dgInt32 dgClusterFind (dgParallelClusterSyncData::dgClusterBody* const bodies, dgInt32 index)
+{
+	// path halving, a racing thread can only move a link closer to the root
+	dgInt32 parent = bodies[index].m_parent;
+	while (parent != index) {
+		const dgInt32 grandParent = bodies[parent].m_parent;
+		bodies[index].m_parent = grandParent;
+		index = grandParent;
+		parent = bodies[index].m_parent;
+	}
+	return index;
+}
+
+static DG_INLINE void dgClusterUnion (dgParallelClusterSyncData::dgClusterBody* const bodies, dgInt32 index0, dgInt32 index1)
+{
+	for (;;) {
+		index0 = dgClusterFind (bodies, index0);
+		index1 = dgClusterFind (bodies, index1);
+		if (index0 == index1) {
+			return;
+		}
+		// the higher root always links to the lower one, so the root of a set is its lowest index
+		// no matter the order the threads merge the links
+		if (index0 > index1) {
+			dgSwap (index0, index1);
+		}
+		if (dgInterlockedCompareExchange (&bodies[index1].m_parent, index0, index1) == index1) {
+			return;
+		}
+	}
+}
+
 
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
@@ -86,8 +178,12 @@ void dgWorldDynamicUpdate::UpdateDynamics(dgFloat32 timestep)
 	sentinelBody->m_equilibrium = 1;
 	sentinelBody->m_dynamicsLru = m_markLru;
 
-	BuildClusters(timestep);
-	SortClustersByCount();
+	{
+		DG_PROFILE_UPDATE_PHASE (world, m_clusterBuild);
+		BuildClusters(timestep);
+		SortClustersByCount();
+		DG_PROFILE_UPDATE_ITEMS (world, m_clusterBuild, m_clusters);
+	}
 
 	dgInt32 maxRowCount = 0;
 	dgInt32 blockMatrixSize = 0;
@@ -111,21 +207,13 @@ void dgWorldDynamicUpdate::UpdateDynamics(dgFloat32 timestep)
 	descriptor.m_firstCluster = index;
 	descriptor.m_clusterCount = m_clusters - index;
 
-	dgInt32 useParallel = world->m_useParallelSolver && (threadCount > 1);
-	//useParallel = 1;
-	if (useParallel) {
-		dgInt32 sum = m_joints;
-		useParallel = useParallel && m_joints && m_clusters;
-		useParallel = useParallel && ((threadCount * m_clusterMemory[0].m_jointCount) >= sum);
-		useParallel = useParallel && (m_clusterMemory[0].m_jointCount > DG_PARALLEL_JOINT_COUNT_CUT_OFF);
-		//useParallel = 1;
-		while (useParallel) {
+	if (world->m_useParallelSolver && (threadCount > 1)) {
+		// clusters are sorted by joint count, large clusters that dominate the step are solved one at the time using all threads
+		while ((index < m_clusters) && 
+			   (m_clusterMemory[index].m_jointCount > DG_PARALLEL_JOINT_COUNT_CUT_OFF) && 
+			   ((threadCount * m_clusterMemory[index].m_jointCount) >= m_joints)) {
 			CalculateReactionForcesParallel(&m_clusterMemory[index], timestep);
 			index ++;
-			sum -= m_clusterMemory[index].m_jointCount;
-			useParallel = useParallel && (index < m_clusters);
-			useParallel = useParallel && ((threadCount * m_clusterMemory[index].m_jointCount) >= m_joints);
-			useParallel = useParallel && (m_clusterMemory[index].m_jointCount > DG_PARALLEL_JOINT_COUNT_CUT_OFF);
 		}
 	}
 
@@ -165,23 +253,25 @@ void dgWorldDynamicUpdate::BuildClusters(dgFloat32 timestep)
 	dgUnsigned32 lru = m_markLru - 1;
 
 	dgBodyMasterList& masterList = *world;
+	dgBroadPhase* const broadPhase = world->GetBroadPhase();
+
+	// bodies woken up during the contact update are still in the pending tail of the active set
+	broadPhase->SortActiveBodies();
 
 	dgAssert (masterList.GetFirst()->GetInfo().GetBody() == world->m_sentinelBody);
-	world->m_solverJacobiansMemory.ResizeIfNecessary ((2 * (masterList.m_constraintCount + 1024)) * sizeof (dgDynamicBody*));
-	dgDynamicBody** const stackPoolBuffer = (dgDynamicBody**)&world->m_solverJacobiansMemory[0];
+	if ((world->GetThreadCount() > 1) && (broadPhase->m_activeBodiesCount > DG_PARALLEL_CLUSTER_BODY_CUT_OFF)) {
+		BuildClustersParallel (timestep);
+		return;
+	}
 
-	for (dgBodyMasterList::dgListNode* node = masterList.GetLast(); node; node = node->GetPrev()) {
-		const dgBodyMasterListRow& graphNode = node->GetInfo();
-		dgBody* const body = graphNode.GetBody();
+	dgFrameArena::dgBuffer<dgDynamicBody*> stackPool (world->m_frameArena, 0, 2 * (masterList.m_constraintCount + 1024));
+	dgDynamicBody** const stackPoolBuffer = stackPool.GetBuffer();
 
+	// only awake bodies can seed a cluster, the spanning tree pulls in the sleeping bodies linked to them
+	for (dgInt32 i = broadPhase->m_sortedActiveBodiesCount - 1; i >= 0; i --) {
+		dgBody* const body = broadPhase->m_activeBodies[i];
 		if (body->GetInvMass().m_w == dgFloat32(0.0f)) {
-#ifdef _DEBUG
-			for (; node; node = node->GetPrev()) {
-				//dgAssert ((body->GetType() == dgBody::m_kinamticBody) ||(node->GetInfo().GetBody()->GetInvMass().m_w == dgFloat32(0.0f)));
-				dgAssert(node->GetInfo().GetBody()->GetInvMass().m_w == dgFloat32(0.0f));
-			}
-#endif
-			break;
+			continue;
 		}
 
 		if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
@@ -245,6 +335,7 @@ void dgWorldDynamicUpdate::SpanningTree (dgDynamicBody* const body, dgDynamicBod
 			hasSoftBodies |= (srcBody->m_collision->IsType(dgCollision::dgCollisionDeformableMesh_RTTI) ? 1 : 0);
 
 			srcBody->m_sleeping = false;
+			srcBody->Activate();
 
 			bodyCount++;
 			for (dgBodyMasterListRow::dgListNode* jointNode = srcBody->m_masterNode->GetInfo().GetFirst(); jointNode; jointNode = jointNode->GetNext()) {
@@ -255,11 +346,8 @@ void dgWorldDynamicUpdate::SpanningTree (dgDynamicBody* const body, dgDynamicBod
 				dgBody* const linkBody = cell->m_bodyNode;
 				dgAssert((constraint->m_body0 == srcBody) || (constraint->m_body1 == srcBody));
 				dgAssert((constraint->m_body0 == linkBody) || (constraint->m_body1 == linkBody));
-				const dgContact* const contact = (constraint->GetId() == dgConstraint::m_contactConstraint) ? (dgContact*)constraint : NULL;
 
-				bool check0 = linkBody->IsCollidable();
-				check0 = check0 && (!contact || (contact->m_contactActive && contact->m_maxDOF) || (srcBody->m_continueCollisionMode | linkBody->m_continueCollisionMode));
-				if (check0) {
+				if (IsClusterLink (srcBody, linkBody, constraint)) {
 					bool check1 = constraint->m_dynamicsLru != lruMark;
 					if (check1) {
 						const dgInt32 jointIndex = m_joints + jointCount;
@@ -353,47 +441,7 @@ void dgWorldDynamicUpdate::SpanningTree (dgDynamicBody* const body, dgDynamicBod
 			rowsCount += constraintArray[i].m_pairCount;
 			if (joint->GetId() == dgConstraint::m_contactConstraint) {
 				if (body0->m_continueCollisionMode | body1->m_continueCollisionMode) {
-					dgInt32 ccdJoint = false;
-					const dgVector& veloc0 = body0->m_veloc;
-					const dgVector& veloc1 = body1->m_veloc;
-
-					const dgVector& omega0 = body0->m_omega;
-					const dgVector& omega1 = body1->m_omega;
-
-					const dgVector& com0 = body0->m_globalCentreOfMass;
-					const dgVector& com1 = body1->m_globalCentreOfMass;
-
-					const dgCollisionInstance* const collision0 = body0->m_collision;
-					const dgCollisionInstance* const collision1 = body1->m_collision;
-					dgFloat32 dist = dgMax(body0->m_collision->GetBoxMinRadius(), body1->m_collision->GetBoxMinRadius()) * dgFloat32(0.25f);
-
-					dgVector relVeloc(veloc1 - veloc0);
-					dgVector relOmega(omega1 - omega0);
-					dgVector relVelocMag2(relVeloc.DotProduct4(relVeloc));
-					dgVector relOmegaMag2(relOmega.DotProduct4(relOmega));
-
-					if ((relOmegaMag2.m_w > dgFloat32(1.0f)) || ((relVelocMag2.m_w * timestep * timestep) > (dist * dist))) {
-						dgTriplex normals[16];
-						dgTriplex points[16];
-						dgInt64 attrib0[16];
-						dgInt64 attrib1[16];
-						dgFloat32 penetrations[16];
-						dgFloat32 timeToImpact = timestep;
-						const dgInt32 ccdContactCount = world->CollideContinue(collision0, body0->m_matrix, veloc0, omega0, collision1, body1->m_matrix, veloc1, omega1,
-																			   timeToImpact, points, normals, penetrations, attrib0, attrib1, 6, 0);
-
-						for (dgInt32 j = 0; j < ccdContactCount; j++) {
-							dgVector point(&points[j].m_x);
-							dgVector normal(&normals[j].m_x);
-							dgVector vel0(veloc0 + omega0.CrossProduct3(point - com0));
-							dgVector vel1(veloc1 + omega1.CrossProduct3(point - com1));
-							dgVector vRel(vel1 - vel0);
-							dgFloat32 contactDistTravel = vRel.DotProduct4(normal).m_w * timestep;
-							ccdJoint |= (contactDistTravel > dist);
-						}
-					}
-					//ccdJoint = body0->m_continueCollisionMode | body1->m_continueCollisionMode;
-					isContinueCollisionCluster |= ccdJoint;
+					isContinueCollisionCluster |= IsContinueCollisionJoint (joint, timestep, 0);
 					rowsCount += DG_CCD_EXTRA_CONTACT_COUNT;
 				}
 			}
@@ -412,17 +460,446 @@ void dgWorldDynamicUpdate::SpanningTree (dgDynamicBody* const body, dgDynamicBod
 }
 
 
+// The parallel builder finds the same clusters the spanning tree does, but with a lock free union find 
+// over the body graph followed by a counting sort of bodies and joints into the cluster ranges.
+// The awake bodies of the active set and the sleeping bodies linked to them are split into one range per thread, and every pass is a job per range:
+// - union: merges the sets of the bodies of every joint the spanning tree would follow, and records the joints each body owns
+// - roots: compresses the paths and numbers the set roots of each range
+// - count: adds the bodies, joints and rows of each range into its row of the island table
+// - the update thread turns the island table into scatter offsets, islands that are not woken up or go to sleep get no cluster
+// - bodies: scatters the bodies, in array order, and assigns their cluster index
+// - joints: scatters the owned joints and resolves their body indices
+// Clusters come out in the order of their first body and the joints in body order, so the result does not depend on the thread count.
+void dgWorldDynamicUpdate::BuildClustersParallel(dgFloat32 timestep)
+{
+	dgWorld* const world = (dgWorld*) this;
+	dgBodyMasterList& masterList = *world;
+	dgBroadPhase* const broadPhase = world->GetBroadPhase();
+	const dgInt32 threadCount = world->GetThreadCount();
+
+	dgFrameArena::dgBuffer<dgParallelClusterSyncData::dgClusterBody> bodyPool (world->m_frameArena, 0, masterList.GetCount());
+	dgParallelClusterSyncData::dgClusterBody* const bodies = bodyPool.GetBuffer();
+
+	dgInt32 bodyCount = 0;
+	for (dgInt32 i = broadPhase->m_sortedActiveBodiesCount - 1; i >= 0; i --) {
+		dgBody* const body = broadPhase->m_activeBodies[i];
+		if (body->GetInvMass().m_w != dgFloat32(0.0f)) {
+			body->m_index = bodyCount;
+			bodies[bodyCount].m_body = body;
+			bodyCount ++;
+		}
+	}
+
+	// sleeping bodies linked to the awake ones can join their clusters, append them so that every link 
+	// the union pass follows stays inside the body array 
+	for (dgInt32 i = 0; i < bodyCount; i ++) {
+		const dgBody* const srcBody = bodies[i].m_body;
+		for (dgBodyMasterListRow::dgListNode* jointNode = srcBody->m_masterNode->GetInfo().GetFirst(); jointNode; jointNode = jointNode->GetNext()) {
+			const dgBodyMasterListCell& cell = jointNode->GetInfo();
+			dgBody* const linkBody = cell.m_bodyNode;
+			if ((linkBody->GetInvMass().m_w != dgFloat32(0.0f)) && IsClusterLink (srcBody, linkBody, cell.m_joint)) {
+				const dgInt32 index = linkBody->m_index;
+				if ((index < 0) || (index >= bodyCount) || (bodies[index].m_body != linkBody)) {
+					linkBody->m_index = bodyCount;
+					bodies[bodyCount].m_body = linkBody;
+					bodyCount ++;
+				}
+			}
+		}
+	}
+
+	dgInt32 cellCount = 0;
+	for (dgInt32 i = 0; i < bodyCount; i ++) {
+		dgBody* const body = bodies[i].m_body;
+		dgInt32 flags = 0;
+		if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
+			dgDynamicBody* const dynamicBody = (dgDynamicBody*)body;
+			flags |= (dynamicBody->m_freeze | dynamicBody->m_spawnnedFromCallback | dynamicBody->m_sleeping) ? 0 : DG_CLUSTER_SEED_BODY;
+			dynamicBody->m_spawnnedFromCallback = false;
+		}
+		flags |= (body->m_autoSleep & body->m_equilibrium) ? 0 : DG_CLUSTER_AWAKE_BODY;
+		flags |= body->m_collision->IsType(dgCollision::dgCollisionDeformableMesh_RTTI) ? DG_CLUSTER_SOFT_BODY : 0;
+
+		dgAssert (body->m_index == i);
+		dgParallelClusterSyncData::dgClusterBody& entry = bodies[i];
+		entry.m_parent = i;
+		entry.m_island = 0;
+		entry.m_rank = 0;
+		entry.m_jointStart = cellCount;
+		entry.m_jointCount = 0;
+		entry.m_rowCount = 0;
+		entry.m_flags = flags;
+		// each body can own at most one joint per cell of its row
+		cellCount += body->m_masterNode->GetInfo().GetCount();
+	}
+
+	if (!bodyCount) {
+		return;
+	}
+
+	dgFrameArena::dgBuffer<dgConstraint*> jointPool (world->m_frameArena, 0, cellCount + 1);
+	dgFrameArena::dgBuffer<dgInt32> rangePool (world->m_frameArena, 0, threadCount + 1);
+
+	dgParallelClusterSyncData syncData;
+	syncData.m_bodies = bodies;
+	syncData.m_joints = jointPool.GetBuffer();
+	syncData.m_rangeIslands = rangePool.GetBuffer();
+	syncData.m_timestep = timestep;
+	syncData.m_bodyCount = bodyCount;
+	syncData.m_rangeCount = threadCount;
+	syncData.m_rangeSize = (bodyCount + threadCount - 1) / threadCount;
+	syncData.m_markLru = m_markLru;
+
+	BuildClustersParallelPass (&syncData, ClusterUnionKernel);
+	BuildClustersParallelPass (&syncData, ClusterRootsKernel);
+
+	dgInt32 islandCount = 0;
+	for (dgInt32 i = 0; i < threadCount; i ++) {
+		const dgInt32 count = syncData.m_rangeIslands[i];
+		syncData.m_rangeIslands[i] = islandCount;
+		islandCount += count;
+	}
+	syncData.m_islandCount = islandCount;
+
+	dgFrameArena::dgBuffer<dgParallelClusterSyncData::dgClusterCount> countPool (world->m_frameArena, 0, threadCount * islandCount);
+	dgFrameArena::dgBuffer<dgInt32> islandPool (world->m_frameArena, 0, islandCount);
+	syncData.m_counts = countPool.GetBuffer();
+	syncData.m_islandClusters = islandPool.GetBuffer();
+	BuildClustersParallelPass (&syncData, ClusterCountKernel);
+
+	world->m_clusterMemory.ResizeIfNecessary (islandCount * sizeof (dgBodyCluster));
+	m_clusterMemory = (dgBodyCluster*) &world->m_clusterMemory[0];
+
+	const dgInt32 clusterLRU = world->m_clusterLRU;
+	for (dgInt32 i = 0; i < islandCount; i ++) {
+		dgInt32 flags = 0;
+		for (dgInt32 j = 0; j < threadCount; j ++) {
+			flags |= syncData.m_counts[j * islandCount + i].m_flags;
+		}
+
+		if (!(flags & DG_CLUSTER_SEED_BODY)) {
+			syncData.m_islandClusters[i] = DG_CLUSTER_INACTIVE;
+		} else if (!(flags & DG_CLUSTER_AWAKE_BODY)) {
+			syncData.m_islandClusters[i] = DG_CLUSTER_ASLEEP;
+		} else {
+			dgInt32 bodyIndex = m_bodies + 1;
+			dgInt32 jointIndex = m_joints;
+			dgInt32 rowsCount = 0;
+			for (dgInt32 j = 0; j < threadCount; j ++) {
+				dgParallelClusterSyncData::dgClusterCount& count = syncData.m_counts[j * islandCount + i];
+				const dgInt32 bodies = count.m_bodyCount;
+				const dgInt32 joints = count.m_jointCount;
+				count.m_bodyCount = bodyIndex;
+				count.m_jointCount = jointIndex;
+				bodyIndex += bodies;
+				jointIndex += joints;
+				rowsCount += count.m_rowCount;
+			}
+
+			dgBodyCluster& cluster = m_clusterMemory[m_clusters];
+			cluster.m_bodyStart = m_bodies;
+			cluster.m_bodyCount = bodyIndex - m_bodies;
+			cluster.m_jointStart = m_joints;
+			cluster.m_jointCount = jointIndex - m_joints;
+			cluster.m_clusterLRU = clusterLRU + m_clusters;
+			cluster.m_rowsStart = 0;
+			cluster.m_rowsCount = (flags & DG_CLUSTER_CCD_BODY) ? dgMax (rowsCount, 64) : rowsCount;
+			cluster.m_isContinueCollision = dgInt16 ((flags & DG_CLUSTER_CCD_BODY) ? 1 : 0);
+			cluster.m_hasSoftBodies = dgInt16 ((flags & DG_CLUSTER_SOFT_BODY) ? 1 : 0);
+
+			syncData.m_islandClusters[i] = m_clusters;
+			m_clusters ++;
+			m_bodies = bodyIndex;
+			m_joints = jointIndex;
+		}
+	}
+	world->m_clusterLRU += m_clusters;
+
+	world->m_bodiesMemory.ResizeIfNecessary ((m_bodies + 1) * sizeof (dgBodyInfo));
+	world->m_jointsMemory.ResizeIfNecessary ((m_joints + 1) * sizeof (dgJointInfo));
+	syncData.m_bodyArray = (dgBodyInfo*) &world->m_bodiesMemory[0];
+	syncData.m_jointArray = (dgJointInfo*) &world->m_jointsMemory[0];
+	syncData.m_clusters = m_clusterMemory;
+	for (dgInt32 i = 0; i < m_clusters; i ++) {
+		syncData.m_bodyArray[m_clusterMemory[i].m_bodyStart].m_body = world->m_sentinelBody;
+	}
+
+	BuildClustersParallelPass (&syncData, ClusterBodiesKernel);
+	BuildClustersParallelPass (&syncData, ClusterJointsKernel);
+
+	if (world->m_clusterUpdate) {
+		// rejected clusters leave a hole in the body and joint arrays, the solver only sees the cluster ranges
+		dgInt32 clusterCount = 0;
+		for (dgInt32 i = 0; i < m_clusters; i ++) {
+			const dgBodyCluster& cluster = m_clusterMemory[i];
+			dgClusterCallbackStruct record;
+			record.m_world = world;
+			record.m_count = cluster.m_bodyCount;
+			record.m_strideInByte = sizeof (dgBodyInfo);
+			record.m_bodyArray = &syncData.m_bodyArray[cluster.m_bodyStart].m_body;
+			if (world->m_clusterUpdate(world, &record, cluster.m_bodyCount)) {
+				m_clusterMemory[clusterCount] = cluster;
+				clusterCount ++;
+			}
+		}
+		m_clusters = clusterCount;
+	}
+}
+
+void dgWorldDynamicUpdate::BuildClustersParallelPass (dgParallelClusterSyncData* const syncData, dgWorkerThreadTaskCallback kernel) const
+{
+	dgWorld* const world = (dgWorld*) this;
+	const dgInt32 threadCounts = world->GetThreadCount();	
+
+	syncData->m_atomicIndex = 0;
+	for (dgInt32 i = 0; i < threadCounts; i ++) {
+		world->QueueJob (kernel, syncData, world);
+	}
+	world->SynchronizationBarrier();
+}
+
+void dgWorldDynamicUpdate::ClusterUnionKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgParallelClusterSyncData* const syncData = (dgParallelClusterSyncData*) context;
+	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILE_PHASE (world, m_clusterBuild, threadID);
+
+	dgParallelClusterSyncData::dgClusterBody* const bodies = syncData->m_bodies;
+	dgConstraint** const joints = syncData->m_joints;
+	const dgInt32 vectorStride = dgInt32 (sizeof (dgVector) / sizeof (dgFloat32));
+	for (dgInt32 range = dgAtomicExchangeAndAdd(&syncData->m_atomicIndex, 1); range < syncData->m_rangeCount; range = dgAtomicExchangeAndAdd(&syncData->m_atomicIndex, 1)) {
+		const dgInt32 start = range * syncData->m_rangeSize;
+		const dgInt32 end = dgMin (start + syncData->m_rangeSize, syncData->m_bodyCount);
+		for (dgInt32 i = start; i < end; i ++) {
+			dgParallelClusterSyncData::dgClusterBody& entry = bodies[i];
+			const dgBody* const srcBody = entry.m_body;
+			dgAssert (srcBody->m_index == i);
+			for (dgBodyMasterListRow::dgListNode* jointNode = srcBody->m_masterNode->GetInfo().GetFirst(); jointNode; jointNode = jointNode->GetNext()) {
+				const dgBodyMasterListCell& cell = jointNode->GetInfo();
+				dgConstraint* const constraint = cell.m_joint;
+				const dgBody* const linkBody = cell.m_bodyNode;
+				if (IsClusterLink (srcBody, linkBody, constraint)) {
+					// a link between two dynamic bodies is seen from both of them, it belongs to the body with the 
+					// lower index unless that body can not be reached from the other one
+					const bool isStatic = (linkBody->GetInvMass().m_w == dgFloat32(0.0f));
+					if (isStatic || (i < linkBody->m_index) || !srcBody->IsCollidable()) {
+						if (!isStatic) {
+							dgClusterUnion (bodies, i, linkBody->m_index);
+						}
+						joints[entry.m_jointStart + entry.m_jointCount] = constraint;
+						entry.m_jointCount ++;
+						entry.m_rowCount += (constraint->m_maxDOF + vectorStride - 1) & (-vectorStride);
+						if ((constraint->GetId() == dgConstraint::m_contactConstraint) && (srcBody->m_continueCollisionMode | linkBody->m_continueCollisionMode)) {
+							entry.m_rowCount += DG_CCD_EXTRA_CONTACT_COUNT;
+							entry.m_flags |= world->IsContinueCollisionJoint (constraint, syncData->m_timestep, threadID) ? DG_CLUSTER_CCD_BODY : 0;
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+void dgWorldDynamicUpdate::ClusterRootsKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgParallelClusterSyncData* const syncData = (dgParallelClusterSyncData*) context;
+	DG_PROFILE_PHASE ((dgWorld*) worldContext, m_clusterBuild, threadID);
+
+	dgParallelClusterSyncData::dgClusterBody* const bodies = syncData->m_bodies;
+	for (dgInt32 range = dgAtomicExchangeAndAdd(&syncData->m_atomicIndex, 1); range < syncData->m_rangeCount; range = dgAtomicExchangeAndAdd(&syncData->m_atomicIndex, 1)) {
+		const dgInt32 start = range * syncData->m_rangeSize;
+		const dgInt32 end = dgMin (start + syncData->m_rangeSize, syncData->m_bodyCount);
+		dgInt32 roots = 0;
+		for (dgInt32 i = start; i < end; i ++) {
+			const dgInt32 root = dgClusterFind (bodies, i);
+			bodies[i].m_parent = root;
+			if (root == i) {
+				bodies[i].m_rank = roots;
+				roots ++;
+			}
+		}
+		syncData->m_rangeIslands[range] = roots;
+	}
+}
+
+void dgWorldDynamicUpdate::ClusterCountKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgParallelClusterSyncData* const syncData = (dgParallelClusterSyncData*) context;
+	DG_PROFILE_PHASE ((dgWorld*) worldContext, m_clusterBuild, threadID);
+
+	dgParallelClusterSyncData::dgClusterBody* const bodies = syncData->m_bodies;
+	const dgInt32 rangeSize = syncData->m_rangeSize;
+	const dgInt32 islandCount = syncData->m_islandCount;
+	for (dgInt32 range = dgAtomicExchangeAndAdd(&syncData->m_atomicIndex, 1); range < syncData->m_rangeCount; range = dgAtomicExchangeAndAdd(&syncData->m_atomicIndex, 1)) {
+		dgParallelClusterSyncData::dgClusterCount* const counts = &syncData->m_counts[range * islandCount];
+		memset (counts, 0, islandCount * sizeof (dgParallelClusterSyncData::dgClusterCount));
+
+		const dgInt32 start = range * rangeSize;
+		const dgInt32 end = dgMin (start + rangeSize, syncData->m_bodyCount);
+		for (dgInt32 i = start; i < end; i ++) {
+			dgParallelClusterSyncData::dgClusterBody& entry = bodies[i];
+			const dgInt32 root = entry.m_parent;
+			const dgInt32 island = syncData->m_rangeIslands[root / rangeSize] + bodies[root].m_rank;
+			dgAssert (island < islandCount);
+			entry.m_island = island;
+
+			dgParallelClusterSyncData::dgClusterCount& count = counts[island];
+			count.m_bodyCount ++;
+			count.m_jointCount += entry.m_jointCount;
+			count.m_rowCount += entry.m_rowCount;
+			count.m_flags |= entry.m_flags;
+		}
+	}
+}
+
+void dgWorldDynamicUpdate::ClusterBodiesKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgParallelClusterSyncData* const syncData = (dgParallelClusterSyncData*) context;
+	DG_PROFILE_PHASE ((dgWorld*) worldContext, m_clusterBuild, threadID);
+
+	const dgParallelClusterSyncData::dgClusterBody* const bodies = syncData->m_bodies;
+	const dgInt32 islandCount = syncData->m_islandCount;
+	for (dgInt32 range = dgAtomicExchangeAndAdd(&syncData->m_atomicIndex, 1); range < syncData->m_rangeCount; range = dgAtomicExchangeAndAdd(&syncData->m_atomicIndex, 1)) {
+		dgParallelClusterSyncData::dgClusterCount* const counts = &syncData->m_counts[range * islandCount];
+		const dgInt32 start = range * syncData->m_rangeSize;
+		const dgInt32 end = dgMin (start + syncData->m_rangeSize, syncData->m_bodyCount);
+		for (dgInt32 i = start; i < end; i ++) {
+			const dgParallelClusterSyncData::dgClusterBody& entry = bodies[i];
+			const dgInt32 clusterIndex = syncData->m_islandClusters[entry.m_island];
+			if (clusterIndex == DG_CLUSTER_INACTIVE) {
+				continue;
+			}
+
+			dgBody* const body = entry.m_body;
+			body->m_dynamicsLru = syncData->m_markLru;
+			body->m_resting = body->m_equilibrium;
+			if (clusterIndex == DG_CLUSTER_ASLEEP) {
+				body->m_sleeping = true;
+			} else {
+				const dgInt32 index = counts[entry.m_island].m_bodyCount;
+				counts[entry.m_island].m_bodyCount ++;
+				syncData->m_bodyArray[index].m_body = body;
+				body->m_index = index - syncData->m_clusters[clusterIndex].m_bodyStart;
+				body->m_sleeping = false;
+				body->Activate();
+			}
+		}
+	}
+}
+
+void dgWorldDynamicUpdate::ClusterJointsKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgParallelClusterSyncData* const syncData = (dgParallelClusterSyncData*) context;
+	DG_PROFILE_PHASE ((dgWorld*) worldContext, m_clusterBuild, threadID);
+
+	const dgParallelClusterSyncData::dgClusterBody* const bodies = syncData->m_bodies;
+	const dgInt32 islandCount = syncData->m_islandCount;
+	const dgUnsigned32 lruMark = syncData->m_markLru - 1;
+	const dgInt32 vectorStride = dgInt32 (sizeof (dgVector) / sizeof (dgFloat32));
+	for (dgInt32 range = dgAtomicExchangeAndAdd(&syncData->m_atomicIndex, 1); range < syncData->m_rangeCount; range = dgAtomicExchangeAndAdd(&syncData->m_atomicIndex, 1)) {
+		dgParallelClusterSyncData::dgClusterCount* const counts = &syncData->m_counts[range * islandCount];
+		const dgInt32 start = range * syncData->m_rangeSize;
+		const dgInt32 end = dgMin (start + syncData->m_rangeSize, syncData->m_bodyCount);
+		for (dgInt32 i = start; i < end; i ++) {
+			const dgParallelClusterSyncData::dgClusterBody& entry = bodies[i];
+			const dgInt32 clusterIndex = syncData->m_islandClusters[entry.m_island];
+			if (clusterIndex < 0) {
+				continue;
+			}
+
+			const dgBodyCluster& cluster = syncData->m_clusters[clusterIndex];
+			dgConstraint** const joints = &syncData->m_joints[entry.m_jointStart];
+			const dgInt32 index = counts[entry.m_island].m_jointCount;
+			counts[entry.m_island].m_jointCount += entry.m_jointCount;
+			for (dgInt32 j = 0; j < entry.m_jointCount; j ++) {
+				dgConstraint* const constraint = joints[j];
+				const dgBody* const body0 = constraint->m_body0;
+				const dgBody* const body1 = constraint->m_body1;
+				dgJointInfo& jointInfo = syncData->m_jointArray[index + j];
+				jointInfo.m_joint = constraint;
+				jointInfo.m_pairCount = (constraint->m_maxDOF + vectorStride - 1) & (-vectorStride);
+				jointInfo.m_m0 = (body0->GetInvMass().m_w != dgFloat32(0.0f)) ? body0->m_index : 0;
+				jointInfo.m_m1 = (body1->GetInvMass().m_w != dgFloat32(0.0f)) ? body1->m_index : 0;
+
+				constraint->m_index = index + j - cluster.m_jointStart;
+				constraint->m_clusterLRU = cluster.m_clusterLRU;
+				constraint->m_dynamicsLru = lruMark;
+			}
+		}
+	}
+}
+
+bool dgWorldDynamicUpdate::IsClusterLink (const dgBody* const srcBody, const dgBody* const linkBody, const dgConstraint* const constraint)
+{
+	const dgContact* const contact = (constraint->GetId() == dgConstraint::m_contactConstraint) ? (dgContact*)constraint : NULL;
+	bool check = linkBody->IsCollidable();
+	check = check && (!contact || (contact->m_contactActive && contact->m_maxDOF) || (srcBody->m_continueCollisionMode | linkBody->m_continueCollisionMode));
+	return check;
+}
+
+dgInt32 dgWorldDynamicUpdate::IsContinueCollisionJoint (const dgConstraint* const joint, dgFloat32 timestep, dgInt32 threadID) const
+{
+	dgWorld* const world = (dgWorld*) this;
+	const dgBody* const body0 = joint->m_body0;
+	const dgBody* const body1 = joint->m_body1;
+
+	dgInt32 ccdJoint = false;
+	const dgVector& veloc0 = body0->m_veloc;
+	const dgVector& veloc1 = body1->m_veloc;
+
+	const dgVector& omega0 = body0->m_omega;
+	const dgVector& omega1 = body1->m_omega;
+
+	const dgVector& com0 = body0->m_globalCentreOfMass;
+	const dgVector& com1 = body1->m_globalCentreOfMass;
+
+	const dgCollisionInstance* const collision0 = body0->m_collision;
+	const dgCollisionInstance* const collision1 = body1->m_collision;
+	dgFloat32 dist = dgMax(body0->m_collision->GetBoxMinRadius(), body1->m_collision->GetBoxMinRadius()) * dgFloat32(0.25f);
+
+	dgVector relVeloc(veloc1 - veloc0);
+	dgVector relOmega(omega1 - omega0);
+	dgVector relVelocMag2(relVeloc.DotProduct4(relVeloc));
+	dgVector relOmegaMag2(relOmega.DotProduct4(relOmega));
+
+	if ((relOmegaMag2.m_w > dgFloat32(1.0f)) || ((relVelocMag2.m_w * timestep * timestep) > (dist * dist))) {
+		dgTriplex normals[16];
+		dgTriplex points[16];
+		dgInt64 attrib0[16];
+		dgInt64 attrib1[16];
+		dgFloat32 penetrations[16];
+		dgFloat32 timeToImpact = timestep;
+		const dgInt32 ccdContactCount = world->CollideContinue(collision0, body0->m_matrix, veloc0, omega0, collision1, body1->m_matrix, veloc1, omega1,
+															   timeToImpact, points, normals, penetrations, attrib0, attrib1, 6, threadID);
+
+		for (dgInt32 j = 0; j < ccdContactCount; j++) {
+			dgVector point(&points[j].m_x);
+			dgVector normal(&normals[j].m_x);
+			dgVector vel0(veloc0 + omega0.CrossProduct3(point - com0));
+			dgVector vel1(veloc1 + omega1.CrossProduct3(point - com1));
+			dgVector vRel(vel1 - vel0);
+			dgFloat32 contactDistTravel = vRel.DotProduct4(normal).m_w * timestep;
+			ccdJoint |= (contactDistTravel > dist);
+		}
+	}
+	//ccdJoint = body0->m_continueCollisionMode | body1->m_continueCollisionMode;
+	return ccdJoint;
+}
+
+
 dgInt32 dgWorldDynamicUpdate::SortClusters(const dgBodyCluster* const cluster, dgFloat32 timestep, dgInt32 threadID) const
 {
 	dgWorld* const world = (dgWorld*) this;
+	DG_PROFILE_PHASE (world, m_clusterBuild, threadID);
 	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*)&world->m_bodiesMemory[0];
 	dgJointInfo* const constraintArrayPtr = (dgJointInfo*)&world->m_jointsMemory[0];
 	
 	dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart];
 	dgJointInfo* const constraintArray = &constraintArrayPtr[cluster->m_jointStart];
 
-	dgJointInfo* const tmpInfoList = dgAlloca(dgJointInfo, cluster->m_jointCount);
-	dgJointInfo** queueBuffer = dgAlloca(dgJointInfo*, cluster->m_jointCount * 2 + 1024 * 8);
+	dgFrameArena::dgScope scope (world->m_frameArena, threadID);
+	dgJointInfo* const tmpInfoList = (dgJointInfo*) world->m_frameArena.Alloc (threadID, cluster->m_jointCount * sizeof (dgJointInfo));
+	dgJointInfo** queueBuffer = (dgJointInfo**) world->m_frameArena.Alloc (threadID, (cluster->m_jointCount * 2 + 1024 * 8) * sizeof (dgJointInfo*));
 	dgQueue<dgJointInfo*> queue(queueBuffer, cluster->m_jointCount * 2 + 1024 * 8);
 	dgFloat32 heaviestMass = dgFloat32(1.0e20f);
 	dgInt32 infoIndex = 0;
@@ -640,85 +1117,59 @@ dgInt32 dgWorldDynamicUpdate::GetJacobianDerivatives (dgContraintDescritor& cons
 }
 
 
-void dgWorldDynamicUpdate::IntegrateVelocity(const dgBodyCluster* const cluster, dgFloat32 accelTolerance, dgFloat32 timestep, dgInt32 threadID) const
+void dgWorldDynamicUpdate::IntegrateBodyVelocity(dgBody* const body, const dgVector& velocDragVect, dgFloat32 speedFreeze, dgFloat32 accelFreeze, dgFloat32 timestep, dgClusterSleepState& sleepState, dgInt32 threadID) const
 {
-	bool stackSleeping = true;
-	bool isClusterResting = true;
-	dgInt32 sleepCounter = 10000;
-
-	dgWorld* const world = (dgWorld*) this;
-
-	dgFloat32 velocityDragCoeff = DG_FREEZZING_VELOCITY_DRAG;
-	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
-	dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart + 1]; 
-	dgInt32 count = cluster->m_bodyCount - 1;
-	if (count <= 2) {
-		//bool autosleep = bodyArray[0].m_body->m_autoSleep;
-		bool equilibrium  = bodyArray[0].m_body->m_equilibrium;
-		if (count == 2) {
-			equilibrium  &= bodyArray[1].m_body->m_equilibrium;
-		}
-		if (!equilibrium ) {
-			velocityDragCoeff = dgFloat32 (0.9999f);
-		}
-	}
-
-	dgFloat32 maxAccel = dgFloat32 (0.0f);
-	dgFloat32 maxAlpha = dgFloat32 (0.0f);
-	dgFloat32 maxSpeed = dgFloat32 (0.0f);
-	dgFloat32 maxOmega = dgFloat32 (0.0f);
-
-	const dgFloat32 speedFreeze = world->m_freezeSpeed2;
-	const dgFloat32 accelFreeze = world->m_freezeAccel2 * ((cluster->m_jointCount <= DG_SMALL_ISLAND_COUNT) ? dgFloat32 (0.05f) : dgFloat32 (1.0f));
-	dgVector velocDragVect (velocityDragCoeff, velocityDragCoeff, velocityDragCoeff, dgFloat32 (0.0f));
-
-	for (dgInt32 i = 0; i < count; i ++) {
-		dgBody* const body = bodyArray[i].m_body;
-		dgAssert(body->IsRTTIType(dgBody::m_dynamicBodyRTTI) || body->IsRTTIType(dgBody::m_kinematicBody));
+	dgAssert(body->IsRTTIType(dgBody::m_dynamicBodyRTTI) || body->IsRTTIType(dgBody::m_kinematicBody));
 		
-		body->m_equilibrium = 1;
-		dgVector isMovingMask ((body->m_veloc + body->m_omega + body->m_accel + body->m_alpha) & dgVector::m_signMask);
-		if ((isMovingMask.TestZero().GetSignMask() & 7) != 7) {
-			dgAssert (body->m_invMass.m_w);
-			if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
-				body->IntegrateVelocity(timestep);
-			}
-
-			dgAssert (body->m_accel.m_w == dgFloat32 (0.0f));
-			dgAssert (body->m_alpha.m_w == dgFloat32 (0.0f));
-			dgAssert (body->m_veloc.m_w == dgFloat32 (0.0f));
-			dgAssert (body->m_omega.m_w == dgFloat32 (0.0f));
-			dgFloat32 accel2 = body->m_accel.DotProduct4(body->m_accel).GetScalar();
-			dgFloat32 alpha2 = body->m_alpha.DotProduct4(body->m_alpha).GetScalar();
-			dgFloat32 speed2 = body->m_veloc.DotProduct4(body->m_veloc).GetScalar();
-			dgFloat32 omega2 = body->m_omega.DotProduct4(body->m_omega).GetScalar();
-
-			maxAccel = dgMax (maxAccel, accel2);
-			maxAlpha = dgMax (maxAlpha, alpha2);
-			maxSpeed = dgMax (maxSpeed, speed2);
-			maxOmega = dgMax (maxOmega, omega2);
-			bool equilibrium = (accel2 < accelFreeze) && (alpha2 < accelFreeze) && (speed2 < speedFreeze) && (omega2 < speedFreeze);
-			if (equilibrium) {
-				dgVector veloc (body->m_veloc * velocDragVect);
-				dgVector omega (body->m_omega * velocDragVect);
-				body->m_veloc = (veloc.DotProduct4(veloc) > m_velocTol) & veloc;
-				body->m_omega = (omega.DotProduct4(omega) > m_velocTol) & omega;
-			}
+	body->m_equilibrium = 1;
+	dgVector isMovingMask ((body->m_veloc + body->m_omega + body->m_accel + body->m_alpha) & dgVector::m_signMask);
+	if ((isMovingMask.TestZero().GetSignMask() & 7) != 7) {
+		dgAssert (body->m_invMass.m_w);
+		if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
+			body->IntegrateVelocity(timestep);
+		}
 
-			body->m_equilibrium = equilibrium ? 1 : 0;
-//body->m_equilibrium &= body->m_autoSleep;
-			stackSleeping &= equilibrium;
-			isClusterResting &= (body->m_autoSleep & equilibrium);
-			if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
-				sleepCounter = dgMin (sleepCounter, ((dgDynamicBody*)body)->m_sleepingCounter);
-			}
+		dgAssert (body->m_accel.m_w == dgFloat32 (0.0f));
+		dgAssert (body->m_alpha.m_w == dgFloat32 (0.0f));
+		dgAssert (body->m_veloc.m_w == dgFloat32 (0.0f));
+		dgAssert (body->m_omega.m_w == dgFloat32 (0.0f));
+		dgFloat32 accel2 = body->m_accel.DotProduct4(body->m_accel).GetScalar();
+		dgFloat32 alpha2 = body->m_alpha.DotProduct4(body->m_alpha).GetScalar();
+		dgFloat32 speed2 = body->m_veloc.DotProduct4(body->m_veloc).GetScalar();
+		dgFloat32 omega2 = body->m_omega.DotProduct4(body->m_omega).GetScalar();
+
+		sleepState.m_maxAccel = dgMax (sleepState.m_maxAccel, accel2);
+		sleepState.m_maxAlpha = dgMax (sleepState.m_maxAlpha, alpha2);
+		sleepState.m_maxSpeed = dgMax (sleepState.m_maxSpeed, speed2);
+		sleepState.m_maxOmega = dgMax (sleepState.m_maxOmega, omega2);
+		bool equilibrium = (accel2 < accelFreeze) && (alpha2 < accelFreeze) && (speed2 < speedFreeze) && (omega2 < speedFreeze);
+		if (equilibrium) {
+			dgVector veloc (body->m_veloc * velocDragVect);
+			dgVector omega (body->m_omega * velocDragVect);
+			body->m_veloc = (veloc.DotProduct4(veloc) > m_velocTol) & veloc;
+			body->m_omega = (omega.DotProduct4(omega) > m_velocTol) & omega;
+		}
 
-			body->UpdateCollisionMatrix (timestep, threadID);
+		body->m_equilibrium = equilibrium ? 1 : 0;
+		sleepState.m_stackSleeping &= equilibrium ? 1 : 0;
+		sleepState.m_isClusterResting &= (body->m_autoSleep & equilibrium) ? 1 : 0;
+		if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
+			sleepState.m_sleepCounter = dgMin (sleepState.m_sleepCounter, ((dgDynamicBody*)body)->m_sleepingCounter);
 		}
+
+		body->UpdateCollisionMatrix (timestep, threadID);
 	}
+}
 
-	if (isClusterResting && cluster->m_jointCount) {
-		if (stackSleeping) {
+void dgWorldDynamicUpdate::UpdateClusterSleepState(const dgBodyCluster* const cluster, const dgClusterSleepState& sleepState, dgFloat32 timestep) const
+{
+	dgWorld* const world = (dgWorld*) this;
+	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
+	dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart + 1]; 
+	const dgInt32 count = cluster->m_bodyCount - 1;
+
+	if (sleepState.m_isClusterResting && cluster->m_jointCount) {
+		if (sleepState.m_stackSleeping) {
 			for (dgInt32 i = 0; i < count; i ++) {
 				dgBody* const body =  bodyArray[i].m_body;
 				dgAssert(body->IsRTTIType(dgBody::m_dynamicBodyRTTI) || body->IsRTTIType(dgBody::m_kinematicBodyRTTI));
@@ -729,6 +1180,10 @@ void dgWorldDynamicUpdate::IntegrateVelocity(const dgBodyCluster* const cluster,
 				body->m_sleeping = body->m_autoSleep;
 			}
 		} else {
+			const dgFloat32 maxAccel = sleepState.m_maxAccel;
+			const dgFloat32 maxAlpha = sleepState.m_maxAlpha;
+			const dgFloat32 maxSpeed = sleepState.m_maxSpeed;
+			const dgFloat32 maxOmega = sleepState.m_maxOmega;
 			const bool state = (maxAccel > world->m_sleepTable[DG_SLEEP_ENTRIES - 1].m_maxAccel) || (maxAlpha > world->m_sleepTable[DG_SLEEP_ENTRIES - 1].m_maxAlpha) ||
 							   (maxSpeed > world->m_sleepTable[DG_SLEEP_ENTRIES - 1].m_maxVeloc) || (maxOmega > world->m_sleepTable[DG_SLEEP_ENTRIES - 1].m_maxOmega);
 			if (state) { 
@@ -749,6 +1204,7 @@ void dgWorldDynamicUpdate::IntegrateVelocity(const dgBodyCluster* const cluster,
 					}
 				}
 
+				dgInt32 sleepCounter = sleepState.m_sleepCounter;
 				dgInt32 timeScaleSleepCount = dgInt32 (dgFloat32 (60.0f) * sleepCounter * timestep);
 				if (timeScaleSleepCount > world->m_sleepTable[index].m_steps) {
 					for (dgInt32 i = 0; i < count; i ++) {
@@ -775,6 +1231,41 @@ void dgWorldDynamicUpdate::IntegrateVelocity(const dgBodyCluster* const cluster,
 	}
 }
 
+void dgWorldDynamicUpdate::IntegrateVelocity(const dgBodyCluster* const cluster, dgFloat32 accelTolerance, dgFloat32 timestep, dgInt32 threadID) const
+{
+	dgWorld* const world = (dgWorld*) this;
+	DG_PROFILE_PHASE (world, m_integration, threadID);
+	DG_PROFILE_ITEMS (world, m_integration, threadID, cluster->m_bodyCount - 1);
+
+	dgFloat32 velocityDragCoeff = DG_FREEZZING_VELOCITY_DRAG;
+	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
+	dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart + 1]; 
+	dgInt32 count = cluster->m_bodyCount - 1;
+	if (count <= 2) {
+		//bool autosleep = bodyArray[0].m_body->m_autoSleep;
+		bool equilibrium  = bodyArray[0].m_body->m_equilibrium;
+		if (count == 2) {
+			equilibrium  &= bodyArray[1].m_body->m_equilibrium;
+		}
+		if (!equilibrium ) {
+			velocityDragCoeff = dgFloat32 (0.9999f);
+		}
+	}
+
+	const dgFloat32 speedFreeze = world->m_freezeSpeed2;
+	const dgFloat32 accelFreeze = world->m_freezeAccel2 * ((cluster->m_jointCount <= DG_SMALL_ISLAND_COUNT) ? dgFloat32 (0.05f) : dgFloat32 (1.0f));
+	dgVector velocDragVect (velocityDragCoeff, velocityDragCoeff, velocityDragCoeff, dgFloat32 (0.0f));
+
+	dgClusterSleepState sleepState;
+	sleepState.Init();
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgBody* const body = bodyArray[i].m_body;
+		IntegrateBodyVelocity (body, velocDragVect, speedFreeze, accelFreeze, timestep, sleepState, threadID);
+	}
+
+	UpdateClusterSleepState (cluster, sleepState, timestep);
+}
+
 void dgJacobianMemory::Init(dgWorld* const world, dgInt32 rowsCount, dgInt32 bodyCount, dgInt32 blockMatrixSizeInBytes)
 {
 	world->m_solverJacobiansMemory.ResizeIfNecessary ((rowsCount + 1) * sizeof (dgJacobianMatrixElement));
@@ -35,6 +35,7 @@
 #define	DG_MAX_SKELETON_JOINT_COUNT		256
 #define DG_MAX_CONTINUE_COLLISON_STEPS	8
 #define	DG_SMALL_ISLAND_COUNT			2
+#define	DG_MAX_PARALLEL_JOINT_BATCHES	32
 
 #define	DG_FREEZZING_VELOCITY_DRAG		dgFloat32 (0.9f)
 #define	DG_SOLVER_MAX_ERROR				(DG_FREEZE_ACCEL * dgFloat32 (0.5f))
@@ -56,6 +57,7 @@
 class dgBody;
 class dgDynamicBody;
 class dgParallelSolverSyncData;
+class dgParallelClusterSyncData;
 class dgWorldDynamicUpdateSyncDescriptor;
 
 
@@ -102,6 +104,49 @@ class dgJointInfo
 };
 
 
+class dgClusterSleepState
+{
+	public:
+	void Init()
+	{
+		m_maxAccel = dgFloat32 (0.0f);
+		m_maxAlpha = dgFloat32 (0.0f);
+		m_maxSpeed = dgFloat32 (0.0f);
+		m_maxOmega = dgFloat32 (0.0f);
+		m_sleepCounter = 10000;
+		m_stackSleeping = 1;
+		m_isClusterResting = 1;
+	}
+
+	void Merge(const dgClusterSleepState& state)
+	{
+		m_maxAccel = dgMax (m_maxAccel, state.m_maxAccel);
+		m_maxAlpha = dgMax (m_maxAlpha, state.m_maxAlpha);
+		m_maxSpeed = dgMax (m_maxSpeed, state.m_maxSpeed);
+		m_maxOmega = dgMax (m_maxOmega, state.m_maxOmega);
+		m_sleepCounter = dgMin (m_sleepCounter, state.m_sleepCounter);
+		m_stackSleeping &= state.m_stackSleeping;
+		m_isClusterResting &= state.m_isClusterResting;
+	}
+
+	dgFloat32 m_maxAccel;
+	dgFloat32 m_maxAlpha;
+	dgFloat32 m_maxSpeed;
+	dgFloat32 m_maxOmega;
+	dgInt32 m_sleepCounter;
+	dgInt32 m_stackSleeping;
+	dgInt32 m_isClusterResting;
+};
+
+// partial results of each worker thread, allocated by the world when the thread count changes
+class dgParallelSolverThreadData
+{
+	public:
+	dgClusterSleepState m_sleepState;
+	dgFloat32 m_accelNorm;
+	dgInt32 m_hasJointFeeback;
+};
+
 class dgParallelSolverSyncData
 {
 	public:
@@ -118,8 +163,6 @@ class dgParallelSolverSyncData
 		memset (this, 0, sizeof (dgParallelSolverSyncData));
 	}
 
-	dgFloat32 m_accelNorm[DG_MAX_THREADS_HIVE_COUNT];
-
 	dgFloat32 m_timestep;
 	dgFloat32 m_invTimestep;
 	dgFloat32 m_invStepRK;
@@ -130,20 +173,21 @@ class dgParallelSolverSyncData
 	dgInt32 m_passes;
 	dgInt32 m_bachIndex;
 	dgInt32 m_bachCount;
+	dgInt32 m_overflowBach;
 	dgInt32 m_maxPasses;
 	dgInt32 m_bodyCount;
 	dgInt32 m_jointCount;
 	dgInt32 m_rowCount;
 	dgInt32 m_atomicIndex;
-	dgInt32 m_lock0;
-	dgInt32 m_lock1;
 	dgInt32 m_jacobianMatrixRowAtomicIndex;
 
-	dgInt32* m_bodyLocks;  
 	const dgBodyCluster* m_cluster;
 	dgParallelJointMap* m_jointConflicts;
-	dgInt32 m_jointBatches[32];
-	dgInt32 m_hasJointFeeback[DG_MAX_THREADS_HIVE_COUNT];
+	dgParallelSolverThreadData* m_threadData;
+	dgFloat32 m_velocityDragCoeff;
+	dgFloat32 m_speedFreeze;
+	dgFloat32 m_accelFreeze;
+	dgInt32 m_jointBatches[DG_MAX_PARALLEL_JOINT_BATCHES + 1];
 };
 
 
@@ -245,14 +289,24 @@ class dgWorldDynamicUpdate
 
 	private:
 	void BuildClusters(dgFloat32 timestep);
+	void BuildClustersParallel(dgFloat32 timestep);
 	dgInt32 SortClusters(const dgBodyCluster* const cluster, dgFloat32 timestep, dgInt32 threadID) const;
 	void SpanningTree (dgDynamicBody* const body, dgDynamicBody** const queueBuffer, dgFloat32 timestep);
+	dgInt32 IsContinueCollisionJoint (const dgConstraint* const joint, dgFloat32 timestep, dgInt32 threadID) const;
+	static bool IsClusterLink (const dgBody* const srcBody, const dgBody* const linkBody, const dgConstraint* const constraint);
+	void BuildClustersParallelPass (dgParallelClusterSyncData* const syncData, dgWorkerThreadTaskCallback kernel) const;
 	
 	static dgInt32 CompareClusters (const dgBodyCluster* const clusterA, const dgBodyCluster* const clusterB, void* notUsed);
 
 	static void CalculateClusterReactionForcesKernel (void* const context, void* const worldContext, dgInt32 threadID);
 
-	static void IntegrateInslandParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
+	static void ClusterUnionKernel (void* const context, void* const worldContext, dgInt32 threadID);
+	static void ClusterRootsKernel (void* const context, void* const worldContext, dgInt32 threadID);
+	static void ClusterCountKernel (void* const context, void* const worldContext, dgInt32 threadID);
+	static void ClusterBodiesKernel (void* const context, void* const worldContext, dgInt32 threadID);
+	static void ClusterJointsKernel (void* const context, void* const worldContext, dgInt32 threadID);
+
+	static void IntegrateClusterParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
 	static void InitializeBodyArrayParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
 	static void BuildJacobianMatrixParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
 	static void SolverInitInternalForcesParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
@@ -269,8 +323,11 @@ class dgWorldDynamicUpdate
 	void BuildJacobianMatrixParallel (dgParallelSolverSyncData* const syncData) const; 
 	void SolverInitInternalForcesParallel (dgParallelSolverSyncData* const syncData) const; 
 	void CalculateForcesGameModeParallel (dgParallelSolverSyncData* const syncData) const; 
+	void CalculateJointBatchesParallel (dgParallelSolverSyncData* const syncData, dgWorkerThreadTaskCallback kernel) const;
+	void CalculateBodiesParallel (dgParallelSolverSyncData* const syncData, dgWorkerThreadTaskCallback kernel) const;
+	void CalculateJointsParallel (dgParallelSolverSyncData* const syncData, dgWorkerThreadTaskCallback kernel) const;
 
-	void CalculateReactionForcesParallel (const dgBodyCluster* const cluster, dgFloat32 timestep) const;
+	void CalculateReactionForcesParallel (dgBodyCluster* const cluster, dgFloat32 timestep) const;
 	void LinearizeJointParallelArray(dgParallelSolverSyncData* const solverSyncData, dgJointInfo* const constraintArray, const dgBodyCluster* const cluster) const;
 
 	void CalculateNetAcceleration (dgBody* const body, const dgVector& invTimeStep, const dgVector& accNorm) const;
@@ -288,6 +345,8 @@ class dgWorldDynamicUpdate
 	void SortClustersByCount ();
 	void IntegrateExternalForce(const dgBodyCluster* const cluster, dgFloat32 timestep, dgInt32 threadID) const;
 	void IntegrateVelocity (const dgBodyCluster* const cluster, dgFloat32 accelTolerance, dgFloat32 timestep, dgInt32 threadID) const;
+	void IntegrateBodyVelocity (dgBody* const body, const dgVector& velocDragVect, dgFloat32 speedFreeze, dgFloat32 accelFreeze, dgFloat32 timestep, dgClusterSleepState& sleepState, dgInt32 threadID) const;
+	void UpdateClusterSleepState (const dgBodyCluster* const cluster, const dgClusterSleepState& sleepState, dgFloat32 timestep) const;
 
 	void CalculateClusterContacts (dgBodyCluster* const cluster, dgFloat32 timestep, dgInt32 currLru, dgInt32 threadID) const;
 	dgInt32 GetJacobianDerivatives (dgContraintDescritor& constraintParamOut, dgJointInfo* const jointInfo, dgConstraint* const constraint, dgJacobianMatrixElement* const matrixRow, dgInt32 rowCount) const;
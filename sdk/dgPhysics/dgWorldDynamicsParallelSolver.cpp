@@ -25,34 +25,48 @@
 #include "dgWorld.h"
 #include "dgConstraint.h"
 #include "dgDynamicBody.h"
+#include "dgSkeletonContainer.h"
 #include "dgWorldDynamicUpdate.h"
 
+// batches smaller than this per thread are not worth a synchronization barrier, they are solved by one thread 
+#define DG_PARALLEL_BATCH_MIN_JOINTS_PER_THREAD	8
 
 
-
-
-void dgWorldDynamicUpdate::CalculateReactionForcesParallel(const dgBodyCluster* const cluster, dgFloat32 timestep) const
+void dgWorldDynamicUpdate::CalculateReactionForcesParallel(dgBodyCluster* const cluster, dgFloat32 timestep) const
 {
-	dgAssert(0);
-	/*
-	dgParallelSolverSyncData syncData;
-
 	dgWorld* const world = (dgWorld*) this;
+	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
+	dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart];
 
-	syncData.m_bodyLocks = dgAlloca (dgInt32, island->m_bodyCount + 1024);
-	syncData.m_jointConflicts = dgAlloca (dgParallelSolverSyncData::dgParallelJointMap, island->m_jointCount + 1024);
-	memset (syncData.m_bodyLocks, 0, island->m_bodyCount * sizeof (dgInt32));
+	// continue collision and skeleton clusters are not supported by the parallel solver
+	bool hasSkeletons = false;
+	for (dgInt32 i = 1; (i < cluster->m_bodyCount) && !hasSkeletons; i ++) {
+		hasSkeletons = bodyArray[i].m_body->GetSkeleton() ? true : false;
+	}
+	if (cluster->m_isContinueCollision || hasSkeletons) {
+		ResolveClusterForces (cluster, 0, timestep);
+		return;
+	}
 
-	dgInt32 bodyCount = island->m_bodyCount;
-	dgInt32 jointsCount = island->m_jointCount;
-	dgJointInfo* const constraintArrayPtr = (dgJointInfo*) &world->m_jointsMemory[0];
-	dgJointInfo* const constraintArray = &constraintArrayPtr[island->m_jointStart];
+	const dgInt32 activeJoints = SortClusters(cluster, timestep, 0);
+	if (!activeJoints) {
+		for (dgInt32 i = 1; i < cluster->m_bodyCount; i++) {
+			dgBody* const body = bodyArray[i].m_body;
+			body->m_accel = dgVector::m_zero;
+			body->m_alpha = dgVector::m_zero;
+		}
+		IntegrateVelocity (cluster, DG_SOLVER_MAX_ERROR, timestep, 0); 
+		return;
+	}
 
-	LinearizeJointParallelArray (&syncData, constraintArray, island);
-	
-	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForcesBuffer[0];
-	internalForces[0].m_linear = dgVector::m_zero;
-	internalForces[0].m_angular = dgVector::m_zero;
+	dgParallelSolverSyncData syncData;
+	dgFrameArena::dgBuffer<dgParallelSolverSyncData::dgParallelJointMap> jointConflicts (world->m_frameArena, 0, cluster->m_jointCount + 1);
+	syncData.m_jointConflicts = jointConflicts.GetBuffer();
+	syncData.m_threadData = (dgParallelSolverThreadData*) &world->m_solverThreadMemory[0];
+
+	dgJointInfo* const constraintArrayPtr = (dgJointInfo*) &world->m_jointsMemory[0];
+	dgJointInfo* const constraintArray = &constraintArrayPtr[cluster->m_jointStart];
+	LinearizeJointParallelArray (&syncData, constraintArray, cluster);
 
 	const dgInt32 maxPasses = 4;
 	syncData.m_timestep = timestep;
@@ -63,24 +77,85 @@ void dgWorldDynamicUpdate::CalculateReactionForcesParallel(const dgBodyCluster*
 	syncData.m_maxPasses = maxPasses;
 	syncData.m_passes = world->m_solverMode;
 
-	syncData.m_bodyCount = bodyCount;
-	syncData.m_jointCount = jointsCount;
+	syncData.m_bodyCount = cluster->m_bodyCount;
+	syncData.m_jointCount = cluster->m_jointCount;
 	syncData.m_atomicIndex = 0;
-	syncData.m_island = island;
+	syncData.m_cluster = cluster;
 
 	InitilizeBodyArrayParallel (&syncData);
 	BuildJacobianMatrixParallel (&syncData);
 	SolverInitInternalForcesParallel (&syncData);
 	CalculateForcesGameModeParallel (&syncData);
-	IntegrateIslandParallel(&syncData); 
-*/
+	IntegrateClusterParallel(&syncData); 
+}
+
+
+void dgWorldDynamicUpdate::CalculateBodiesParallel (dgParallelSolverSyncData* const syncData, dgWorkerThreadTaskCallback kernel) const
+{
+	dgWorld* const world = (dgWorld*) this;
+	const dgInt32 threadCounts = world->GetThreadCount();	
+
+	// body zero is the sentinel
+	syncData->m_atomicIndex = 1;
+	for (dgInt32 i = 0; i < threadCounts; i ++) {
+		world->QueueJob (kernel, syncData, world);
+	}
+	world->SynchronizationBarrier();
+}
+
+
+void dgWorldDynamicUpdate::CalculateJointsParallel (dgParallelSolverSyncData* const syncData, dgWorkerThreadTaskCallback kernel) const
+{
+	dgWorld* const world = (dgWorld*) this;
+	const dgInt32 threadCounts = world->GetThreadCount();	
+
+	syncData->m_atomicIndex = 0;
+	for (dgInt32 i = 0; i < threadCounts; i ++) {
+		world->QueueJob (kernel, syncData, world);
+	}
+	world->SynchronizationBarrier();
+}
+
+
+void dgWorldDynamicUpdate::CalculateJointBatchesParallel (dgParallelSolverSyncData* const syncData, dgWorkerThreadTaskCallback kernel) const
+{
+	dgWorld* const world = (dgWorld*) this;
+	const dgInt32 threadCounts = world->GetThreadCount();	
+	const dgInt32 batchCount = syncData->m_bachCount;
+	const dgInt32 parallelBatchCount = batchCount - syncData->m_overflowBach;
+	const dgInt32 minJointsCount = threadCounts * DG_PARALLEL_BATCH_MIN_JOINTS_PER_THREAD;
+
+	// joints in the same batch do not share dynamics bodies, so each batch can be solved concurrently,
+	// except for the overflow batch which holds the joints that could not be colored
+	dgInt32 batchIndex = 0;
+	for (; batchIndex < parallelBatchCount; batchIndex ++) {
+		const dgInt32 start = syncData->m_jointBatches[batchIndex];
+		const dgInt32 end = syncData->m_jointBatches[batchIndex + 1];
+		if ((end - start) < minJointsCount) {
+			break;
+		}
+		syncData->m_atomicIndex = start;
+		syncData->m_bachIndex = end;
+		for (dgInt32 i = 0; i < threadCounts; i ++) {
+			world->QueueJob (kernel, syncData, world);
+		}
+		world->SynchronizationBarrier();
+	}
+
+	// batches are sorted by color and greedy coloring tends to make the later colors smaller, once a batch is too small
+	// the remaining batches and the overflow batch are solved sequentially by one thread
+	if (batchIndex < batchCount) {
+		syncData->m_atomicIndex = syncData->m_jointBatches[batchIndex];
+		syncData->m_bachIndex = syncData->m_jointBatches[batchCount];
+		kernel (syncData, world, 0);
+	}
 }
 
 
 dgInt32 dgWorldDynamicUpdate::SortJointInfoByColor(const dgParallelSolverSyncData::dgParallelJointMap* const indirectIndexA, const dgParallelSolverSyncData::dgParallelJointMap* const indirectIndexB, void* const )
 {
-	dgInt64 keyA = (((dgInt64)indirectIndexA->m_bashCount) << 32) + indirectIndexA->m_color;
-	dgInt64 keyB = (((dgInt64)indirectIndexB->m_bashCount) << 32) + indirectIndexB->m_color;
+	dgInt64 keyA = (((dgInt64)indirectIndexA->m_bashCount) << 32) + indirectIndexA->m_jointIndex;
+	dgInt64 keyB = (((dgInt64)indirectIndexB->m_bashCount) << 32) + indirectIndexB->m_jointIndex;
 	if (keyA < keyB) {
 		return -1;
 	}
@@ -104,44 +179,38 @@ void dgWorldDynamicUpdate::LinearizeJointParallelArray(dgParallelSolverSyncData*
 	jointInfoMap[count].m_color = 0x7fffffff;
 	jointInfoMap[count].m_jointIndex = -1;
 
+	// greedy graph coloring, the last color is reserved for joints that can not be colored,
+	// these are placed in a batch that is always solved by a single thread.
+	const dgInt32 overflowBatch = DG_MAX_PARALLEL_JOINT_BATCHES - 1;
 	for (dgInt32 i = 0; i < count; i++) {
 		dgInt32 index = 0;
 		dgInt32 color = jointInfoMap[i].m_color;
-		for (dgInt32 n = 1; n & color; n <<= 1) {
+		for (dgInt32 n = 1; (n & color) && (index < overflowBatch); n <<= 1) {
 			index++;
-			dgAssert(index < 32);
 		}
 		jointInfoMap[i].m_bashCount = index;
+		if (index == overflowBatch) {
+			continue;
+		}
+
 		color = 1 << index;
 		dgAssert(jointInfoMap[i].m_jointIndex == i);
 		dgJointInfo& jointInfo = constraintArray[i];
 
 		dgConstraint* const constraint = jointInfo.m_joint;
-		dgDynamicBody* const body0 = (dgDynamicBody*)constraint->m_body0;
-		dgAssert(body0->IsRTTIType(dgBody::m_dynamicBodyRTTI));
-
-		if (body0->m_invMass.m_w > dgFloat32(0.0f)) {
-			for (dgBodyMasterListRow::dgListNode* jointNode = body0->m_masterNode->GetInfo().GetFirst(); jointNode; jointNode = jointNode->GetNext()) {
-				dgBodyMasterListCell& cell = jointNode->GetInfo();
-
-				dgConstraint* const neiborgLink = cell.m_joint;
-				if ((neiborgLink != constraint) && (neiborgLink->m_maxDOF)) {
-					dgParallelSolverSyncData::dgParallelJointMap& info = jointInfoMap[neiborgLink->m_index];
-					info.m_color |= color;
-				}
-			}
-		}
-
-		dgDynamicBody* const body1 = (dgDynamicBody*)constraint->m_body1;
-		dgAssert(body1->IsRTTIType(dgBody::m_dynamicBodyRTTI));
-		if (body1->m_invMass.m_w > dgFloat32(0.0f)) {
-			for (dgBodyMasterListRow::dgListNode* jointNode = body1->m_masterNode->GetInfo().GetFirst(); jointNode; jointNode = jointNode->GetNext()) {
-				dgBodyMasterListCell& cell = jointNode->GetInfo();
-
-				dgConstraint* const neiborgLink = cell.m_joint;
-				if ((neiborgLink != constraint) && (neiborgLink->m_maxDOF)) {
-					dgParallelSolverSyncData::dgParallelJointMap& info = jointInfoMap[neiborgLink->m_index];
-					info.m_color |= color;
+		for (dgInt32 j = 0; j < 2; j ++) {
+			dgBody* const body = j ? constraint->m_body1 : constraint->m_body0;
+			dgAssert(body->IsRTTIType(dgBody::m_dynamicBodyRTTI) || body->IsRTTIType(dgBody::m_kinematicBodyRTTI));
+			if (body->m_invMass.m_w > dgFloat32(0.0f)) {
+				for (dgBodyMasterListRow::dgListNode* jointNode = body->m_masterNode->GetInfo().GetFirst(); jointNode; jointNode = jointNode->GetNext()) {
+					dgBodyMasterListCell& cell = jointNode->GetInfo();
+
+					dgConstraint* const neiborgLink = cell.m_joint;
+					const dgInt32 neiborgIndex = neiborgLink->m_index;
+					// skip links that are not part of this cluster, their index is stale
+					if ((neiborgLink != constraint) && (neiborgIndex < count) && (constraintArray[neiborgIndex].m_joint == neiborgLink)) {
+						jointInfoMap[neiborgIndex].m_color |= color;
+					}
 				}
 			}
 		}
@@ -149,221 +218,198 @@ void dgWorldDynamicUpdate::LinearizeJointParallelArray(dgParallelSolverSyncData*
 
 	dgSort(jointInfoMap, count, SortJointInfoByColor);
 
-	dgInt32 acc = 0;
 	dgInt32 bash = 0;
 	dgInt32 bachCount = 0;
-	for (int i = 0; i < count; i++) {
+	solverSyncData->m_jointBatches[0] = 0;
+	for (dgInt32 i = 0; i < count; i++) {
 		if (jointInfoMap[i].m_bashCount > bash) {
 			bash = jointInfoMap[i].m_bashCount;
-			solverSyncData->m_jointBatches[bachCount + 1] = acc;
 			bachCount++;
-			dgAssert(bachCount < (dgInt32(sizeof (solverSyncData->m_jointBatches) / sizeof (solverSyncData->m_jointBatches[0])) - 1));
+			solverSyncData->m_jointBatches[bachCount] = i;
+			dgAssert(bachCount < DG_MAX_PARALLEL_JOINT_BATCHES);
 		}
-		acc++;
 	}
 	bachCount++;
 	solverSyncData->m_bachCount = bachCount;
-	solverSyncData->m_jointBatches[bachCount] = acc;
-	dgAssert(bachCount < (dgInt32(sizeof (solverSyncData->m_jointBatches) / sizeof (solverSyncData->m_jointBatches[0])) - 1));
+	solverSyncData->m_overflowBach = (count && (jointInfoMap[count - 1].m_bashCount == overflowBatch)) ? 1 : 0;
+	solverSyncData->m_jointBatches[bachCount] = count;
+	dgAssert(bachCount <= DG_MAX_PARALLEL_JOINT_BATCHES);
 }
 
 
 void dgWorldDynamicUpdate::InitilizeBodyArrayParallel (dgParallelSolverSyncData* const syncData) const
 {
-	dgAssert (0);
-	/*
-	dgWorld* const world = (dgWorld*) this;
-	const dgInt32 threadCounts = world->GetThreadCount();	
-
-	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForcesBuffer[0];
-	internalForces[0].m_linear = dgVector(dgFloat32(0.0f));
-	internalForces[0].m_angular = dgVector(dgFloat32(0.0f));
-
-	syncData->m_atomicIndex = 1;
-	for (dgInt32 i = 0; i < threadCounts; i ++) {
-		world->QueueJob (InitializeBodyArrayParallelKernel, syncData, world);
-	}
-	world->SynchronizationBarrier();
-*/
+	const dgBodyCluster* const cluster = syncData->m_cluster;
+	dgJacobian* const internalForces = &m_solverMemory.m_internalForcesBuffer[cluster->m_bodyStart];
+	internalForces[0].m_linear = dgVector::m_zero;
+	internalForces[0].m_angular = dgVector::m_zero;
+	CalculateBodiesParallel (syncData, InitializeBodyArrayParallelKernel);
 }
 
+
 void dgWorldDynamicUpdate::InitializeBodyArrayParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
 {
-	dgAssert (0);
-/*
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
 	dgInt32* const atomicIndex = &syncData->m_atomicIndex; 
 
-	const dgIsland* const island = syncData->m_island;
+	const dgBodyCluster* const cluster = syncData->m_cluster;
 	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
-	dgBodyInfo* const bodyArray = &bodyArrayPtr[island->m_bodyStart];
-	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForcesBuffer[0];
+	dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart];
+	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForcesBuffer[cluster->m_bodyStart];
 
-	if (syncData->m_timestep != dgFloat32 (0.0f)) {
-		for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_bodyCount; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
-			dgAssert (bodyArray[0].m_body->IsRTTIType (dgBody::m_dynamicBodyRTTI) || (((dgDynamicBody*)bodyArray[0].m_body)->m_accel.DotProduct3(((dgDynamicBody*)bodyArray[0].m_body)->m_accel)) == dgFloat32 (0.0f));
-			dgAssert (bodyArray[0].m_body->IsRTTIType (dgBody::m_dynamicBodyRTTI) || (((dgDynamicBody*)bodyArray[0].m_body)->m_alpha.DotProduct3(((dgDynamicBody*)bodyArray[0].m_body)->m_alpha)) == dgFloat32 (0.0f));
-
-			dgBody* const body = bodyArray[i].m_body;
-			dgAssert (body->m_index == i);
-			if (!body->m_equilibrium) {
-				dgAssert (body->m_invMass.m_w > dgFloat32 (0.0f));
-				body->AddDampingAcceleration(syncData->m_timestep);
-				body->CalcInvInertiaMatrix ();
-			}
-
-			if (body->m_active) {
-				// re use these variables for temp storage 
-				body->m_netForce = body->m_veloc;
-				body->m_netTorque = body->m_omega;
-				internalForces[i].m_linear = dgVector::m_zero;
-				internalForces[i].m_angular = dgVector::m_zero;
+	const dgFloat32 timestep = syncData->m_timestep;
+	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_bodyCount; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+		dgDynamicBody* const body = (dgDynamicBody*)bodyArray[i].m_body;
+		dgAssert(body->IsRTTIType(dgBody::m_dynamicBodyRTTI) || body->IsRTTIType(dgBody::m_kinematicBodyRTTI));
+		dgAssert (body->m_index == i);
+		if (!body->m_equilibrium) {
+			dgAssert (body->m_invMass.m_w > dgFloat32 (0.0f));
+			if (timestep != dgFloat32 (0.0f)) {
+				body->AddDampingAcceleration(timestep);
 			}
+			body->CalcInvInertiaMatrix ();
 		}
-	} else {
-		for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_bodyCount; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
-			dgAssert(bodyArray[0].m_body->IsRTTIType(dgBody::m_dynamicBodyRTTI) || (((dgDynamicBody*)bodyArray[0].m_body)->m_accel.DotProduct3(((dgDynamicBody*)bodyArray[0].m_body)->m_accel)) == dgFloat32(0.0f));
-			dgAssert(bodyArray[0].m_body->IsRTTIType(dgBody::m_dynamicBodyRTTI) || (((dgDynamicBody*)bodyArray[0].m_body)->m_alpha.DotProduct3(((dgDynamicBody*)bodyArray[0].m_body)->m_alpha)) == dgFloat32(0.0f));
-
-			dgBody* const body = bodyArray[i].m_body;
-			if (!body->m_equilibrium) {
-				dgAssert(body->m_invMass.m_w > dgFloat32(0.0f));
-				body->CalcInvInertiaMatrix();
-			}
 
-			if (body->m_active) {
-				 //re use these variables for temp storage 
-				body->m_netForce = body->m_veloc;
-				body->m_netTorque = body->m_omega;
-				internalForces[i].m_linear = dgVector::m_zero;
-				internalForces[i].m_angular = dgVector::m_zero;
-			}
-		}
+		// re use these variables for temp storage 
+		body->m_accel = body->m_veloc;
+		body->m_alpha = body->m_omega;
+		internalForces[i].m_linear = dgVector::m_zero;
+		internalForces[i].m_angular = dgVector::m_zero;
 	}
-*/
 }
 
 
 void dgWorldDynamicUpdate::BuildJacobianMatrixParallel (dgParallelSolverSyncData* const syncData) const
 {
-	dgWorld* const world = (dgWorld*) this;
-	const dgInt32 threadCounts = world->GetThreadCount();	
-
-	syncData->m_atomicIndex = 0;
-	for (dgInt32 i = 0; i < threadCounts; i ++) {
-		world->QueueJob (BuildJacobianMatrixParallelKernel, syncData, world);
-	}
-	world->SynchronizationBarrier();
+	DG_PROFILE_UPDATE_PHASE ((dgWorld*) this, m_jacobianBuild);
+	DG_PROFILE_UPDATE_ITEMS ((dgWorld*) this, m_jacobianBuild, syncData->m_jointCount);
+	syncData->m_jacobianMatrixRowAtomicIndex = 0;
+	CalculateJointsParallel (syncData, BuildJacobianMatrixParallelKernel);
+	dgAssert (syncData->m_jacobianMatrixRowAtomicIndex <= syncData->m_cluster->m_rowsCount);
 }
 
 
 void dgWorldDynamicUpdate::BuildJacobianMatrixParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
 {
-	dgAssert (0);
-/*
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILE_PHASE (world, m_jacobianBuild, threadID);
 	dgInt32* const atomicIndex = &syncData->m_atomicIndex; 
-	const dgIsland* const island = syncData->m_island;
+	const dgBodyCluster* const cluster = syncData->m_cluster;
 	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
-	dgBodyInfo* const bodyArray = &bodyArrayPtr[island->m_bodyStart];
+	dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart];
 	dgJointInfo* const constraintArrayPtr = (dgJointInfo*) &world->m_jointsMemory[0];
-	dgJointInfo* const constraintArray = &constraintArrayPtr[island->m_jointStart];
-	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_jacobianBuffer[0];
+	dgJointInfo* const constraintArray = &constraintArrayPtr[cluster->m_jointStart];
+	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_jacobianBuffer[cluster->m_rowsStart];
 	dgAssert (syncData->m_jointCount);
 
 	dgContraintDescritor constraintParams;
 	constraintParams.m_world = world;
 	constraintParams.m_threadIndex = threadID;
 	constraintParams.m_timestep = syncData->m_timestep;
-	constraintParams.m_invTimestep = syncData->m_invTimestep;
+	constraintParams.m_invTimestep = (syncData->m_timestep > dgFloat32(1.0e-5f)) ? dgFloat32(1.0f / syncData->m_timestep) : dgFloat32(0.0f);
+	const dgFloat32 forceOrImpulseScale = (syncData->m_timestep > dgFloat32 (0.0f)) ? dgFloat32 (1.0f) : dgFloat32 (0.0f);
 
-	dgFloat32 forceOrImpulseScale = (syncData->m_timestep > dgFloat32 (0.0f)) ? dgFloat32 (1.0f) : dgFloat32 (0.0f);
 	for (dgInt32 jointIndex = dgAtomicExchangeAndAdd(atomicIndex, 1); jointIndex < syncData->m_jointCount;  jointIndex = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
 		dgJointInfo* const jointInfo = &constraintArray[jointIndex];
 		dgConstraint* const constraint = jointInfo->m_joint;
 
-		dgInt32 rowBase = dgAtomicExchangeAndAdd(&syncData->m_jacobianMatrixRowAtomicIndex, jointInfo->m_pairCount);
-
+		// m_pairCount is the max dof rounded up to the vector size, so all rows blocks stay aligned
+		dgAssert ((jointInfo->m_pairCount & (dgInt32(sizeof (dgVector) / sizeof (dgFloat32)) - 1)) == 0);
+		const dgInt32 rowBase = dgAtomicExchangeAndAdd(&syncData->m_jacobianMatrixRowAtomicIndex, jointInfo->m_pairCount);
 		world->GetJacobianDerivatives(constraintParams, jointInfo, constraint, matrixRow, rowBase);
+		dgAssert ((rowBase + jointInfo->m_pairCount) <= cluster->m_rowsCount);
 
 		dgAssert (jointInfo->m_m0 >= 0);
 		dgAssert (jointInfo->m_m1 >= 0);
 		dgAssert (jointInfo->m_m0 != jointInfo->m_m1);
-		dgAssert (jointInfo->m_m0 < island->m_bodyCount);
-		dgAssert (jointInfo->m_m1 < island->m_bodyCount);
-		world->BuildJacobianMatrix (bodyArray, jointInfo, matrixRow, forceOrImpulseScale);
+		dgAssert (jointInfo->m_m0 < cluster->m_bodyCount);
+		dgAssert (jointInfo->m_m1 < cluster->m_bodyCount);
+
+		// bodies are shared by many joints, the internal forces are accumulated later in batches
+		const dgInt32 m0 = jointInfo->m_m0;
+		const dgInt32 m1 = jointInfo->m_m1;
+		dgBodyInfo localBodies[2];
+		dgJacobian localForces[2];
+		localBodies[0] = bodyArray[m0];
+		localBodies[1] = bodyArray[m1];
+		jointInfo->m_m0 = 0;
+		jointInfo->m_m1 = 1;
+		world->BuildJacobianMatrix (localBodies, jointInfo, localForces, matrixRow, forceOrImpulseScale);
+		jointInfo->m_m0 = m0;
+		jointInfo->m_m1 = m1;
 	}
-*/
 }
 
 
 void dgWorldDynamicUpdate::SolverInitInternalForcesParallel (dgParallelSolverSyncData* const syncData) const
 {
-	dgWorld* const world = (dgWorld*) this;
-	const dgInt32 threadCounts = world->GetThreadCount();	
-
-	syncData->m_atomicIndex = 0;
-	for (dgInt32 i = 0; i < threadCounts; i ++) {
-		world->QueueJob (SolverInitInternalForcesParallelKernel, syncData, world);
-	}
-	world->SynchronizationBarrier();
+	CalculateJointBatchesParallel (syncData, SolverInitInternalForcesParallelKernel);
 }
 
 
 void dgWorldDynamicUpdate::SolverInitInternalForcesParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
 {
-	dgAssert (0);
-/*
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
-	const dgIsland* const island = syncData->m_island;
-	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForcesBuffer[0];
-	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_jacobianBuffer[0];
+	const dgBodyCluster* const cluster = syncData->m_cluster;
+	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForcesBuffer[cluster->m_bodyStart];
+	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_jacobianBuffer[cluster->m_rowsStart];
 	dgInt32* const atomicIndex = &syncData->m_atomicIndex; 
 	dgJointInfo* const constraintArrayPtr = (dgJointInfo*) &world->m_jointsMemory[0];
-	dgJointInfo* const constraintArray = &constraintArrayPtr[island->m_jointStart];
-	dgInt32* const bodyLocks = syncData->m_bodyLocks;
+	dgJointInfo* const constraintArray = &constraintArrayPtr[cluster->m_jointStart];
+	const dgParallelSolverSyncData::dgParallelJointMap* const jointInfoMap = syncData->m_jointConflicts;
 
-	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_jointCount;  i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
-		dgJointInfo* const jointInfo = &constraintArray[i];
-		if (jointInfo->m_joint->m_solverActive) {
-			dgJacobian y0;
-			dgJacobian y1;
-			world->InitJointForce (jointInfo, matrixRow, y0, y1);
-			const dgInt32 m0 = jointInfo->m_m0;
-			const dgInt32 m1 = jointInfo->m_m1;
-			dgAssert (m0 != m1);
-
-			if (m0) {
-				dgSpinLock(&bodyLocks[m0], false);
-				internalForces[m0].m_linear += y0.m_linear;
-				internalForces[m0].m_angular += y0.m_angular;
-				dgSpinUnlock(&bodyLocks[m0]);
-			}
-			if (m1) {
-				dgSpinLock(&bodyLocks[m1], false);
-				internalForces[m1].m_linear += y1.m_linear;
-				internalForces[m1].m_angular += y1.m_angular;
-				dgSpinUnlock(&bodyLocks[m1]);
-			}
+	const dgInt32 batchEnd = syncData->m_bachIndex;
+	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < batchEnd;  i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+		const dgJointInfo* const jointInfo = &constraintArray[jointInfoMap[i].m_jointIndex];
+
+		const dgInt32 index = jointInfo->m_pairStart;
+		const dgInt32 count = jointInfo->m_pairCount;
+		const dgInt32 m0 = jointInfo->m_m0;
+		const dgInt32 m1 = jointInfo->m_m1;
+		dgAssert (m0 != m1);
+
+		dgJacobian forceAcc0;
+		dgJacobian forceAcc1;
+		forceAcc0.m_linear = dgVector::m_zero;
+		forceAcc0.m_angular = dgVector::m_zero;
+		forceAcc1.m_linear = dgVector::m_zero;
+		forceAcc1.m_angular = dgVector::m_zero;
+		for (dgInt32 j = 0; j < count; j++) {
+			const dgJacobianMatrixElement* const row = &matrixRow[index + j];
+			dgAssert(dgCheckFloat(row->m_force));
+			const dgVector val(row->m_force);
+			forceAcc0.m_linear += row->m_Jt.m_jacobianM0.m_linear * val;
+			forceAcc0.m_angular += row->m_Jt.m_jacobianM0.m_angular * val;
+			forceAcc1.m_linear += row->m_Jt.m_jacobianM1.m_linear * val;
+			forceAcc1.m_angular += row->m_Jt.m_jacobianM1.m_angular * val;
+		}
+
+		// the sentinel body is shared by all joints attached to static bodies, it does not need the forces 
+		if (m0) {
+			const dgVector scale0(jointInfo->m_scale0);
+			internalForces[m0].m_linear += forceAcc0.m_linear * scale0;
+			internalForces[m0].m_angular += forceAcc0.m_angular * scale0;
+		}
+		if (m1) {
+			const dgVector scale1(jointInfo->m_scale1);
+			internalForces[m1].m_linear += forceAcc1.m_linear * scale1;
+			internalForces[m1].m_angular += forceAcc1.m_angular * scale1;
 		}
 	}
-*/
 }
 
 
 void dgWorldDynamicUpdate::CalculateJointsAccelParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
 {
-	dgAssert (0);
-/*
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
-	const dgIsland* const island = syncData->m_island;
+	const dgBodyCluster* const cluster = syncData->m_cluster;
 	dgJointInfo* const constraintArrayPtr = (dgJointInfo*) &world->m_jointsMemory[0];
-	dgJointInfo* const constraintArray = &constraintArrayPtr[island->m_jointStart];
-	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_jacobianBuffer[0];
+	dgJointInfo* const constraintArray = &constraintArrayPtr[cluster->m_jointStart];
+	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_jacobianBuffer[cluster->m_rowsStart];
 
 	dgJointAccelerationDecriptor joindDesc;
 	joindDesc.m_timeStep = syncData->m_timestepRK;
@@ -371,172 +417,167 @@ void dgWorldDynamicUpdate::CalculateJointsAccelParallelKernel (void* const conte
 	joindDesc.m_firstPassCoefFlag = syncData->m_firstPassCoef;
 
 	dgInt32* const atomicIndex = &syncData->m_atomicIndex; 
-	if (joindDesc.m_firstPassCoefFlag == dgFloat32 (0.0f)) {
-		for (dgInt32 curJoint = dgAtomicExchangeAndAdd(atomicIndex, 1); curJoint < syncData->m_jointCount;  curJoint = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
-			dgJointInfo* const jointInfo = &constraintArray[curJoint];
-			dgConstraint* const constraint = jointInfo->m_joint;
-			if (constraint->m_solverActive) {
-				joindDesc.m_rowsCount = jointInfo->m_pairCount;
-				joindDesc.m_rowMatrix = &matrixRow[jointInfo->m_pairStart];
-				constraint->JointAccelerations(&joindDesc);
-			}
-		}
-	} else {
-		const dgIsland* const island = syncData->m_island;
-		dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
-		const dgBodyInfo* const bodyArray = &bodyArrayPtr[island->m_bodyStart];
-
-		for (dgInt32 curJoint = dgAtomicExchangeAndAdd(atomicIndex, 1); curJoint < syncData->m_jointCount;  curJoint = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
-			dgJointInfo* const jointInfo = &constraintArray[curJoint];
-			dgConstraint* const constraint = jointInfo->m_joint;
-			if (constraint->m_solverActive) {
-				const dgInt32 m0 = jointInfo->m_m0;
-				const dgInt32 m1 = jointInfo->m_m1;
-				const dgBody* const body0 = bodyArray[m0].m_body;
-				const dgBody* const body1 = bodyArray[m1].m_body;
-				if (!(body0->m_resting & body1->m_resting)) {
-					joindDesc.m_rowsCount = jointInfo->m_pairCount;
-					joindDesc.m_rowMatrix = &matrixRow[jointInfo->m_pairStart];
-					constraint->JointAccelerations(&joindDesc);
-				}
-			}
-		}
+	for (dgInt32 curJoint = dgAtomicExchangeAndAdd(atomicIndex, 1); curJoint < syncData->m_jointCount;  curJoint = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+		dgJointInfo* const jointInfo = &constraintArray[curJoint];
+		dgConstraint* const constraint = jointInfo->m_joint;
+		joindDesc.m_rowsCount = jointInfo->m_pairCount;
+		joindDesc.m_rowMatrix = &matrixRow[jointInfo->m_pairStart];
+		constraint->JointAccelerations(&joindDesc);
 	}
-*/
 }
 
 
-void dgWorldDynamicUpdate::CalculateJointsVelocParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
+void dgWorldDynamicUpdate::CalculateJointsForceParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
 {
-dgAssert (0);
-/*
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILE_PHASE (world, m_solverPasses, threadID);
 
-	const dgIsland* const island = syncData->m_island;
+	const dgBodyCluster* const cluster = syncData->m_cluster;
+	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_jacobianBuffer[cluster->m_rowsStart];
 	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
-	dgBodyInfo* const bodyArray = &bodyArrayPtr[island->m_bodyStart];
-
-	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForcesBuffer[0];
+	const dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart];
+	dgJointInfo* const constraintArrayPtr = (dgJointInfo*) &world->m_jointsMemory[0];
+	dgJointInfo* const constraintArray = &constraintArrayPtr[cluster->m_jointStart];
+	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForcesBuffer[cluster->m_bodyStart];
+	const dgParallelSolverSyncData::dgParallelJointMap* const jointInfoMap = syncData->m_jointConflicts;
 
-	dgVector speedFreeze2 (world->m_freezeSpeed2 * dgFloat32 (0.1f));
-	dgVector freezeOmega2 (world->m_freezeOmega2 * dgFloat32 (0.1f));
-	dgVector forceActiveMask ((syncData->m_jointCount <= DG_SMALL_ISLAND_COUNT) ?  dgVector (-1, -1, -1, -1) : dgFloat32 (0.0f));
 	dgInt32* const atomicIndex = &syncData->m_atomicIndex;
+	const dgInt32 batchEnd = syncData->m_bachIndex;
+	dgFloat32 accNorm = dgFloat32(0.0f);
+	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < batchEnd; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+		const dgJointInfo* const jointInfo = &constraintArray[jointInfoMap[i].m_jointIndex];
 
-	if (syncData->m_timestepRK != dgFloat32 (0.0f)) {
-		dgVector timestep4 (syncData->m_timestepRK);
-		for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_bodyCount;  i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
-			dgDynamicBody* const body = (dgDynamicBody*) bodyArray[i].m_body;
-			dgAssert (body->m_index == i);
-			world->ApplyNetVelcAndOmega (body, internalForces[i], timestep4, speedFreeze2, forceActiveMask);
-		}
-	} else {
-		for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_bodyCount;  i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
-			dgBody* const body = bodyArray[i].m_body;
-			if (body->m_active) {
-				const dgVector& linearMomentum = internalForces[i].m_linear;
-				const dgVector& angularMomentum = internalForces[i].m_angular;
+		// joints in a batch do not share dynamic bodies, but all static bodies map to the sentinel,
+		// so the joint is solved on a local copy of its two bodies.
+		const dgInt32 m0 = jointInfo->m_m0;
+		const dgInt32 m1 = jointInfo->m_m1;
+		dgAssert(m0 != m1);
 
-				body->m_veloc += linearMomentum.Scale4(body->m_invMass.m_w);
-				body->m_omega += body->m_invWorldInertiaMatrix.RotateVector(angularMomentum);
-			}
+		dgJointInfo localJoint (*jointInfo);
+		dgBodyInfo localBodies[2];
+		dgJacobian localForces[2];
+		localJoint.m_m0 = 0;
+		localJoint.m_m1 = 1;
+		localBodies[0] = bodyArray[m0];
+		localBodies[1] = bodyArray[m1];
+		localForces[0] = internalForces[m0];
+		localForces[1] = internalForces[m1];
+
+		accNorm += world->CalculateJointForce(&localJoint, localBodies, localForces, matrixRow);
+
+		if (m0) {
+			internalForces[m0] = localForces[0];
+		}
+		if (m1) {
+			internalForces[m1] = localForces[1];
 		}
 	}
-*/
+
+	syncData->m_threadData[threadID].m_accelNorm += accNorm;
 }
 
-/*
-void dgWorldDynamicUpdate::CalculateJointsImpulseVelocParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
+
+void dgWorldDynamicUpdate::CalculateJointsVelocParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
 {
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
 
-	const dgIsland* const island = syncData->m_island;
+	const dgBodyCluster* const cluster = syncData->m_cluster;
 	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
-	dgBodyInfo* const bodyArray = &bodyArrayPtr[island->m_bodyStart];
-
-	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForces[0];
-	//dgJacobian* const internalVeloc = &world->m_solverMemory.m_internalVeloc[0];
+	dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart];
+	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForcesBuffer[cluster->m_bodyStart];
 
+	dgVector speedFreeze2 (world->m_freezeSpeed2 * dgFloat32 (0.1f));
 	dgInt32* const atomicIndex = &syncData->m_atomicIndex;
-	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_bodyCount;  i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
-		dgInt32 index = i + 1;
-		dgAssert (index);
-		dgDynamicBody* const body = (dgDynamicBody*) bodyArray[index].m_body;
-		dgAssert (body->m_index == index);
 
-		const dgVector& linearMomentum = internalForces[index].m_linear;
-		const dgVector& angularMomentum = internalForces[index].m_angular;
+	if (syncData->m_timestepRK != dgFloat32 (0.0f)) {
+		dgVector timestep4 (syncData->m_timestepRK);
+		for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_bodyCount;  i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+			dgDynamicBody* const body = (dgDynamicBody*) bodyArray[i].m_body;
+			dgAssert (body->m_index == i);
+			if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
+				const dgJacobian& forceAndTorque = internalForces[i];
+				const dgVector force(body->m_externalForce + forceAndTorque.m_linear);
+				const dgVector torque(body->m_externalTorque + forceAndTorque.m_angular);
+
+				const dgVector velocStep((force.Scale4(body->m_invMass.m_w)) * timestep4);
+				const dgVector omegaStep((body->m_invWorldInertiaMatrix.RotateVector(torque)) * timestep4);
+
+				if (!body->m_resting) {
+					body->m_veloc += velocStep;
+					body->m_omega += omegaStep;
+				} else {
+					const dgVector velocStep2(velocStep.DotProduct4(velocStep));
+					const dgVector omegaStep2(omegaStep.DotProduct4(omegaStep));
+					const dgVector test(((velocStep2 > speedFreeze2) | (omegaStep2 > speedFreeze2)) & dgVector::m_negOne);
+					const dgInt32 equilibrium = test.GetSignMask() ? 0 : 1;
+					body->m_resting &= equilibrium;
+				}
 
-		body->m_veloc += linearMomentum.Scale4(body->m_invMass.m_w);
-		body->m_omega += body->m_invWorldInertiaMatrix.RotateVector (angularMomentum);
+				dgAssert(body->m_veloc.m_w == dgFloat32(0.0f));
+				dgAssert(body->m_omega.m_w == dgFloat32(0.0f));
+			}
+		}
+	} else {
+		for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_bodyCount;  i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+			dgDynamicBody* const body = (dgDynamicBody*) bodyArray[i].m_body;
+			const dgVector& linearMomentum = internalForces[i].m_linear;
+			const dgVector& angularMomentum = internalForces[i].m_angular;
 
-		//internalVeloc[index].m_linear += body->m_veloc;
-		//internalVeloc[index].m_angular += body->m_omega;
+			body->m_veloc += linearMomentum.Scale4(body->m_invMass.m_w);
+			body->m_omega += body->m_invWorldInertiaMatrix.RotateVector(angularMomentum);
+		}
 	}
 }
-*/
+
 
 void dgWorldDynamicUpdate::UpdateFeedbackForcesParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
 {
-dgAssert (0);
-/*
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
-	const dgIsland* const island = syncData->m_island;
+	const dgBodyCluster* const cluster = syncData->m_cluster;
 	dgJointInfo* const constraintArrayPtr = (dgJointInfo*) &world->m_jointsMemory[0];
-	dgJointInfo* const constraintArray = &constraintArrayPtr[island->m_jointStart];
-	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_jacobianBuffer[0];
+	dgJointInfo* const constraintArray = &constraintArrayPtr[cluster->m_jointStart];
+	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_jacobianBuffer[cluster->m_rowsStart];
 
 	dgInt32 hasJointFeeback = 0;
 	dgInt32* const atomicIndex = &syncData->m_atomicIndex;
-	
 	for (dgInt32 curJoint = dgAtomicExchangeAndAdd(atomicIndex, 1); curJoint < syncData->m_jointCount;  curJoint = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
 		dgJointInfo* const jointInfo = &constraintArray[curJoint];
 		dgConstraint* const constraint = jointInfo->m_joint;
-		if (constraint->m_solverActive) {
-			const dgInt32 first = jointInfo->m_pairStart;
-			const dgInt32 count = jointInfo->m_pairCount;
-
-			for (dgInt32 j = 0; j < count; j++) {
-				dgJacobianMatrixElement* const row = &matrixRow[j + first];
-				dgFloat32 val = row->m_force;
-				dgAssert(dgCheckFloat(val));
-				row->m_jointFeebackForce->m_force = val;
-				row->m_jointFeebackForce->m_impact = row->m_maxImpact * syncData->m_timestepRK;
-			}
-			hasJointFeeback |= (constraint->m_updaFeedbackCallback ? 1 : 0);
+		const dgInt32 first = jointInfo->m_pairStart;
+		const dgInt32 count = jointInfo->m_pairCount;
+
+		for (dgInt32 j = 0; j < count; j++) {
+			dgJacobianMatrixElement* const row = &matrixRow[j + first];
+			dgFloat32 val = row->m_force;
+			dgAssert(dgCheckFloat(val));
+			row->m_jointFeebackForce->m_force = val;
+			row->m_jointFeebackForce->m_impact = row->m_maxImpact * syncData->m_timestepRK;
 		}
+		hasJointFeeback |= (constraint->m_updaFeedbackCallback ? 1 : 0);
 	}
-	syncData->m_hasJointFeeback[threadID] = hasJointFeeback;
-*/
+	syncData->m_threadData[threadID].m_hasJointFeeback |= hasJointFeeback;
 }
 
 
 void dgWorldDynamicUpdate::UpdateBodyVelocityParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
 {
-dgAssert (0);
-/*
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
 
-	const dgBodyCluster* const island = syncData->m_cluster;
+	const dgBodyCluster* const cluster = syncData->m_cluster;
 	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
-	dgBodyInfo* const bodyArray = &bodyArrayPtr[island->m_bodyStart];
-
-	dgFloat32 maxAccNorm2 = DG_SOLVER_MAX_ERROR * DG_SOLVER_MAX_ERROR;
+	dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart];
 
-	//dgFloat32 invTimestepSrc = dgFloat32 (1.0f) / syncData->m_timestep;
-	dgFloat32 invTimestepSrc = syncData->m_invTimestep;
-
-	dgVector invTime (invTimestepSrc);
+	const dgVector invTime (syncData->m_invTimestep);
+	const dgVector maxAccNorm2 (DG_SOLVER_MAX_ERROR * DG_SOLVER_MAX_ERROR);
 	dgInt32* const atomicIndex = &syncData->m_atomicIndex;
 	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_bodyCount; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
-		dgDynamicBody* const body = (dgDynamicBody*) bodyArray[i].m_body;
+		dgBody* const body = bodyArray[i].m_body;
 		world->CalculateNetAcceleration (body, invTime, maxAccNorm2);
 	}
-*/
 }
 
 
@@ -544,9 +585,9 @@ void dgWorldDynamicUpdate::KinematicCallbackUpdateParallelKernel (void* const co
 {
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
-	const dgBodyCluster* const island = syncData->m_cluster;
+	const dgBodyCluster* const cluster = syncData->m_cluster;
 	dgJointInfo* const constraintArrayPtr = (dgJointInfo*) &world->m_jointsMemory[0];
-	dgJointInfo* const constraintArray = &constraintArrayPtr[island->m_jointStart];
+	dgJointInfo* const constraintArray = &constraintArrayPtr[cluster->m_jointStart];
 
 	dgInt32* const atomicIndex = &syncData->m_atomicIndex;
 	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_jointCount;  i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
@@ -558,183 +599,111 @@ void dgWorldDynamicUpdate::KinematicCallbackUpdateParallelKernel (void* const co
 }
 
 
+void dgWorldDynamicUpdate::IntegrateClusterParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
+	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILE_PHASE (world, m_integration, threadID);
+
+	const dgBodyCluster* const cluster = syncData->m_cluster;
+	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
+	dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart];
+
+	const dgFloat32 velocityDragCoeff = syncData->m_velocityDragCoeff;
+	const dgVector velocDragVect (velocityDragCoeff, velocityDragCoeff, velocityDragCoeff, dgFloat32 (0.0f));
+
+	dgClusterSleepState& sleepState = syncData->m_threadData[threadID].m_sleepState;
+	dgInt32* const atomicIndex = &syncData->m_atomicIndex;
+	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_bodyCount; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+		dgBody* const body = bodyArray[i].m_body;
+		world->IntegrateBodyVelocity (body, velocDragVect, syncData->m_speedFreeze, syncData->m_accelFreeze, syncData->m_timestep, sleepState, threadID);
+	}
+}
+
+
 void dgWorldDynamicUpdate::IntegrateClusterParallel(dgParallelSolverSyncData* const syncData) const
 {
-	dgAssert (0);
-/*
 	dgWorld* const world = (dgWorld*) this;
-//	dgWorldDynamicUpdate::IntegrateIslandParallelKernel (syncData, world, 0);
-	world->IntegrateVelocity (syncData->m_cluster, DG_SOLVER_MAX_ERROR, syncData->m_timestep, 0); 
-*/
+	DG_PROFILE_UPDATE_PHASE (world, m_integration);
+	const dgBodyCluster* const cluster = syncData->m_cluster;
+	const dgInt32 threadCounts = world->GetThreadCount();	
+	DG_PROFILE_UPDATE_ITEMS (world, m_integration, syncData->m_bodyCount - 1);
+
+	// parallel clusters are always large, so the small cluster drag and acceleration tolerances do not apply 
+	dgAssert (cluster->m_jointCount > DG_SMALL_ISLAND_COUNT);
+	syncData->m_velocityDragCoeff = DG_FREEZZING_VELOCITY_DRAG;
+	syncData->m_speedFreeze = world->m_freezeSpeed2;
+	syncData->m_accelFreeze = world->m_freezeAccel2;
+	for (dgInt32 i = 0; i < threadCounts; i ++) {
+		syncData->m_threadData[i].m_sleepState.Init();
+	}
+
+	CalculateBodiesParallel (syncData, IntegrateClusterParallelKernel);
+
+	dgClusterSleepState sleepState;
+	sleepState.Init();
+	for (dgInt32 i = 0; i < threadCounts; i ++) {
+		sleepState.Merge (syncData->m_threadData[i].m_sleepState);
+	}
+	UpdateClusterSleepState (cluster, sleepState, syncData->m_timestep);
 }
 
 
 void dgWorldDynamicUpdate::CalculateForcesGameModeParallel (dgParallelSolverSyncData* const syncData) const
 {
-dgAssert (0);
-/*
 	dgWorld* const world = (dgWorld*) this;
+	DG_PROFILE_UPDATE_PHASE (world, m_solverPasses);
+	DG_PROFILE_UPDATE_ITEMS (world, m_solverPasses, syncData->m_jointCount);
 	const dgInt32 threadCounts = world->GetThreadCount();	
 
 	const dgInt32 passes = syncData->m_passes;
 	const dgInt32 maxPasses = syncData->m_maxPasses;
-//	const dgInt32 batchCount = syncData->m_bachCount;
 	syncData->m_firstPassCoef = dgFloat32 (0.0f);
 
 	for (dgInt32 step = 0; step < maxPasses; step++) {
-
-		syncData->m_atomicIndex = 0;
-		for (dgInt32 i = 0; i < threadCounts; i++) {
-			world->QueueJob(CalculateJointsAccelParallelKernel, syncData, world);
-		}
-		world->SynchronizationBarrier();
+		CalculateJointsParallel (syncData, CalculateJointsAccelParallelKernel);
 		syncData->m_firstPassCoef = dgFloat32(1.0f);
 
-		dgFloat32 accNorm = DG_SOLVER_MAX_ERROR * dgFloat32(2.0f);
-		for (dgInt32 k = 0; (k < passes) && (accNorm > DG_SOLVER_MAX_ERROR); k++) {
-
-#if 0
-			dgInt32 batchIndex = 0;
-			dgInt32 count = syncData->m_jointBatches[batchIndex + 1];
-			while ((batchIndex < batchCount) && (count >= threadCounts * 8)) {
-				syncData->m_bachIndex = syncData->m_jointBatches[batchIndex + 1];
-				syncData->m_atomicIndex = syncData->m_jointBatches[batchIndex];
-				for (dgInt32 i = 0; i < threadCounts; i++) {
-					world->QueueJob(CalculateJointsForceParallelKernel, syncData, world);
-				}
-				world->SynchronizationBarrier();
-				accNorm = dgFloat32(0.0f);
-				for (dgInt32 i = 0; i < threadCounts; i++) {
-					accNorm = dgMax(accNorm, syncData->m_accelNorm[i]);
-				}
-
-				batchIndex++;
-				count = syncData->m_jointBatches[batchIndex + 1] - syncData->m_jointBatches[batchIndex];
-			}
-
-			if (batchIndex < batchCount) {
-				syncData->m_bachIndex = syncData->m_jointBatches[batchCount];
-				syncData->m_atomicIndex = syncData->m_jointBatches[batchIndex];
-				CalculateJointsForceParallelKernel(syncData, world, 0);
-				accNorm = dgMax(accNorm, syncData->m_accelNorm[0]);
-			}
-#endif
-
-			syncData->m_atomicIndex = 0;
+		const dgFloat32 maxAccNorm = DG_SOLVER_MAX_ERROR * DG_SOLVER_MAX_ERROR;
+		dgFloat32 accNorm = maxAccNorm * dgFloat32(2.0f);
+		for (dgInt32 k = 0; (k < passes) && (accNorm > maxAccNorm); k++) {
 			for (dgInt32 i = 0; i < threadCounts; i++) {
-				world->QueueJob(CalculateJointsForceParallelKernel, syncData, world);
+				syncData->m_threadData[i].m_accelNorm = dgFloat32(0.0f);
 			}
-			world->SynchronizationBarrier();
+			CalculateJointBatchesParallel (syncData, CalculateJointsForceParallelKernel);
 			accNorm = dgFloat32(0.0f);
 			for (dgInt32 i = 0; i < threadCounts; i++) {
-				accNorm = dgMax(accNorm, syncData->m_accelNorm[i]);
+				accNorm += syncData->m_threadData[i].m_accelNorm;
 			}
 		}
 
-
-		syncData->m_atomicIndex = 1;
-		for (dgInt32 j = 0; j < threadCounts; j++) {
-			world->QueueJob(CalculateJointsVelocParallelKernel, syncData, world);
-		}
-		world->SynchronizationBarrier();
+		CalculateBodiesParallel (syncData, CalculateJointsVelocParallelKernel);
 	}
 
 	if (syncData->m_timestepRK != dgFloat32 (0.0f)) {
-		syncData->m_atomicIndex = 0;
-		for (dgInt32 j = 0; j < threadCounts; j ++) {
-			world->QueueJob (UpdateFeedbackForcesParallelKernel, syncData, world);
+		for (dgInt32 i = 0; i < threadCounts; i ++) {
+			syncData->m_threadData[i].m_hasJointFeeback = 0;
 		}
-		world->SynchronizationBarrier();
+		CalculateJointsParallel (syncData, UpdateFeedbackForcesParallelKernel);
 
 		dgInt32 hasJointFeeback = 0;
-		for (dgInt32 i = 0; i < DG_MAX_THREADS_HIVE_COUNT; i ++) {
-			hasJointFeeback |= syncData->m_hasJointFeeback[i];
-		}
-
-		syncData->m_atomicIndex = 1;
-		for (dgInt32 j = 0; j < threadCounts; j++) {
-			world->QueueJob(UpdateBodyVelocityParallelKernel, syncData, world);
+		for (dgInt32 i = 0; i < threadCounts; i ++) {
+			hasJointFeeback |= syncData->m_threadData[i].m_hasJointFeeback;
 		}
-		world->SynchronizationBarrier();
 
+		CalculateBodiesParallel (syncData, UpdateBodyVelocityParallelKernel);
 		if (hasJointFeeback) {
-			syncData->m_atomicIndex = 0;
-			for (dgInt32 j = 0; j < threadCounts; j++) {
-				world->QueueJob(KinematicCallbackUpdateParallelKernel, syncData, world);
-			}
-			world->SynchronizationBarrier();
+			CalculateJointsParallel (syncData, KinematicCallbackUpdateParallelKernel);
 		}
-
 	} else {
 		const dgInt32 count = syncData->m_bodyCount;
-		const dgIsland* const island = syncData->m_island;
+		const dgBodyCluster* const cluster = syncData->m_cluster;
 		dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*)&world->m_bodiesMemory[0];
-		dgBodyInfo* const bodyArray = &bodyArrayPtr[island->m_bodyStart];
+		dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart];
 		for (dgInt32 i = 1; i < count; i++) {
 			dgBody* const body = bodyArray[i].m_body;
-			if (body->m_active) {
-				body->m_netForce = dgVector::m_zero;
-				body->m_netTorque = dgVector::m_zero;
-			}
+			body->m_accel = dgVector::m_zero;
+			body->m_alpha = dgVector::m_zero;
 		}
 	}
-*/
-}
-
-
-void dgWorldDynamicUpdate::CalculateJointsForceParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
-{
-	dgAssert (0);
-/*
-	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
-	dgWorld* const world = (dgWorld*) worldContext;
-
-	const dgIsland* const island = syncData->m_island;
-	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_jacobianBuffer[0];
-	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
-	const dgBodyInfo* const bodyArray = &bodyArrayPtr[island->m_bodyStart];
-	dgJointInfo* const constraintArrayPtr = (dgJointInfo*) &world->m_jointsMemory[0];
-	dgJointInfo* const constraintArray = &constraintArrayPtr[island->m_jointStart];
-	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForcesBuffer[0];
-//	const int jointCount = syncData->m_bachIndex;
-	const int jointCount = syncData->m_jointCount;
-
-	dgInt32* const bodyLocks = syncData->m_bodyLocks;
-	dgParallelSolverSyncData::dgParallelJointMap* const jointInfoMap = syncData->m_jointConflicts;
-
-	dgInt32* const atomicIndex = &syncData->m_atomicIndex;
-	dgFloat32 accNorm = dgFloat32(0.0f);
-	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < jointCount; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
-		dgInt32 index = jointInfoMap[i].m_jointIndex;
-		dgJointInfo* const jointInfo = &constraintArray[index];
-
-		const dgInt32 m0 = jointInfo->m_m0;
-		const dgInt32 m1 = jointInfo->m_m1;
-		dgAssert(m0 != m1);
-
-		dgSpinLock(&syncData->m_lock0, false);
-			if (m0) {
-				dgSpinLock(&bodyLocks[m0], false);
-			}
-			if (m1) {
-				dgSpinLock(&bodyLocks[m1], false);
-			}
-		dgSpinUnlock(&syncData->m_lock0);
-
-		dgFloat32 accel = world->CalculateJointForce(jointInfo, bodyArray, internalForces, matrixRow);
-
-		dgSpinLock(&syncData->m_lock1, false);
-			if (m0) {
-				dgSpinUnlock(&bodyLocks[m0]);
-			}
-			if (m1) {
-				dgSpinUnlock(&bodyLocks[m1]);
-			}
-		dgSpinUnlock(&syncData->m_lock1);
-
-		accNorm = (accel > accNorm) ? accel : accNorm;
-	}
-
-	syncData->m_accelNorm[threadID] = accNorm;
-*/
 }
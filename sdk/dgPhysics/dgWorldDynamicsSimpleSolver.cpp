@@ -25,6 +25,7 @@
 #include "dgConstraint.h"
 #include "dgDynamicBody.h"
 #include "dgDynamicBody.h"
+#include "dgSoaJointSolver.h"
 #include "dgSkeletonContainer.h"
 #include "dgCollisionInstance.h"
 #include "dgWorldDynamicUpdate.h"
@@ -273,8 +274,7 @@ void dgWorldDynamicUpdate::ResolveClusterForces(dgBodyCluster* const cluster, dg
 									const dgVector& com0 = body0->m_globalCentreOfMass;
 									const dgVector& com1 = body1->m_globalCentreOfMass;
 									
-									for (dgList<dgContactMaterial>::dgListNode* node = contact->GetFirst(); node; node = node->GetNext()) {
-										const dgContactMaterial* const contactMaterial = &node->GetInfo();
+									for (dgContactMaterial* contactMaterial = contact->GetFirstContact(); contactMaterial; contactMaterial = contact->GetNextContact(contactMaterial)) {
 										dgVector vel0 (veloc0 + omega0.CrossProduct3(contactMaterial->m_point - com0));
 										dgVector vel1 (veloc1 + omega1.CrossProduct3(contactMaterial->m_point - com1));
 										dgVector vRel (vel0 - vel1);
@@ -466,6 +466,8 @@ void dgWorldDynamicUpdate::BuildJacobianMatrix(dgBodyCluster* const cluster, dgI
 	dgAssert (cluster->m_bodyCount >= 2);
 
 	dgWorld* const world = (dgWorld*) this;
+	DG_PROFILE_PHASE (world, m_jacobianBuild, threadID);
+	DG_PROFILE_ITEMS (world, m_jacobianBuild, threadID, cluster->m_jointCount);
 	const dgInt32 bodyCount = cluster->m_bodyCount;
 
 	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
@@ -555,6 +557,7 @@ void dgWorldDynamicUpdate::BuildJacobianMatrix(dgBodyCluster* const cluster, dgI
 void dgWorldDynamicUpdate::IntegrateExternalForce(const dgBodyCluster* const cluster, dgFloat32 timestep, dgInt32 threadID) const
 {
 	dgWorld* const world = (dgWorld*) this;
+	DG_PROFILE_PHASE (world, m_integration, threadID);
 	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
 	dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart];
 
@@ -1022,6 +1025,8 @@ void dgWorldDynamicUpdate::CalculateSingleClusterReactionForces(const dgBodyClus
 	dgWorld* const world = (dgWorld*) this;
 	const dgInt32 bodyCount = cluster->m_bodyCount;
 	const dgInt32 jointCount = cluster->m_jointCount;
+	DG_PROFILE_PHASE (world, m_solverPasses, threadID);
+	DG_PROFILE_ITEMS (world, m_solverPasses, threadID, jointCount);
 
 	dgJacobian* const internalForces = &m_solverMemory.m_internalForcesBuffer[cluster->m_bodyStart];
 	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*)&world->m_bodiesMemory[0];
@@ -1137,6 +1142,8 @@ void dgWorldDynamicUpdate::CalculateClusterReactionForces(const dgBodyCluster* c
 	dgWorld* const world = (dgWorld*) this;
 	const dgInt32 bodyCount = cluster->m_bodyCount;
 	const dgInt32 jointCount = cluster->m_jointCount;
+	DG_PROFILE_PHASE (world, m_solverPasses, threadID);
+	DG_PROFILE_ITEMS (world, m_solverPasses, threadID, jointCount);
 
 	dgJacobian* const internalForces = &m_solverMemory.m_internalForcesBuffer[cluster->m_bodyStart];
 	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*)&world->m_bodiesMemory[0];
@@ -1179,7 +1186,8 @@ void dgWorldDynamicUpdate::CalculateClusterReactionForces(const dgBodyCluster* c
 		}
 	}
 
-	dgInt8* const skeletonMemory = (dgInt8*)dgAlloca(dgVector, skeletonMemorySizeInBytes / sizeof(dgVector));
+	dgFrameArena::dgBuffer<dgInt8> skeletonBuffer (world->m_frameArena, threadID, skeletonMemorySizeInBytes);
+	dgInt8* const skeletonMemory = skeletonBuffer.GetBuffer();
 	dgAssert((dgInt64(skeletonMemory) & 0x0f) == 0);
 
 	skeletonMemorySizeInBytes = 0;
@@ -1188,6 +1196,10 @@ void dgWorldDynamicUpdate::CalculateClusterReactionForces(const dgBodyCluster* c
 		skeletonMemorySizeInBytes += memorySizes[i];
 	}
 
+	// skeletons need the rows of their joints in place, so clusters with skeletons are solved one joint at the time
+	const bool useSoaSolver = world->m_useSoaSolver && !skeletonCount && (jointCount >= DG_SOA_SOLVER_MIN_JOINTS);
+	dgSoaJointSolver soaSolver (world->m_frameArena, threadID, constraintArray, useSoaSolver ? jointCount : 0, matrixRow, useSoaSolver ? cluster->m_rowsCount : 0);
+
 	const dgInt32 passes = world->m_solverMode;
 	for (dgInt32 step = 0; step < derivativesEvaluationsRK4; step++) {
 
@@ -1202,14 +1214,21 @@ void dgWorldDynamicUpdate::CalculateClusterReactionForces(const dgBodyCluster* c
 
 		dgFloat32 maxAccNorm = DG_SOLVER_MAX_ERROR * DG_SOLVER_MAX_ERROR;
 		dgFloat32 accNorm = maxAccNorm * dgFloat32(2.0f);
-		for (dgInt32 i = 0; (i < passes) && (accNorm > maxAccNorm); i++) {
-			accNorm = dgFloat32(0.0f);
-			for (dgInt32 j = 0; j < jointCount; j++) {
-				dgJointInfo* const jointInfo = &constraintArray[j];
-				//dgFloat32 accel2 = CalculateJointForce_3_13(jointInfo, bodyArray, internalForces, matrixRow);
-				dgFloat32 accel2 = CalculateJointForce(jointInfo, bodyArray, internalForces, matrixRow);
-				//accNorm = (accel > accNorm) ? accel : accNorm;
-				accNorm += accel2;
+		if (useSoaSolver) {
+			soaSolver.UpdateAccelerations();
+			for (dgInt32 i = 0; (i < passes) && (accNorm > maxAccNorm); i++) {
+				accNorm = soaSolver.CalculateJointForces(bodyArray, internalForces);
+			}
+		} else {
+			for (dgInt32 i = 0; (i < passes) && (accNorm > maxAccNorm); i++) {
+				accNorm = dgFloat32(0.0f);
+				for (dgInt32 j = 0; j < jointCount; j++) {
+					dgJointInfo* const jointInfo = &constraintArray[j];
+					//dgFloat32 accel2 = CalculateJointForce_3_13(jointInfo, bodyArray, internalForces, matrixRow);
+					dgFloat32 accel2 = CalculateJointForce(jointInfo, bodyArray, internalForces, matrixRow);
+					//accNorm = (accel > accNorm) ? accel : accNorm;
+					accNorm += accel2;
+				}
 			}
 		}
 		for (dgInt32 j = 0; j < skeletonCount; j++) {
@@ -1256,6 +1275,10 @@ void dgWorldDynamicUpdate::CalculateClusterReactionForces(const dgBodyCluster* c
 		}
 	}
 
+	if (useSoaSolver) {
+		soaSolver.UpdateForces();
+	}
+
 	dgInt32 hasJointFeeback = 0;
 	if (timestepRK != dgFloat32(0.0f)) {
 		for (dgInt32 i = 0; i < jointCount; i++) {